@@ -0,0 +1,695 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsmbrokerd.cc
+// *
+// * Purpose: Daemon that owns the ME/TA and shares it with several
+// *          gsmlib clients over a UNIX domain socket
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <string>
+#include <vector>
+#if defined(HAVE_GETOPT_LONG)
+#include <getopt.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <gsmlib/gsm_me_ta.h>
+#include <gsmlib/gsm_unix_serial.h>
+#include <gsmlib/gsm_socket_port.h>
+#include <gsmlib/gsm_recording_port.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#ifdef HAVE_GETOPT_LONG
+static struct option longOpts[] =
+{
+  {"xonxoff", no_argument, (int*)NULL, 'X'},
+  {"quickopen", no_argument, (int*)NULL, 'Q'},
+  {"init", required_argument, (int*)NULL, 'I'},
+  {"device", required_argument, (int*)NULL, 'd'},
+  {"socket", required_argument, (int*)NULL, 's'},
+  {"timeout", required_argument, (int*)NULL, 't'},
+  {"hold", required_argument, (int*)NULL, 'H'},
+  {"syslog", no_argument, (int*)NULL, 'L'},
+  {"baudrate", required_argument, (int*)NULL, 'b'},
+  {"help", no_argument, (int*)NULL, 'h'},
+  {"version", no_argument, (int*)NULL, 'v'},
+  {(char*)NULL, 0, (int*)NULL, 0}
+};
+#else
+#define getopt_long(argc, argv, options, longopts, indexptr) \
+  getopt(argc, argv, options)
+#endif
+
+// default time a client may hold the ME/TA for one command
+
+static const int DEFAULT_TRANSACTION_TIMEOUT = 180;
+
+// default time a client keeps the ME/TA after its last command
+
+static const int DEFAULT_HOLD_TIME = 2;
+
+// a client keeps the ME/TA for at most this many hold times in a row
+
+static const int MAX_HOLD_TIMES = 5;
+
+// signal handler for terminate signal
+
+static bool terminateSent = false;
+
+static void terminateHandler(int signum)
+{
+  terminateSent = true;
+}
+
+static bool enableSyslog = false;
+
+static void logMessage(int priority, std::string message)
+{
+  if (enableSyslog)
+    syslog(priority, "%s", message.c_str());
+  else
+    std::cerr << "gsmbrokerd: " << message << std::endl;
+}
+
+// one connected client
+
+struct Client
+{
+  int _fd;                      // socket
+  std::string _input;           // bytes received but not yet forwarded
+  bool _dead;                   // connection closed or broken
+
+  Client(int fd) : _fd(fd), _dead(false) {}
+};
+
+// the broker
+// Commands are forwarded to the ME/TA one at a time. The response is
+// forwarded to the client that sent the command until a final result code
+// is seen. The client then keeps the ME/TA until it has been idle for the
+// hold time, so that sequences like +CPBS/+CPBR or +CPMS/+CMGR are not
+// interleaved with the commands of other clients (which might select
+// another phonebook or store). A busy client loses the ME/TA after
+// MAX_HOLD_TIMES hold times. Afterwards the clients take turns (round
+// robin). Unsolicited result codes are sent to all clients, even while a
+// command is pending.
+
+class Broker
+{
+  gsmlib::Port *_port;          // port of ME/TA (owned by the MeTa)
+  std::vector<Client> _clients; // connected clients
+  unsigned int _nextClient;     // client to look at first for next command
+  std::string _modemInput;      // partial line received from ME/TA
+  bool _busy;                   // command pending
+  bool _pduMode;                // ME/TA waits for PDU (after "> " prompt)
+  int _activeFd;                // client that sent pending command (or -1)
+  time_t _deadline;             // end of transaction timeout
+  int _transactionTimeout;      // transaction timeout in seconds
+  int _ownerFd;                 // client holding the ME/TA (or -1)
+  time_t _holdUntil;            // end of hold time of _ownerFd
+  time_t _ownedSince;           // start of the hold of _ownerFd
+  int _holdTime;                // hold time in seconds
+  int _urcLines;                // lines of current URC still to broadcast
+  unsigned int _connections;    // connections of a TCP port seen so far
+
+  // send data to client, mark client dead on error
+  void send(Client &client, const std::string &data);
+
+  // forward line from ME/TA to active client or broadcast it
+  void modemLine(const std::string &line);
+
+  // forward PDU from active client to the ME/TA up to ^Z or ESC
+  void forwardPdu(Client &client);
+
+  // return true if line is a final result code
+  static bool isFinalResult(std::string line);
+
+  // return number of lines of the unsolicited result code that starts
+  // with line, 0 if line is not an unsolicited result code
+  static int urcLines(std::string line);
+
+  // return true if line ends the prompt for a PDU
+  bool isPrompt() const;
+
+  // transaction finished
+  void endTransaction();
+
+  // file descriptor of the port (changes if a TCP connection is
+  // reestablished)
+  // throw ParameterError if the port has no file descriptor to wait for
+  int portFd() const;
+
+  // return the socket port below a recording port or NULL
+  gsmlib::SocketPort *socketPort() const;
+
+  // return true if a TCP connection was reestablished since the last call
+  bool reconnected();
+
+public:
+  Broker(gsmlib::Port *port, int transactionTimeout, int holdTime);
+
+  // add new client
+  void addClient(int fd);
+
+  // fill in file descriptors to wait for, return highest
+  int fdSet(fd_set &fds) const;
+
+  // process readable file descriptors
+  void process(const fd_set &fds);
+
+  // check transaction timeout and forward next command if idle
+  void dispatch();
+};
+
+Broker::Broker(gsmlib::Port *port, int transactionTimeout, int holdTime) :
+  _port(port), _nextClient(0), _busy(false), _pduMode(false), _activeFd(-1),
+  _deadline(0), _transactionTimeout(transactionTimeout), _ownerFd(-1),
+  _holdUntil(0), _ownedSince(0), _holdTime(holdTime), _urcLines(0),
+  _connections(0)
+{
+  // fail at startup if the port cannot be shared
+  portFd();
+  reconnected();
+}
+
+void Broker::send(Client &client, const std::string &data)
+{
+  size_t bytesWritten = 0;
+  while (! client._dead && bytesWritten < data.length())
+  {
+    ssize_t bw = ::send(client._fd, data.data() + bytesWritten,
+                        data.length() - bytesWritten, MSG_NOSIGNAL);
+    if (bw < 0 && errno != EINTR)
+      client._dead = true;
+    else if (bw > 0)
+      bytesWritten += bw;
+  }
+}
+
+bool Broker::isFinalResult(std::string line)
+{
+  size_t end = line.find_last_not_of("\r\n");
+  line.erase(end == std::string::npos ? 0 : end + 1);
+  return line == "OK" || line == "ERROR" ||
+    line.substr(0, 11) == "+CME ERROR:" || line.substr(0, 11) == "+CMS ERROR:" ||
+    line == "NO CARRIER" || line == "BUSY" || line == "NO ANSWER" ||
+    line == "NO DIALTONE" || line.substr(0, 7) == "CONNECT";
+}
+
+int Broker::urcLines(std::string line)
+{
+  size_t end = line.find_last_not_of("\r\n");
+  line.erase(end == std::string::npos ? 0 : end + 1);
+  if (line == "RING" || line.substr(0, 7) == "+CRING:" ||
+      line.substr(0, 6) == "+CMTI:" || line.substr(0, 6) == "+CBMI:" ||
+      line.substr(0, 6) == "+CDSI:")
+    return 1;
+  // the +CLIP? query returns +CLIP: n,m which is not unsolicited
+  if (line.substr(0, 6) == "+CLIP:" && line.length() > 10)
+    return 1;
+  // the SMS follows in the next line
+  if (line.substr(0, 5) == "+CMT:" || line.substr(0, 5) == "+CBM:" ||
+      line.substr(0, 5) == "+CDS:")
+    return 2;
+  return 0;
+}
+
+bool Broker::isPrompt() const
+{
+  size_t i = _modemInput.find_first_not_of("\r\n");
+  return i != std::string::npos && _modemInput.substr(i, 2) == "> ";
+}
+
+void Broker::endTransaction()
+{
+  if (_activeFd != -1 && _holdTime > 0)
+  {
+    time_t now = time(NULL);
+    if (_ownerFd != _activeFd)
+    {
+      _ownerFd = _activeFd;
+      _ownedSince = now;
+    }
+    // the hold is not extended beyond MAX_HOLD_TIMES hold times, then
+    // the clients waiting meanwhile get their turn
+    _holdUntil = std::min(now + _holdTime,
+                          _ownedSince + _holdTime * MAX_HOLD_TIMES);
+  }
+  _busy = false;
+  _pduMode = false;
+  _activeFd = -1;
+}
+
+void Broker::modemLine(const std::string &line)
+{
+  // unsolicited result codes are not part of the response
+  bool broadcast = ! _busy;
+  if (_urcLines > 0)
+  {
+    broadcast = true;
+    --_urcLines;
+  }
+  else if (urcLines(line) > 0)
+  {
+    broadcast = true;
+    _urcLines = urcLines(line) - 1;
+  }
+
+  if (broadcast)
+    for (std::vector<Client>::iterator i = _clients.begin();
+         i != _clients.end(); ++i)
+      send(*i, line);
+  else
+  {
+    for (std::vector<Client>::iterator i = _clients.begin();
+         i != _clients.end(); ++i)
+      if (i->_fd == _activeFd)
+        send(*i, line);
+    if (isFinalResult(line))
+      endTransaction();
+  }
+}
+
+void Broker::forwardPdu(Client &client)
+{
+  size_t end = client._input.find_first_of("\032\033");
+  std::string pdu = client._input.substr(0, end == std::string::npos ?
+                                         std::string::npos : end + 1);
+  client._input.erase(0, pdu.length());
+  if (end != std::string::npos)
+    _pduMode = false;           // wait for the result of the command
+  if (pdu.length() > 0)
+    _port->putLine(pdu, false);
+}
+
+void Broker::addClient(int fd)
+{
+  _clients.push_back(Client(fd));
+}
+
+gsmlib::SocketPort *Broker::socketPort() const
+{
+  gsmlib::Port *port = _port;
+  gsmlib::RecordingPort *recordingPort =
+    dynamic_cast<gsmlib::RecordingPort*>(port);
+  if (recordingPort != NULL)
+    port = recordingPort->port().getptr();
+  return dynamic_cast<gsmlib::SocketPort*>(port);
+}
+
+int Broker::portFd() const
+{
+  gsmlib::Port *port = _port;
+  gsmlib::RecordingPort *recordingPort =
+    dynamic_cast<gsmlib::RecordingPort*>(port);
+  if (recordingPort != NULL)
+    port = recordingPort->port().getptr();
+  gsmlib::UnixSerialPort *serialPort =
+    dynamic_cast<gsmlib::UnixSerialPort*>(port);
+  if (serialPort != NULL)
+    return serialPort->fd();
+  if (socketPort() != NULL)
+    return socketPort()->fd();
+  throw gsmlib::GsmException(_("device cannot be shared by gsmbrokerd"),
+                             gsmlib::ParameterError);
+}
+
+bool Broker::reconnected()
+{
+  if (socketPort() == NULL || socketPort()->connections() == _connections)
+    return false;
+  _connections = socketPort()->connections();
+  return true;
+}
+
+int Broker::fdSet(fd_set &fds) const
+{
+  int maxFd = portFd();
+  FD_SET(maxFd, &fds);
+  for (std::vector<Client>::const_iterator i = _clients.begin();
+       i != _clients.end(); ++i)
+  {
+    FD_SET(i->_fd, &fds);
+    if (i->_fd > maxFd)
+      maxFd = i->_fd;
+  }
+  return maxFd;
+}
+
+void Broker::process(const fd_set &fds)
+{
+  char buffer[1024];
+
+  // read from the clients first so that a PDU is forwarded immediately
+  for (std::vector<Client>::iterator i = _clients.begin();
+       i != _clients.end(); ++i)
+    if (FD_ISSET(i->_fd, &fds))
+    {
+      ssize_t res = read(i->_fd, buffer, sizeof(buffer));
+      if (res <= 0)
+        i->_dead = true;
+      else
+      {
+        i->_input.append(buffer, res);
+        if (_pduMode && i->_fd == _activeFd)
+          forwardPdu(*i);
+      }
+    }
+
+  if (FD_ISSET(portFd(), &fds))
+  {
+    // the port filters the telnet protocol of RFC 2217 connections and
+    // reconnects dropped TCP connections, so there may be nothing to read
+    struct timeval noWait = {0, 0};
+    while (_port->wait(&noWait))
+      _modemInput += (char)_port->readByte();
+
+    // the response to the pending command is lost with the connection
+    if (reconnected())
+    {
+      _modemInput = "";
+      _urcLines = 0;
+      if (_busy)
+      {
+        logMessage(LOG_WARNING, _("connection to TA lost, command aborted"));
+        modemLine("ERROR\r\n");
+      }
+    }
+
+    size_t eol;
+    while ((eol = _modemInput.find(gsmlib::LF)) != std::string::npos)
+    {
+      std::string line = _modemInput.substr(0, eol + 1);
+      _modemInput.erase(0, eol + 1);
+      modemLine(line);
+    }
+
+    // the prompt for the PDU is not terminated by a LF
+    if (_busy && ! _pduMode && isPrompt())
+    {
+      modemLine(_modemInput);
+      _modemInput = "";
+      _pduMode = true;
+      for (std::vector<Client>::iterator i = _clients.begin();
+           i != _clients.end(); ++i)
+        if (i->_fd == _activeFd)
+          forwardPdu(*i);
+    }
+  }
+
+  // remove clients that have gone away
+  for (unsigned int i = 0; i < _clients.size();)
+    if (_clients[i]._dead)
+    {
+      if (_clients[i]._fd == _activeFd)
+      {
+        // the response is discarded, abort PDU input if necessary
+        if (_pduMode)
+        {
+          _port->putLine("\033", false);
+          _pduMode = false;
+        }
+        _activeFd = -1;
+      }
+      if (_clients[i]._fd == _ownerFd)
+        _ownerFd = -1;
+      close(_clients[i]._fd);
+      _clients.erase(_clients.begin() + i);
+      if (_nextClient > i)
+        --_nextClient;
+    }
+    else
+      ++i;
+}
+
+void Broker::dispatch()
+{
+  if (_busy && time(NULL) > _deadline)
+  {
+    logMessage(LOG_WARNING, _("timeout waiting for response of TA"));
+    if (_pduMode)
+      _port->putLine("\033", false);
+    endTransaction();
+  }
+  if (_busy)
+    return;
+  if (_ownerFd != -1 && time(NULL) > _holdUntil)
+    _ownerFd = -1;
+
+  // look for the next client with a complete command, only the owner
+  // may send commands during its hold time
+  for (unsigned int n = 0; n < _clients.size(); ++n)
+  {
+    Client &client = _clients[(_nextClient + n) % _clients.size()];
+    if (_ownerFd != -1 && client._fd != _ownerFd)
+      continue;
+    size_t eol;
+    while ((eol = client._input.find(gsmlib::CR)) != std::string::npos)
+    {
+      std::string command = client._input.substr(0, eol + 1);
+      client._input.erase(0, eol + 1);
+      size_t start = command.find_first_not_of("\r\n");
+      if (start == std::string::npos)
+        continue;               // empty line
+      command.erase(0, start);
+
+      _busy = true;
+      _activeFd = client._fd;
+      _deadline = time(NULL) + _transactionTimeout;
+      _nextClient = (_nextClient + n + 1) % _clients.size();
+      _port->putLine(command, false);
+      // putLine() reconnects before sending if the connection was closed
+      reconnected();
+      return;
+    }
+  }
+}
+
+// create socket and listen on it
+
+static int listenOn(std::string socketPath)
+{
+  struct sockaddr_un addr;
+  if (socketPath.length() >= sizeof(addr.sun_path))
+    throw gsmlib::GsmException(
+      gsmlib::stringPrintf(_("socket name '%s' too long"),
+                           socketPath.c_str()), gsmlib::ParameterError);
+
+  // remove socket left over by a previous instance
+  if (gsmlib::isSocket(socketPath))
+    unlink(socketPath.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socketPath.c_str());
+  if (fd == -1 ||
+      bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+      listen(fd, 16) == -1)
+    throw gsmlib::GsmException(
+      gsmlib::stringPrintf(_("error when creating socket '%s' "
+                             "(errno: %d/%s)"),
+                           socketPath.c_str(), errno, strerror(errno)),
+      gsmlib::OSError);
+  return fd;
+}
+
+// *** main program
+
+int main(int argc, char *argv[])
+{
+  std::string socketPath;
+  int listenFd = -1;
+  try
+  {
+    // handle command line options
+    std::string device = "/dev/mobilephone";
+    std::string baudrate;
+    std::string initString = gsmlib::DEFAULT_INIT_STRING;
+    bool swHandshake = false;
+    bool fastOpen = false;
+    int transactionTimeout = DEFAULT_TRANSACTION_TIMEOUT;
+    int holdTime = DEFAULT_HOLD_TIME;
+
+    int opt;
+    int dummy;
+    while((opt = getopt_long(argc, argv, "I:d:b:s:t:H:LXQhv", longOpts,
+                             &dummy)) != -1)
+      switch (opt)
+      {
+      case 'X':
+        swHandshake = true;
+        break;
+      case 'Q':
+        fastOpen = true;
+        break;
+      case 'I':
+        initString = optarg;
+        break;
+      case 'd':
+        device = optarg;
+        break;
+      case 'b':
+        baudrate = optarg;
+        break;
+      case 's':
+        socketPath = optarg;
+        break;
+      case 't':
+        transactionTimeout = gsmlib::checkNumber(optarg);
+        break;
+      case 'H':
+        holdTime = gsmlib::checkNumber(optarg);
+        break;
+      case 'L':
+        enableSyslog = true;
+        openlog("gsmbrokerd", LOG_CONS | LOG_NDELAY | LOG_PID, LOG_DAEMON);
+        syslog(LOG_NOTICE, "%s started (version %s [compiled %s])",
+               argv[0], VERSION, __DATE__);
+        break;
+      case 'v':
+        std::cerr << argv[0] << gsmlib::stringPrintf(_(": version %s [compiled %s]"),
+                                                     VERSION, __DATE__) << std::endl;
+        exit(0);
+        break;
+      case 'h':
+        std::cerr << argv[0] << _(": [-b baudrate][-d device][-h]"
+                                  "[-H hold time][-I init string]\n"
+                                  "  [-L][-Q][-t timeout][-v][-X] -s socket")
+                  << std::endl << std::endl
+                  << _("  -b, --baudrate    baudrate to use for device "
+                       "(default: 38400)")
+                  << std::endl
+                  << _("  -d, --device      sets the device to connect to")
+                  << std::endl
+                  << _("  -h, --help        prints this message") << std::endl
+                  << _("  -H, --hold        seconds a client keeps the device "
+                       "after its last\n"
+                       "                    command (default: 2, 0 = none), "
+                       "at most 5 times\n"
+                       "                    as long in a row")
+                  << std::endl
+                  << _("  -I, --init        device AT init sequence") << std::endl
+                  << _("  -L, --syslog      log errors and information to syslog")
+                  << std::endl
+                  << _("  -Q, --quickopen   skip reset of device if it responds")
+                  << std::endl
+                  << _("  -s, --socket      UNIX domain socket to listen on")
+                  << std::endl
+                  << _("  -t, --timeout     seconds a client may wait for the "
+                       "response\n"
+                       "                    to a command (default: 180)")
+                  << std::endl
+                  << _("  -v, --version     prints version and exits") << std::endl
+                  << _("  -X, --xonxoff     switch on software handshake")
+                  << std::endl << std::endl;
+        exit(0);
+        break;
+      case '?':
+        throw gsmlib::GsmException(_("unknown option"), gsmlib::ParameterError);
+        break;
+      }
+
+    if (socketPath == "")
+      throw gsmlib::GsmException(_("socket name must be given"),
+                                 gsmlib::ParameterError);
+
+    // register signal handler for terminate signal
+    struct sigaction terminateAction;
+    terminateAction.sa_handler = terminateHandler;
+    sigemptyset(&terminateAction.sa_mask);
+    terminateAction.sa_flags = 0;
+    if (sigaction(SIGINT, &terminateAction, NULL) != 0 ||
+        sigaction(SIGTERM, &terminateAction, NULL) != 0)
+      throw gsmlib::GsmException(
+        gsmlib::stringPrintf(_("error when calling sigaction() (errno: %d/%s)"),
+                             errno, strerror(errno)),
+        gsmlib::OSError);
+    signal(SIGPIPE, SIG_IGN);
+
+    // open the port and initialize the ME/TA once for all clients
+    gsmlib::Ref<gsmlib::Port> port =
+      gsmlib::openPort(device,
+                       baudrate == "" ? gsmlib::DEFAULT_BAUD_RATE :
+                       gsmlib::baudRateStrToSpeed(baudrate),
+                       initString, swHandshake, fastOpen);
+    gsmlib::UnixSerialPort *serialPort =
+      dynamic_cast<gsmlib::UnixSerialPort*>(port.getptr());
+    if (serialPort != NULL)
+      logMessage(LOG_NOTICE, gsmlib::stringPrintf(_("opened %s in %ld ms"),
+                                                  device.c_str(),
+                                                  serialPort->openLatency()));
+    else
+      logMessage(LOG_NOTICE, gsmlib::stringPrintf(_("opened %s"),
+                                                  device.c_str()));
+    gsmlib::MeTa me(port);
+
+    Broker broker(port.getptr(), transactionTimeout, holdTime);
+    listenFd = listenOn(socketPath);
+
+    while (! terminateSent)
+    {
+      fd_set fds;
+      FD_ZERO(&fds);
+      FD_SET(listenFd, &fds);
+      int maxFd = broker.fdSet(fds);
+      if (listenFd > maxFd)
+        maxFd = listenFd;
+
+      struct timeval oneSecond;
+      oneSecond.tv_sec = 1;
+      oneSecond.tv_usec = 0;
+      int res = select(maxFd + 1, &fds, NULL, NULL, &oneSecond);
+      if (res < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        throw gsmlib::GsmException(
+          gsmlib::stringPrintf(_("error when calling select() (errno: %d/%s)"),
+                               errno, strerror(errno)),
+          gsmlib::OSError);
+      }
+
+      if (res > 0)
+      {
+        if (FD_ISSET(listenFd, &fds))
+        {
+          int clientFd = accept(listenFd, NULL, NULL);
+          if (clientFd >= 0)
+            broker.addClient(clientFd);
+        }
+        broker.process(fds);
+      }
+      broker.dispatch();
+    }
+    unlink(socketPath.c_str());
+  }
+  catch (gsmlib::GsmException &ge)
+  {
+    if (enableSyslog)
+      syslog(LOG_ERR, "error %s", ge.what());
+    std::cerr << argv[0] << _("[ERROR]: ") << ge.what() << std::endl;
+    if (listenFd != -1)
+      unlink(socketPath.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -65,6 +65,7 @@ enum InfoParameter {AllInfo, // print all info
 static struct option longOpts[] =
 {
   {"xonxoff", no_argument, (int*)NULL, 'X'},
+  {"quickopen", no_argument, (int*)NULL, 'Q'},
   {"operation", required_argument, (int*)NULL, 'o'},
   {"device", required_argument, (int*)NULL, 'd'},
   {"baudrate", required_argument, (int*)NULL, 'b'},
@@ -374,16 +375,20 @@ int main(int argc, char *argv[])
     std::string baudrate;
     std::string initString = gsmlib::DEFAULT_INIT_STRING;
     bool swHandshake = false;
+    bool fastOpen = false;
 
     int opt;
     int dummy;
-    while((opt = getopt_long(argc, argv, "I:o:d:b:hvX", longOpts, &dummy))
+    while((opt = getopt_long(argc, argv, "I:o:d:b:hvXQ", longOpts, &dummy))
           != -1)
       switch (opt)
       {
       case 'X':
         swHandshake = true;
         break;
+      case 'Q':
+        fastOpen = true;
+        break;
       case 'I':
         initString = optarg;
         break;
@@ -404,7 +409,7 @@ int main(int argc, char *argv[])
       case 'h':
 	std::cerr << argv[0] << _(": [-b baudrate][-d device][-h]"
 				  "[-I init string][-o operation]\n"
-				  "  [-v][-X]{parameters}") << std::endl
+				  "  [-Q][-v][-X]{parameters}") << std::endl
 		  << std::endl
 		  << _("  -b, --baudrate    baudrate to use for device "
 		       "(default: 38400)")
@@ -416,6 +421,8 @@ int main(int argc, char *argv[])
 		  << _("  -o, --operation   operation to perform on the mobile \n"
 		       "                    phone with the specified parameters")
 		  << std::endl
+		  << _("  -Q, --quickopen   skip reset of device if it responds")
+		  << std::endl
 		  << _("  -v, --version     prints version and exits") << std::endl
 		  << _("  -X, --xonxoff     switch on software handshake") << std::endl
 		  << std::endl
@@ -436,17 +443,17 @@ int main(int argc, char *argv[])
       }
 
     // open the port and ME/TA
-    m = new gsmlib::MeTa(new
+    m = new gsmlib::MeTa(
 #ifdef WIN32
-			 gsmlib::Win32SerialPort
+			 new gsmlib::Win32SerialPort
 #else
-			 gsmlib::UnixSerialPort
+			 gsmlib::openPort
 #endif
 			 (device,
 			  baudrate == "" ?
 			  gsmlib::DEFAULT_BAUD_RATE :
 			  gsmlib::baudRateStrToSpeed(baudrate),
-			  initString, swHandshake));
+			  initString, swHandshake, fastOpen));
 
     if (operation == "")
     {                           // process info parameters
@@ -651,7 +658,11 @@ int main(int argc, char *argv[])
   catch (gsmlib::GsmException &ge)
   {
     std::cerr << argv[0] << _("[ERROR]: ") << ge.what() << std::endl;
+    if (m != NULL)
+      gsmlib::exportMetrics(m->getMetrics());
     return 1;
   }
+  if (m != NULL)
+    gsmlib::exportMetrics(m->getMetrics());
   return 0;
 }
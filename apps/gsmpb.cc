@@ -29,12 +29,14 @@
 #include <gsmlib/gsm_me_ta.h>
 #include <gsmlib/gsm_util.h>
 #include <gsmlib/gsm_sorted_phonebook.h>
+#include <gsmlib/gsm_phonebook_diff.h>
 #include <iostream>
 
 #ifdef HAVE_GETOPT_LONG
 static struct option longOpts[] =
 {
   {"xonxoff", no_argument, (int*)NULL, 'X'},
+  {"quickopen", no_argument, (int*)NULL, 'Q'},
   {"phonebook", required_argument, (int*)NULL, 'p'},
   {"init", required_argument, (int*)NULL, 'I'},
   {"destination", required_argument, (int*)NULL, 'd'},
@@ -49,6 +51,7 @@ static struct option longOpts[] =
   {"version", no_argument, (int*)NULL, 'v'},
   {"verbose", no_argument, (int*)NULL, 'V'},
   {"indexed", no_argument, (int*)NULL, 'i'},
+  {"dry-run", no_argument, (int*)NULL, 'n'},
   {(char*)NULL, 0, (int*)NULL, 0}
 };
 #else
@@ -235,10 +238,25 @@ void deleteNotPresent(gsmlib::SortedPhonebookRef sourcePhonebook,
   }
 }
 
+// export metrics of the ME/TAs used (see GSMLIB_METRICS)
+
+static void exportMetrics(gsmlib::Ref<gsmlib::MeTa> sourceMeTa,
+                          gsmlib::Ref<gsmlib::MeTa> destMeTa)
+{
+  gsmlib::GsmMetrics metrics;
+  if (! sourceMeTa.isnull())
+    metrics.add(sourceMeTa->getMetrics());
+  if (! destMeTa.isnull())
+    metrics.add(destMeTa->getMetrics());
+  if (! sourceMeTa.isnull() || ! destMeTa.isnull())
+    gsmlib::exportMetrics(metrics);
+}
+
 // *** main program
 
 int main(int argc, char *argv[])
 {
+  gsmlib::Ref<gsmlib::MeTa> sourceMeTa, destMeTa;
   try
   {
     // handle command line options
@@ -252,14 +270,16 @@ int main(int argc, char *argv[])
     gsmlib::SortedPhonebookRef sourcePhonebook, destPhonebook;
     bool verbose = false;
     bool indexed = false;
+    bool dryRun = false;
     std::string initString = gsmlib::DEFAULT_INIT_STRING;
     bool swHandshake = false;
+    bool fastOpen = false;
     std::string charSet;
-    gsmlib::Ref<gsmlib::MeTa> sourceMeTa, destMeTa;
+    gsmlib::PhonebookRef destPb;
 
     int opt;
     int dummy;
-    while((opt = getopt_long(argc, argv, "I:p:s:d:b:cyhvViD:S:Xt:", longOpts,
+    while((opt = getopt_long(argc, argv, "I:p:s:d:b:cyhvViD:S:XQt:n", longOpts,
                              &dummy))
           != -1)
       switch (opt)
@@ -267,6 +287,9 @@ int main(int argc, char *argv[])
       case 'X':
         swHandshake = true;
         break;
+      case 'Q':
+        fastOpen = true;
+        break;
       case 'I':
         initString = optarg;
         break;
@@ -300,6 +323,9 @@ int main(int argc, char *argv[])
       case 'i':
         indexed = true;
         break;
+      case 'n':
+        dryRun = true;
+        break;
       case 'y':
         doSynchronize = true;
         break;
@@ -311,7 +337,7 @@ int main(int argc, char *argv[])
       case 'h':
         std::cerr << argv[0] << _(": [-b baudrate][-c][-d device or file][-h]"
                                   "[-I init string]\n"
-                                  "  [-p phonebook name][-s device or file]"
+                                  "  [-n][-p phonebook name][-Q][-s device or file]"
                                   "[-t charset][-v]"
                                   "[-V][-y][-X]") << std::endl
              << std::endl
@@ -329,7 +355,12 @@ int main(int argc, char *argv[])
              << _("  -i, --index       takes index positions into account")
              << std::endl
              << _("  -I, --init        device AT init sequence") << std::endl
+             << _("  -n, --dry-run     only print the changes that would be\n"
+                  "                    written to the destination device")
+             << std::endl
              << _("  -p, --phonebook   name of phonebook to use") << std::endl
+             << _("  -Q, --quickopen   skip reset of device if it responds")
+             << std::endl
              << _("  -s, --source      sets the source device to connect to,\n"
                   "                    or the file to read") << std::endl
              << _("  -t, --charset     sets the character set to use for\n"
@@ -369,20 +400,22 @@ int main(int argc, char *argv[])
       if (phonebook == "")
         throw gsmlib::GsmException(_("phonebook name must be given"), gsmlib::ParameterError);
 
-      sourceMeTa = new gsmlib::MeTa(new
+      sourceMeTa = new gsmlib::MeTa(
 #ifdef WIN32
-              gsmlib::Win32SerialPort
+              new gsmlib::Win32SerialPort
 #else
-              gsmlib::UnixSerialPort
+              gsmlib::openPort
 #endif
               (source,
                baudrate == "" ? gsmlib::DEFAULT_BAUD_RATE :
                gsmlib::baudRateStrToSpeed(baudrate), initString,
-               swHandshake));
+               swHandshake, fastOpen));
       if (charSet != "")
         sourceMeTa->setCharSet(charSet);
+      // the whole phonebook is needed, so preload it
       sourcePhonebook =
-        new gsmlib::SortedPhonebook(sourceMeTa->getPhonebook(phonebook));
+        new gsmlib::SortedPhonebook(sourceMeTa->getPhonebook(phonebook,
+                                                             true));
     }
 
     // make sure destination.c_str file exists
@@ -411,19 +444,19 @@ int main(int argc, char *argv[])
       if (phonebook == "")
         throw gsmlib::GsmException(_("phonebook name must be given"), gsmlib::ParameterError);
 
-      destMeTa = new gsmlib::MeTa(new 
+      destMeTa = new gsmlib::MeTa(
 #ifdef WIN32
-              gsmlib::Win32SerialPort
+              new gsmlib::Win32SerialPort
 #else
-              gsmlib::UnixSerialPort
+              gsmlib::openPort
 #endif
               (destination,
                baudrate == "" ? gsmlib::DEFAULT_BAUD_RATE :
                gsmlib::baudRateStrToSpeed(baudrate), initString,
-               swHandshake));
+               swHandshake, fastOpen));
       if (charSet != "")
         destMeTa->setCharSet(charSet);
-      gsmlib::PhonebookRef destPb = destMeTa->getPhonebook(phonebook);
+      destPb = destMeTa->getPhonebook(phonebook, true);
 
       // check maximum lengths of source text and phonenumber when writing to
       // mobile phone
@@ -446,13 +479,45 @@ int main(int argc, char *argv[])
               gsmlib::ParameterError);
         }
       }
-
-      // read phonebook
-      destPhonebook = new gsmlib::SortedPhonebook(destPb);      
     }
 
     // now do the actual work
-    if (doSynchronize)
+    if (! destPb.isnull())
+    {
+      // synchronizing and copying both make the destination equal to the
+      // source, write only the slots that differ
+      // (synchronizing does not care about the case of names)
+      gsmlib::PhonebookDiff diff(gsmlib::PhonebookDiff::slots(destPb),
+                                 gsmlib::PhonebookDiff::slots(sourcePhonebook()),
+                                 indexed, doSynchronize);
+      if (verbose || dryRun)
+      {
+        for (std::vector<gsmlib::PhonebookSlot>::const_iterator i =
+               diff.writes().begin(); i != diff.writes().end(); ++i)
+          if (i->empty())
+            std::cout << gsmlib::stringPrintf(_("clearing index #%d"),
+                                              i->_index) << std::endl;
+          else
+            std::cout << gsmlib::stringPrintf(_("writing '%s' tel# %s"),
+                                              i->_text.c_str(),
+                                              i->_telephone.c_str())
+                      << gsmlib::stringPrintf(_(" (index #%d)"), i->_index)
+                      << std::endl;
+        std::cout << gsmlib::stringPrintf(_("%d unchanged, %d updated, "
+                                            "%d inserted, %d deleted "
+                                            "(%d writes)"),
+                                          diff.unchanged(), diff.updates(),
+                                          diff.inserts(), diff.clears(),
+                                          diff.roundTrips())
+                  << std::endl;
+      }
+      if (! dryRun)
+        diff.apply(destPb);
+    }
+    else if (dryRun)
+      throw gsmlib::GsmException(_("dry run needs a destination device"),
+                                 gsmlib::ParameterError);
+    else if (doSynchronize)
     {                           // synchronizing
       if (indexed)
       {
@@ -499,7 +564,9 @@ int main(int argc, char *argv[])
   catch (gsmlib::GsmException &ge)
   {
     std::cerr << argv[0] << _("[ERROR]: ") << ge.what() << std::endl;
+    exportMetrics(sourceMeTa, destMeTa);
     return 1;
   }
+  exportMetrics(sourceMeTa, destMeTa);
   return 0;
 }
@@ -30,6 +30,7 @@
 #include <gsmlib/gsm_me_ta.h>
 #include <gsmlib/gsm_util.h>
 #include <iostream>
+#include <fstream>
 
 // options
 
@@ -37,7 +38,9 @@
 static struct option longOpts[] =
 {
   {"requeststat", no_argument, (int*)NULL, 'r'},
+  {"recipients", required_argument, (int*)NULL, 'R'},
   {"xonxoff", no_argument, (int*)NULL, 'X'},
+  {"quickopen", no_argument, (int*)NULL, 'Q'},
   {"sca", required_argument, (int*)NULL, 'C'},
   {"device", required_argument, (int*)NULL, 'd'},
   {"init", required_argument, (int*)NULL, 'I'},
@@ -87,10 +90,73 @@ static std::string unescapeString(char *line)
   return result;
 }
 
+// send the text to every phone number in recipientsFile
+// the SMS is encoded only once, errors for single recipients are reported
+// and the remaining recipients are processed
+// return false if sending failed for any recipient
+
+static bool sendToRecipients(gsmlib::MeTa *m,
+                             gsmlib::Ref<gsmlib::SMSSubmitMessage> submitSMS,
+                             std::string text, int concatenatedMessageId,
+                             std::string recipientsFile)
+{
+  std::ifstream ifs(recipientsFile.c_str());
+  if (! ifs)
+    throw gsmlib::GsmException(
+      gsmlib::stringPrintf(_("could not open recipients file '%s'"),
+                           recipientsFile.c_str()), gsmlib::ParameterError);
+
+  gsmlib::SMSSubmitTemplateRef smsTemplate =
+    new gsmlib::SMSSubmitTemplate(submitSMS, text, concatenatedMessageId == -1,
+                                  concatenatedMessageId);
+
+  // keep the link to the SC open for the whole batch
+  try
+  {
+    m->setMoreMessagesToSend(2);
+  }
+  catch (gsmlib::GsmException &ge)
+  {
+    // ignore, the SMS can be sent without
+  }
+
+  bool allSent = true;
+  std::string line;
+  while (getline(ifs, line))
+  {
+    // ignore everything after a <TAB> in the phone number (like gsmsmsd)
+    std::string phoneNumber =
+      gsmlib::removeWhiteSpace(line.substr(0, line.find('\t')));
+    if (phoneNumber == "")
+      continue;
+    try
+    {
+      m->sendSMSs(smsTemplate, gsmlib::Address(phoneNumber));
+    }
+    catch (gsmlib::GsmException &ge)
+    {
+      std::cerr << _("failed sending SMS to ") << phoneNumber << ": "
+                << ge.what() << std::endl;
+      allSent = false;
+    }
+  }
+
+  try
+  {
+    m->setMoreMessagesToSend(0);
+  }
+  catch (gsmlib::GsmException &ge)
+  {
+    // ignore, the ME releases the link itself after some time
+  }
+  return allSent;
+}
+
 // *** main program
 
 int main(int argc, char *argv[])
 {
+  gsmlib::MeTa *m = NULL;
   try
   {
     // handle command line options
@@ -100,17 +166,18 @@ int main(int argc, char *argv[])
     gsmlib::Ref<gsmlib::GsmAt> at;
     std::string initString = gsmlib::DEFAULT_INIT_STRING;
     bool swHandshake = false;
+    bool fastOpen = false;
     bool requestStatusReport = false;
     // service centre address (set on command line)
     std::string serviceCentreAddress;
-    gsmlib::MeTa *m = NULL;
     std::string concatenatedMessageIdStr;
     int concatenatedMessageId = -1;
+    std::string recipientsFile;
 
     int opt;
     int dummy;
-    while((opt = getopt_long(argc, argv, "c:C:I:d:b:thvXr", longOpts, &dummy))
-          != -1)
+    while((opt = getopt_long(argc, argv, "c:C:I:d:b:thvXQrR:", longOpts,
+                             &dummy)) != -1)
       switch (opt)
       {
       case 'c':
@@ -122,6 +189,9 @@ int main(int argc, char *argv[])
       case 'X':
         swHandshake = true;
         break;
+      case 'Q':
+        fastOpen = true;
+        break;
       case 'I':
         initString = optarg;
         break;
@@ -137,6 +207,9 @@ int main(int argc, char *argv[])
       case 'r':
         requestStatusReport = true;
         break;
+      case 'R':
+        recipientsFile = optarg;
+        break;
       case 'v':
 	std::cerr << argv[0] << gsmlib::stringPrintf(_(": version %s [compiled %s]"),
 						     VERSION, __DATE__) << std::endl;
@@ -145,8 +218,9 @@ int main(int argc, char *argv[])
       case 'h':
 	std::cerr << argv[0] << _(": [-b baudrate][-c concatenatedID]"
                              "[-C sca][-d device][-h][-I init string]\n"
-                             "  [-t][-v][-X] phonenumber [text]") << std::endl
-             << std::endl
+                             "  [-Q][-t][-v][-X] phonenumber [text]") << std::endl
+             << argv[0] << _(": [options] -R recipients file [text]")
+             << std::endl << std::endl
              << _("  -b, --baudrate    baudrate to use for device "
                   "(default: 38400)")
              << std::endl
@@ -157,7 +231,12 @@ int main(int argc, char *argv[])
                   "to") << std::endl
              << _("  -h, --help        prints this message") << std::endl
              << _("  -I, --init        device AT init sequence") << std::endl
+             << _("  -Q, --quickopen   skip reset of device if it responds")
+             << std::endl
              << _("  -r, --requeststat request SMS status report") << std::endl
+             << _("  -R, --recipients  send the SMS to all phone numbers in "
+                  "file\n"
+                  "                    (one per line)") << std::endl
              << _("  -t, --test        convert text to GSM alphabet and "
                   "vice\n"
                   "                    versa, no SMS message is sent") << std::endl
@@ -179,16 +258,16 @@ int main(int argc, char *argv[])
     if (!test)
     {
       // open the port and ME/TA
-      gsmlib::Ref<gsmlib::Port> port = new
+      gsmlib::Ref<gsmlib::Port> port =
 #ifdef WIN32
-	gsmlib::Win32SerialPort
+	new gsmlib::Win32SerialPort
 #else
-	gsmlib::UnixSerialPort
+	gsmlib::openPort
 #endif
         (device,
          baudrate == "" ? gsmlib::DEFAULT_BAUD_RATE :
          gsmlib::baudRateStrToSpeed(baudrate),
-         initString, swHandshake);
+         initString, swHandshake, fastOpen);
       // switch message service level to 1
       // this enables acknowledgement PDUs
       m = new gsmlib::MeTa(port);
@@ -198,21 +277,25 @@ int main(int argc, char *argv[])
     }
 
     // check parameters
-    if (optind == argc)
+    // (with -R the phone numbers are read from the recipients file)
+    int textIndex = optind + (recipientsFile == "" ? 1 : 0);
+    if (textIndex > argc)
       throw gsmlib::GsmException(_("phone number and text missing"), gsmlib::ParameterError);
 
-    if (optind + 2 < argc)
+    if (textIndex + 1 < argc)
       throw gsmlib::GsmException(_("more than two parameters given"), gsmlib::ParameterError);
     
     if (concatenatedMessageIdStr != "")
       concatenatedMessageId = gsmlib::checkNumber(concatenatedMessageIdStr);
 
     // get phone number
-    std::string phoneNumber = argv[optind];
+    std::string phoneNumber;
+    if (recipientsFile == "")
+      phoneNumber = argv[optind];
 
     // get text
     std::string text;
-    if (optind + 1 == argc)
+    if (textIndex == argc)
     {                           // read from stdin
       char s[1000];
       std::cin.get(s, 1000);
@@ -222,7 +305,7 @@ int main(int argc, char *argv[])
 				   gsmlib::ParameterError);
     }
     else
-      text = argv[optind + 1];
+      text = argv[textIndex];
 
     if (test)
       std::cout << gsmlib::gsmToLatin1(gsmlib::latin1ToGsm(text)) << std::endl;
@@ -237,18 +320,34 @@ int main(int argc, char *argv[])
         submitSMS->setServiceCentreAddress(sca);
       }
       submitSMS->setStatusReportRequest(requestStatusReport);
-      gsmlib::Address destAddr(phoneNumber);
-      submitSMS->setDestinationAddress(destAddr);
-      if (concatenatedMessageId == -1)
-        m->sendSMSs(submitSMS, text, true);
+      if (recipientsFile != "")
+      {
+        if (! sendToRecipients(m, submitSMS, text, concatenatedMessageId,
+                               recipientsFile))
+        {
+          gsmlib::exportMetrics(m->getMetrics());
+          return 1;
+        }
+      }
       else
-        m->sendSMSs(submitSMS, text, false, concatenatedMessageId);
+      {
+        gsmlib::Address destAddr(phoneNumber);
+        submitSMS->setDestinationAddress(destAddr);
+        if (concatenatedMessageId == -1)
+          m->sendSMSs(submitSMS, text, true);
+        else
+          m->sendSMSs(submitSMS, text, false, concatenatedMessageId);
+      }
     }
   }
   catch (gsmlib::GsmException &ge)
   {
     std::cerr << argv[0] << _("[ERROR]: ") << ge.what() << std::endl;
+    if (m != NULL)
+      gsmlib::exportMetrics(m->getMetrics());
     return 1;
   }
+  if (m != NULL)
+    gsmlib::exportMetrics(m->getMetrics());
   return 0;
 }
@@ -40,14 +40,19 @@
 #include <iostream>
 #include <gsmlib/gsm_me_ta.h>
 #include <gsmlib/gsm_event.h>
+#include <gsmlib/gsm_status_report_index.h>
+#include <gsmlib/gsm_tracing.h>
 #include <cstring>
+#include <time.h>
 
 #ifdef HAVE_GETOPT_LONG
 static struct option longOpts[] =
 {
   {"requeststat", no_argument, (int*)NULL, 'r'},
+  {"reportindex", required_argument, (int*)NULL, 'R'},
   {"direct", no_argument, (int*)NULL, 'D'},
   {"xonxoff", no_argument, (int*)NULL, 'X'},
+  {"quickopen", no_argument, (int*)NULL, 'Q'},
   {"init", required_argument, (int*)NULL, 'I'},
   {"store", required_argument, (int*)NULL, 't'},
   {"device", required_argument, (int*)NULL, 'd'},
@@ -85,6 +90,12 @@ static std::string serviceCentreAddress;
 
 static int concatenatedMessageId = -1;
 
+// index to correlate status reports with sent spool files (set with -R)
+// the device name is used as the modem name in the index
+
+static gsmlib::StatusReportIndexRef reportIndex;
+static std::string deviceName;
+
 // signal handler for terminate signal
 
 bool terminateSent = false;
@@ -115,13 +126,18 @@ std::vector<IncomingMessage> newMessages;
 
 class EventHandler : public gsmlib::GsmEvent
 {
+  bool _enableSyslog;           // report warnings to syslog
+
 public:
+  EventHandler(bool enableSyslog) : _enableSyslog(enableSyslog) {}
+
   // inherited from GsmEvent
   void SMSReception(gsmlib::SMSMessageRef newMessage,
                     gsmlib::GsmEvent::SMSMessageType messageType);
   void CBReception(gsmlib::CBMessageRef newMessage);
   void SMSReceptionIndication(std::string storeName, unsigned int index,
                               gsmlib::GsmEvent::SMSMessageType messageType);
+  void SMSStoreFull(std::string storeName, int freeEntries);
 
   virtual ~EventHandler() {}
 };
@@ -158,10 +174,24 @@ void EventHandler::SMSReceptionIndication(std::string storeName, unsigned int in
   newMessages.push_back(m);
 }
 
+void EventHandler::SMSStoreFull(std::string storeName, int freeEntries)
+{
+#ifndef WIN32
+  if (_enableSyslog)
+    syslog(LOG_WARNING, "SMS store %s is full (%d entries left)",
+           storeName.c_str(), freeEntries);
+  else
+#endif
+    std::cerr << gsmlib::stringPrintf(
+      _("[WARNING]: SMS store %s is full (%d entries left)"),
+      storeName.c_str(), freeEntries) << std::endl;
+}
+
 // execute action on std::string
 
 void doAction(std::string action, std::string result)
 {
+  gsmlib::TraceSpan span("gsmsmsd", "action");
   if (action != "")
   {
     FILE *fd = popen(action.c_str(), "w");
@@ -179,6 +209,34 @@ void doAction(std::string action, std::string result)
     std::cout << result << std::endl;
 }
 
+// look up status report in the report index and describe the outcome
+// return "" if the report does not belong to any SMS sent by us
+
+std::string resolveStatusReport(gsmlib::SMSMessageRef message,
+                                bool enableSyslog)
+{
+  if (reportIndex.isnull() || message.isnull() ||
+      message->messageType() != gsmlib::SMSMessage::SMS_STATUS_REPORT)
+    return "";
+
+  gsmlib::SMSStatusReportMessage *report =
+    dynamic_cast<gsmlib::SMSStatusReportMessage*>(message.getptr());
+  gsmlib::StatusReportIndexEntry entry;
+  if (! reportIndex->resolve(deviceName, *report, entry))
+    return "";
+
+  long latency = (long)(time(NULL) - entry._submitTime);
+#ifndef WIN32
+  if (enableSyslog)
+    syslog(LOG_NOTICE, "Status report %d for SMS to %s from file %s "
+           "after %ld seconds", report->status(), entry._recipient.c_str(),
+           entry._spoolId.c_str(), latency);
+#endif
+  return gsmlib::stringPrintf(_("Spool file: %s\n"
+                                "Latency from submit to report: %ld s\n"),
+                              entry._spoolId.c_str(), latency);
+}
+
 // send all SMS messages in spool dir
 
 bool requestStatusReport = false;
@@ -234,10 +292,13 @@ void sendSMS(std::string spoolDirBase, std::string sentDirBase, std::string fail
         // the first line is interpreted as the phone number
         // the rest is the message
 #ifdef WIN32
-        std::string filename = spoolDir + "\\" + fileInfo.name;
+        std::string spoolId = fileInfo.name;
+        std::string filename = spoolDir + "\\" + spoolId;
 #else
-        std::string filename = spoolDir + "/" + entry->d_name;
+        std::string spoolId = entry->d_name;
+        std::string filename = spoolDir + "/" + spoolId;
 #endif
+        gsmlib::TraceSpan span("gsmsmsd", "send spooled SMS", spoolId);
         std::ifstream ifs(filename.c_str());
         if (! ifs)
         {
@@ -292,17 +353,39 @@ void sendSMS(std::string spoolDirBase, std::string sentDirBase, std::string fail
         submitSMS->setStatusReportRequest(requestStatusReport);
         gsmlib::Address destAddr(phoneNumber);
         submitSMS->setDestinationAddress(destAddr);
+
+        // keep the link to the SC open while the spool dir is emptied
+        if (me->getMoreMessagesToSend() != 2)
+        {
+          try
+          {
+            me->setMoreMessagesToSend(2);
+          }
+          catch (gsmlib::GsmException &ge)
+          {
+            // ignore, the SMS can be sent without
+          }
+        }
+
         try
         {
+          std::vector<unsigned char> messageReferences;
           if (concatenatedMessageId == -1)
-            me->sendSMSs(submitSMS, text, true);
+            messageReferences = me->sendSMSs(submitSMS, text, true);
           else
           {
             // maximum for concatenatedMessageId is 255
             if (concatenatedMessageId > 256)
               concatenatedMessageId = 0;
-            me->sendSMSs(submitSMS, text, false, concatenatedMessageId++);
+            messageReferences =
+              me->sendSMSs(submitSMS, text, false, concatenatedMessageId++);
           }
+          // remember message references to match status reports
+          if (! reportIndex.isnull() && requestStatusReport)
+            for (std::vector<unsigned char>::iterator i =
+                   messageReferences.begin();
+                 i != messageReferences.end(); ++i)
+              reportIndex->add(deviceName, *i, destAddr.toString(), spoolId);
 #ifndef WIN32
           if (enableSyslog)
             syslog(LOG_NOTICE, "Sent SMS to %s from file %s", phoneBuf, filename.c_str());
@@ -381,11 +464,13 @@ int main(int argc, char *argv[])
     unsigned int priorities = 0;
     std::string initString = gsmlib::DEFAULT_INIT_STRING;
     bool swHandshake = false;
+    bool fastOpen = false;
     std::string concatenatedMessageIdStr;
+    std::string reportIndexFile;
 
     int opt;
     int dummy;
-    while((opt = getopt_long(argc, argv, "c:C:I:t:fd:a:b:hvs:S:F:P:LXDr",
+    while((opt = getopt_long(argc, argv, "c:C:I:t:fd:a:b:hvs:S:F:P:LXQDrR:",
                              longOpts, &dummy)) != -1)
       switch (opt)
       {
@@ -395,12 +480,18 @@ int main(int argc, char *argv[])
       case 'r':
         requestStatusReport = true;
         break;
+      case 'R':
+        reportIndexFile = optarg;
+        break;
       case 'D':
         onlyReceptionIndication = false;
         break;
       case 'X':
         swHandshake = true;
         break;
+      case 'Q':
+        fastOpen = true;
+        break;
       case 'I':
         initString = optarg;
         break;
@@ -453,9 +544,9 @@ int main(int argc, char *argv[])
       case 'h':
         std::cerr << argv[0] << _(": [-a action][-b baudrate][-C sca][-d device]"
                              "[-f][-F failed dir]\n"
-                             "  [-h][-I init string][-L][-P priorities]"
-                             "[-s spool dir][-S sent dir][-t]\n"
-                             "  [-v]{sms_type}")
+                             "  [-h][-I init string][-L][-P priorities][-Q]"
+                             "[-r][-R report index]\n"
+                             "  [-s spool dir][-S sent dir][-t][-v]{sms_type}")
              << std::endl << std::endl
              << _("  -a, --action      the action to execute when an SMS "
                   "arrives\n"
@@ -480,7 +571,13 @@ int main(int argc, char *argv[])
 #endif
              << _("  -P, --priorities  number of priority levels to use,") << std::endl
              << _("                    (default: none)") << std::endl
+             << _("  -Q, --quickopen   skip reset of device if it responds")
+             << std::endl
              << _("  -r, --requeststat request SMS status report") << std::endl
+             << _("  -R, --reportindex file to keep the index that matches")
+             << std::endl
+             << _("                    status reports to sent spool files")
+             << std::endl
              << _("  -s, --spool       spool directory for outgoing SMS")
              << std::endl
              << _("  -S, --sent        directory to move sent SMS to,") << std::endl
@@ -537,6 +634,9 @@ int main(int argc, char *argv[])
     // check parameters
     if (concatenatedMessageIdStr != "")
       concatenatedMessageId = gsmlib::checkNumber(concatenatedMessageIdStr);
+    deviceName = device;
+    if (reportIndexFile != "")
+      reportIndex = new gsmlib::StatusReportIndex(reportIndexFile);
 
     // register signal handler for terminate signal
 #ifndef WIN32
@@ -556,16 +656,24 @@ int main(int argc, char *argv[])
                                  gsmlib::OSError);
 
     // open GSM device
-    me = new gsmlib::MeTa(new
+    gsmlib::Ref<gsmlib::Port> port =
 #ifdef WIN32
-    gsmlib::Win32SerialPort
+    new gsmlib::Win32SerialPort
 #else
-    gsmlib::UnixSerialPort
+    gsmlib::openPort
 #endif
         (device,
          baudrate == "" ? gsmlib::DEFAULT_BAUD_RATE :
          gsmlib::baudRateStrToSpeed(baudrate), initString,
-         swHandshake));
+         swHandshake, fastOpen);
+#ifndef WIN32
+    gsmlib::UnixSerialPort *serialPort =
+      dynamic_cast<gsmlib::UnixSerialPort*>(port.getptr());
+    if (enableSyslog && serialPort != NULL)
+      syslog(LOG_NOTICE, "opened %s in %ld ms", device.c_str(),
+             serialPort->openLatency());
+#endif
+    me = new gsmlib::MeTa(port);
 
     // if flush option is given get all SMS from store and dispatch them
     if (flushSMS)
@@ -593,6 +701,7 @@ int main(int argc, char *argv[])
             break;
           }
           result += s->message()->toString();
+          result += resolveStatusReport(s->message(), enableSyslog);
           doAction(action, result);
           store->erase(s);
         }
@@ -617,7 +726,7 @@ int main(int argc, char *argv[])
                         onlyReceptionIndication);
 
     // register event handler to handle routed SMSs, CBMs, and status reports
-    me->setEventHandler(new EventHandler());
+    me->setEventHandler(new EventHandler(enableSyslog));
 
     // wait for new messages
     bool exitScheduled = false;
@@ -672,15 +781,22 @@ int main(int argc, char *argv[])
           if (messageType == gsmlib::GsmEvent::CellBroadcastSMS)
             result += (*store.getptr())[index].cbMessage()->toString();
           else
-            result += (*store.getptr())[index].message()->toString();
+          {
+            newSMSMessage = (*store.getptr())[index].message();
+            result += newSMSMessage->toString();
+          }
 
           store->erase(store->begin() + index);
         }
+        result += resolveStatusReport(newSMSMessage, enableSyslog);
 
         // call the action
         doAction(action, result);
       }
 
+      // export the metrics (see GSMLIB_METRICS)
+      gsmlib::exportMetrics(me->getMetrics());
+
       // if no new SMS came in and program exit was scheduled, then exit
       if (exitScheduled)
         exit(0);
@@ -705,7 +821,22 @@ int main(int argc, char *argv[])
 
       // send spooled SMS
       if (!terminateSent)
+      {
         sendSMS(spoolDir, sentDir, failedDir, priorities, enableSyslog, me->getAt());
+
+        // release the link to the SC kept open while sending
+        if (me->getMoreMessagesToSend() == 2)
+        {
+          try
+          {
+            me->setMoreMessagesToSend(0);
+          }
+          catch (gsmlib::GsmException &ge)
+          {
+            // ignore, the ME releases the link itself after some time
+          }
+        }
+      }
     }
   }
   catch (gsmlib::GsmException &ge)
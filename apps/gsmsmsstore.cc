@@ -37,6 +37,7 @@
 static struct option longOpts[] =
 {
   {"xonxoff", no_argument, (int*)NULL, 'X'},
+  {"quickopen", no_argument, (int*)NULL, 'Q'},
   {"init", required_argument, (int*)NULL, 'I'},
   {"store", required_argument, (int*)NULL, 't'},
   {"erase", no_argument, (int*)NULL, 'e'},
@@ -101,10 +102,25 @@ void checkNoOp(Operation operation, int opt)
 			       gsmlib::ParameterError);
 }
 
+// export metrics of the ME/TAs used (see GSMLIB_METRICS)
+
+static void exportMetrics(gsmlib::Ref<gsmlib::MeTa> sourceMeTa,
+                          gsmlib::Ref<gsmlib::MeTa> destMeTa)
+{
+  gsmlib::GsmMetrics metrics;
+  if (! sourceMeTa.isnull())
+    metrics.add(sourceMeTa->getMetrics());
+  if (! destMeTa.isnull())
+    metrics.add(destMeTa->getMetrics());
+  if (! sourceMeTa.isnull() || ! destMeTa.isnull())
+    gsmlib::exportMetrics(metrics);
+}
+
 // *** main program
 
 int main(int argc, char *argv[])
 {
+  gsmlib::Ref<gsmlib::MeTa> sourceMeTa, destMeTa;
   try
   {
     // handle command line options
@@ -117,13 +133,13 @@ int main(int argc, char *argv[])
     bool useIndices = false;    // use indices in delete, copy, backup op
     std::string initString = gsmlib::DEFAULT_INIT_STRING;
     bool swHandshake = false;
+    bool fastOpen = false;
     // service centre address (set on command line)
     std::string serviceCentreAddress;
-    gsmlib::Ref<gsmlib::MeTa> sourceMeTa, destMeTa;
 
     int opt;
     int dummy;
-    while((opt = getopt_long(argc, argv, "I:t:s:d:b:cxlakhvVXC:",
+    while((opt = getopt_long(argc, argv, "I:t:s:d:b:cxlakhvVXQC:",
                              longOpts, &dummy))
           != -1)
       switch (opt)
@@ -134,6 +150,9 @@ int main(int argc, char *argv[])
       case 'X':
         swHandshake = true;
         break;
+      case 'Q':
+        fastOpen = true;
+        break;
       case 'I':
         initString = optarg;
         break;
@@ -180,7 +199,7 @@ int main(int argc, char *argv[])
       case 'h':
 	std::cerr << argv[0] << _(": [-a][-b baudrate][-c][-C sca]"
 				  "[-d device or file]\n"
-				  "  [-h][-I init string][-k][-l]"
+				  "  [-h][-I init string][-k][-l][-Q]"
 				  "[-s device or file]"
 				  "[-t SMS store name]\n  [-v][-V][-x][-X]"
 				  "{indices}|[phonenumber text]") << std::endl
@@ -204,6 +223,8 @@ int main(int argc, char *argv[])
 		       "                    (if indices are given, "
 		       "copy only these entries)") << std::endl
 		  << _("  -l, --list        list source to stdout") << std::endl
+		  << _("  -Q, --quickopen   skip reset of device if it responds")
+		  << std::endl
 		  << _("  -s, --source      sets the source device to connect to,\n"
 		       "                    or the file to read") << std::endl
 		  << _("  -t, --store       name of SMS store to use") << std::endl
@@ -277,16 +298,16 @@ int main(int argc, char *argv[])
 	    if (storeName == "")
 	      throw gsmlib::GsmException(_("store name must be given"), gsmlib::ParameterError);
 	    
-	    sourceMeTa = new gsmlib::MeTa(new
+	    sourceMeTa = new gsmlib::MeTa(
 #ifdef WIN32
-					  gsmlib::Win32SerialPort
+					  new gsmlib::Win32SerialPort
 #else
-					  gsmlib::UnixSerialPort
+					  gsmlib::openPort
 #endif
 					  (source,
 					   baudrate == "" ? gsmlib::DEFAULT_BAUD_RATE :
 					   gsmlib::baudRateStrToSpeed(baudrate), initString,
-					   swHandshake));
+					   swHandshake, fastOpen));
 	    sourceStore = new gsmlib::SortedSMSStore(sourceMeTa->getSMSStore(storeName));
 	  }
       }
@@ -311,16 +332,16 @@ int main(int argc, char *argv[])
 	    if (storeName == "")
 	      throw gsmlib::GsmException(_("store name must be given"), gsmlib::ParameterError);
 	    
-	    destMeTa = new gsmlib::MeTa(new
+	    destMeTa = new gsmlib::MeTa(
 #ifdef WIN32
-					gsmlib::Win32SerialPort
+					new gsmlib::Win32SerialPort
 #else
-					gsmlib::UnixSerialPort
+					gsmlib::openPort
 #endif
 					(destination,
 					 baudrate == "" ? gsmlib::DEFAULT_BAUD_RATE :
 					 gsmlib::baudRateStrToSpeed(baudrate), initString,
-					 swHandshake));
+					 swHandshake, fastOpen));
 	    destStore = new gsmlib::SortedSMSStore(destMeTa->getSMSStore(storeName));      
 	  }
       }
@@ -429,7 +450,9 @@ int main(int argc, char *argv[])
   catch (gsmlib::GsmException &ge)
   {
     std::cerr << argv[0] << _("[ERROR]: ") << ge.what() << std::endl;
+    exportMetrics(sourceMeTa, destMeTa);
     return 1;
   }
+  exportMetrics(sourceMeTa, destMeTa);
   return 0;
 }
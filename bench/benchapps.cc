@@ -0,0 +1,755 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    benchapps.cc
+// *
+// * Purpose: Benchmark whole workflows of the apps against the ME/TA
+// *          simulator (gsmsim)
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include "benchmark.h"
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <getopt.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace gsmlib;
+
+// gsmsim writes the time of day modulo this many seconds into its trace
+// (with microseconds)
+const double TRACE_TIME_MODULUS = 1000000;
+
+// seconds to wait for the simulator or gsmsmsd
+const double START_TIMEOUT = 5;
+const double RECEIVE_TIMEOUT = 60;
+
+// ms the simulator takes to set up the relay link to the SC for an SMS
+// in the multipart workflows (unless +CMMS keeps the link open)
+const long LINK_SETUP_MS = 50;
+
+// most parts of a concatenated SMS
+const long MAX_PARTS = 255;
+
+// options
+static string appsDirectory = "../apps";
+static string gsmsim = "../tests/gsmsim";
+static vector<string> simOptions;
+static string directory;        // temporary directory for the files
+
+// *** running programs
+
+// time of day in seconds (gsmsim uses the same clock)
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void sleepSeconds(double seconds)
+{
+  usleep((useconds_t)(seconds * 1e6));
+}
+
+// resources used by a program that has finished
+struct Usage
+{
+  double _seconds;              // wall clock time
+  double _cpuSeconds;           // CPU time of the program (not its children)
+  long _readWriteCalls;         // read and write system calls, -1 if unknown
+};
+
+// start program with arguments, its output goes to outputFile
+static pid_t start(vector<string> arguments, string outputFile = "/dev/null")
+{
+  pid_t pid = fork();
+  if (pid == -1)
+    throw GsmException("cannot fork", OSError, errno);
+  if (pid == 0)
+  {
+    int fd = open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd != -1)
+    {
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+    }
+    vector<char*> argv;
+    for (vector<string>::iterator i = arguments.begin();
+         i != arguments.end(); ++i)
+      argv.push_back(&(*i)[0]);
+    argv.push_back(NULL);
+    execv(argv[0], &argv[0]);
+    cerr << "cannot execute " << arguments[0] << ": " << strerror(errno)
+         << endl;
+    _exit(127);
+  }
+  return pid;
+}
+
+// read a file in /proc of a process, return "" if not available
+static string procFile(pid_t pid, string name)
+{
+  ifstream ifs(("/proc/" + intToStr(pid) + "/" + name).c_str());
+  stringstream result;
+  result << ifs.rdbuf();
+  return result.str();
+}
+
+// wait until program started at startTime has finished (or kill it if
+// kill is true), throw GsmException if it failed
+static Usage finish(pid_t pid, double startTime, bool kill = false)
+{
+  if (kill)
+    ::kill(pid, SIGKILL);
+
+  // the counters in /proc remain available until the program is reaped
+  siginfo_t info;
+  while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) == -1)
+    if (errno != EINTR)
+      throw GsmException("waitid failed", OSError, errno);
+  Usage result;
+  result._seconds = now() - startTime;
+
+  // time on the CPU in nanoseconds and read and write system calls
+  string schedstat = procFile(pid, "schedstat");
+  string io = procFile(pid, "io");
+  result._readWriteCalls = -1;
+  string::size_type syscr = io.find("syscr: ");
+  string::size_type syscw = io.find("syscw: ");
+  if (syscr != string::npos && syscw != string::npos)
+    result._readWriteCalls = atol(io.c_str() + syscr + 7) +
+      atol(io.c_str() + syscw + 7);
+
+  int status;
+  struct rusage usage;
+  while (wait4(pid, &status, 0, &usage) == -1)
+    if (errno != EINTR)
+      throw GsmException("wait4 failed", OSError, errno);
+  if (schedstat != "")
+    result._cpuSeconds = atof(schedstat.c_str()) / 1e9;
+  else                          // includes the children the program waited for
+    result._cpuSeconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+  if (! kill && (! WIFEXITED(status) || WEXITSTATUS(status) != 0))
+    throw GsmException(stringPrintf("program failed (status %d)", status),
+                       OtherError);
+  return result;
+}
+
+static string app(string name)
+{
+  return appsDirectory + "/" + name;
+}
+
+// *** the simulator
+
+// one line of the trace written by gsmsim --trace
+struct TraceLine
+{
+  double _time;                 // seconds modulo TRACE_TIME_MODULUS
+  bool _sent;                   // true if sent by gsmsim
+  string _text;
+};
+
+// runs gsmsim with a PTY reachable as device()
+class Simulator
+{
+  pid_t _pid;
+  string _link;
+  string _traceFile;
+
+public:
+  Simulator(vector<string> options);
+
+  string device() const {return _link;}
+
+  // return the lines exchanged so far
+  vector<TraceLine> trace() const;
+
+  ~Simulator();
+};
+
+Simulator::Simulator(vector<string> options) :
+  _link(directory + "/sim.tty"), _traceFile(directory + "/sim.trace")
+{
+  unlink(_link.c_str());
+  vector<string> arguments;
+  arguments.push_back(gsmsim);
+  arguments.push_back("--trace");
+  arguments.push_back("--link");
+  arguments.push_back(_link);
+  arguments.insert(arguments.end(), simOptions.begin(), simOptions.end());
+  arguments.insert(arguments.end(), options.begin(), options.end());
+  _pid = start(arguments, _traceFile);
+
+  double startTime = now();
+  struct stat st;
+  while (lstat(_link.c_str(), &st) != 0)
+  {
+    int status;
+    if (waitpid(_pid, &status, WNOHANG) == _pid ||
+        now() - startTime > START_TIMEOUT)
+      throw GsmException("cannot start " + gsmsim, OtherError);
+    sleepSeconds(0.01);
+  }
+}
+
+vector<TraceLine> Simulator::trace() const
+{
+  vector<TraceLine> result;
+  ifstream ifs(_traceFile.c_str());
+  string line;
+  while (getline(ifs, line))
+  {
+    // eg. "123456.789012 --> \r\nOK\r\n"
+    TraceLine traceLine;
+    string::size_type arrow = line.find(" --> ");
+    if (arrow == string::npos)
+      arrow = line.find(" <-- ");
+    if (arrow == string::npos || arrow == 0)
+      continue;
+    traceLine._time = atof(line.substr(0, arrow).c_str());
+    traceLine._sent = line[arrow + 1] == '-';
+    traceLine._text = line.substr(arrow + 5);
+    result.push_back(traceLine);
+  }
+  return result;
+}
+
+Simulator::~Simulator()
+{
+  kill(_pid, SIGTERM);
+  waitpid(_pid, NULL, 0);
+  unlink(_link.c_str());
+  unlink(_traceFile.c_str());
+}
+
+// return milliseconds from trace time from to trace time to
+static double traceInterval(double from, double to)
+{
+  double result = fmod(to - from + TRACE_TIME_MODULUS, TRACE_TIME_MODULUS);
+  return result * 1000;
+}
+
+// *** workflows
+// the apps are started with -Q (quick open), the simulator is in a sane
+// state, so the runs do not include the reset of the device
+
+// measurements of one workflow
+struct Result
+{
+  string _name;
+  string _itemName;             // eg. "message"
+  string _latencyOf;            // latencies are per item or per "run"
+  long _items;                  // per run
+  vector<double> _runSeconds;
+  vector<double> _latencies;    // milliseconds
+  double _cpuSeconds;           // total
+  long _readWriteCalls;         // total, -1 if unknown
+
+  Result(string name, string itemName, string latencyOf, long items) :
+    _name(name), _itemName(itemName), _latencyOf(latencyOf), _items(items),
+    _cpuSeconds(0), _readWriteCalls(0) {}
+
+  void add(const Usage &usage);
+};
+
+void Result::add(const Usage &usage)
+{
+  _runSeconds.push_back(usage._seconds);
+  _cpuSeconds += usage._cpuSeconds;
+  if (usage._readWriteCalls == -1 || _readWriteCalls == -1)
+    _readWriteCalls = -1;
+  else
+    _readWriteCalls += usage._readWriteCalls;
+}
+
+// add the latency of each SMS sent to result, ie. the time from the
+// completion of the previous one (or the first AT+CMGS) to the +CMGS
+// response of the simulator, return the number of SMS sent
+static long addSendLatencies(Result &result, const Simulator &simulator)
+{
+  vector<TraceLine> trace = simulator.trace();
+  double previous = -1;
+  long sent = 0;
+  for (vector<TraceLine>::iterator i = trace.begin(); i != trace.end(); ++i)
+    if (! i->_sent && previous == -1 && i->_text.find("AT+CMGS=") == 0)
+      previous = i->_time;
+    else if (i->_sent && previous != -1 &&
+             i->_text.find("+CMGS:") != string::npos)
+    {
+      result._latencies.push_back(traceInterval(previous, i->_time));
+      previous = i->_time;
+      ++sent;
+    }
+  return sent;
+}
+
+// gsmsendsms sending one text to count recipients
+static void sendSMS(Result &result, long count)
+{
+  string recipients = directory + "/recipients";
+  ofstream ofs(recipients.c_str());
+  for (long i = 0; i < count; ++i)
+    ofs << "+49170" << 1000000 + i << endl;
+  ofs.close();
+
+  vector<string> options;
+  Simulator simulator(options);
+  vector<string> arguments;
+  arguments.push_back(app("gsmsendsms"));
+  arguments.push_back("-Q");
+  arguments.push_back("-d");
+  arguments.push_back(simulator.device());
+  arguments.push_back("-R");
+  arguments.push_back(recipients);
+  arguments.push_back("Benchmark message");
+  double startTime = now();
+  result.add(finish(start(arguments), startTime));
+
+  long sent = addSendLatencies(result, simulator);
+  unlink(recipients.c_str());
+  if (sent != count)
+    throw GsmException(stringPrintf("%ld of %ld SMS sent", sent, count),
+                       OtherError);
+}
+
+// gsmsendsms sending a concatenated SMS of parts parts, the simulator
+// needs LINK_SETUP_MS for each part unless the link is kept open with
+// +CMMS (or useCMMS is false and the simulator does not support it)
+static void sendMultipartSMS(Result &result, long parts, bool useCMMS)
+{
+  vector<string> options;
+  options.push_back("--link-setup");
+  options.push_back(intToStr(LINK_SETUP_MS));
+  if (! useCMMS)
+    options.push_back("--no-cmms");
+  Simulator simulator(options);
+
+  // 7-bit parts with the concatenation header of gsmlib hold 152
+  // characters
+  string text;
+  for (long i = 0; i < parts; ++i)
+    text += string(152, 'a' + i % 26);
+  vector<string> arguments;
+  arguments.push_back(app("gsmsendsms"));
+  arguments.push_back("-Q");
+  arguments.push_back("-d");
+  arguments.push_back(simulator.device());
+  arguments.push_back("-c");
+  arguments.push_back("1");
+  arguments.push_back("+491701000000");
+  arguments.push_back(text);
+  double startTime = now();
+  result.add(finish(start(arguments), startTime));
+
+  long sent = addSendLatencies(result, simulator);
+  if (sent != parts)
+    throw GsmException(stringPrintf("%ld of %ld parts sent", sent, parts),
+                       OtherError);
+}
+
+// gsmsmsd receiving a burst of count SMS, the latency of an SMS is the
+// time from its delivery by the simulator to the action receiving it
+static void receiveSMS(Result &result, long count)
+{
+  string fifo = directory + "/received";
+  unlink(fifo.c_str());
+  if (mkfifo(fifo.c_str(), 0600) != 0)
+    throw GsmException("cannot create FIFO " + fifo, OSError, errno);
+  // opened for writing too, so that there is no end of file between actions
+  int fd = open(fifo.c_str(), O_RDWR | O_NONBLOCK);
+  if (fd == -1)
+    throw GsmException("cannot open FIFO " + fifo, OSError, errno);
+
+  vector<string> options;
+  options.push_back("--incoming");
+  options.push_back(intToStr(count));
+  options.push_back("--interval");
+  options.push_back("0");
+  options.push_back("--sms-size");
+  options.push_back(intToStr(count < 30 ? 30 : count));
+  Simulator simulator(options);
+
+  vector<string> arguments;
+  arguments.push_back(app("gsmsmsd"));
+  arguments.push_back("-Q");
+  arguments.push_back("-d");
+  arguments.push_back(simulator.device());
+  arguments.push_back("-a");
+  arguments.push_back("cat > " + fifo);
+  double startTime = now();
+  pid_t pid = start(arguments);
+
+  // every SMS printed by the action contains "User data:" once
+  const string marker = "User data:";
+  vector<double> received;
+  string pending;
+  while ((long)received.size() < count)
+  {
+    if (now() - startTime > RECEIVE_TIMEOUT)
+    {
+      finish(pid, startTime, true);
+      close(fd);
+      unlink(fifo.c_str());
+      throw GsmException(stringPrintf("%ld of %ld SMS received",
+                                      (long)received.size(), count),
+                         OtherError);
+    }
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(fd, &fds);
+    struct timeval timeout = {0, 100000};
+    if (select(fd + 1, &fds, NULL, NULL, &timeout) <= 0)
+      continue;
+    char buffer[4096];
+    ssize_t res = read(fd, buffer, sizeof(buffer));
+    if (res <= 0)
+      continue;
+    double time = fmod(now(), TRACE_TIME_MODULUS);
+    pending.append(buffer, res);
+    string::size_type pos;
+    while ((pos = pending.find(marker)) != string::npos)
+    {
+      received.push_back(time);
+      pending.erase(0, pos + marker.length());
+    }
+    if (pending.length() > marker.length())
+      pending.erase(0, pending.length() - marker.length());
+  }
+  // gsmsmsd only terminates after its event timeout on SIGTERM
+  result.add(finish(pid, startTime, true));
+  close(fd);
+  unlink(fifo.c_str());
+
+  vector<TraceLine> trace = simulator.trace();
+  vector<double>::iterator r = received.begin();
+  for (vector<TraceLine>::iterator i = trace.begin();
+       i != trace.end() && r != received.end(); ++i)
+    if (i->_sent && i->_text.find("+CMT") != string::npos)
+      result._latencies.push_back(traceInterval(i->_time, *r++));
+  if (r != received.end())
+    throw GsmException("SMS received that were not delivered", OtherError);
+}
+
+// gsmpb copying a full phonebook of count entries to a file
+static void copyPhonebook(Result &result, long count)
+{
+  vector<string> options;
+  options.push_back("--pb-size");
+  options.push_back(intToStr(count));
+  options.push_back("--pb-used");
+  options.push_back(intToStr(count));
+  Simulator simulator(options);
+
+  string filename = directory + "/copy.pb";
+  ofstream(filename.c_str());
+  vector<string> arguments;
+  arguments.push_back(app("gsmpb"));
+  arguments.push_back("-Q");
+  arguments.push_back("-s");
+  arguments.push_back(simulator.device());
+  arguments.push_back("-p");
+  arguments.push_back("SM");
+  arguments.push_back("-d");
+  arguments.push_back(filename);
+  double startTime = now();
+  Usage usage = finish(start(arguments), startTime);
+  result.add(usage);
+  result._latencies.push_back(usage._seconds * 1000);
+  unlink(filename.c_str());
+  unlink((filename + "~").c_str());
+}
+
+// gsmsmsstore backing up a full SMS store of count messages to a file
+static void backupSMSStore(Result &result, long count)
+{
+  vector<string> options;
+  options.push_back("--sms-size");
+  options.push_back(intToStr(count));
+  options.push_back("--sms-used");
+  options.push_back(intToStr(count));
+  Simulator simulator(options);
+
+  string filename = directory + "/backup.sms";
+  ofstream(filename.c_str());
+  vector<string> arguments;
+  arguments.push_back(app("gsmsmsstore"));
+  arguments.push_back("-Q");
+  arguments.push_back("-s");
+  arguments.push_back(simulator.device());
+  arguments.push_back("-t");
+  arguments.push_back("SM");
+  arguments.push_back("-k");
+  arguments.push_back("-d");
+  arguments.push_back(filename);
+  double startTime = now();
+  Usage usage = finish(start(arguments), startTime);
+  result.add(usage);
+  result._latencies.push_back(usage._seconds * 1000);
+  unlink(filename.c_str());
+  unlink((filename + "~").c_str());
+}
+
+// *** results
+
+// return the p-quantile (0 < p <= 1) of values (nearest rank)
+static double percentile(vector<double> values, double p)
+{
+  if (values.empty())
+    return 0;
+  sort(values.begin(), values.end());
+  unsigned int rank = (unsigned int)ceil(p * values.size());
+  return values[rank == 0 ? 0 : rank - 1];
+}
+
+static void report(const Result &result)
+{
+  double seconds = percentile(result._runSeconds, 0.5);
+  long items = result._items * result._runSeconds.size();
+  cerr << "apps: " << result._name << ": "
+       << stringPrintf("%.1f", result._items / seconds) << " "
+       << result._itemName << "/s, latency p50 "
+       << stringPrintf("%.1f", percentile(result._latencies, 0.5))
+       << " ms p99 "
+       << stringPrintf("%.1f", percentile(result._latencies, 0.99))
+       << " ms (per " << result._latencyOf << "), CPU "
+       << stringPrintf("%.3f", result._cpuSeconds * 1000 / items)
+       << " ms/" << result._itemName;
+  if (result._readWriteCalls != -1)
+    cerr << ", " << stringPrintf("%.1f", (double)result._readWriteCalls / items)
+         << " read/write calls/" << result._itemName;
+  cerr << endl;
+}
+
+static void writeResults(ostream &os, const vector<Result> &results,
+                         long count, int runs)
+{
+  os << "{\"suite\":\"apps\"," << endl
+     << "\"context\":{" << jsonContext()
+     << ",\"runs\":" << runs << ",\"items\":" << count
+     << ",\"simulator_options\":\"";
+  for (vector<string>::const_iterator i = simOptions.begin();
+       i != simOptions.end(); ++i)
+    os << (i == simOptions.begin() ? "" : " ") << jsonEscape(*i);
+  os << "\"}," << endl << "\"benchmarks\":[";
+  for (vector<Result>::const_iterator i = results.begin();
+       i != results.end(); ++i)
+  {
+    double seconds = percentile(i->_runSeconds, 0.5);
+    long items = i->_items * i->_runSeconds.size();
+    os << (i == results.begin() ? "\n" : ",\n")
+       << "{\"name\":\"" << jsonEscape(i->_name)
+       << "\",\"item\":\"" << i->_itemName
+       << "\",\"items\":" << i->_items
+       << ",\"runs\":" << i->_runSeconds.size()
+       << ",\"seconds\":" << stringPrintf("%.3f", seconds)
+       << ",\"items_per_second\":"
+       << stringPrintf("%.1f", i->_items / seconds)
+       << ",\"latency_of\":\"" << i->_latencyOf
+       << "\",\"latency_p50_ms\":"
+       << stringPrintf("%.1f", percentile(i->_latencies, 0.5))
+       << ",\"latency_p99_ms\":"
+       << stringPrintf("%.1f", percentile(i->_latencies, 0.99))
+       << ",\"cpu_ms_per_item\":"
+       << stringPrintf("%.3f", i->_cpuSeconds * 1000 / items)
+       << ",\"read_write_calls_per_item\":"
+       << (i->_readWriteCalls == -1 ? string("null") :
+           stringPrintf("%.1f", (double)i->_readWriteCalls / items)) << "}";
+  }
+  os << "\n]}" << endl;
+}
+
+// *** main program
+
+static struct option longOpts[] =
+{
+  {"apps", required_argument, (int*)NULL, 'A'},
+  {"filter", required_argument, (int*)NULL, 'f'},
+  {"help", no_argument, (int*)NULL, 'h'},
+  {"items", required_argument, (int*)NULL, 'n'},
+  {"output", required_argument, (int*)NULL, 'o'},
+  {"runs", required_argument, (int*)NULL, 'r'},
+  {"gsmsim", required_argument, (int*)NULL, 'S'},
+  {"sim-options", required_argument, (int*)NULL, 's'},
+  {(char*)NULL, 0, (int*)NULL, 0}
+};
+
+static void usage(const char *name)
+{
+  cerr << name << ": [-A directory][-f substring][-h][-n items][-o file]"
+       << "[-r runs][-S gsmsim]" << endl
+       << "  [-s options]" << endl << endl
+       << "  -A, --apps        directory of the apps (default: ../apps)"
+       << endl
+       << "  -f, --filter      run only workflows whose name contains"
+       << " substring" << endl
+       << "  -h, --help        prints this message" << endl
+       << "  -n, --items       SMS, phonebook entries, or messages per run"
+       << " (default: 100)" << endl
+       << "  -o, --output      write JSON results to file"
+       << " (default: stdout)" << endl
+       << "  -r, --runs        runs of each workflow (default: 3)" << endl
+       << "  -S, --gsmsim      simulator program"
+       << " (default: ../tests/gsmsim)" << endl
+       << "  -s, --sim-options options for the simulator, eg."
+       << " \"--latency 20\"" << endl << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  int exitCode = 1;
+  try
+  {
+    long count = 100;
+    int runs = 3;
+    string filter, output;
+    int opt;
+    int dummy;
+    while ((opt = getopt_long(argc, argv, "A:f:hn:o:r:S:s:", longOpts,
+                              &dummy)) != -1)
+      switch (opt)
+      {
+      case 'A':
+        appsDirectory = optarg;
+        break;
+      case 'f':
+        filter = optarg;
+        break;
+      case 'n':
+        count = checkNumber(optarg);
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      case 'r':
+        runs = checkNumber(optarg);
+        break;
+      case 'S':
+        gsmsim = optarg;
+        break;
+      case 's':
+      {
+        istringstream options(optarg);
+        string option;
+        while (options >> option)
+          simOptions.push_back(option);
+        break;
+      }
+      case 'h':
+        usage(argv[0]);
+        return 0;
+      case '?':
+        usage(argv[0]);
+        return 1;
+      }
+    if (count < 1 || runs < 1)
+      throw GsmException("at least one item and run needed", ParameterError);
+
+    // gsmsmsd would otherwise stop when a pipe to the action breaks
+    signal(SIGPIPE, SIG_IGN);
+    directory = temporaryDirectory();
+    vector<Result> results;
+    try
+    {
+      if (string("gsmsendsms").find(filter) != string::npos)
+      {
+        Result result("gsmsendsms", "message", "message", count);
+        for (int r = 0; r < runs; ++r)
+          sendSMS(result, count);
+        report(result);
+        results.push_back(result);
+      }
+      // per-part latency of a concatenated SMS with and without +CMMS
+      long parts = min(count, MAX_PARTS);
+      if (string("gsmsendsms/multipart").find(filter) != string::npos)
+      {
+        Result result("gsmsendsms/multipart", "part", "part", parts);
+        for (int r = 0; r < runs; ++r)
+          sendMultipartSMS(result, parts, true);
+        report(result);
+        results.push_back(result);
+      }
+      if (string("gsmsendsms/multipart/no-cmms").find(filter) !=
+          string::npos)
+      {
+        Result result("gsmsendsms/multipart/no-cmms", "part", "part", parts);
+        for (int r = 0; r < runs; ++r)
+          sendMultipartSMS(result, parts, false);
+        report(result);
+        results.push_back(result);
+      }
+      if (string("gsmsmsd").find(filter) != string::npos)
+      {
+        Result result("gsmsmsd", "message", "message", count);
+        for (int r = 0; r < runs; ++r)
+          receiveSMS(result, count);
+        report(result);
+        results.push_back(result);
+      }
+      if (string("gsmpb").find(filter) != string::npos)
+      {
+        Result result("gsmpb", "entry", "run", count);
+        for (int r = 0; r < runs; ++r)
+          copyPhonebook(result, count);
+        report(result);
+        results.push_back(result);
+      }
+      if (string("gsmsmsstore").find(filter) != string::npos)
+      {
+        Result result("gsmsmsstore", "message", "run", count);
+        for (int r = 0; r < runs; ++r)
+          backupSMSStore(result, count);
+        report(result);
+        results.push_back(result);
+      }
+
+      if (output == "")
+        writeResults(cout, results, count, runs);
+      else
+      {
+        ofstream ofs(output.c_str());
+        writeResults(ofs, results, count, runs);
+        if (! ofs)
+          throw GsmException("error writing to file '" + output + "'",
+                             OSError);
+      }
+      exitCode = 0;
+    }
+    catch (GsmException &ge)
+    {
+      cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+    }
+    rmdir(directory.c_str());
+  }
+  catch (GsmException &ge)
+  {
+    cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+  }
+  return exitCode;
+}
@@ -0,0 +1,200 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    benchchat.cc
+// *
+// * Purpose: Benchmark GsmAt::chat() and chatv() against a port that
+// *          answers from memory
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include "benchmark.h"
+#include <gsmlib/gsm_at.h>
+#include <gsmlib/gsm_event.h>
+#include <gsmlib/gsm_me_ta.h>
+#include <gsmlib/gsm_port.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace gsmlib;
+
+// *** port
+
+// ScriptedPort answers each line written with the lines given to
+// respond(), or with "OK" for unknown commands. Every answer starts with
+// the empty line that GsmAt::putLine() removes.
+class ScriptedPort : public Port
+{
+private:
+  map<string, vector<string> > _responses;
+  vector<string> _ok;
+  const vector<string> *_pending; // answer to the last line written
+  unsigned int _next;           // next line of _pending
+
+public:
+  ScriptedPort() : _pending(NULL), _next(0)
+    {
+      _ok.push_back("");
+      _ok.push_back("OK");
+    }
+
+  // answer line with lines separated by '\n'
+  void respond(string line, string lines);
+
+  // inherited from Port
+  string getLine();
+  void putLine(string line, bool carriageReturn = true);
+  bool wait(GsmTime timeout) {return true;}
+  void putBack(unsigned char c) {}
+  int readByte() {return -1;}
+  void setTimeOut(unsigned int timeout) {}
+};
+
+void ScriptedPort::respond(string line, string lines)
+{
+  vector<string> &response = _responses[line];
+  response.clear();
+  response.push_back("");
+  string::size_type start = 0, end;
+  while ((end = lines.find('\n', start)) != string::npos)
+  {
+    response.push_back(lines.substr(start, end - start));
+    start = end + 1;
+  }
+  response.push_back(lines.substr(start));
+}
+
+string ScriptedPort::getLine()
+{
+  if (_pending == NULL || _next == _pending->size())
+    throw GsmException("no more lines to answer", OtherError);
+  return (*_pending)[_next++];
+}
+
+void ScriptedPort::putLine(string line, bool carriageReturn)
+{
+  map<string, vector<string> >::const_iterator i = _responses.find(line);
+  _pending = i == _responses.end() ? &_ok : &i->second;
+  _next = 0;
+}
+
+// *** operations
+
+struct Chat
+{
+  GsmAt &_at;
+  string _command, _response;
+  Chat(GsmAt &at, string command, string response) :
+    _at(at), _command(command), _response(response) {}
+  void operator()()
+    {
+      string result = _at.chat(_command, _response);
+      keep(result);
+    }
+};
+
+struct ChatPdu
+{
+  GsmAt &_at;
+  string _command, _response;
+  ChatPdu(GsmAt &at, string command, string response) :
+    _at(at), _command(command), _response(response) {}
+  void operator()()
+    {
+      string pdu;
+      string result = _at.chat(_command, _response, pdu);
+      keep(result);
+      keep(pdu);
+    }
+};
+
+struct ChatV
+{
+  GsmAt &_at;
+  string _command, _response;
+  ChatV(GsmAt &at, string command, string response) :
+    _at(at), _command(command), _response(response) {}
+  void operator()()
+    {
+      vector<string> result = _at.chatv(_command, _response);
+      keep(result);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    Benchmarks benchmarks("chat", argc, argv);
+
+    // answers for MeTa::init(), everything else gets "OK"
+    ScriptedPort *port = new ScriptedPort();
+    port->respond("AT+GMM", "+GMM: Modem simulator\n\nOK");
+    port->respond("AT+CGMI", "gsmlib\n\nOK");
+    port->respond("AT+CGMM", "Modem simulator\n\nOK");
+    port->respond("AT+CGMR", "1.11\n\nOK");
+    port->respond("AT+CGSN", "000000000000001\n\nOK");
+    port->respond("AT+CSMS?", "+CSMS: 0,1,1,1\n\nOK");
+    port->respond("AT+CMMS=?", "+CMMS: (0-2)\n\nOK");
+    port->respond("AT+CSCS?", "+CSCS: \"GSM\"\n\nOK");
+
+    // answers for the benchmarks
+    port->respond("AT+CSQ", "+CSQ: 20,99\n\nOK");
+    port->respond("AT+CPBS?", "AT+CPBS?\n+CPBS: \"SM\",12,250\n\nOK");
+    port->respond("AT+CMGF=0", "+CMGF: 0\n\nOK");
+    port->respond("AT+CPBR=1", "+CPBR: 1,\"+491701234567\",145,"
+                  "\"Hofmann, Peter\"\n\nOK");
+    port->respond("AT+CMGR=1", "+CMGR: 1,,159\n"
+                  "079194710167120004038571F1390099406180904480A0D416"
+                  "31067296EF7390383D07CD622E58CD95CB81D6EF39BDEC66BF"
+                  "E7207A794E2FBB4320AFB82C07E56020A8FC7D9687DBED3228"
+                  "5C9F83A06F769A9E5EB340D7B49C3E1FA3C3663A0B24E4CBE7"
+                  "6516680A7FCBE920725A5E5ED341F0B21C346D4E41E1BA790E"
+                  "4286DDE4BC0BD42CA3E5207258EE1797E5A0BA9B5E9683C865"
+                  "39685997EBEF61341B249BC966\n\nOK");
+    port->respond("AT+CREG?", "+CMTI: \"SM\",1\n+CREG: 0,1\n\nOK");
+    port->respond("AT+CPBR=1,5",
+                  "+CPBR: 1,\"+491701234567\",145,\"Hofmann, Peter\"\n"
+                  "+CPBR: 2,\"+491707654321\",145,\"Meier, Anna\"\n"
+                  "+CPBR: 3,\"0301234567\",129,\"Office\"\n"
+                  "+CPBR: 4,\"112\",129,\"Emergency\"\n"
+                  "+CPBR: 5,\"+4930987654\",145,\"Home\"\n\nOK");
+
+    MeTa meTa((Ref<Port>)port);
+    GsmAt &at = *meTa.getAt().getptr();
+
+    // short lines fit into the strings without allocating
+    benchmarks.run("chat/OK", Chat(at, "E0", ""));
+    benchmarks.run("chat/+CSQ", Chat(at, "+CSQ", "+CSQ:"));
+    benchmarks.run("chat/echo/+CPBS?", Chat(at, "+CPBS?", "+CPBS:"));
+    benchmarks.run("chat/confirmation/+CMGF=0", Chat(at, "+CMGF=0", ""));
+
+    // the port returns copies of long lines, which allocates
+    benchmarks.run("chat/+CPBR=1", Chat(at, "+CPBR=1", "+CPBR:"));
+    benchmarks.run("chat/pdu/+CMGR=1", ChatPdu(at, "+CMGR=1", "+CMGR:"));
+    benchmarks.run("chatv/+CPBR=1,5", ChatV(at, "+CPBR=1,5", "+CPBR:"));
+
+    // every line is checked for unsolicited result codes
+    GsmEvent events;
+    at.setEventHandler(&events);
+    benchmarks.run("chat/events/+CSQ", Chat(at, "+CSQ", "+CSQ:"));
+    benchmarks.run("chat/events/+CPBR=1", Chat(at, "+CPBR=1", "+CPBR:"));
+    benchmarks.run("chat/events/+CMTI/+CREG?", Chat(at, "+CREG?", "+CREG:"));
+    at.setEventHandler(NULL);
+
+    return benchmarks.finish();
+  }
+  catch (GsmException &ge)
+  {
+    cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,220 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    benchcodec.cc
+// *
+// * Purpose: Benchmark SMS TPDU coding and the character set and hex
+// *          conversions
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include "benchmark.h"
+#include <gsmlib/gsm_sms.h>
+#include <gsmlib/gsm_sms_codec.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <string.h>
+
+using namespace std;
+using namespace gsmlib;
+
+// *** operations
+
+struct Decode
+{
+  string _pdu;
+  bool _scToMe;
+  Decode(string pdu, bool scToMe) : _pdu(pdu), _scToMe(scToMe) {}
+  void operator()()
+    {
+      SMSMessageRef sms = SMSMessage::decode(_pdu, _scToMe);
+      keep(sms);
+    }
+};
+
+struct Encode
+{
+  SMSMessageRef _sms;
+  Encode(SMSMessage *sms) : _sms(sms) {}
+  void operator()()
+    {
+      string pdu = _sms->encode();
+      keep(pdu);
+    }
+};
+
+struct GetString
+{
+  string _pdu;
+  unsigned short _length;
+  GetString(string pdu, unsigned short length) :
+    _pdu(pdu), _length(length) {}
+  void operator()()
+    {
+      SMSDecoder d(_pdu);
+      d.markSeptet();
+      string s = d.getString(_length);
+      keep(s);
+    }
+};
+
+struct HexToBuf
+{
+  string _hex;
+  unsigned char _buf[140];
+  HexToBuf(string hex) : _hex(hex) {}
+  void operator()()
+    {
+      hexToBuf(_hex, _buf);
+      keep(_buf);
+    }
+};
+
+struct BufToHex
+{
+  unsigned char _buf[140];
+  BufToHex(const unsigned char *buf) {memcpy(_buf, buf, sizeof(_buf));}
+  void operator()()
+    {
+      string hex = bufToHex(_buf, sizeof(_buf));
+      keep(hex);
+    }
+};
+
+struct GsmToLatin1
+{
+  string _s;
+  GsmToLatin1(string s) : _s(s) {}
+  void operator()()
+    {
+      string latin1 = gsmToLatin1(_s);
+      keep(latin1);
+    }
+};
+
+struct Latin1ToGsm
+{
+  string _s;
+  Latin1ToGsm(string s) : _s(s) {}
+  void operator()()
+    {
+      string gsm = latin1ToGsm(_s);
+      keep(gsm);
+    }
+};
+
+// *** messages
+
+// text of length characters with some characters outside of ASCII
+static string text(unsigned int length)
+{
+  string pattern = "Meeting moved to 10:30 @ room 4, "
+    "bring the \344\366\374 forms & 5\243! ";
+  string result;
+  while (result.length() < length)
+    result += pattern;
+  return result.substr(0, length);
+}
+
+// 70 UCS2 characters
+static string ucs2Text()
+{
+  string result;
+  for (int i = 0; i < 70; ++i)
+  {
+    result += (char)0x04;       // Cyrillic
+    result += (char)(0x10 + i % 32);
+  }
+  return result;
+}
+
+static SMSMessageRef deliver(unsigned char alphabet, string userData)
+{
+  SMSDeliverMessage *sms = new SMSDeliverMessage();
+  Address sca("+491710760000");
+  sms->setServiceCentreAddress(sca);
+  Address originator("+491701234567");
+  sms->setOriginatingAddress(originator);
+  Timestamp timestamp;
+  timestamp._year = 26;
+  timestamp._month = 10;
+  timestamp._day = 19;
+  timestamp._hour = 12;
+  timestamp._minute = 30;
+  timestamp._timeZoneMinutes = 120;
+  sms->setServiceCentreTimestamp(timestamp);
+  sms->setDataCodingScheme(DataCodingScheme(alphabet));
+  sms->setUserData(userData);
+  return sms;
+}
+
+static Ref<SMSSubmitMessage> submit(unsigned char alphabet, string userData)
+{
+  Ref<SMSSubmitMessage> sms = new SMSSubmitMessage();
+  Address sca("+491710760000");
+  sms->setServiceCentreAddress(sca);
+  Address destination("+491707654321");
+  sms->setDestinationAddress(destination);
+  sms->setDataCodingScheme(DataCodingScheme(alphabet));
+  sms->setUserData(userData);
+  return sms;
+}
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    Benchmarks benchmarks("codec", argc, argv);
+
+    // a message I have received
+    benchmarks.run("decode/deliver/7bit", Decode("079194710167120004038571F1390099406180904480A0D41631067296EF7390383D07CD622E58CD95CB81D6EF39BDEC66BFE7207A794E2FBB4320AFB82C07E56020A8FC7D9687DBED32285C9F83A06F769A9E5EB340D7B49C3E1FA3C3663A0B24E4CBE76516680A7FCBE920725A5E5ED341F0B21C346D4E41E1BA790E4286DDE4BC0BD42CA3E5207258EE1797E5A0BA9B5E9683C86539685997EBEF61341B249BC966", true));
+    benchmarks.run("decode/deliver/8bit",
+                   Decode(deliver(DCS_EIGHT_BIT_ALPHABET,
+                                  text(140))->encode(), true));
+    benchmarks.run("decode/deliver/ucs2",
+                   Decode(deliver(DCS_SIXTEEN_BIT_ALPHABET,
+                                  ucs2Text())->encode(), true));
+
+    // first part of a concatenated SMS, has a user data header
+    Ref<SMSSubmitMessage> concatenated =
+      splitSMSText(submit(DCS_DEFAULT_ALPHABET, ""), text(300), false, 42)[0];
+    benchmarks.run("decode/submit/7bit+udh",
+                   Decode(concatenated->encode(), false));
+    benchmarks.run("decode/status-report",
+                   Decode(SMSMessageRef(new SMSStatusReportMessage())->encode(),
+                          true));
+
+    benchmarks.run("encode/deliver/7bit",
+                   Encode(deliver(DCS_DEFAULT_ALPHABET, text(160)).getptr()));
+    benchmarks.run("encode/submit/7bit",
+                   Encode(submit(DCS_DEFAULT_ALPHABET, text(160)).getptr()));
+    benchmarks.run("encode/submit/8bit",
+                   Encode(submit(DCS_EIGHT_BIT_ALPHABET, text(140)).getptr()));
+    benchmarks.run("encode/submit/ucs2",
+                   Encode(submit(DCS_SIXTEEN_BIT_ALPHABET,
+                                 ucs2Text()).getptr()));
+    benchmarks.run("encode/submit/7bit+udh", Encode(concatenated.getptr()));
+
+    // 160 septets packed into 140 octets
+    unsigned char octets[140];
+    for (unsigned int i = 0; i < sizeof(octets); ++i)
+      octets[i] = (unsigned char)(i * 37 + 11);
+    string hex = bufToHex(octets, sizeof(octets));
+    benchmarks.run("SMSDecoder::getString/160", GetString(hex, 160));
+    benchmarks.run("hexToBuf/140", HexToBuf(hex));
+    benchmarks.run("bufToHex/140", BufToHex(octets));
+
+    benchmarks.run("gsmToLatin1/160", GsmToLatin1(latin1ToGsm(text(160))));
+    benchmarks.run("latin1ToGsm/160", Latin1ToGsm(text(160)));
+    return benchmarks.finish();
+  }
+  catch (GsmException &ge)
+  {
+    cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,255 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    benchmark.cc
+// *
+// * Purpose: Run microbenchmarks and write the results as JSON
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include "benchmark.h"
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <new>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace gsmlib;
+
+#ifndef VERSION
+#define VERSION "unknown"
+#endif
+
+static struct option longOpts[] =
+{
+  {"filter", required_argument, (int*)NULL, 'f'},
+  {"help", no_argument, (int*)NULL, 'h'},
+  {"max-entries", required_argument, (int*)NULL, 'n'},
+  {"output", required_argument, (int*)NULL, 'o'},
+  {"repetitions", required_argument, (int*)NULL, 'r'},
+  {"min-time", required_argument, (int*)NULL, 't'},
+  {(char*)NULL, 0, (int*)NULL, 0}
+};
+
+static double median(vector<double> values)
+{
+  sort(values.begin(), values.end());
+  unsigned int n = values.size();
+  return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+string jsonEscape(const string &s)
+{
+  string result;
+  for (string::const_iterator i = s.begin(); i != s.end(); ++i)
+    if (*i == '"' || *i == '\\')
+      result += string("\\") + *i;
+    else if ((unsigned char)*i < 0x20)
+      result += stringPrintf("\\u%04x", (unsigned char)*i);
+    else
+      result += *i;
+  return result;
+}
+
+string jsonContext()
+{
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+  char date[32];
+  time_t now = ::time(NULL);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+  return string("\"date\":\"") + date + "\",\"host\":\"" + jsonEscape(host) +
+    "\",\"version\":\"" + jsonEscape(VERSION) + "\"";
+}
+
+string temporaryDirectory()
+{
+  const char *tmpdir = getenv("TMPDIR");
+  string result = string(tmpdir != NULL && *tmpdir != 0 ? tmpdir : "/tmp") +
+    "/gsmbenchXXXXXX";
+  if (mkdtemp(&result[0]) == NULL)
+    throw GsmException("cannot create directory '" + result + "'",
+                       OSError, errno);
+  return result;
+}
+
+// count all allocations of the program, the benchmarks run in one thread
+static unsigned long allocations = 0;
+
+void *operator new(size_t size)
+{
+  ++allocations;
+  void *result = malloc(size == 0 ? 1 : size);
+  if (result == NULL)
+    throw std::bad_alloc();
+  return result;
+}
+
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  free(p);
+}
+
+unsigned long benchmarkAllocations()
+{
+  return allocations;
+}
+
+double benchmarkClock()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Benchmarks members
+
+Benchmarks::Benchmarks(string suite, int argc, char *argv[]) :
+  _suite(suite), _minTime(0.5), _repetitions(5), _maxEntries(1000000)
+{
+  int opt;
+  int dummy;
+  while ((opt = getopt_long(argc, argv, "f:hn:o:r:t:", longOpts, &dummy))
+         != -1)
+    switch (opt)
+    {
+    case 'f':
+      _filter = optarg;
+      break;
+    case 'n':
+      _maxEntries = checkNumber(optarg);
+      break;
+    case 'o':
+      _output = optarg;
+      break;
+    case 'r':
+      _repetitions = checkNumber(optarg);
+      if (_repetitions < 1)
+        throw GsmException("at least one repetition needed", ParameterError);
+      break;
+    case 't':
+      _minTime = atof(optarg);
+      break;
+    case 'h':
+    case '?':
+      cerr << argv[0] << ": [-f substring][-h][-n entries][-o file]"
+           << "[-r repetitions][-t seconds]" << endl << endl
+           << "  -f, --filter      run only benchmarks whose name contains"
+           << " substring" << endl
+           << "  -h, --help        prints this message" << endl
+           << "  -n, --max-entries largest store to benchmark"
+           << " (default: 1000000)" << endl
+           << "  -o, --output      write JSON results to file"
+           << " (default: stdout)" << endl
+           << "  -r, --repetitions measurements per benchmark (default: 5)"
+           << endl
+           << "  -t, --min-time    seconds to measure each benchmark"
+           << " (default: 0.5)" << endl << endl;
+      exit(opt == 'h' ? 0 : 1);
+    }
+}
+
+unsigned long Benchmarks::nextIterations(unsigned long iterations,
+                                         double seconds, double target)
+{
+  // aim a bit higher than the target, grow at most tenfold per step
+  double factor = seconds > 0 ? 1.4 * target / seconds : 10;
+  if (factor > 10)
+    factor = 10;
+  unsigned long result = (unsigned long)(iterations * factor);
+  return result > iterations ? result : iterations + 1;
+}
+
+void Benchmarks::report(const Result &result)
+{
+  _results.push_back(result);
+  cerr << _suite << ": " << result._name;
+  if (result._size != 0)
+    cerr << " (" << result._size << " entries)";
+  cerr << ": " << stringPrintf("%.1f", median(result._nsPerOp))
+       << " ns/op, " << stringPrintf("%.2f", result._allocationsPerOp)
+       << " allocations/op" << endl;
+}
+
+bool Benchmarks::selected(string name) const
+{
+  return name.find(_filter) != string::npos;
+}
+
+vector<long> Benchmarks::sizes() const
+{
+  vector<long> result;
+  for (long size = 1000; size <= _maxEntries; size *= 10)
+    result.push_back(size);
+  return result;
+}
+
+int Benchmarks::finish()
+{
+  ofstream ofs;
+  if (_output != "")
+  {
+    ofs.open(_output.c_str());
+    if (! ofs)
+    {
+      cerr << _suite << ": cannot open file '" << _output << "'" << endl;
+      return 1;
+    }
+  }
+  ostream &os = _output == "" ? cout : ofs;
+
+  os << "{\"suite\":\"" << jsonEscape(_suite) << "\"," << endl
+     << "\"context\":{" << jsonContext()
+     << ",\"min_time\":" << _minTime
+     << ",\"repetitions\":" << _repetitions << "}," << endl
+     << "\"benchmarks\":[";
+  for (vector<Result>::iterator i = _results.begin(); i != _results.end();
+       ++i)
+  {
+    double ns = median(i->_nsPerOp);
+    os << (i == _results.begin() ? "\n" : ",\n")
+       << "{\"name\":\"" << jsonEscape(i->_name)
+       << "\",\"size\":" << i->_size
+       << ",\"iterations\":" << i->_iterations
+       << ",\"repetitions\":" << i->_nsPerOp.size()
+       << ",\"ns_per_op\":" << stringPrintf("%.1f", ns)
+       << ",\"ns_min\":" << stringPrintf("%.1f", *min_element(
+                                          i->_nsPerOp.begin(),
+                                          i->_nsPerOp.end()))
+       << ",\"ns_max\":" << stringPrintf("%.1f", *max_element(
+                                          i->_nsPerOp.begin(),
+                                          i->_nsPerOp.end()))
+       << ",\"ops_per_second\":" << stringPrintf("%.1f", 1e9 / ns)
+       << ",\"allocations_per_op\":"
+       << stringPrintf("%.2f", i->_allocationsPerOp) << "}";
+  }
+  os << "\n]}" << endl;
+  if (! os)
+  {
+    cerr << _suite << ": error writing results" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    benchmark.h
+// *
+// * Purpose: Run microbenchmarks and write the results as JSON
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+// keep the compiler from optimizing away the computation of value
+template <class T> inline void keep(const T &value)
+{
+#ifdef __GNUC__
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static const void * volatile sink;
+  sink = &value;
+#endif
+}
+
+// return monotonic time in seconds
+extern double benchmarkClock();
+
+// return number of calls of operator new so far (benchmark.cc replaces
+// the global operator new of the benchmark programs to count them)
+extern unsigned long benchmarkAllocations();
+
+// return s escaped for use in a JSON string
+extern std::string jsonEscape(const std::string &s);
+
+// return the members of the "context" object written with the results
+// (date, host, and gsmlib version)
+extern std::string jsonContext();
+
+// create a directory for temporary files in $TMPDIR or /tmp, return its
+// name, throws GsmException on errors
+extern std::string temporaryDirectory();
+
+// A benchmark program creates one Benchmarks object with its command
+// line and calls run() for each operation. run() repeats the operation
+// until a repetition takes long enough to be measured reliably, then
+// measures it a number of times and reports the median.
+// finish() writes all results as JSON (to stdout or the --output file),
+// progress is reported on stderr.
+class Benchmarks
+{
+private:
+  struct Result
+  {
+    std::string _name;
+    long _size;                 // entries in the store, 0 if not applicable
+    unsigned long _iterations;  // calls per repetition
+    std::vector<double> _nsPerOp; // one value per repetition
+    double _allocationsPerOp;   // calls of operator new
+  };
+
+  std::string _suite;           // name of the program's suite, eg. "codec"
+  std::string _filter;          // run only benchmarks containing this
+  std::string _output;          // JSON file, "" for stdout
+  double _minTime;              // seconds of measuring per benchmark
+  int _repetitions;
+  long _maxEntries;             // largest store size to benchmark
+  std::vector<Result> _results;
+
+  // time iterations calls of op, return seconds
+  template <class Op> static double time(Op &op, unsigned long iterations)
+    {
+      double start = benchmarkClock();
+      for (unsigned long i = 0; i < iterations; ++i)
+        op();
+      return benchmarkClock() - start;
+    }
+
+  // return number of iterations so that a repetition takes target seconds
+  static unsigned long nextIterations(unsigned long iterations,
+                                      double seconds, double target);
+
+  void report(const Result &result);
+
+public:
+  // parse options (-h prints them), throws GsmException on errors
+  Benchmarks(std::string suite, int argc, char *argv[]);
+
+  // return true if the benchmark name was selected on the command line
+  bool selected(std::string name) const;
+
+  // return the store sizes to benchmark: 1000, 10000, ... up to
+  // --max-entries
+  std::vector<long> sizes() const;
+
+  // measure calls of op(), a functor or lambda taking no arguments
+  // size is reported with the result (eg. number of entries in a store)
+  template <class Op> void run(std::string name, Op op, long size = 0)
+    {
+      if (! selected(name))
+        return;
+      Result result;
+      result._name = name;
+      result._size = size;
+
+      // the calibration runs also warm up caches and allocators
+      double target = _minTime / _repetitions;
+      unsigned long iterations = 1;
+      double seconds = time(op, iterations);
+      double firstCall = seconds;
+      while (seconds < target)
+      {
+        iterations = nextIterations(iterations, seconds, target);
+        seconds = time(op, iterations);
+      }
+      result._iterations = iterations;
+
+      // operations taking longer than the minimum time are measured
+      // fewer times to keep the run time reasonable
+      int repetitions = _repetitions;
+      if (firstCall > _minTime && repetitions > 3)
+        repetitions = 3;
+      result._nsPerOp.reserve(repetitions);
+      unsigned long allocations = benchmarkAllocations();
+      for (int r = 0; r < repetitions; ++r)
+        result._nsPerOp.push_back(time(op, iterations) * 1e9 / iterations);
+      result._allocationsPerOp =
+        (double)(benchmarkAllocations() - allocations) /
+        ((double)iterations * repetitions);
+      report(result);
+    }
+
+  // write results, return exit code for main()
+  int finish();
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,197 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    benchparser.cc
+// *
+// * Purpose: Benchmark parsing the responses of the ME/TA
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include "benchmark.h"
+#include <gsmlib/gsm_parser.h>
+#include <gsmlib/gsm_me_ta.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+
+using namespace std;
+using namespace gsmlib;
+
+// *** operations, each parses a response as MeTa or Phonebook do
+
+// list of string lists, eg. "+CPMS=?"
+struct StringLists
+{
+  string _response;
+  StringLists(string response) : _response(response) {}
+  void operator()()
+    {
+      Parser p(_response);
+      do
+      {
+        vector<string> strings = p.parseStringList();
+        keep(strings);
+      }
+      while (p.parseComma(true));
+    }
+};
+
+// same as above, without copying the strings
+struct StringViewLists
+{
+  string _response;
+  StringViewLists(string response) : _response(response) {}
+  void operator()()
+    {
+      Parser p((StringView)_response);
+      do
+      {
+        vector<StringView> strings = p.parseStringViewList();
+        keep(strings);
+      }
+      while (p.parseComma(true));
+    }
+};
+
+// list of integer lists, eg. "+CNMI=?"
+struct IntLists
+{
+  string _response;
+  IntLists(string response) : _response(response) {}
+  void operator()()
+    {
+      Parser p(_response);
+      do
+      {
+        vector<bool> ints = p.parseIntList();
+        keep(ints);
+      }
+      while (p.parseComma(true));
+    }
+};
+
+// same as above, as ranges
+struct IntRanges
+{
+  string _response;
+  IntRanges(string response) : _response(response) {}
+  void operator()()
+    {
+      Parser p((StringView)_response);
+      do
+      {
+        IntList ints = p.parseIntRanges();
+        keep(ints);
+      }
+      while (p.parseComma(true));
+    }
+};
+
+// "+CPBR=?" (Phonebook::Phonebook())
+struct PhonebookInfo
+{
+  string _response;
+  PhonebookInfo(string response) : _response(response) {}
+  void operator()()
+    {
+      Parser p(_response);
+      IntList availablePositions = p.parseIntRanges();
+      p.parseComma();
+      int maxNumberLength = p.parseInt();
+      p.parseComma();
+      int maxTextLength = p.parseInt();
+      keep(availablePositions);
+      keep(maxNumberLength);
+      keep(maxTextLength);
+    }
+};
+
+// "+COPS=?" (MeTa::getAvailableOPInfo()), the operators are followed by
+// the lists of supported modes and formats
+struct Operators
+{
+  string _response;
+  Operators(string response) : _response(response) {}
+  void operator()()
+    {
+      Parser p(_response);
+      vector<OPInfo> result;
+      while (1)
+      {
+        OPInfo opi;
+        bool expectClosingParenthesis = p.parseChar('(', true);
+        int status = p.parseInt(true);
+        opi._status = (status == NOT_SET ? UnknownOPStatus : (OPStatus)status);
+        p.parseComma();
+        opi._longName = p.parseString(true);
+        p.parseComma();
+        opi._shortName = p.parseString(true);
+        p.parseComma();
+        try
+        {
+          opi._numericName = p.parseInt(true);
+        }
+        catch (GsmException &e)
+        {
+          // the numeric ID given as string, as in the response below
+          opi._numericName = checkNumber(p.parseString());
+        }
+        if (expectClosingParenthesis) p.parseChar(')');
+        result.push_back(opi);
+        if (! p.parseComma(true)) break;
+        // two commas ",," mean the list is finished
+        if (p.getEol() == "" || p.parseComma(true)) break;
+      }
+      vector<bool> modes = p.parseIntList();
+      p.parseComma();
+      vector<bool> formats = p.parseIntList();
+      keep(result);
+      keep(modes);
+      keep(formats);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    Benchmarks benchmarks("parser", argc, argv);
+
+    // responses without the "+XXXX:" prefix as returned by GsmAt::chat()
+    benchmarks.run("parseStringList/+CPBS=?", StringLists(
+                     "(\"FD\",\"LD\",\"ME\",\"MT\",\"SM\",\"DC\",\"EN\","
+                     "\"MC\",\"RC\",\"ON\")"));
+    benchmarks.run("parseStringList/+CPMS=?", StringLists(
+                     "(\"ME\",\"SM\",\"MT\"),(\"ME\",\"SM\",\"MT\"),"
+                     "(\"ME\",\"SM\",\"MT\")"));
+    benchmarks.run("parseStringList/+CSCS=?", StringLists(
+                     "(\"GSM\",\"IRA\",\"8859-1\",\"PCCP437\",\"UCS2\")"));
+    benchmarks.run("parseStringViewList/+CPBS=?", StringViewLists(
+                     "(\"FD\",\"LD\",\"ME\",\"MT\",\"SM\",\"DC\",\"EN\","
+                     "\"MC\",\"RC\",\"ON\")"));
+    benchmarks.run("parseStringViewList/+CPMS=?", StringViewLists(
+                     "(\"ME\",\"SM\",\"MT\"),(\"ME\",\"SM\",\"MT\"),"
+                     "(\"ME\",\"SM\",\"MT\")"));
+    benchmarks.run("parseIntList/+CNMI=?", IntLists(
+                     "(0-3),(0-3),(0,2,3),(0-2),(0,1)"));
+    benchmarks.run("parseIntRanges/+CNMI=?", IntRanges(
+                     "(0-3),(0-3),(0,2,3),(0-2),(0,1)"));
+    benchmarks.run("parseIntList/(1-65535)", IntLists("(1-65535)"));
+    benchmarks.run("parseIntRanges/(1-65535)", IntRanges("(1-65535)"));
+    benchmarks.run("phonebook/+CPBR=?", PhonebookInfo("(1-250),40,18"));
+    benchmarks.run("operators/+COPS=?", Operators(
+                     "(2,\"E-Plus\",\"E-Plus\",\"26203\"),"
+                     "(3,\"T-Mobile D\",\"TMO D\",\"26201\"),"
+                     "(3,\"Vodafone.de\",\"Vodafone\",\"26202\"),"
+                     "(3,\"o2 - de\",\"o2 - de\",\"26207\"),,(0-4),(0-2)"));
+    return benchmarks.finish();
+  }
+  catch (GsmException &ge)
+  {
+    cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+    return 1;
+  }
+}
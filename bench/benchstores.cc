@@ -0,0 +1,332 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    benchstores.cc
+// *
+// * Purpose: Benchmark the file-based sorted phonebook and SMS store with
+// *          1000 to 1000000 entries
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include "benchmark.h"
+#include <gsmlib/gsm_sorted_phonebook.h>
+#include <gsmlib/gsm_sorted_sms_store.h>
+#include <gsmlib/gsm_sms.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+using namespace gsmlib;
+
+// indexed phonebooks check every index on insert, so loading them takes
+// quadratic time and they are only benchmarked up to this size
+const long MAX_INDEXED_ENTRIES = 10000;
+
+// number of keys looked up in turn by the find benchmarks
+const int FIND_KEYS = 1024;
+
+// *** operations
+
+struct LoadPhonebook
+{
+  string _filename;
+  bool _useIndices;
+  LoadPhonebook(string filename, bool useIndices) :
+    _filename(filename), _useIndices(useIndices) {}
+  void operator()()
+    {
+      SortedPhonebook pb(_filename, _useIndices);
+      keep(pb.size());
+    }
+};
+
+struct InsertPhonebook
+{
+  SortedPhonebook &_pb;
+  PhonebookEntryBase _entry;
+  InsertPhonebook(SortedPhonebook &pb) :
+    _pb(pb), _entry("+4917099999999", "New entry") {}
+  void operator()()
+    {
+      // remove the entry again to keep the size constant
+      _pb.erase(_pb.insert(_entry));
+    }
+};
+
+struct FindPhonebook
+{
+  SortedPhonebook &_pb;
+  vector<string> _keys;
+  unsigned int _next;
+  FindPhonebook(SortedPhonebook &pb, vector<string> keys) :
+    _pb(pb), _keys(keys), _next(0) {}
+  void operator()()
+    {
+      SortedPhonebook::iterator i = _pb.find(_keys[_next++ % _keys.size()]);
+      keep(i);
+    }
+};
+
+struct SyncPhonebook
+{
+  SortedPhonebook &_pb;
+  InsertPhonebook _change;
+  SyncPhonebook(SortedPhonebook &pb) : _pb(pb), _change(pb) {}
+  void operator()()
+    {
+      _change();
+      _pb.sync();
+    }
+};
+
+// read text and number of every entry as a listing would
+struct ScanPhonebook
+{
+  SortedPhonebook &_pb;
+  ScanPhonebook(SortedPhonebook &pb) : _pb(pb) {}
+  void operator()()
+    {
+      unsigned long length = 0;
+      for (SortedPhonebook::iterator i = _pb.begin(); i != _pb.end(); ++i)
+        length += i->text().length() + i->telephone().length();
+      keep(length);
+    }
+};
+
+struct LoadSMSStore
+{
+  string _filename;
+  LoadSMSStore(string filename) : _filename(filename) {}
+  void operator()()
+    {
+      SortedSMSStore sms(_filename);
+      keep(sms.size());
+    }
+};
+
+struct InsertSMSStore
+{
+  SortedSMSStore &_sms;
+  SMSStoreEntry _entry;
+  InsertSMSStore(SortedSMSStore &sms, SMSMessageRef message) :
+    _sms(sms), _entry(message) {}
+  void operator()()
+    {
+      _sms.erase(_sms.insert(_entry));
+    }
+};
+
+struct FindSMSStore
+{
+  SortedSMSStore &_sms;
+  vector<Address> _keys;
+  unsigned int _next;
+  FindSMSStore(SortedSMSStore &sms, vector<Address> keys) :
+    _sms(sms), _keys(keys), _next(0) {}
+  void operator()()
+    {
+      SortedSMSStore::iterator i = _sms.find(_keys[_next++ % _keys.size()]);
+      keep(i);
+    }
+};
+
+// read address and text of every message as a listing would
+struct ScanSMSStore
+{
+  SortedSMSStore &_sms;
+  ScanSMSStore(SortedSMSStore &sms) : _sms(sms) {}
+  void operator()()
+    {
+      unsigned long length = 0;
+      for (SortedSMSStore::iterator i = _sms.begin(); i != _sms.end(); ++i)
+        length += i->message()->address()._number.length() +
+          i->message()->userData().length();
+      keep(length);
+    }
+};
+
+struct SyncSMSStore
+{
+  SortedSMSStore &_sms;
+  InsertSMSStore _change;
+  SyncSMSStore(SortedSMSStore &sms, SMSMessageRef message) :
+    _sms(sms), _change(sms, message) {}
+  void operator()()
+    {
+      _change();
+      _sms.sync();
+    }
+};
+
+// *** test data
+
+static string directory;        // temporary directory for the files
+
+static void removeFile(string filename)
+{
+  unlink(filename.c_str());
+  unlink((filename + "~").c_str());
+}
+
+// return the number of entry i, all numbers are different
+static string telephone(long i)
+{
+  return "+49170" + stringPrintf("%08ld", i * 7919 % 100000000);
+}
+
+static string name(long i)
+{
+  return "Name " + intToStr(i);
+}
+
+// write phonebook file with size entries (format see
+// SortedPhonebook::readPhonebookFile())
+static void writePhonebook(string filename, long size, bool useIndices)
+{
+  ofstream pbs(filename.c_str());
+  for (long i = 0; i < size; ++i)
+    pbs << (useIndices ? intToStr(i) : string("")) << "|" << name(i) << "|"
+        << telephone(i) << endl;
+  if (! pbs)
+    throw GsmException("error writing to file '" + filename + "'", OSError);
+}
+
+static SMSMessageRef message(long i)
+{
+  SMSDeliverMessage *sms = new SMSDeliverMessage();
+  Address originator(telephone(i));
+  sms->setOriginatingAddress(originator);
+  Timestamp timestamp;
+  timestamp._year = 26;
+  timestamp._month = 1 + i / 2678400 % 12;
+  timestamp._day = 1 + i / 86400 % 31;
+  timestamp._hour = i / 3600 % 24;
+  timestamp._minute = i / 60 % 60;
+  timestamp._seconds = i % 60;
+  sms->setServiceCentreTimestamp(timestamp);
+  sms->setUserData("Message " + intToStr(i) +
+                   ", please call me back when you are home");
+  return sms;
+}
+
+static void writeSMSStore(string filename, long size)
+{
+  removeFile(filename);
+  ofstream(filename.c_str());   // SortedSMSStore needs an existing file
+  SortedSMSStore sms(filename);
+  for (long i = 0; i < size; ++i)
+    sms.insert(SMSStoreEntry(message(i)));
+  sms.sync();
+}
+
+// *** benchmarks
+
+static void benchmarkPhonebook(Benchmarks &benchmarks, long size,
+                               bool useIndices)
+{
+  string prefix = useIndices ? "SortedPhonebook/indexed/" :
+    "SortedPhonebook/";
+  if (! benchmarks.selected(prefix + "load") &&
+      ! benchmarks.selected(prefix + "insert") &&
+      ! benchmarks.selected(prefix + "sync") &&
+      ! benchmarks.selected(prefix + "find") &&
+      ! benchmarks.selected(prefix + "scan"))
+    return;
+
+  string filename = directory + "/bench.pb";
+  writePhonebook(filename, size, useIndices);
+  benchmarks.run(prefix + "load", LoadPhonebook(filename, useIndices), size);
+
+  SortedPhonebook pb(filename, useIndices);
+  benchmarks.run(prefix + "insert", InsertPhonebook(pb), size);
+  benchmarks.run(prefix + "sync", SyncPhonebook(pb), size);
+  benchmarks.run(prefix + "scan", ScanPhonebook(pb), size);
+
+  // find by text, spread the keys over the phonebook
+  if (benchmarks.selected(prefix + "find"))
+  {
+    pb.setSortOrder(ByText);
+    vector<string> keys;
+    for (int k = 0; k < FIND_KEYS; ++k)
+      keys.push_back(name(k * 7919L % size));
+    benchmarks.run(prefix + "find", FindPhonebook(pb, keys), size);
+  }
+  pb.sync();
+  removeFile(filename);
+}
+
+static void benchmarkSMSStore(Benchmarks &benchmarks, long size)
+{
+  if (! benchmarks.selected("SortedSMSStore/load") &&
+      ! benchmarks.selected("SortedSMSStore/insert") &&
+      ! benchmarks.selected("SortedSMSStore/sync") &&
+      ! benchmarks.selected("SortedSMSStore/find") &&
+      ! benchmarks.selected("SortedSMSStore/scan"))
+    return;
+
+  string filename = directory + "/bench.sms";
+  writeSMSStore(filename, size);
+  benchmarks.run("SortedSMSStore/load", LoadSMSStore(filename), size);
+
+  SortedSMSStore sms(filename);
+  SMSMessageRef newMessage = message(size);
+  benchmarks.run("SortedSMSStore/insert", InsertSMSStore(sms, newMessage),
+                 size);
+  benchmarks.run("SortedSMSStore/sync", SyncSMSStore(sms, newMessage), size);
+  benchmarks.run("SortedSMSStore/scan", ScanSMSStore(sms), size);
+
+  // find by address, spread the keys over the store
+  if (benchmarks.selected("SortedSMSStore/find"))
+  {
+    sms.setSortOrder(ByAddress);
+    vector<Address> keys;
+    for (int k = 0; k < FIND_KEYS; ++k)
+      keys.push_back(Address(telephone(k * 7919L % size)));
+    benchmarks.run("SortedSMSStore/find", FindSMSStore(sms, keys), size);
+  }
+  sms.sync();
+  removeFile(filename);
+}
+
+int main(int argc, char *argv[])
+{
+  int result = 1;
+  try
+  {
+    Benchmarks benchmarks("stores", argc, argv);
+
+    directory = temporaryDirectory();
+
+    try
+    {
+      vector<long> sizes = benchmarks.sizes();
+      for (vector<long>::iterator i = sizes.begin(); i != sizes.end(); ++i)
+      {
+        benchmarkPhonebook(benchmarks, *i, false);
+        if (*i <= MAX_INDEXED_ENTRIES)
+          benchmarkPhonebook(benchmarks, *i, true);
+        benchmarkSMSStore(benchmarks, *i);
+      }
+      result = benchmarks.finish();
+    }
+    catch (GsmException &ge)
+    {
+      cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+    }
+    removeFile(directory + "/bench.pb");
+    removeFile(directory + "/bench.sms");
+    rmdir(directory.c_str());
+  }
+  catch (GsmException &ge)
+  {
+    cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+  }
+  return result;
+}
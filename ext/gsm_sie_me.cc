@@ -45,26 +45,24 @@ std::vector<std::string> SieMe::getSupportedPhonebooks()
 
 std::string SieMe::getCurrentPhonebook()
 {
-  if (_lastPhonebookName == "")
-  {
-    Parser p(_at->chat("^SPBS?", "^SPBS:"));
-    // answer is e.g. ^SPBS: "SM",41,250
-    _lastPhonebookName = p.parseString();
-    p.parseComma();
-    p.parseInt();
-    p.parseComma();
-    p.parseInt();
-  }
-  return _lastPhonebookName;
+  std::string phonebookName;
+  if (_state.get("^SPBS", phonebookName))
+    return Parser(phonebookName).parseString();
+
+  Parser p(_at->chat("^SPBS?", "^SPBS:"));
+  // answer is e.g. ^SPBS: "SM",41,250
+  phonebookName = p.parseString();
+  p.parseComma();
+  p.parseInt();
+  p.parseComma();
+  p.parseInt();
+  _state.set("^SPBS", "\"" + phonebookName + "\"");
+  return phonebookName;
 }
 
 void SieMe::setPhonebook(std::string phonebookName)
 {
-  if (phonebookName != _lastPhonebookName)
-  {
-    _at->chat("^SPBS=\"" + phonebookName + "\"");
-    _lastPhonebookName = phonebookName;
-  }
+  setState("^SPBS", "\"" + phonebookName + "\"");
 }
 
 
@@ -74,7 +72,7 @@ IntRange SieMe:: getSupportedSignalTones()
   // ^SPST: (0-4),(0,1)
   IntRange typeRange = p.parseRange();
   p.parseComma();
-  std::vector<bool> volumeList = p.parseIntList();
+  IntList volumeList = p.parseIntRanges();
   return typeRange;
 }
 
@@ -183,8 +181,8 @@ BinaryObject SieMe::getBinary(std::string type, int subtype)
   {
     ++fragmentCount;
     // parse header
-    Parser p(*i);
-    std::string fragmentType = p.parseString();
+    Parser p((StringView)*i);
+    StringView fragmentType = p.parseStringView();
     if (fragmentType != type)
       throw GsmException(_("bad PDU type"), ChatError);
     p.parseComma();
@@ -1,4 +1,4 @@
-%define LIBVER 1.0.5
+%define LIBVER 2.0.0
 Summary: Library to access GSM mobile phones through GSM modems
 Name: gsmlib
 Version: 1.11
@@ -67,11 +67,13 @@ rm -rf $RPM_BUILD_ROOT
 %{_bindir}/gsmsmsd
 %{_bindir}/gsmpb
 %{_bindir}/gsmsendsms
+%{_bindir}/gsmbrokerd
 %{_mandir}/man1/gsmctl.1.gz
 %{_mandir}/man7/gsminfo.7.gz
 %{_mandir}/man1/gsmpb.1.gz
 %{_mandir}/man1/gsmsendsms.1.gz
 %{_mandir}/man8/gsmsmsd.8.gz
+%{_mandir}/man8/gsmbrokerd.8.gz
 %{_mandir}/man1/gsmsmsstore.1.gz
 %{_datadir}/locale/de/LC_MESSAGES/gsmlib.mo
 
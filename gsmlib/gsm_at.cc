@@ -19,74 +19,203 @@
 #include <gsmlib/gsm_error.h>
 #include <gsmlib/gsm_event.h>
 #include <gsmlib/gsm_me_ta.h>
-#include <ctype.h>
+#include <gsmlib/gsm_tracing.h>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <sys/time.h>
+#include <unistd.h>
 
 using namespace gsmlib;
 
+// records the latency of one AT command in the metrics when it goes out
+// of scope (also if the command failed), and a span if tracing is enabled
+class CommandTimer
+{
+  GsmMetrics &_metrics;
+  std::string _verb;
+  struct timeval _start;
+  TraceSpan _span;
+
+public:
+  CommandTimer(GsmMetrics &metrics, const std::string &verb,
+               const char *function) :
+    _metrics(metrics), _verb(verb), _span("at", function, verb)
+  {
+    if (_metrics.enabled())
+      gettimeofday(&_start, NULL);
+  }
+
+  ~CommandTimer()
+  {
+    if (! _metrics.enabled())
+      return;
+    struct timeval end;
+    gettimeofday(&end, NULL);
+    _metrics.countCommand(_verb, (end.tv_sec - _start.tv_sec) +
+                          (end.tv_usec - _start.tv_usec) / 1000000.0);
+  }
+};
+
+// recognizes the lines a TA may send before the response to atCommand:
+// the echo of the command if echo can't be switched off, and the
+// confirmation some mobiles (e.g., Sony Ericsson K800i) send for
+// commands like "at+cmgf=0", "+CMGF: 0", as well as the "OK" status
+// FIXME: this is a gross hack, should be done via capabilities or sth
+class CommandEcho
+{
+  StringView _command;
+  StringView _verb;             // "+CMGF" of "+CMGF=0"
+  StringView _arguments;        // "0" of "+CMGF=0"
+  bool _isSet;                  // command contains '='
+
+public:
+  CommandEcho(const std::string &atCommand) : _command(atCommand)
+  {
+    size_t loc = _command.length() > 0 ? _command.find('=', 1) :
+      StringView::npos;
+    _isSet = loc != StringView::npos;
+    if (_isSet)
+    {
+      _verb = _command.substr(0, loc);
+      _arguments = _command.substr(loc + 1);
+    }
+  }
+
+  // return true if s is "AT" + atCommand
+  bool isEcho(StringView s) const
+  {
+    return s.length() == _command.length() + 2 && s.startsWith("AT") &&
+      s.substr(2) == _command;
+  }
+
+  // return true if s starts with "+CMGF: 0" for "+CMGF=0"
+  bool isConfirmation(StringView s) const
+  {
+    return _isSet && s.startsWith(_verb) &&
+      s.substr(_verb.length()).startsWith(": ") &&
+      s.substr(_verb.length() + 2).startsWith(_arguments);
+  }
+};
+
 // GsmAt members
 
-bool GsmAt::matchResponse(std::string answer, std::string responseToMatch)
+bool GsmAt::matchResponse(StringView answer, StringView responseToMatch) const
 {
-  if (answer.substr(0, responseToMatch.length()) == responseToMatch)
+  if (answer.startsWith(responseToMatch))
     return true;
   else
     // some TAs omit the ':' at the end of the response
-    if (_meTa.getCapabilities()._omitsColon &&
+    if (responseToMatch.length() > 0 &&
         responseToMatch[responseToMatch.length() - 1] == ':' &&
-        answer.substr(0, responseToMatch.length() - 1) == 
-        responseToMatch.substr(0, responseToMatch.length() - 1))
+        _meTa.getCapabilities()._omitsColon &&
+        answer.startsWith(responseToMatch.substr(0, responseToMatch.length()
+                                                 - 1)))
       return true;
   return false;
 }
 
-std::string GsmAt::cutResponse(std::string answer, std::string responseToMatch)
+StringView GsmAt::cutResponse(StringView answer,
+                              StringView responseToMatch) const
 {
-  if (answer.substr(0, responseToMatch.length()) == responseToMatch)
-    return normalize(answer.substr(responseToMatch.length(),
-                                   answer.length() -
-                                   responseToMatch.length()));
+  if (answer.startsWith(responseToMatch))
+    return answer.substr(responseToMatch.length()).trim();
   else
     // some TAs omit the ':' at the end of the response
-    if (_meTa.getCapabilities()._omitsColon &&
+    if (responseToMatch.length() > 0 &&
         responseToMatch[responseToMatch.length() - 1] == ':' &&
-        answer.substr(0, responseToMatch.length() - 1) == 
-        responseToMatch.substr(0, responseToMatch.length() - 1))
-      return normalize(answer.substr(responseToMatch.length() - 1,
-                                     answer.length() -
-                                     responseToMatch.length() + 1));
+        _meTa.getCapabilities()._omitsColon &&
+        answer.startsWith(responseToMatch.substr(0, responseToMatch.length()
+                                                 - 1)))
+      return answer.substr(responseToMatch.length() - 1).trim();
   assert(0);
-  return "";
+  return StringView();
+}
+
+StringView GsmAt::getNonEmptyLine(std::string &line)
+{
+  StringView result;
+  do
+    {
+      line = getLine();
+      result = StringView(line).trim();
+    }
+  while (result.length() == 0);
+  return result;
 }
 
-void GsmAt::throwCmeException(std::string s)
+void GsmAt::throwCmeException(StringView s)
 {
   if (matchResponse(s, "ERROR"))
     throw GsmException(_("unspecified ME/TA error"), ChatError);
 
   bool meError = matchResponse(s, "+CME ERROR:");
-  if (meError)
-    s = cutResponse(s, "+CME ERROR:");
-  else
-    s = cutResponse(s, "+CMS ERROR:");
-  std::istringstream is(s);
+  std::string code = cutResponse(s, meError ? "+CME ERROR:" :
+                                 "+CMS ERROR:").str();
+  std::istringstream is(code);
   int error;
   is >> error;
   throw GsmException(_("ME/TA error '") +
                      (meError ? getMEErrorText(error) :
                       getSMSErrorText(error)) +
                      "' " +
-                     stringPrintf(_("(code %s)"), s.c_str()),
+                     stringPrintf(_("(code %s)"), code.c_str()),
                      ChatError, error);
 }
 
+void GsmAt::countError(const std::string &verb, StringView s)
+{
+  GsmMetrics &metrics = _meTa.getMetrics();
+  if (! metrics.enabled())
+    return;
+  int code = -1;
+  if (matchResponse(s, "+CME ERROR:") || matchResponse(s, "+CMS ERROR:"))
+  {
+    std::string type = s.substr(1, 3).str();
+    std::istringstream is(cutResponse(s, "+" + type + " ERROR:").str());
+    if (! (is >> code))
+      code = -1;                // verbose error text
+    metrics.countError(verb, type, code);
+  }
+  else
+    metrics.countError(verb, "ERROR", code);
+}
+
+// GsmAt::Lock members
+
+GsmAt::Lock::Lock(GsmAt &at) : _at(at), _locked(at._threadSafe)
+{
+  if (_locked)
+    pthread_mutex_lock(&_at._mutex);
+}
+
+GsmAt::Lock::~Lock()
+{
+  if (_locked)
+    pthread_mutex_unlock(&_at._mutex);
+}
+
+// GsmAt members
+
 GsmAt::GsmAt(MeTa &meTa) :
-  _meTa(meTa), _port(meTa.getPort()), _eventHandler(NULL)
+  _meTa(meTa), _port(meTa.getPort()), _eventHandler(NULL),
+  _threadSafe(false)
 {
+  // recursive because event handlers send commands from within chat()
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
 }
 
-std::string GsmAt::chat(std::string atCommand, std::string response,
+GsmAt::~GsmAt()
+{
+  pthread_mutex_destroy(&_mutex);
+}
+
+std::string GsmAt::chat(const std::string &atCommand,
+                        const std::string &response,
 			bool ignoreErrors, bool acceptEmptyResponse)
 {
   std::string dummy;
@@ -94,41 +223,35 @@ std::string GsmAt::chat(std::string atCommand, std::string response,
               acceptEmptyResponse);
 }
 
-std::string GsmAt::chat(std::string atCommand, std::string response, std::string &pdu,
+std::string GsmAt::chat(const std::string &atCommand,
+                        const std::string &response, std::string &pdu,
 			bool ignoreErrors, bool expectPdu,
 			bool acceptEmptyResponse)
 {
-  std::string s;
+  std::string line;             // last line read
+  StringView s;                 // line without white space
   bool gotOk = false;           // special handling for empty SMS entries
+  Lock lock(*this);
+  std::string verb = GsmMetrics::verb(atCommand);
+  CommandTimer timer(_meTa.getMetrics(), verb, "chat");
 
   // send AT command
   putLine("AT" + atCommand);
-  // and gobble up CR/LF (and possibly echoed characters if echo can't be
-  // switched off)
-  // Also, some mobiles (e.g., Sony Ericsson K800i) respond to commands
-  // like "at+cmgf=0" with "+CMGF: 0" on success as well as the "OK"
-  // status -- so gobble that (but not if that sort of response was expected)
-  // FIXME: this is a gross hack, should be done via capabilities or sth
-  std::string::size_type loc = atCommand.find( "=", 1 );
-  std::string expect;
-  if (loc != std::string::npos) {
-    expect = atCommand;
-    expect.replace(loc, 1, " ");
-    expect.insert(loc, ":");
-  } else {
-    expect = "";
-  }
+  // and gobble up CR/LF, echoed commands and confirmations (but not if
+  // that sort of response was expected)
+  CommandEcho echo(atCommand);
   do
     {
-      s = normalize(getLine());
+      s = getNonEmptyLine(line);
     }
-  while (s.length() == 0 || s == "AT" + atCommand || 
+  while (echo.isEcho(s) ||
          ((response.length() == 0 || !matchResponse(s, response)) &&
-          (expect.length() > 0 && matchResponse(s, expect))));
+          echo.isConfirmation(s)));
 
   // handle errors
   if (matchResponse(s, "+CME ERROR:") || matchResponse(s, "+CMS ERROR:"))
     {
+      countError(verb, s);
       if (ignoreErrors)
 	return "";
       else
@@ -136,6 +259,7 @@ std::string GsmAt::chat(std::string atCommand, std::string response, std::string
     }
   if (matchResponse(s, "ERROR"))
     {
+      countError(verb, s);
       if (ignoreErrors)
 	return "";
       else
@@ -150,17 +274,13 @@ std::string GsmAt::chat(std::string atCommand, std::string response, std::string
   // handle PDU if one is expected
   if (expectPdu)
     {
-      std::string ps;
-      do
-	{
-	  ps = normalize(getLine());
-	}
-      while (ps.length() == 0 && ps != "OK");
+      std::string pduLine;
+      StringView ps = getNonEmptyLine(pduLine);
       if (ps == "OK")
 	gotOk = true;
       else
 	{
-	  pdu = ps;
+	  pdu.assign(ps.data(), ps.length());
 	  // remove trailing zero added by some devices (e.g. Falcom A2-1)
 	  if (pdu.length() > 0 && pdu[pdu.length() - 1] == 0)
 	    pdu.erase(pdu.length() - 1);
@@ -179,20 +299,16 @@ std::string GsmAt::chat(std::string atCommand, std::string response, std::string
       // some TA/TEs don't prefix their response with the response string
       // as proscribed by the standard: just handle either case
       if (matchResponse(s, response))
-	result = cutResponse(s, response);
+	result = cutResponse(s, response).str();
       else
-	result = s;
+	result = s.str();
 
       if (gotOk)
 	return result;
       else
 	{
 	  // get the final "OK"
-	  do
-	    {
-	      s = normalize(getLine());
-	    }
-	  while (s.length() == 0);
+	  s = getNonEmptyLine(line);
 
 	  if (s == "OK") return result;
 	  // else fall through to error
@@ -200,29 +316,36 @@ std::string GsmAt::chat(std::string atCommand, std::string response, std::string
     }
   throw GsmException(
 		     stringPrintf(_("unexpected response '%s' when sending 'AT%s'"),
-				  s.c_str(), atCommand.c_str()),
+				  s.str().c_str(), atCommand.c_str()),
 		     ChatError);
 }
 
-std::vector<std::string> GsmAt::chatv(std::string atCommand, std::string response,
+std::vector<std::string> GsmAt::chatv(const std::string &atCommand,
+                                      const std::string &response,
 				      bool ignoreErrors)
 {
-  std::string s;
+  std::string line;             // last line read
+  StringView s;                 // line without white space
   std::vector<std::string> result;
+  Lock lock(*this);
+  std::string verb = GsmMetrics::verb(atCommand);
+  CommandTimer timer(_meTa.getMetrics(), verb, "chatv");
 
   // send AT command
   putLine("AT" + atCommand);
   // and gobble up CR/LF (and possibly echoed characters if echo can't be
   // switched off)
+  CommandEcho echo(atCommand);
   do
     {
-      s = normalize(getLine());
+      s = getNonEmptyLine(line);
     }
-  while (s.length() == 0 || s == "AT" + atCommand);
+  while (echo.isEcho(s));
 
   // handle errors
   if (matchResponse(s, "+CME ERROR:") || matchResponse(s, "+CMS ERROR:"))
     {
+      countError(verb, s);
       if (ignoreErrors)
 	return result;
       else
@@ -230,6 +353,7 @@ std::vector<std::string> GsmAt::chatv(std::string atCommand, std::string respons
     }
   if (matchResponse(s, "ERROR"))
     {
+      countError(verb, s);
       if (ignoreErrors)
 	return result;
       else
@@ -246,15 +370,11 @@ std::vector<std::string> GsmAt::chatv(std::string atCommand, std::string respons
       // some TA/TEs don't prefix their response with the response string
       // as proscribed by the standard: just handle either case
       if (response.length() != 0 && matchResponse(s, response))
-	result.push_back(cutResponse(s, response));
+	result.push_back(cutResponse(s, response).str());
       else
-	result.push_back(s);
+	result.push_back(s.str());
       // get next line
-      do
-	{
-	  s = normalize(getLine());
-	}
-      while (s.length() == 0);
+      s = getNonEmptyLine(line);
       reportProgress();
     }
 
@@ -263,42 +383,30 @@ std::vector<std::string> GsmAt::chatv(std::string atCommand, std::string respons
   return result;
 }
 
-std::string GsmAt::normalize(std::string s)
+std::string GsmAt::normalize(const std::string &s)
 {
-  size_t start = 0, end = s.length();
-  bool changed = true;
-
-  while (start < end && changed)
-    {
-      changed = false;
-      if (isspace(s[start]))
-	{
-	  ++start;
-	  changed = true;
-	}
-      else
-	if (isspace(s[end - 1]))
-	  {
-	    --end;
-	    changed = true;
-	  }
-    }
-  return s.substr(start, end - start);
+  return StringView(s).trim().str();
 }
 
-std::string GsmAt::sendPdu(std::string atCommand, std::string response, std::string pdu,
-                      bool acceptEmptyResponse)
+std::string GsmAt::sendPdu(const std::string &atCommand,
+                           const std::string &response,
+                           const std::string &pdu, bool acceptEmptyResponse)
 {
-  std::string s;
+  std::string line;             // last line read
+  StringView s;                 // line without white space
   bool errorCondition;
   bool retry = false;
   int tries = 5;                // How many error conditions do we accept
+  Lock lock(*this);
+  std::string verb = GsmMetrics::verb(atCommand);
+  CommandTimer timer(_meTa.getMetrics(), verb, "sendPdu");
 
   int c;
   do
     {
       errorCondition = false;
       putLine("AT" + atCommand);
+      TraceSpan span("at", "wait for prompt");
       do
 	{
 	  retry = false;
@@ -322,8 +430,9 @@ std::string GsmAt::sendPdu(std::string atCommand, std::string response, std::str
 	  if (c == '+' || c == 'E') // error or unsolicited result code
 	    {
 	      _port->putBack(c);
-	      s = normalize(getLine());
-	      errorCondition = (s != "");
+	      line = getLine();
+	      s = StringView(line).trim();
+	      errorCondition = (s.length() != 0);
 
 	      retry = ! errorCondition;
 	    }
@@ -352,18 +461,26 @@ std::string GsmAt::sendPdu(std::string atCommand, std::string response, std::str
       // is read
       do
 	{
-	  s = normalize(getLine());
+	  s = getNonEmptyLine(line);
 	}
-      while (s.length() == 0 || s == pdu || s == (pdu + "\032") ||
+      while (s == pdu ||
+	     (s.length() == pdu.length() + 1 && s.startsWith(pdu) &&
+	      s[pdu.length()] == '\032') ||
 	     (s.length() == 1 && s[0] == 0));
     }
 
   // handle errors
   if (matchResponse(s, "+CME ERROR:") || matchResponse(s, "+CMS ERROR:"))
+  {
+    countError(verb, s);
     throwCmeException(s);
+  }
   if (matchResponse(s, "ERROR"))
+  {
+    countError(verb, s);
     throw GsmException(_("ME/TA error '<unspecified>' (code not known)"), 
                        ChatError, -1);
+  }
 
   // return if response is "OK" and caller says this is OK
   if (acceptEmptyResponse && s == "OK")
@@ -371,51 +488,39 @@ std::string GsmAt::sendPdu(std::string atCommand, std::string response, std::str
 
   if (matchResponse(s, response))
     {
-      std::string result = cutResponse(s, response);
+      std::string result = cutResponse(s, response).str();
       // get the final "OK"
-      do
-	{
-	  s = normalize(getLine());
-	}
-      while (s.length() == 0);
+      s = getNonEmptyLine(line);
 
       if (s == "OK") return result;
       // else fall through to error
     }
   throw GsmException(
 		     stringPrintf(_("unexpected response '%s' when sending 'AT%s'"),
-				  s.c_str(), atCommand.c_str()),
+				  s.str().c_str(), atCommand.c_str()),
 		     ChatError);
 }
 
 std::string GsmAt::getLine()
 {
+  Lock lock(*this);
+  GsmMetrics &metrics = _meTa.getMetrics();
   if (_eventHandler == (GsmEvent*)NULL)
-    return _port->getLine();
+    {
+      std::string result = _port->getLine();
+      metrics.countBytesIn(result.length() + 2);
+      return result;
+    }
   else
     {
       bool eventOccurred;
       std::string result;
       do
 	{
-	  eventOccurred = false;
 	  result = _port->getLine();
-	  std::string s = normalize(result);
-	  if (matchResponse(s, "+CMT:") ||
-	      matchResponse(s, "+CBM:") ||
-	      matchResponse(s, "+CDS:") ||
-	      matchResponse(s, "+CMTI:") ||
-	      matchResponse(s, "+CBMI:") ||
-	      matchResponse(s, "+CDSI:") ||
-	      matchResponse(s, "RING") ||
-	      matchResponse(s, "NO CARRIER") ||
-	      // hack: the +CLIP? sequence returns +CLIP: n,m
-	      // which is NOT an unsolicited result code
-	      (matchResponse(s, "+CLIP:") && s.length() > 10))
-	    {
-	      _eventHandler->dispatch(s, *this);
-	      eventOccurred = true;
-	    }
+	  metrics.countBytesIn(result.length() + 2);
+	  eventOccurred =
+	    _eventHandler->dispatch(StringView(result).trim(), *this);
 	}
       while (eventOccurred);
       return result;
@@ -425,7 +530,15 @@ std::string GsmAt::getLine()
 void GsmAt::putLine(std::string line,
                     bool carriageReturn)
 {
-  _port->putLine(line, carriageReturn);
+  Lock lock(*this);
+  // resets make the shadowed settings invalid
+  StringView command(line);
+  if (command.startsWithNoCase("atz") || command.startsWithNoCase("at&f"))
+    _meTa.getStateShadow().invalidate();
+
+  _meTa.getMetrics().countBytesOut(line.length() + (carriageReturn ? 1 : 0));
+  // the line is not needed any more
+  _port->putLine(std::move(line), carriageReturn);
   // remove empty echo line
   if (carriageReturn)
     getLine();
@@ -433,12 +546,40 @@ void GsmAt::putLine(std::string line,
 
 bool GsmAt::wait(GsmTime timeout)
 {
-  return _port->wait(timeout);
+  if (! _threadSafe)
+    return _port->wait(timeout);
+
+  // poll in slices so that the mutex is free for other threads in between
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  while (true)
+  {
+    {
+      Lock lock(*this);
+      struct timeval zero = {0, 0};
+      if (_port->wait(&zero))
+        return true;
+    }
+    if (timeout != NULL)
+    {
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      long elapsed = (now.tv_sec - start.tv_sec) * 1000000L +
+        now.tv_usec - start.tv_usec;
+      if (elapsed >= timeout->tv_sec * 1000000L + timeout->tv_usec)
+        return false;
+    }
+    usleep(10000);
+  }
 }
 
 int GsmAt::readByte()
 {
-  return _port->readByte();
+  Lock lock(*this);
+  int result = _port->readByte();
+  if (result >= 0)
+    _meTa.getMetrics().countBytesIn(1);
+  return result;
 }
 
 GsmEvent *GsmAt::setEventHandler(GsmEvent *newHandler)
@@ -14,8 +14,10 @@
 #define GSM_AT_H
 
 #include <gsmlib/gsm_port.h>
+#include <gsmlib/gsm_string_view.h>
 #include <string>
 #include <vector>
+#include <pthread.h>
 
 namespace gsmlib
 {
@@ -28,24 +30,57 @@ namespace gsmlib
 
   // utiliy class to handle AT sequences
 
-  class GsmAt : public RefBase
+  // In thread-safe mode (see setThreadSafe()) each chat(), chatv(), and
+  // sendPdu() call holds a recursive mutex, so that the AT transactions
+  // of several threads sharing a GsmAt are not interleaved. Event
+  // handlers run in the thread that reads the unsolicited result code
+  // with the mutex held, they may issue further AT commands.
+
+  class GsmAt : public RefBase, public NoCopy
   {
   protected:
     MeTa &_meTa;
     Ref<Port> _port;
     GsmEvent *_eventHandler;
+    bool _threadSafe;
+    pthread_mutex_t _mutex;     // serializes AT transactions
     
     // return true if response matches
-    bool matchResponse(std::string answer, std::string responseToMatch);
+    bool matchResponse(StringView answer, StringView responseToMatch) const;
 
     // cut response and normalize
-    std::string cutResponse(std::string answer, std::string responseToMatch);
+    StringView cutResponse(StringView answer,
+                           StringView responseToMatch) const;
+
+    // read lines into line until one is not empty, return it without
+    // white space at beginning and end (valid until line is changed)
+    StringView getNonEmptyLine(std::string &line);
 
     // parse CME error contained in string and throw MeTaException
-    void throwCmeException(std::string s);
+    void throwCmeException(StringView s);
+
+    // count the error contained in string for verb in the metrics
+    void countError(const std::string &verb, StringView s);
 
   public:
+    // holds the GsmAt mutex for its lifetime if the GsmAt is in thread-safe
+    // mode, use it to make sequences of AT commands atomic
+    class Lock
+    {
+      GsmAt &_at;
+      bool _locked;
+    public:
+      Lock(GsmAt &at);
+      ~Lock();
+    };
+
     GsmAt(MeTa &meTa);
+    ~GsmAt();
+
+    // switch thread-safe mode on or off, this must be done before the
+    // GsmAt is used by more than one thread
+    void setThreadSafe(bool threadSafe) {_threadSafe = threadSafe;}
+    bool threadSafe() const {return _threadSafe;}
 
     // return MeTa object for this AT object
     MeTa &getMeTa() {return _meTa;}
@@ -61,34 +96,37 @@ namespace gsmlib
     // additionally, accept empty responses (just an OK)
     //   if acceptEmptyResponse == true
     //   in this case an empty string is returned
-    std::string chat(std::string atCommand = "",
-		     std::string response = "",
+    std::string chat(const std::string &atCommand = "",
+		     const std::string &response = "",
 		     bool ignoreErrors = false,
 		     bool acceptEmptyResponse = false);
 
     // same as chat() above but also get pdu if expectPdu == true
-    std::string chat(std::string atCommand,
-		     std::string response,
+    std::string chat(const std::string &atCommand,
+		     const std::string &response,
 		     std::string &pdu,
 		     bool ignoreErrors = false,
 		     bool expectPdu = true,
 		     bool acceptEmptyResponse = false);
 
     // same as above, but expect several response lines
-    std::vector<std::string> chatv(std::string atCommand = "",
-				   std::string response = "",
+    std::vector<std::string> chatv(const std::string &atCommand = "",
+				   const std::string &response = "",
 				   bool ignoreErrors = false);
 
     // removes whitespace at beginning and end of string
-    std::string normalize(std::string s);
+    std::string normalize(const std::string &s);
 
     // send pdu (wait for <CR><LF><greater_than><space> and send <CTRL-Z>
     // at the end
     // return text after response
-    std::string sendPdu(std::string atCommand, std::string response, std::string pdu,
+    std::string sendPdu(const std::string &atCommand,
+                        const std::string &response, const std::string &pdu,
 			bool acceptEmptyResponse = false);
     
     // functions from class Port
+    // in thread-safe mode wait() only holds the mutex while polling, so
+    // that other threads can send commands while one thread waits
     std::string getLine();
     void putLine(std::string line,
                  bool carriageReturn = true);
@@ -97,6 +135,9 @@ namespace gsmlib
 
     // set event handler class, return old one
     GsmEvent *setEventHandler(GsmEvent *newHandler);
+
+    // return current event handler (NULL if none)
+    GsmEvent *getEventHandler() const {return _eventHandler;}
   };
 };
 
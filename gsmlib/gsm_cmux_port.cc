@@ -0,0 +1,580 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_cmux_port.cc
+// *
+// * Purpose: GSM 07.10 (3GPP 27.010) multiplexer, virtual channels on top
+// *          of one serial port
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <gsmlib/gsm_cmux_port.h>
+#include <iostream>
+#include <cassert>
+#include <sys/time.h>
+
+using namespace gsmlib;
+
+// frame delimiter (basic option)
+static const unsigned char CMUX_FLAG = 0xf9;
+
+// address and length field bits
+static const unsigned char CMUX_EA = 0x01;
+static const unsigned char CMUX_CR = 0x02;
+
+// frame types (control field without P/F bit)
+static const unsigned char CMUX_SABM = 0x2f;
+static const unsigned char CMUX_UA = 0x63;
+static const unsigned char CMUX_DM = 0x0f;
+static const unsigned char CMUX_DISC = 0x43;
+static const unsigned char CMUX_UIH = 0xef;
+static const unsigned char CMUX_UI = 0x03;
+static const unsigned char CMUX_PF = 0x10;
+
+// control channel message types (with EA bit, without C/R bit)
+static const unsigned char CMUX_CLD = 0xc1;
+static const unsigned char CMUX_MSC = 0xe1;
+
+// V.24 signals sent with MSC: DV, RTR, RTC, EA
+static const unsigned char CMUX_V24_SIGNALS = 0x8d;
+
+// maximum information field size (N1 default for AT+CMUX=0)
+static const unsigned int CMUX_FRAME_SIZE = 31;
+
+// time to wait for UA or DM (in ms) and number of tries (T1, N2)
+static const long int CMUX_RESPONSE_TIMEOUT = 1000;
+static const int CMUX_RETRIES = 3;
+
+// readers check for interrupts and timeouts after this time (in us)
+static const long int CMUX_SLICE = 100000;
+
+// return milliseconds elapsed since startTime
+static long int millisecondsSince(const struct timeval &startTime)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - startTime.tv_sec) * 1000 +
+    (now.tv_usec - startTime.tv_usec) / 1000;
+}
+
+// CRC-8 as used for the frame check sequence
+static unsigned char crc(const std::string &data)
+{
+  unsigned char result = 0xff;
+  for (std::string::const_iterator i = data.begin(); i != data.end(); ++i)
+  {
+    result ^= (unsigned char)*i;
+    for (int bit = 0; bit < 8; ++bit)
+      result = (result & 1) ? (result >> 1) ^ 0xe0 : result >> 1;
+  }
+  return result;
+}
+
+// hold the mutex while in scope
+class MutexLock
+{
+  pthread_mutex_t &_mutex;
+public:
+  MutexLock(pthread_mutex_t &mutex) : _mutex(mutex)
+    {pthread_mutex_lock(&_mutex);}
+  ~MutexLock() {pthread_mutex_unlock(&_mutex);}
+};
+
+// CmuxPort members
+
+void CmuxPort::sendFrame(int dlci, unsigned char control,
+                         const std::string &info)
+{
+  std::string header;
+  // frames from the initiator (we) are commands except UA and DM
+  bool command = (control & ~CMUX_PF) != CMUX_UA &&
+    (control & ~CMUX_PF) != CMUX_DM;
+  header += (char)((dlci << 2) | (command ? CMUX_CR : 0) | CMUX_EA);
+  header += (char)control;
+  if (info.length() < 128)
+    header += (char)((info.length() << 1) | CMUX_EA);
+  else
+  {
+    header += (char)(info.length() << 1);
+    header += (char)(info.length() >> 7);
+  }
+
+  std::string frame;
+  frame += (char)CMUX_FLAG;
+  frame += header;
+  frame += info;
+  frame += (char)(0xff - crc(header));
+  frame += (char)CMUX_FLAG;
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "*** CMUX send DLC " << dlci << " control "
+              << (int)control << " length " << info.length() << std::endl;
+#endif
+  _port->putLine(frame, false);
+}
+
+bool CmuxPort::receive(GsmTime timeout)
+{
+  if (_reading)
+  {
+    // another thread waits on the port, let it dispatch the frames
+    if (timeout == NULL)
+      pthread_cond_wait(&_dispatched, &_mutex);
+    else
+    {
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      long int usecs = now.tv_usec + timeout->tv_usec;
+      struct timespec deadline;
+      deadline.tv_sec = now.tv_sec + timeout->tv_sec + usecs / 1000000L;
+      deadline.tv_nsec = (usecs % 1000000L) * 1000;
+      if (pthread_cond_timedwait(&_dispatched, &_mutex, &deadline) != 0)
+        return false;
+    }
+    return true;
+  }
+
+  // wait without the lock so that other threads can write meanwhile
+  _reading = true;
+  pthread_mutex_unlock(&_mutex);
+  bool ready;
+  try
+  {
+    ready = _port->wait(timeout);
+  }
+  catch (GsmException &)
+  {
+    pthread_mutex_lock(&_mutex);
+    _reading = false;
+    pthread_cond_broadcast(&_dispatched);
+    throw;
+  }
+  pthread_mutex_lock(&_mutex);
+  _reading = false;
+  try
+  {
+    if (ready)
+      readFrames();
+  }
+  catch (GsmException &)
+  {
+    pthread_cond_broadcast(&_dispatched);
+    throw;
+  }
+  pthread_cond_broadcast(&_dispatched);
+  return ready;
+}
+
+void CmuxPort::readFrames()
+{
+  struct timeval noWait = {0, 0};
+  do
+  {
+    int c = _port->readByte();
+    if (c < 0)
+      break;
+    _frame += (char)c;
+  }
+  while (_port->wait(&noWait));
+
+  while (true)
+  {
+    // skip to the last of consecutive flags
+    std::string::size_type start = _frame.find((char)CMUX_FLAG);
+    if (start == std::string::npos)
+    {
+      _frame = "";
+      return;
+    }
+    while (start + 1 < _frame.length() &&
+           (unsigned char)_frame[start + 1] == CMUX_FLAG)
+      ++start;
+    _frame.erase(0, start);
+
+    // flag, address, control, length (one or two bytes)
+    if (_frame.length() < 4)
+      return;
+    unsigned int headerLength = 3;
+    unsigned int length = (unsigned char)_frame[3] >> 1;
+    if (! ((unsigned char)_frame[3] & CMUX_EA))
+    {
+      if (_frame.length() < 5)
+        return;
+      length |= (unsigned char)_frame[4] << 7;
+      headerLength = 4;
+    }
+    unsigned int frameLength = 1 + headerLength + length + 2;
+    if (_frame.length() < frameLength)
+      return;
+
+    // on garbage resynchronize at the next flag
+    // (the FCS of UI frames covers the information field, too)
+    std::string checked = _frame.substr(1, headerLength);
+    if (((unsigned char)_frame[2] & ~CMUX_PF) == CMUX_UI)
+      checked += _frame.substr(1 + headerLength, length);
+    if ((unsigned char)_frame[frameLength - 1] != CMUX_FLAG ||
+        crc(checked + _frame[frameLength - 2]) != 0xcf)
+    {
+#ifndef NDEBUG
+      if (debugLevel() >= 1)
+        std::cerr << "*** CMUX bad frame" << std::endl;
+#endif
+      _frame.erase(0, 1);
+      continue;
+    }
+    handleFrame((unsigned char)_frame[1] >> 2,
+                (unsigned char)_frame[2] & ~CMUX_PF,
+                _frame.substr(1 + headerLength, length));
+
+    // the closing flag may open the next frame
+    _frame.erase(0, frameLength - 1);
+  }
+}
+
+void CmuxPort::handleFrame(int dlci, unsigned char control,
+                           const std::string &info)
+{
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "*** CMUX receive DLC " << dlci << " control "
+              << (int)control << " length " << info.length() << std::endl;
+#endif
+  switch (control)
+  {
+  case CMUX_UIH:
+  case CMUX_UI:
+    if (dlci == 0)
+      handleControl(info);
+    else if (_received.find(dlci) != _received.end())
+      _received[dlci] += info;
+    break;
+  case CMUX_UA:
+  case CMUX_DM:
+    _responses[dlci] = control;
+    break;
+  case CMUX_DISC:
+    sendFrame(dlci, CMUX_UA | CMUX_PF);
+    if (dlci == 0)
+      _closed = true;
+    else
+      _received.erase(dlci);
+    break;
+  case CMUX_SABM:
+    // we do not accept DLCs opened by the ME
+    sendFrame(dlci, CMUX_DM | CMUX_PF);
+    break;
+  }
+}
+
+void CmuxPort::handleControl(const std::string &info)
+{
+  if (info.length() < 2)
+    return;
+  unsigned char type = info[0];
+  if (! (type & CMUX_CR))
+  {
+    // response to one of our messages
+    if (type == CMUX_CLD)
+      _closed = true;
+    return;
+  }
+
+  // acknowledge commands (MSC, test, flow control, ...) by echoing them
+  // as responses
+  if ((type & ~CMUX_CR) == CMUX_CLD)
+    _closed = true;
+  std::string response = info;
+  response[0] = type & ~CMUX_CR;
+  sendFrame(0, CMUX_UIH, response);
+}
+
+bool CmuxPort::command(int dlci, unsigned char control)
+{
+  for (int tries = 0; tries < CMUX_RETRIES; ++tries)
+  {
+    _responses.erase(dlci);
+    sendFrame(dlci, control | CMUX_PF);
+    struct timeval startTime;
+    gettimeofday(&startTime, NULL);
+    while (millisecondsSince(startTime) < CMUX_RESPONSE_TIMEOUT)
+    {
+      struct timeval slice = {0, CMUX_SLICE};
+      receive(&slice);
+      std::map<int, int>::iterator i = _responses.find(dlci);
+      if (i != _responses.end())
+        return i->second == CMUX_UA;
+    }
+  }
+  throw GsmException(stringPrintf(_("no answer from multiplexer for DLC %d"),
+                                  dlci), ChatError);
+}
+
+int CmuxPort::dataAvailable(int dlci)
+{
+  std::map<int, std::string>::iterator i = _received.find(dlci);
+  if (i == _received.end())
+    throw GsmException(stringPrintf(_("DLC %d closed"), dlci), OSError);
+  return i->second.length();
+}
+
+int CmuxPort::readByte(int dlci, long int timeout)
+{
+  struct timeval startTime;
+  gettimeofday(&startTime, NULL);
+  while (true)
+  {
+    {
+      MutexLock lock(_mutex);
+      if (! _closed && dataAvailable(dlci) == 0)
+      {
+        struct timeval slice = {0, CMUX_SLICE};
+        receive(&slice);
+      }
+      if (dataAvailable(dlci) > 0)
+      {
+        std::string &data = _received[dlci];
+        unsigned char c = data[0];
+        data.erase(0, 1);
+        return c;
+      }
+      if (_closed)
+        throw GsmException(_("multiplexer closed"), OSError);
+    }
+    if (interrupted())
+      throw GsmException(_("interrupted when reading from multiplexer"),
+                         InterruptException);
+    if (millisecondsSince(startTime) >= timeout * 1000)
+      throw GsmException(_("timeout when reading from multiplexer"),
+                         OSError);
+  }
+}
+
+bool CmuxPort::wait(int dlci, GsmTime timeout)
+{
+  struct timeval startTime;
+  gettimeofday(&startTime, NULL);
+  while (true)
+  {
+    {
+      MutexLock lock(_mutex);
+      if (dataAvailable(dlci) > 0)
+        return true;
+      if (_closed)
+        return false;
+      struct timeval slice = {0, CMUX_SLICE};
+      receive(&slice);
+      if (dataAvailable(dlci) > 0)
+        return true;
+    }
+    if (timeout != NULL &&
+        millisecondsSince(startTime) >=
+        timeout->tv_sec * 1000 + timeout->tv_usec / 1000)
+      return false;
+  }
+}
+
+void CmuxPort::write(int dlci, const std::string &data)
+{
+  MutexLock lock(_mutex);
+  if (_closed)
+    throw GsmException(_("multiplexer closed"), OSError);
+  for (std::string::size_type i = 0; i < data.length(); i += CMUX_FRAME_SIZE)
+    sendFrame(dlci, CMUX_UIH, data.substr(i, CMUX_FRAME_SIZE));
+}
+
+void CmuxPort::closeChannel(int dlci)
+{
+  MutexLock lock(_mutex);
+  if (_received.find(dlci) == _received.end())
+    return;
+  _received.erase(dlci);
+  if (! _closed)
+    command(dlci, CMUX_DISC);
+}
+
+CmuxPort::CmuxPort(Ref<Port> port, bool sendCmux) :
+  _port(port), _closed(false), _reading(false)
+{
+  pthread_mutex_init(&_mutex, NULL);
+  pthread_cond_init(&_dispatched, NULL);
+  if (sendCmux)
+  {
+    _port->putLine("AT+CMUX=0");
+    int readTries = 5;
+    while (true)
+    {
+      std::string s = _port->getLine();
+      if (s.find("OK") != std::string::npos)
+        break;
+      if (s.find("ERROR") != std::string::npos || readTries-- == 0)
+        throw GsmException(_("ME/TA does not support multiplexer mode"),
+                           MeTaCapabilityError);
+    }
+  }
+
+  MutexLock lock(_mutex);
+  if (! command(0, CMUX_SABM))
+    throw GsmException(_("opening multiplexer control channel failed"),
+                       ChatError);
+}
+
+Ref<Port> CmuxPort::openChannel(int dlci)
+{
+  if (dlci < 1 || dlci > 63)
+    throw GsmException(stringPrintf(_("invalid DLC %d"), dlci),
+                       ParameterError);
+  {
+    MutexLock lock(_mutex);
+    if (_closed)
+      throw GsmException(_("multiplexer closed"), OSError);
+    if (_received.find(dlci) != _received.end())
+      throw GsmException(stringPrintf(_("DLC %d already open"), dlci),
+                         ParameterError);
+    if (! command(dlci, CMUX_SABM))
+      throw GsmException(stringPrintf(_("opening DLC %d failed"), dlci),
+                         ChatError);
+    _received[dlci] = "";
+
+    // signal DTR and RTS, some MEs do not send anything before
+    std::string msc;
+    msc += (char)(CMUX_MSC | CMUX_CR);
+    msc += (char)((2 << 1) | CMUX_EA);
+    msc += (char)((dlci << 2) | CMUX_CR | CMUX_EA);
+    msc += (char)CMUX_V24_SIGNALS;
+    sendFrame(0, CMUX_UIH, msc);
+  }
+  return new CmuxChannel(Ref<CmuxPort>(this), dlci);
+}
+
+void CmuxPort::close()
+{
+  MutexLock lock(_mutex);
+  if (_closed)
+    return;
+  while (_received.size() > 0)
+  {
+    int dlci = _received.begin()->first;
+    _received.erase(_received.begin());
+    command(dlci, CMUX_DISC);
+  }
+
+  // close down, the ME answers with the CLD response
+  std::string cld;
+  cld += (char)(CMUX_CLD | CMUX_CR);
+  cld += (char)CMUX_EA;
+  sendFrame(0, CMUX_UIH, cld);
+  struct timeval startTime;
+  gettimeofday(&startTime, NULL);
+  while (! _closed && millisecondsSince(startTime) < CMUX_RESPONSE_TIMEOUT)
+  {
+    struct timeval slice = {0, CMUX_SLICE};
+    receive(&slice);
+  }
+  _closed = true;
+}
+
+CmuxPort::~CmuxPort()
+{
+  try
+  {
+    close();
+  }
+  catch (GsmException &)
+  {
+  }
+  pthread_cond_destroy(&_dispatched);
+  pthread_mutex_destroy(&_mutex);
+}
+
+// CmuxChannel members
+
+void CmuxChannel::putBack(unsigned char c)
+{
+  assert(_oldChar == -1);
+  _oldChar = c;
+}
+
+int CmuxChannel::readByte()
+{
+  if (_oldChar != -1)
+  {
+    int result = _oldChar;
+    _oldChar = -1;
+    return result;
+  }
+
+  int c = _mux->readByte(_dlci, _timeoutVal);
+#ifndef NDEBUG
+  if (debugLevel() >= 2)
+  {
+    if (c == LF)
+      std::cerr << "<LF>";
+    else if (c == CR)
+      std::cerr << "<CR>";
+    else
+      std::cerr << "<'" << (char) c << "'>";
+    std::cerr.flush();
+  }
+#endif
+  return c;
+}
+
+std::string CmuxChannel::getLine()
+{
+  std::string result;
+  int c;
+  while ((c = readByte()) >= 0)
+  {
+    while (c == CR)
+      c = readByte();
+    if (c == LF)
+      break;
+    result += c;
+  }
+
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "<-- [" << _dlci << "] " << result << std::endl;
+#endif
+
+  return result;
+}
+
+void CmuxChannel::putLine(std::string line, bool carriageReturn)
+{
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "--> [" << _dlci << "] " << line << std::endl;
+#endif
+
+  if (carriageReturn) line += CR;
+  _mux->write(_dlci, line);
+}
+
+bool CmuxChannel::wait(GsmTime timeout)
+{
+  if (_oldChar != -1)
+    return true;
+  return _mux->wait(_dlci, timeout);
+}
+
+void CmuxChannel::setTimeOut(unsigned int timeout)
+{
+  _timeoutVal = timeout;
+}
+
+CmuxChannel::~CmuxChannel()
+{
+  try
+  {
+    _mux->closeChannel(_dlci);
+  }
+  catch (GsmException &)
+  {
+  }
+}
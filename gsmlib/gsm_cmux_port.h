@@ -0,0 +1,134 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_cmux_port.h
+// *
+// * Purpose: GSM 07.10 (3GPP 27.010) multiplexer, virtual channels on top
+// *          of one serial port
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_CMUX_PORT_H
+#define GSM_CMUX_PORT_H
+
+#include <string>
+#include <map>
+#include <pthread.h>
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_port.h>
+#include <gsmlib/gsm_util.h>
+
+namespace gsmlib
+{
+  // The CmuxPort switches the ME/TA on port into multiplexer mode
+  // (basic option, AT+CMUX=0) and opens data link connections (DLCs) on
+  // it. Each DLC is a Port of its own that can be given to a MeTa, so one
+  // MeTa can eg. send SMS on one DLC while another one waits for
+  // unsolicited result codes on a second DLC.
+  // Frames are demultiplexed by whichever channel reads, data for the
+  // other channels is buffered until they read it. Channels may be used
+  // from different threads: only one thread at a time waits on the
+  // underlying port, without holding the lock, so that the others can
+  // write meanwhile, and the other readers wait until it has dispatched
+  // the frames. Therefore the wait() of the underlying port must allow
+  // putLine() from another thread (UnixSerialPort does).
+  // The CmuxPort must be allocated with new and held in a Ref, the
+  // channels keep it alive.
+
+  class CmuxPort : public RefBase, public NoCopy
+  {
+  private:
+    Ref<Port> _port;            // underlying serial port
+    std::map<int, std::string> _received; // data received per open DLC
+    std::map<int, int> _responses; // UA or DM received per DLC
+    std::string _frame;         // bytes of incomplete frame
+    bool _closed;               // multiplexer closed down
+    bool _reading;              // a thread waits on the underlying port
+    pthread_mutex_t _mutex;     // protects all of the above
+    pthread_cond_t _dispatched; // frames dispatched or reader done
+
+    // send one frame
+    void sendFrame(int dlci, unsigned char control,
+                   const std::string &info = "");
+
+    // wait for data from the underlying port and dispatch complete
+    // frames, or wait for the thread doing so
+    // called with _mutex held, which is released while waiting
+    // return false if no data arrived within timeout
+    bool receive(GsmTime timeout);
+
+    // read the data available on the underlying port and dispatch
+    // complete frames
+    void readFrames();
+    void handleFrame(int dlci, unsigned char control,
+                     const std::string &info);
+
+    // handle message on the control channel (DLC 0)
+    void handleControl(const std::string &info);
+
+    // send SABM or DISC and wait for UA or DM
+    // return true if the ME answered with UA
+    bool command(int dlci, unsigned char control);
+
+    // return number of bytes received for DLC dlci
+    // throw an exception if the DLC was closed
+    int dataAvailable(int dlci);
+
+    // used by CmuxChannel
+    int readByte(int dlci, long int timeout);
+    bool wait(int dlci, GsmTime timeout);
+    void write(int dlci, const std::string &data);
+    void closeChannel(int dlci);
+
+  public:
+    // switch ME/TA on port to multiplexer mode and open the control
+    // channel
+    // if sendCmux is false the ME/TA is assumed to be in multiplexer mode
+    // already
+    CmuxPort(Ref<Port> port, bool sendCmux = true);
+
+    // open DLC dlci (1..63) and return it as a Port
+    Ref<Port> openChannel(int dlci);
+
+    // close all DLCs and leave multiplexer mode
+    void close();
+
+    virtual ~CmuxPort();
+
+    friend class CmuxChannel;
+  };
+
+  // one DLC of a CmuxPort
+
+  class CmuxChannel : public Port
+  {
+  private:
+    Ref<CmuxPort> _mux;         // multiplexer
+    int _dlci;                  // my DLC
+    int _oldChar;               // character set by putBack() (-1 == none)
+    long int _timeoutVal;       // timeout for getLine/readByte
+
+    CmuxChannel(Ref<CmuxPort> mux, int dlci) :
+      _mux(mux), _dlci(dlci), _oldChar(-1), _timeoutVal(TIMEOUT_SECS) {}
+
+  public:
+    // return DLC number
+    int dlci() const {return _dlci;}
+
+    // inherited from Port
+    void putBack(unsigned char c);
+    int readByte();
+    std::string getLine();
+    void putLine(std::string line,
+                 bool carriageReturn = true);
+    bool wait(GsmTime timeout);
+    void setTimeOut(unsigned int timeout);
+
+    virtual ~CmuxChannel();
+
+    friend class CmuxPort;
+  };
+};
+
+#endif // GSM_CMUX_PORT_H
@@ -18,57 +18,159 @@
 #include <gsmlib/gsm_parser.h>
 #include <gsmlib/gsm_at.h>
 #include <gsmlib/gsm_me_ta.h>
+#include <ctype.h>
 
 using namespace gsmlib;
 
 // GsmEvent members
 
-void GsmEvent::dispatch(std::string s, GsmAt &at)
+GsmEvent::GsmEvent()
 {
+  URCNode root;
+  root._c = 0;
+  root._child = root._sibling = root._urc = -1;
+  _urcNodes.push_back(root);
+
+  // the common ones first, they are found first in the trie
+  setURC("+CMTI", CMTI, NULL);
+  setURC("+CMT", CMT, NULL);
+  setURC("+CDS", CDS, NULL);
+  setURC("RING", RING, NULL);
+  setURC("+CBM", CBM, NULL);
+  setURC("+CBMI", CBMI, NULL);
+  setURC("+CDSI", CDSI, NULL);
+  setURC("NO CARRIER", NoCarrier, NULL);
+  setURC("+CLIP", CLIP, NULL);
+}
+
+void GsmEvent::setURC(std::string tag, URCType type, URCHandler *handler)
+{
+  if (tag.length() > 0 && tag[tag.length() - 1] == ':')
+    tag.erase(tag.length() - 1);
+  if (tag.length() == 0)
+    throw GsmException(_("empty unsolicited result code"), ParameterError);
+
+  // find or add the nodes for the characters of tag
+  int node = 0;
+  for (std::string::iterator c = tag.begin(); c != tag.end(); ++c)
+  {
+    int next = _urcNodes[node]._child, last = -1;
+    while (next != -1 && _urcNodes[next]._c != *c)
+    {
+      last = next;
+      next = _urcNodes[next]._sibling;
+    }
+    if (next == -1)
+    {
+      URCNode newNode;
+      newNode._c = *c;
+      newNode._child = newNode._sibling = newNode._urc = -1;
+      next = _urcNodes.size();
+      _urcNodes.push_back(newNode);
+      if (last == -1)
+        _urcNodes[node]._child = next;
+      else
+        _urcNodes[last]._sibling = next;
+    }
+    node = next;
+  }
+
+  if (_urcNodes[node]._urc == -1)
+  {
+    _urcNodes[node]._urc = _urcs.size();
+    _urcs.push_back(URC());
+  }
+  URC &urc = _urcs[_urcNodes[node]._urc];
+  urc._tag = tag;
+  urc._type = type;
+  urc._handler = handler;
+}
+
+const GsmEvent::URC *GsmEvent::findURC(StringView line) const
+{
+  const URC *result = NULL;
+  int node = _urcNodes[0]._child;
+  size_t i = 0;
+  while (node != -1 && i < line.length())
+    if (_urcNodes[node]._c == line[i])
+    {
+      // a tag matches if it is not followed by more letters or digits,
+      // eg. "+CMT" does not match "+CMTI:"
+      ++i;
+      int urc = _urcNodes[node]._urc;
+      if (urc != -1 && _urcs[urc]._type != NoURC &&
+          (i == line.length() || ! isalnum((unsigned char)line[i])))
+        result = &_urcs[urc];
+      node = _urcNodes[node]._child;
+    }
+    else
+      node = _urcNodes[node]._sibling;
+  return result;
+}
+
+void GsmEvent::setURCHandler(std::string tag, URCHandler *handler)
+{
+  setURC(tag, handler == NULL ? NoURC : CustomURC, handler);
+}
+
+bool GsmEvent::dispatch(StringView s, GsmAt &at)
+{
+  const URC *urc = findURC(s);
+  if (urc == NULL)
+    return false;
+
+  // arguments after the tag and ':'
+  StringView arguments = s.substr(urc->_tag.length());
+  if (arguments.startsWith(":"))
+    arguments = arguments.substr(1);
+  arguments = arguments.trim();
+
+  GsmMetrics &metrics = at.getMeTa().getMetrics();
   SMSMessageType messageType;
   bool indication = false;
-  if (s.substr(0, 5) == "+CMT:")
+  switch (urc->_type)
+  {
+  case CMT:
     messageType = NormalSMS;
-  else if (s.substr(0, 5) == "+CBM:")
+    break;
+  case CBM:
     messageType = CellBroadcastSMS;
-  else if (s.substr(0, 5) == "+CDS:")
-  {
+    break;
+  case CDS:
     // workaround for phones that report CDS when they actually mean CDSI
     indication = at.getMeTa().getCapabilities()._CDSmeansCDSI;
     messageType = StatusReportSMS;
-  }
-  else if (s.substr(0, 6) == "+CMTI:")
-  {
+    break;
+  case CMTI:
     indication = true;
     messageType = NormalSMS;
-  }
-  else if (s.substr(0, 6) == "+CBMI:")
-  {
+    break;
+  case CBMI:
     indication = true;
     messageType = CellBroadcastSMS;
-  }
-  else if (s.substr(0, 6) == "+CDSI:")
-  {
+    break;
+  case CDSI:
     indication = true;
     messageType = StatusReportSMS;
-  }
-  else if (s.substr(0, 4) == "RING")
-  {
+    break;
+  case RING:
+    metrics.countURC(urc->_tag);
     ringIndication();
-    return;
-  }
-  // handling  NO CARRIER
-  else if (s.substr(0, 10) == "NO CARRIER")
-  {
+    return true;
+  case NoCarrier:
+    metrics.countURC(urc->_tag);
     noAnswer();
-    return;
-  }
-  
-  else if (s.substr(0, 6) == "+CLIP:")
+    return true;
+  case CLIP:
   {
+    // hack: the +CLIP? sequence returns +CLIP: n,m
+    // which is NOT an unsolicited result code
+    if (s.length() <= 10)
+      return false;
+    metrics.countURC(urc->_tag);
+
     //    <number>,<type>[,<subaddr>,<satype>[,<alpha>]]
-    s = s.substr(6);
-    Parser p(s);
+    Parser p(arguments);
     std::string num = p.parseString();
     if (p.parseComma(true))
     {
@@ -93,20 +195,29 @@ void GsmEvent::dispatch(std::string s, GsmAt &at)
     
     // call the event handler
     callerLineID(num, subAddr, alpha);
-    return;
+    return true;
   }
-  else
-    throw GsmException(stringPrintf(_("unexpected unsolicited event '%s'"),
-                                    s.c_str()), OtherError);
+  default:
+  {
+    // registered with setURCHandler(), the handler may register other
+    // tags and thereby move *urc
+    std::string::size_type tagLength = urc->_tag.length();
+    if (! urc->_handler->handleURC(s.substr(0, tagLength), arguments, at))
+      return false;
+    metrics.countURC(s.substr(0, tagLength).str());
+    return true;
+  }
+  }
+  metrics.countURC(urc->_tag);
 
   if (indication)
   {
     // handle SMS storage indication
-    s = s.substr(6);
-    Parser p(s);
+    Parser p(arguments);
     std::string storeName = p.parseString();
     p.parseComma();
     unsigned int index = p.parseInt();
+    at.getMeTa().SMSStoreIndication(storeName, index - 1);
     SMSReceptionIndication(storeName, index - 1, messageType);
   }
   else
@@ -138,6 +249,7 @@ void GsmEvent::dispatch(std::string s, GsmAt &at)
       // call the event handler
       SMSReception(sms, messageType);
     }
+  return true;
 }
 
 void GsmEvent::callerLineID(std::string number, std::string subAddr, std::string alpha)
@@ -167,6 +279,11 @@ void GsmEvent::ringIndication()
   // ignore event
 }
 
+void GsmEvent::SMSStoreFull(std::string storeName, int freeEntries)
+{
+  // ignore event
+}
+
 void GsmEvent::noAnswer()
 {
   // ignore event
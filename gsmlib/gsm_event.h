@@ -15,6 +15,8 @@
 
 #include <gsmlib/gsm_sms.h>
 #include <gsmlib/gsm_cb.h>
+#include <gsmlib/gsm_string_view.h>
+#include <vector>
 
 namespace gsmlib
 {
@@ -24,17 +26,72 @@ namespace gsmlib
 
   class GsmAt;
 
+  // handler for unsolicited result codes registered with
+  // GsmEvent::setURCHandler()
+
+  class URCHandler
+  {
+  public:
+    virtual ~URCHandler() { }
+
+    // called for a line starting with tag, arguments is the rest of the
+    // line after the ':' (both are only valid during the call)
+    // return false if the line is not unsolicited (eg. the response to
+    // a query with the same tag), GsmAt returns it to the caller then
+    virtual bool handleURC(StringView tag, StringView arguments,
+                           GsmAt &at) = 0;
+  };
+
   // event handler interface
 
   class GsmEvent
   {
   private:
-    // dispatch CMT/CBR/CDS/CLIP etc.
-    void dispatch(std::string s, GsmAt &at);
+    // unsolicited result codes handled by GsmEvent
+    enum URCType {NoURC, CMT, CBM, CDS, CMTI, CBMI, CDSI, RING, NoCarrier,
+                  CLIP, CustomURC};
+
+    struct URC
+    {
+      std::string _tag;         // eg. "+CMTI" or "RING"
+      URCType _type;
+      URCHandler *_handler;     // for CustomURC
+    };
+
+    // node of the trie of tags, the nodes for the characters that may
+    // follow a node are linked through _sibling
+    struct URCNode
+    {
+      char _c;
+      int _child;               // first node for the next character or -1
+      int _sibling;             // next node for this character or -1
+      int _urc;                 // index into _urcs if a tag ends here or -1
+    };
+
+    std::vector<URC> _urcs;
+    std::vector<URCNode> _urcNodes; // _urcNodes[0] is the root
+
+    // register tag, an existing registration is replaced
+    void setURC(std::string tag, URCType type, URCHandler *handler);
+
+    // return the URC with the longest tag that line starts with
+    // or NULL if line is not an unsolicited result code
+    const URC *findURC(StringView line) const;
+
+    // dispatch CMT/CBR/CDS/CLIP etc. and registered URCs
+    // return false if s is not an unsolicited result code
+    bool dispatch(StringView s, GsmAt &at);
 
   public:
+    GsmEvent();
     virtual ~GsmEvent() { }
 
+    // register handler for lines starting with tag (eg. "+CREG" or
+    // "^SIS", a ':' after the tag is optional in the lines)
+    // this replaces the handling of the tags known to GsmEvent,
+    // a NULL handler removes the tag, the handler is not owned
+    void setURCHandler(std::string tag, URCHandler *handler);
+
     // for SMSReception, type of SMS
     enum SMSMessageType {NormalSMS, CellBroadcastSMS, StatusReportSMS};
 
@@ -63,6 +120,12 @@ namespace gsmlib
     // RING indication
     virtual void ringIndication();
 
+    // SMS store is getting full, only freeEntries entries are left
+    // called once when SMSStore::setFullWarningLevel() is reached
+    // so that messages can be deleted before the ME rejects new ones
+    // (only for stores obtained with MeTa::getSMSStore())
+    virtual void SMSStoreFull(std::string storeName, int freeEntries);
+
     friend class gsmlib::GsmAt;
   };
 };
@@ -17,10 +17,15 @@
 #include <gsmlib/gsm_nls.h>
 #include <gsmlib/gsm_me_ta.h>
 #include <gsmlib/gsm_parser.h>
+#include <gsmlib/gsm_probe_cache.h>
+#include <gsmlib/gsm_recording_port.h>
+#include <gsmlib/gsm_tracing.h>
+#include <gsmlib/gsm_socket_port.h>
 #include <gsmlib/gsm_sysdep.h>
 
 #include <cstdint>
 #include <cstdlib>
+#include <iostream>
 
 using namespace gsmlib;
 
@@ -38,20 +43,194 @@ Capabilities::Capabilities() :
   _CDSmeansCDSI(false),         // Nokia Cellular Card Phone RPE-1 GSM900 and
                                 // Nokia Card Phone RPM-1 GSM900/1800
   _sendAck(false),              // send ack for directly routed SMS
-  _MotorolaModeCmd(false)       // send "+MODE=" to Motorola phone
+  _MotorolaModeCmd(false),      // send "+MODE=" to Motorola phone
+  _hasCMMS(false)               // set by MeTa::init() if +CMMS=? works
 {
 }
 
+// StateShadow members
+
+bool StateShadow::get(std::string setting, std::string &value) const
+{
+  if (! _enabled)
+    return false;
+  std::map<std::string, std::string>::const_iterator i =
+    _settings.find(setting);
+  if (i == _settings.end())
+    return false;
+  value = i->second;
+  return true;
+}
+
+bool StateShadow::has(std::string setting, std::string value) const
+{
+  std::string knownValue;
+  return get(setting, knownValue) && knownValue == value;
+}
+
+void StateShadow::set(std::string setting, std::string value)
+{
+  if (_enabled)
+    _settings[setting] = value;
+}
+
 // MeTa members
 
+void MeTa::setModelQuirks()
+{
+  // Ericsson model 6050102
+  if ((_meInfo._manufacturer == "ERICSSON" &&
+      (_meInfo._model == "1100801" ||
+       _meInfo._model == "1140801")) ||
+      getenv("GSMLIB_SH888_FIX") != NULL)
+  {
+    // the Ericsson leaves out the service centre address
+    _capabilities._hasSMSSCAprefix = false;
+  }
+
+  // handle Falcom strangeness
+  if ((_meInfo._manufacturer == "Funkanlagen Leipoldt OHG" &&
+      _meInfo._revision == "01.95.F2") ||
+      getenv("GSMLIB_FALCOM_A2_1_FIX") != NULL)
+  {
+    _capabilities._veryShortCOPSanswer = true;
+  }
+
+  // handle Motorola SMS store bug - wrong status code
+  if ((_meInfo._manufacturer == "Motorola" &&
+       _meInfo._model == "L Series"))
+  {
+    _capabilities._wrongSMSStatusCode = true;
+  } 
+ 
+  // handle Nokia Cellular Card Phone RPE-1 GSM900 and
+  // Nokia Card Phone RPM-1 GSM900/1800 bug - CDS means CDSI
+  if ((_meInfo._manufacturer == "Nokia Mobile Phones" &&
+       (_meInfo._model == "Nokia Cellular Card Phone RPE-1 GSM900" ||
+        _meInfo._model == "Nokia Card Phone RPM-1 GSM900/1800")))
+  {
+    _capabilities._CDSmeansCDSI = true;
+  } 
+}
+
+// aux function for MeTa::getMEInfo()
+
+static std::string stringVectorToString(const std::vector<std::string>& v,
+					char separator = '\n')
+{
+  if (v.empty())
+    return "";
+
+  // concatenate string in vector as rows
+  std::string result;
+  for (std::vector<std::string>::const_iterator i = v.begin();;)
+  {
+    std::string s = *i;
+    // remove leading and trailing "s
+    if (s.length() > 0 && s[0] == '"')
+      s.erase(s.begin());
+    if (s.length() > 0 && s[s.length() - 1] == '"')
+      s.erase(s.end() - 1);
+
+    result += s;
+    // don't add end line to last
+    if ( ++i == v.end() || !separator)
+      break;
+    result += separator;
+  }
+  return result;
+}
+
+bool MeTa::loadProbeCache()
+{
+  if (_probeCacheDir == "")
+    return false;
+
+  ProbeCacheEntry entry;
+  try
+  {
+    // the IMEI and the firmware revision identify the entry
+    std::string serialNumber =
+      stringVectorToString(_at->chatv("+CGSN", "+CGSN:", false), 0);
+    std::string revision =
+      stringVectorToString(_at->chatv("+CGMR", "+CGMR:", false));
+    // getMEInfo() need not ask again if there is no entry
+    _meInfo._serialNumber = serialNumber;
+    _meInfo._revision = revision;
+    _haveMEIdentity = true;
+    if (! ProbeCache(_probeCacheDir).load(serialNumber, revision, entry))
+      return false;
+  }
+  catch (GsmException&)
+  {
+    return false;               // eg. Motorola 60t before "+MODE=2"
+  }
+
+  _meInfo = entry._meInfo;
+  _haveMEInfo = true;
+  _capabilities._hasSMSPDUmode = entry._hasSMSPDUmode;
+  _capabilities._MotorolaModeCmd = entry._MotorolaModeCmd;
+  _capabilities._noCPBxParentheses = entry._noCPBxParentheses;
+  _capabilities._hasCMMS = entry._hasCMMS;
+  _capabilities._cpmsParamCount = entry._cpmsParamCount;
+  _charSets = entry._charSets;
+  _phonebookStrings = entry._phonebookStrings;
+  _smsStoreNames = entry._smsStoreNames;
+  _cnmiModes = entry._cnmiModes;
+  return true;
+}
+
+void MeTa::saveProbeCache()
+{
+  if (_probeCacheDir == "" || ! _haveMEInfo)
+    return;
+
+  ProbeCacheEntry entry;
+  entry._meInfo = _meInfo;
+  entry._hasSMSPDUmode = _capabilities._hasSMSPDUmode;
+  entry._MotorolaModeCmd = _capabilities._MotorolaModeCmd;
+  entry._noCPBxParentheses = _capabilities._noCPBxParentheses;
+  entry._hasCMMS = _capabilities._hasCMMS;
+  entry._cpmsParamCount = _capabilities._cpmsParamCount;
+  entry._charSets = _charSets;
+  entry._phonebookStrings = _phonebookStrings;
+  entry._smsStoreNames = _smsStoreNames;
+  entry._cnmiModes = _cnmiModes;
+  try
+  {
+    ProbeCache(_probeCacheDir).save(entry);
+  }
+  catch (GsmException &e)
+  {
+    ignoreOutputError("probe cache", e);
+  }
+}
+
 void MeTa::init()
 {
+  char *probeCacheDir = getenv("GSMLIB_PROBE_CACHE");
+  if (probeCacheDir != NULL)
+    _probeCacheDir = probeCacheDir;
+
+  char *traceFile = getenv("GSMLIB_TRACE");
+  if (traceFile != NULL && *traceFile != 0)
+    traceToFile(traceFile);
+
+  // set default event handler
+  // necessary to handle at least RING indications that might
+  // otherwise confuse gsmlib, gsmbrokerd also passes on indications
+  // meant for other clients while this one is initializing
+  _at->setEventHandler(&_defaultEventHandler);
+
+  bool cached = loadProbeCache();
+
   // Motorola 60t needs "+MODE=2" before it will respond to GSM commands;
   // however it will identify itself with the mandatory ITU-T V.25ter
   // generic TA control command "+GMM".
   try
   {
-    if (_at->chat("+GMM", "+GMM:") == "Motorola  60t Phone")
+    if (cached ? _capabilities._MotorolaModeCmd :
+        _at->chat("+GMM", "+GMM:") == "Motorola  60t Phone")
     {
       _capabilities._MotorolaModeCmd = true;
       _capabilities._noCPBxParentheses = true;
@@ -74,56 +253,28 @@ void MeTa::init()
   _at->chat("+CMEE=1", "", true, true);
   
   // select SMS pdu mode
-  try
-  {
-    _at->chat("+CMGF=0");
-  }
-  catch (GsmException&)
-  {
-    _capabilities._hasSMSPDUmode = false;
-  }
+  if (_capabilities._hasSMSPDUmode)
+    try
+    {
+      setState("+CMGF", "0");
+    }
+    catch (GsmException&)
+    {
+      _capabilities._hasSMSPDUmode = false;
+    }
 
   // now fill in capability object
-  MEInfo info = getMEInfo();
-  
-  // Ericsson model 6050102
-  if ((info._manufacturer == "ERICSSON" &&
-      (info._model == "1100801" ||
-       info._model == "1140801")) ||
-      getenv("GSMLIB_SH888_FIX") != NULL)
-  {
-    // the Ericsson leaves out the service centre address
-    _capabilities._hasSMSSCAprefix = false;
-  }
-
-  // handle Falcom strangeness
-  if ((info._manufacturer == "Funkanlagen Leipoldt OHG" &&
-      info._revision == "01.95.F2") ||
-      getenv("GSMLIB_FALCOM_A2_1_FIX") != NULL)
-  {
-    _capabilities._veryShortCOPSanswer = true;
-  }
-
-  // handle Motorola SMS store bug - wrong status code
-  if ((info._manufacturer == "Motorola" &&
-       info._model == "L Series"))
-  {
-    _capabilities._wrongSMSStatusCode = true;
-  } 
- 
-  // handle Nokia Cellular Card Phone RPE-1 GSM900 and
-  // Nokia Card Phone RPM-1 GSM900/1800 bug - CDS means CDSI
-  if ((info._manufacturer == "Nokia Mobile Phones" &&
-       (info._model == "Nokia Cellular Card Phone RPE-1 GSM900" ||
-        info._model == "Nokia Card Phone RPM-1 GSM900/1800")))
-  {
-    _capabilities._CDSmeansCDSI = true;
-  } 
+  if (! cached)
+    getMEInfo();
+  setModelQuirks();
 
   // find out whether we are supposed to send an acknowledgment
+  // (depends on the current message service, so it is not cached)
   Parser p(_at->chat("+CSMS?", "+CSMS:"));
   try {
-    _capabilities._sendAck = p.parseInt() >= 1;
+    int service = p.parseInt();
+    _state.set("+CSMS", intToStr(service));
+    _capabilities._sendAck = service >= 1;
   }
   catch (GsmException &e)
   {
@@ -133,6 +284,20 @@ void MeTa::init()
       throw e;
     }
   }
+
+  // find out whether the link to the SC can be kept open between
+  // consecutive SMS submissions
+  if (! cached)
+    try
+    {
+      Parser p(_at->chat("+CMMS=?", "+CMMS:"));
+      IntList modes = p.parseIntRanges();
+      _capabilities._hasCMMS = modes.contains(1) && modes.contains(2);
+    }
+    catch (GsmException&)
+    {
+      // ignore, +CMMS is not implemented by older phones
+    }
       
   // set GSM default character set
   try
@@ -144,14 +309,22 @@ void MeTa::init()
     // ignore errors, some devices don't support this
   }
 
-  // set default event handler
-  // necessary to handle at least RING indications that might
-  // otherwise confuse gsmlib
-  _at->setEventHandler(&_defaultEventHandler);
+  if (! cached)
+    saveProbeCache();
 }
 
-MeTa::MeTa(Ref<Port> port) : _port(port)
+MeTa::MeTa(Ref<Port> port) : _port(port), _moreMessagesToSend(0),
+  _haveMEInfo(false), _haveMEIdentity(false)
 {
+  // other clients of gsmbrokerd may change the settings behind our back
+  Port *basePort = _port.getptr();
+  RecordingPort *recordingPort = dynamic_cast<RecordingPort*>(basePort);
+  if (recordingPort != NULL)
+    basePort = recordingPort->port().getptr();
+  SocketPort *socketPort = dynamic_cast<SocketPort*>(basePort);
+  if (socketPort != NULL && socketPort->brokered())
+    _state.setEnabled(false);
+
   // initialize AT handling
   _at = new GsmAt(*this);
 
@@ -175,44 +348,57 @@ std::string MeTa::getPINStatus()
   return p.parseString();
 }
 
-void MeTa::setPhonebook(std::string phonebookName)
+void MeTa::setState(std::string setting, std::string value)
 {
-  if (phonebookName != _lastPhonebookName)
+  GsmAt::Lock lock(_at());
+  if (_state.has(setting, value))
   {
-    _at->chat("+CPBS=\"" + phonebookName + "\"");
-    _lastPhonebookName = phonebookName;
+    _state.countSuppressed();
+    return;
   }
+  // if the command fails the setting on the ME/TA is unknown
+  _state.invalidate(setting);
+  _state.countSent();
+  _at->chat(setting + "=" + value);
+  _state.set(setting, value);
+}
+
+void MeTa::setPhonebook(std::string phonebookName)
+{
+  setState("+CPBS", "\"" + phonebookName + "\"");
 }
 
 std::string MeTa::setSMSStore(std::string smsStore, int storeTypes, bool needResultCode)
 {
+  GsmAt::Lock lock(_at());
   if (_capabilities._cpmsParamCount == -1)
+    probeSMSStores();
+
+  // optimatization: only set current SMS stores if different from last
+  // call or the result code is needed
+  // the stores <mem1>, <mem2>, and <mem3> are shadowed as +CPMS1..3
+  int paramCount = std::min(_capabilities._cpmsParamCount, storeTypes);
+  bool unchanged = ! needResultCode;
+  for (int i = 1; i <= paramCount && unchanged; ++i)
+    unchanged = _state.has("+CPMS" + intToStr(i), smsStore);
+  if (unchanged)
   {
-    // count the number of parameters for the CPMS AT sequences
-    _capabilities._cpmsParamCount = 1;
-    Parser p(_at->chat("+CPMS=?", "+CPMS:"));
-    p.parseStringList();
-    while (p.parseComma(true))
-    {
-      ++_capabilities._cpmsParamCount;
-      p.parseStringList();
-    }
+    _state.countSuppressed();
+    return "";
   }
 
-  // optimatization: only set current SMS store if different from last call
-  // or the result code is needed
-  if (needResultCode || _lastSMSStoreName != smsStore)
-  {
-    _lastSMSStoreName = smsStore;
-
-    // build chat string
-    std::string chatString = "+CPMS=\"" + smsStore + "\"";
-    for (int i = 1; i < std::min(_capabilities._cpmsParamCount, storeTypes); ++i)
-      chatString += ",\"" + smsStore + "\"";
-
-    return _at->chat(chatString, "+CPMS:");
-  }
-  return "";
+  // build chat string
+  std::string chatString = "+CPMS=\"" + smsStore + "\"";
+  for (int i = 1; i < paramCount; ++i)
+    chatString += ",\"" + smsStore + "\"";
+
+  for (int i = 1; i <= paramCount; ++i)
+    _state.invalidate("+CPMS" + intToStr(i));
+  _state.countSent();
+  std::string result = _at->chat(chatString, "+CPMS:");
+  for (int i = 1; i <= paramCount; ++i)
+    _state.set("+CPMS" + intToStr(i), smsStore);
+  return result;
 }
 
 void MeTa::getSMSStore(std::string &readDeleteStore,
@@ -244,73 +430,63 @@ void MeTa::waitEvent(GsmTime timeout)
 {
   if (_at->wait(timeout))
     _at->chat();                // send AT, wait for OK, handle events
+  writeTraceIfRequested();
 }
 
-// aux function for MeTa::getMEInfo()
-
-static std::string stringVectorToString(const std::vector<std::string>& v,
-					char separator = '\n')
+MEInfo MeTa::getMEInfo()
 {
-  if (v.empty())
-    return "";
-
-  // concatenate string in vector as rows
-  std::string result;
-  for (std::vector<std::string>::const_iterator i = v.begin();;)
+  GsmAt::Lock lock(_at());
+  if (! _haveMEInfo)
   {
-    std::string s = *i;
-    // remove leading and trailing "s
-    if (s.length() > 0 && s[0] == '"')
-      s.erase(s.begin());
-    if (s.length() > 0 && s[s.length() - 1] == '"')
-      s.erase(s.end() - 1);
-
-    result += s;
-    // don't add end line to last
-    if ( ++i == v.end() || !separator)
-      break;
-    result += separator;
+    // some TAs just return OK and no info line
+    // leave the info empty in this case
+    // some TAs return multirows with info like address, firmware version
+    _meInfo._manufacturer =
+      stringVectorToString(_at->chatv("+CGMI", "+CGMI:", false));
+    _meInfo._model =
+      stringVectorToString(_at->chatv("+CGMM", "+CGMM:", false));
+    if (! _haveMEIdentity)
+    {
+      _meInfo._revision =
+        stringVectorToString(_at->chatv("+CGMR", "+CGMR:", false));
+      _meInfo._serialNumber =
+        stringVectorToString(_at->chatv("+CGSN", "+CGSN:", false),0);
+      _haveMEIdentity = true;
+    }
+    _haveMEInfo = true;
   }
-  return result;
-}
-
-MEInfo MeTa::getMEInfo()
-{
-  MEInfo result;
-  // some TAs just return OK and no info line
-  // leave the info empty in this case
-  // some TAs return multirows with info like address, firmware version
-  result._manufacturer =
-    stringVectorToString(_at->chatv("+CGMI", "+CGMI:", false));
-  result._model = stringVectorToString(_at->chatv("+CGMM", "+CGMM:", false));
-  result._revision =
-    stringVectorToString(_at->chatv("+CGMR", "+CGMR:", false));
-  result._serialNumber =
-    stringVectorToString(_at->chatv("+CGSN", "+CGSN:", false),0);
-  return result;
+  return _meInfo;
 }
 
 std::vector<std::string> MeTa::getSupportedCharSets()
 {
-  Parser p(_at->chat("+CSCS=?", "+CSCS:"));
-  // Some phones leave out the parentheses
-  return p.parseStringList(false, true);
+  GsmAt::Lock lock(_at());
+  if (_charSets.empty())
+  {
+    Parser p(_at->chat("+CSCS=?", "+CSCS:"));
+    // Some phones leave out the parentheses
+    _charSets = p.parseStringList(false, true);
+    saveProbeCache();
+  }
+  return _charSets;
 }
     
 std::string MeTa::getCurrentCharSet()
 {
-  if (_lastCharSet == "")
-  {
-    Parser p(_at->chat("+CSCS?", "+CSCS:"));
-    _lastCharSet = p.parseString();
-  }
-  return _lastCharSet;
+  GsmAt::Lock lock(_at());
+  std::string charSet;
+  if (_state.get("+CSCS", charSet))
+    return Parser(charSet).parseString();
+
+  Parser p(_at->chat("+CSCS?", "+CSCS:"));
+  charSet = p.parseString();
+  _state.set("+CSCS", "\"" + charSet + "\"");
+  return charSet;
 }
 
 void MeTa::setCharSet(std::string charSetName)
 {
-  _at->chat("+CSCS=\"" + charSetName + "\"");
-  _lastCharSet = "";
+  setState("+CSCS", "\"" + charSetName + "\"");
 }
 
 std::string MeTa::getExtendedErrorReport()
@@ -345,7 +521,7 @@ std::vector<OPInfo> MeTa::getAvailableOPInfo()
   {
     if (responses.size() == 1)
     {
-      Parser p(responses[0]);
+      Parser p((StringView)responses[0]);
       while (p.parseChar('(', true))
       {
         OPInfo opi;
@@ -383,7 +559,7 @@ std::vector<OPInfo> MeTa::getAvailableOPInfo()
 //         i->erase(i->length() - 1, 1);
 
       bool expectClosingParenthesis = false;
-      Parser p(*i);
+      Parser p((StringView)*i);
       while (1)
       {
         OPInfo opi;
@@ -410,20 +586,9 @@ std::vector<OPInfo> MeTa::getAvailableOPInfo()
           else
             throw e;
         }
-        try
-        {
-          opi._numericName = p.parseComma();
+        // skip access technology if present
+        if (p.parseComma(true))
           p.parseInt(true);
-        }
-        catch (GsmException &e)
-        {
-          if (e.getErrorClass() == ParserError)
-          {
-            /* okay */
-          }
-          else
-            throw e;
-        }
         if (expectClosingParenthesis) p.parseChar(')');
         result.push_back(opi);
         if (! p.parseComma(true)) break;
@@ -604,7 +769,7 @@ std::vector<std::string> MeTa::getFacilityLockCapabilities()
     locks.insert(locks.begin(),'(');
     locks += ')';
   }
-  Parser p(locks);
+  Parser p((StringView)locks);
   return p.parseStringList();
 }
 
@@ -618,7 +783,7 @@ bool MeTa::getFacilityLockStatus(std::string facility, FacilityClass cl)
   for (std::vector<std::string>::iterator i = responses.begin();
        i != responses.end(); ++i)
   {
-    Parser p(*i);
+    Parser p((StringView)*i);
     int enabled = p.parseInt();
 
     // if the first time and there is no comma this 
@@ -686,24 +851,29 @@ void MeTa::setPassword(std::string facility, std::string oldPasswd, std::string
 
 bool MeTa::getNetworkCLIP()
 {
+  GsmAt::Lock lock(_at());
   Parser p(_at->chat("+CLIP?", "+CLIP:"));
-  p.parseInt();                 // ignore result code presentation
+  _state.set("+CLIP", intToStr(p.parseInt())); // result code presentation
   p.parseComma();
   return p.parseInt() == 1;
 }
 
 void MeTa::setCLIPPresentation(bool enable)
 {
-  if (enable)
-    _at->chat("+CLIP=1");
-  else
-    _at->chat("+CLIP=0");
+  setState("+CLIP", enable ? "1" : "0");
 }
 
 bool MeTa::getCLIPPresentation()
 {
-  Parser p(_at->chat("+CLIP?", "+CLIP:"));
-  return p.parseInt() == 1;     // ignore rest of line
+  GsmAt::Lock lock(_at());
+  std::string clip;
+  if (! _state.get("+CLIP", clip))
+  {
+    Parser p(_at->chat("+CLIP?", "+CLIP:"));
+    clip = intToStr(p.parseInt()); // ignore rest of line
+    _state.set("+CLIP", clip);
+  }
+  return clip == "1";
 }
 
 void MeTa::setCallForwarding(ForwardReason reason,
@@ -773,7 +943,7 @@ void MeTa::getCallForwardInfo(ForwardReason reason,
   for (std::vector<std::string>::iterator i = responses.begin();
        i != responses.end(); ++i)
   {
-    Parser p(*i);
+    Parser p((StringView)*i);
     int status = p.parseInt();
     p.parseComma();
     FacilityClass cl = (FacilityClass)p.parseInt();
@@ -905,13 +1075,21 @@ int MeTa::getBitErrorRate()
 
 std::vector<std::string> MeTa::getPhoneBookStrings()
 {
-  Parser p(_at->chat("+CPBS=?", "+CPBS:"));
-  return p.parseStringList(false, _capabilities._noCPBxParentheses);
+  GsmAt::Lock lock(_at());
+  if (_phonebookStrings.empty())
+  {
+    Parser p(_at->chat("+CPBS=?", "+CPBS:"));
+    _phonebookStrings =
+      p.parseStringList(false, _capabilities._noCPBxParentheses);
+    saveProbeCache();
+  }
+  return _phonebookStrings;
 }
 
 PhonebookRef MeTa::getPhonebook(std::string phonebookString,
                                 bool preload)
 {
+  GsmAt::Lock lock(_at());
   for (PhonebookVector::iterator i = _phonebookCache.begin();
        i !=  _phonebookCache.end(); ++i)
   {
@@ -943,15 +1121,32 @@ void MeTa::setServiceCentreAddress(std::string sca)
   Parser p(_at->chat("+CSCA=\"" + sca + "\"," + intToStr(type)));
 }
 
-std::vector<std::string> MeTa::getSMSStoreNames()
+void MeTa::probeSMSStores()
 {
   Parser p(_at->chat("+CPMS=?", "+CPMS:"));
-  // only return <mem1> values
-  return p.parseStringList();
+  // remember <mem1> values
+  _smsStoreNames = p.parseStringList();
+  // count the number of parameters for the CPMS AT sequences
+  _capabilities._cpmsParamCount = 1;
+  while (p.parseComma(true))
+  {
+    ++_capabilities._cpmsParamCount;
+    p.parseStringList();
+  }
+  saveProbeCache();
+}
+
+std::vector<std::string> MeTa::getSMSStoreNames()
+{
+  GsmAt::Lock lock(_at());
+  if (_smsStoreNames.empty())
+    probeSMSStores();
+  return _smsStoreNames;
 }
 
 SMSStoreRef MeTa::getSMSStore(std::string storeName)
 {
+  GsmAt::Lock lock(_at());
   for (SMSStoreVector::iterator i = _smsStoreCache.begin();
        i !=  _smsStoreCache.end(); ++i)
   {
@@ -963,79 +1158,89 @@ SMSStoreRef MeTa::getSMSStore(std::string storeName)
   return newSs;
 }
 
-void MeTa::sendSMS(Ref<SMSSubmitMessage> smsMessage)
+void MeTa::SMSStoreIndication(std::string storeName, int index)
+{
+  for (SMSStoreVector::iterator i = _smsStoreCache.begin();
+       i !=  _smsStoreCache.end(); ++i)
+    if ((*i)->name() == storeName)
+      (*i)->indication(index);
+}
+
+unsigned char MeTa::sendSMS(Ref<SMSSubmitMessage> smsMessage)
 {
+  TraceSpan span("sms", "send SMS");
   smsMessage->setAt(_at);
-  smsMessage->send();
+  return smsMessage->send();
+}
+
+std::vector<unsigned char> MeTa::sendSMSs(Ref<SMSSubmitMessage> smsTemplate,
+                                          std::string text, bool oneSMS,
+                                          int concatenatedMessageId)
+{
+  TraceSpan span("sms", "send SMS parts");
+  std::vector<Ref<SMSSubmitMessage> > sms =
+    splitSMSText(smsTemplate, text, oneSMS, concatenatedMessageId);
+
+  // keep the link to the SC open for the following parts
+  if (sms.size() > 1)
+    keepLinkOpen();
+
+  std::vector<unsigned char> messageReferences;
+  for (std::vector<Ref<SMSSubmitMessage> >::iterator i = sms.begin();
+       i != sms.end(); ++i)
+    messageReferences.push_back(sendSMS(*i));
+  return messageReferences;
 }
 
-void MeTa::sendSMSs(Ref<SMSSubmitMessage> smsTemplate, std::string text,
-                    bool oneSMS,
-                    int concatenatedMessageId)
+std::vector<unsigned char> MeTa::sendSMSs(Ref<SMSSubmitTemplate> smsTemplate,
+                                          Address destination)
 {
   assert(! smsTemplate.isnull());
+  TraceSpan span("sms", "send SMS parts");
 
-  // compute maximum text length for normal SMSs and concatenated SMSs
-  unsigned int maxTextLength, concMaxTextLength;
-  switch (smsTemplate->dataCodingScheme().getAlphabet())
+  if (smsTemplate->parts() > 1)
+    keepLinkOpen();
+
+  std::vector<unsigned char> messageReferences;
+  for (unsigned int i = 0; i < smsTemplate->parts(); ++i)
   {
-  case DCS_DEFAULT_ALPHABET:
-    maxTextLength = 160;
-    concMaxTextLength = 152;
-    break;
-  case DCS_EIGHT_BIT_ALPHABET:
-    maxTextLength = 140;
-    concMaxTextLength = 134;
-    break;
-  case DCS_SIXTEEN_BIT_ALPHABET:
-    maxTextLength = 70;
-    concMaxTextLength = 67;
-    break;
-  default:
-    throw GsmException(_("unsupported alphabet for SMS"),
-                       ParameterError);
-    break;
+    std::string pdu = smsTemplate->pdu(i, destination);
+    Parser p(_at->sendPdu("+CMGS=" + intToStr(smsTemplate->tpduLength(pdu)),
+                          "+CMGS:", pdu));
+    messageReferences.push_back(p.parseInt());
   }
+  return messageReferences;
+}
 
-  // simple case, only send one SMS
-  if (oneSMS || text.length() <= maxTextLength)
+void MeTa::keepLinkOpen()
+{
+  // not needed if the caller already did so for the whole batch
+  if (! _capabilities._hasCMMS || _moreMessagesToSend == 2)
+    return;
+  try
   {
-    if (text.length() > maxTextLength)
-      throw GsmException(_("SMS text is larger than allowed"),
-                         ParameterError);
-    smsTemplate->setUserData(text);
-    sendSMS(smsTemplate);
+    _at->chat("+CMMS=1");
   }
-  else                          // send multiple SMSs
+  catch (GsmException&)
   {
-    if (concatenatedMessageId != -1)
-      maxTextLength = concMaxTextLength;
-
-    int numMessages = (text.length() + maxTextLength - 1) / maxTextLength;
-    if (numMessages > 255)
-      throw GsmException(_("not more than 255 concatenated SMSs allowed"),
-                         ParameterError);
-    unsigned char numMessage = 0;
-    while (true)
-    {
-      if (concatenatedMessageId != -1)
-      {
-        unsigned char udhs[] = {0x00, 0x03, (uint8_t)concatenatedMessageId,
-                                (uint8_t)numMessages, ++numMessage};
-        UserDataHeader udh(std::string((char*)udhs, 5));
-        smsTemplate->setUserDataHeader(udh);
-      }
-      smsTemplate->setUserData(text.substr(0, maxTextLength));
-      sendSMS(smsTemplate);
-      if (text.length() < maxTextLength)
-        break;
-      text.erase(0, maxTextLength);
-    }
+    // ignore, this is only an optimisation
   }
 }
 
+void MeTa::setMoreMessagesToSend(int mode)
+{
+  if (mode < 0 || mode > 2)
+    throw GsmException(_("only modes 0, 1, or 2 supported for +CMMS"),
+                       ParameterError);
+  if (! _capabilities._hasCMMS)
+    return;
+  _at->chat("+CMMS=" + intToStr(mode));
+  _moreMessagesToSend = mode;
+}
+
 void MeTa::setMessageService(int serviceLevel)
 {
+  GsmAt::Lock lock(_at());
   std::string s;
   switch (serviceLevel)
   {
@@ -1049,8 +1254,16 @@ void MeTa::setMessageService(int serviceLevel)
     throw GsmException(_("only serviceLevel 0 or 1 supported"),
                        ParameterError);
   }
+  if (_state.has("+CSMS", s))
+  {
+    _state.countSuppressed();
+    return;
+  }
   // some devices (eg. Origo 900) don't support service level setting
-  _at->chat("+CSMS=" + s, "+CSMS:", true);
+  _state.invalidate("+CSMS");
+  _state.countSent();
+  if (_at->chat("+CSMS=" + s, "+CSMS:", true) != "")
+    _state.set("+CSMS", s);
 }
 
 unsigned int MeTa::getMessageService()
@@ -1107,33 +1320,39 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
                              bool enableStatReport,
                              bool onlyReceptionIndication)
 {
+  GsmAt::Lock lock(_at());
   bool smsModesSet = false;
   bool cbsModesSet = false;
   bool statModesSet = false;
   bool bufferModesSet = false;
 
   // find out capabilities
-  Parser p(_at->chat("+CNMI=?", "+CNMI:"));
-  std::vector<bool> modes = p.parseIntList();
-  std::vector<bool> smsModes(1);
-  std::vector<bool> cbsModes(1);
-  std::vector<bool> statModes(1);
-  std::vector<bool> bufferModes(1);
+  if (_cnmiModes == "")
+  {
+    _cnmiModes = _at->chat("+CNMI=?", "+CNMI:");
+    saveProbeCache();
+  }
+  Parser p((StringView)_cnmiModes);
+  IntList modes = p.parseIntRanges();
+  IntList smsModes;
+  IntList cbsModes;
+  IntList statModes;
+  IntList bufferModes;
   if (p.parseComma(true))
   {
-    smsModes = p.parseIntList();
+    smsModes = p.parseIntRanges();
     smsModesSet = true;
     if (p.parseComma(true))
     {
-      cbsModes = p.parseIntList();
+      cbsModes = p.parseIntRanges();
       cbsModesSet = true;
       if (p.parseComma(true))
       {
-        statModes = p.parseIntList();
+        statModes = p.parseIntRanges();
         statModesSet = true;
         if (p.parseComma(true))
         {
-          bufferModes = p.parseIntList();
+          bufferModes = p.parseIntRanges();
           bufferModesSet = true;
         }
       }
@@ -1141,10 +1360,10 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
   }
 
   // now set the mode vectors to the default if not set
-  if (! smsModesSet) smsModes[0] = true;
-  if (! cbsModesSet) cbsModes[0] = true;
-  if (! statModesSet) statModes[0] = true;
-  if (! bufferModesSet) bufferModes[0] = true;
+  if (! smsModesSet) smsModes.add(0);
+  if (! cbsModesSet) cbsModes.add(0);
+  if (! statModesSet) statModes.add(0);
+  if (! bufferModesSet) bufferModes.add(0);
   
   std::string chatString;
     
@@ -1152,13 +1371,13 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
   // ME/TA's capabilities
 
   // handle modes
-  if (isSet(modes, 2))
+  if (modes.contains(2))
     chatString = "2";
-  else if (isSet(modes, 1))
+  else if (modes.contains(1))
     chatString = "1";
-  else if (isSet(modes, 0))
+  else if (modes.contains(0))
     chatString = "0";
-  else if (isSet(modes, 3))
+  else if (modes.contains(3))
     chatString = "3";
 
   if (onlyReceptionIndication)
@@ -1166,7 +1385,7 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
     // handle sms mode
     if (enableSMS)
     {
-      if (isSet(smsModes, 1))
+      if (smsModes.contains(1))
         chatString += ",1";
       else 
         throw GsmException(_("cannot route SMS messages to TE"),
@@ -1178,9 +1397,9 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
     // handle cbs mode
     if (enableCBS)
     {
-      if (isSet(cbsModes, 1))
+      if (cbsModes.contains(1))
         chatString += ",1";
-      else if (isSet(cbsModes, 2))
+      else if (cbsModes.contains(2))
         chatString += ",2";
       else 
         throw GsmException(_("cannot route cell broadcast messages to TE"),
@@ -1192,7 +1411,7 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
     // handle stat mode
     if (enableStatReport)
     {
-      if (isSet(statModes, 2))
+      if (statModes.contains(2))
         chatString += ",2";
       else 
         throw GsmException(_("cannot route status reports messages to TE"),
@@ -1206,9 +1425,9 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
     // handle sms mode
     if (enableSMS)
     {
-      if (isSet(smsModes, 2))
+      if (smsModes.contains(2))
         chatString += ",2";
-      else if (isSet(smsModes, 3))
+      else if (smsModes.contains(3))
         chatString += ",3";
       else 
         throw GsmException(_("cannot route SMS messages to TE"),
@@ -1220,9 +1439,9 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
     // handle cbs mode
     if (enableCBS)
     {
-      if (isSet(cbsModes, 2))
+      if (cbsModes.contains(2))
         chatString += ",2";
-      else if (isSet(cbsModes, 3))
+      else if (cbsModes.contains(3))
         chatString += ",3";
       else 
         throw GsmException(_("cannot route cell broadcast messages to TE"),
@@ -1234,9 +1453,9 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
     // handle stat mode
     if (enableStatReport)
     {
-      if (isSet(statModes, 1))
+      if (statModes.contains(1))
         chatString += ",1";
-      else if (isSet(statModes, 2))
+      else if (statModes.contains(2))
         chatString += ",2";
       else 
         throw GsmException(_("cannot route status report messages to TE"),
@@ -1250,13 +1469,13 @@ void MeTa::setSMSRoutingToTA(bool enableSMS, bool enableCBS,
   // the Ericsson GM12 GSM modem does not like it otherwise
   if (bufferModesSet)
     {
-      if (isSet(bufferModes, 1))
+      if (bufferModes.contains(1))
 	chatString += ",1";
       else
 	chatString += ",0";
     }
 
-  _at->chat("+CNMI=" + chatString);
+  setState("+CNMI", chatString);
 }
 
 bool MeTa::getCallWaitingLockStatus(FacilityClass cl)
@@ -1269,7 +1488,7 @@ bool MeTa::getCallWaitingLockStatus(FacilityClass cl)
   for (std::vector<std::string>::iterator i = responses.begin();
        i != responses.end(); ++i)
   {
-    Parser p(*i);
+    Parser p((StringView)*i);
     int enabled = p.parseInt();
 
     // if the first time and there is no comma this 
@@ -1299,23 +1518,31 @@ void MeTa::setCallWaitingLockStatus(FacilityClass cl, bool lock)
 
 void MeTa::setCLIRPresentation(bool enable)
 {
-  if (enable)
-    _at->chat("+CLIR=1");
-  else
-    _at->chat("+CLIR=0");
+  setState("+CLIR", enable ? "1" : "0");
 }
 
 int MeTa::getCLIRPresentation()
 {
+  GsmAt::Lock lock(_at());
   // 0:according to the subscription of the CLIR service
   // 1:CLIR invocation
   // 2:CLIR suppression
+  std::string clir;
+  if (_state.get("+CLIR", clir))
+    return atoi(clir.c_str());
   Parser p(_at->chat("+CLIR?", "+CLIR:"));
-  return p.parseInt();
+  int result = p.parseInt();
+  _state.set("+CLIR", intToStr(result));
+  return result;
 }
 
 MeTa::~MeTa()
 {
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "*** " << _state.sentCount() << " setting commands sent, "
+              << _state.suppressedCount() << " suppressed" << std::endl;
+#endif
   // Take Motorola 60t out of GSM command mode.
   if (_capabilities._MotorolaModeCmd)
   {
@@ -20,9 +20,11 @@
 #include <gsmlib/gsm_sms_store.h>
 #include <gsmlib/gsm_util.h>
 #include <gsmlib/gsm_at.h>
+#include <gsmlib/gsm_metrics.h>
 #include <gsmlib/gsm_sms.h>
 #include <string>
 #include <vector>
+#include <map>
 
 namespace gsmlib
 {
@@ -43,8 +45,52 @@ namespace gsmlib
     bool _CDSmeansCDSI;         // Nokia Cellular Card Phone RPE-1 GSM900
     bool _sendAck;              // send ack for directly routed SMS
     bool _MotorolaModeCmd;      // send "+MODE=" to Motorola 60t
+    bool _hasCMMS;              // can keep SMS relay link open (+CMMS)
     Capabilities();             // constructor, set default behaviours
   };
+
+  // *** shadow of the configurable ME/TA state
+
+  // MeTa remembers the values of settings like +CSCS, +CMGF, +CPMS,
+  // +CNMI, +CSMS, +CLIP, and +CLIR so that commands that would not change
+  // anything need not be sent
+  // settings are keyed by their AT command, the values are the command
+  // parameters as sent to the ME/TA
+  class StateShadow
+  {
+  private:
+    std::map<std::string, std::string> _settings; // known settings
+    bool _enabled;              // if false nothing is known
+    unsigned long _sentCount;   // setting commands sent
+    unsigned long _suppressedCount; // setting commands not sent
+
+  public:
+    StateShadow() : _enabled(true), _sentCount(0), _suppressedCount(0) {}
+
+    // return true and the value if setting is known
+    bool get(std::string setting, std::string &value) const;
+
+    // return true if setting is known to have value
+    bool has(std::string setting, std::string value) const;
+
+    // remember that setting now has value
+    void set(std::string setting, std::string value);
+
+    // forget setting (eg. after an error)
+    void invalidate(std::string setting) {_settings.erase(setting);}
+
+    // forget all settings (eg. after ATZ)
+    void invalidate() {_settings.clear();}
+
+    // switch shadowing off if other programs may change the settings
+    void setEnabled(bool enabled) {_enabled = enabled; _settings.clear();}
+
+    // statistics
+    void countSent() {++_sentCount;}
+    void countSuppressed() {++_suppressedCount;}
+    unsigned long sentCount() const {return _sentCount;}
+    unsigned long suppressedCount() const {return _suppressedCount;}
+  };
   
   // *** auxiliary structs
 
@@ -126,16 +172,44 @@ namespace gsmlib
     Ref<GsmAt> _at;             // chat object for the port
     PhonebookVector _phonebookCache; // cache of all used phonebooks
     SMSStoreVector _smsStoreCache; // cache of all used phonebooks
-    std::string _lastPhonebookName;  // remember last phonebook set on ME/TA
-    std::string _lastSMSStoreName;   // remember last SMS store set on ME/TA
     Capabilities _capabilities; // ME/TA quirks
     GsmEvent _defaultEventHandler; // default event handler
                                 // see comments in MeTa::init()
-    std::string _lastCharSet;        // remember last character set
+    StateShadow _state;         // remember settings made on ME/TA
+    GsmMetrics _metrics;        // latencies and counters of AT commands
+    int _moreMessagesToSend;    // last mode set with +CMMS
+    std::string _probeCacheDir; // directory of the ProbeCache ("" if none)
+    bool _haveMEInfo;           // _meInfo is valid
+    bool _haveMEIdentity;       // _meInfo has revision and serial number
+    MEInfo _meInfo;             // cached result of getMEInfo()
+    std::vector<std::string> _charSets; // cached getSupportedCharSets()
+    std::vector<std::string> _phonebookStrings; // cached getPhoneBookStrings()
+    std::vector<std::string> _smsStoreNames; // cached getSMSStoreNames()
+    std::string _cnmiModes;     // cached +CNMI=? response
 
     // init ME/TA to sensible defaults
     void init();
 
+    // set capabilities that depend on the ME model in _meInfo
+    void setModelQuirks();
+
+    // restore probe results for the connected ME from the ProbeCache
+    // return false if there is no valid entry
+    bool loadProbeCache();
+
+    // write probe results to the ProbeCache (if enabled)
+    void saveProbeCache();
+
+    // query SMS store names and number of +CPMS parameters (+CPMS=?)
+    void probeSMSStores();
+
+    // send setting=value unless the ME/TA is known to have this value
+    // setting is forgotten if the command fails
+    void setState(std::string setting, std::string value);
+
+    // keep link to the SC open for the next SMS (+CMMS=1) if supported
+    void keepLinkOpen();
+
   public:
     // initialize a new MeTa object given the port
     MeTa(Ref<Port> port);
@@ -163,7 +237,15 @@ namespace gsmlib
                      std::string &receiveStore);
 
     // get capabilities of this ME/TA
-    Capabilities getCapabilities() const {return _capabilities;}
+    const Capabilities &getCapabilities() const {return _capabilities;}
+
+    // return the shadow of the ME/TA settings
+    // call invalidate() on it after changing settings with raw AT commands
+    StateShadow &getStateShadow() {return _state;}
+
+    // return the metrics of the AT commands sent to this ME/TA
+    // (use snapshot() to keep the current values)
+    GsmMetrics &getMetrics() {return _metrics;}
 
     // return my port
     Ref<Port> getPort() {return _port;}
@@ -171,6 +253,15 @@ namespace gsmlib
     // return my at handler
     Ref<GsmAt> getAt() {return _at;}
 
+    // allow this MeTa to be used by several threads (eg. one waiting for
+    // events and one sending SMS), must be called before the threads start
+    // AT transactions, the store selections and cached ME/TA information
+    // are then protected by the GsmAt mutex
+    // Phonebook and SMSStore objects, their entries, and the metrics
+    // must still be used by one thread at a time, indications of new SMS
+    // read by another thread are applied to an SMSStore by its next use
+    void setThreadSafe(bool threadSafe) {_at->setThreadSafe(threadSafe);}
+
     // set event handler for unsolicited result codes
     GsmEvent *setEventHandler(GsmEvent *newHandler)
       {return _at->setEventHandler(newHandler);}
@@ -181,9 +272,10 @@ namespace gsmlib
     // *** ETSI GSM 07.07 Section 5: "General Commands"
 
     // return ME information
+    // (queried only once, static information is cached by the MeTa)
     MEInfo getMEInfo();
 
-    // return available character sets
+    // return available character sets (cached)
     std::vector<std::string> getSupportedCharSets();// (+CSCS=?)
     
     // return current character set (default: GSM)
@@ -313,7 +405,7 @@ namespace gsmlib
     // 99 not known or not detectable
     int getBitErrorRate();
 
-    // get available phone book memory storage strings (+CPBS=?)
+    // get available phone book memory storage strings (+CPBS=?, cached)
     std::vector<std::string> getPhoneBookStrings();
 
     // get phone book given the phone book memory storage string
@@ -329,14 +421,18 @@ namespace gsmlib
     // set service centre address (+CSCA=)
     void setServiceCentreAddress(std::string sca);
     
-    // return names of available message stores (<mem1>, +CPMS=?)
+    // return names of available message stores (<mem1>, +CPMS=?, cached)
     std::vector<std::string> getSMSStoreNames();
 
     // return SMS store given the name
     SMSStoreRef getSMSStore(std::string storeName);
 
-    // send a single SMS message
-    void sendSMS(Ref<SMSSubmitMessage> smsMessage);
+    // tell the SMS store (if already used) about a new message at index
+    // called by GsmEvent for +CMTI, +CBMI, and +CDSI indications
+    void SMSStoreIndication(std::string storeName, int index);
+
+    // send a single SMS message, return the message reference (TP-MR)
+    unsigned char sendSMS(Ref<SMSSubmitMessage> smsMessage);
 
     // send one or several (concatenated) SMS messages
     // The SUBMIT message template must have all options set, only
@@ -345,10 +441,32 @@ namespace gsmlib
     // are sent. If concatenatedMessageId is != -1 this is used as the message
     // ID for concatenated SMS (for this a user data header as defined in
     // GSM GTS 3.40 is used, the old UDH in the template is overwritten).
-    void sendSMSs(Ref<SMSSubmitMessage> smsTemplate, std::string text,
+    // Returns the message references (TP-MR) of all SMSs sent.
+    std::vector<unsigned char> sendSMSs(Ref<SMSSubmitMessage> smsTemplate, std::string text,
                   bool oneSMS = false,
                   int concatenatedMessageId = -1);
 
+    // send the pre-encoded SMS(s) of smsTemplate to destination
+    // this is much faster than the above when sending the same text
+    // to many recipients
+    // Returns the message references (TP-MR) of all SMSs sent.
+    std::vector<unsigned char> sendSMSs(Ref<SMSSubmitTemplate> smsTemplate,
+                                        Address destination);
+
+    // keep the relay protocol link to the SC open between
+    // consecutive SMS submissions (+CMMS=), mode is
+    //   0 to disable
+    //   1 to keep it open until the time between two submissions
+    //     exceeds 1-5 seconds, then the ME switches back to 0
+    //   2 to keep it open until disabled again
+    // sendSMSs() uses mode 1 for concatenated SMS by itself, use mode 2
+    // around a batch of sendSMSs() calls
+    // does nothing if the ME does not support +CMMS
+    void setMoreMessagesToSend(int mode);
+
+    // return mode set with setMoreMessagesToSend()
+    int getMoreMessagesToSend() const {return _moreMessagesToSend;}
+
     // set SMS service level
     // if set to 1 send commands return ACK PDU, 0 is the default
     void setMessageService(int serviceLevel);
@@ -0,0 +1,218 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_metrics.cc
+// *
+// * Purpose: Latency histograms and counters of the AT commands sent to
+// *          an ME/TA
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <gsmlib/gsm_metrics.h>
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_util.h>
+#include <fstream>
+#include <limits>
+#include <ctype.h>
+#include <stdlib.h>
+
+using namespace gsmlib;
+
+// bucket bounds in seconds, from fast local commands to network
+// operations like sending an SMS
+static const double bucketBounds[LATENCY_BUCKETS - 1] =
+  {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+
+// escape label value
+static std::string label(const std::string &s)
+{
+  std::string result;
+  for (std::string::const_iterator i = s.begin(); i != s.end(); ++i)
+    if (*i == '\\' || *i == '"')
+      result += std::string("\\") + *i;
+    else if (*i == '\n')
+      result += "\\n";
+    else
+      result += *i;
+  return result;
+}
+
+// Command members
+
+GsmMetrics::Command::Command() : _count(0), _errors(0), _latencySum(0)
+{
+  for (int i = 0; i < LATENCY_BUCKETS; ++i)
+    _latencyBuckets[i] = 0;
+}
+
+// Error members
+
+bool GsmMetrics::Error::operator<(const Error &e) const
+{
+  if (_verb != e._verb)
+    return _verb < e._verb;
+  if (_type != e._type)
+    return _type < e._type;
+  return _code < e._code;
+}
+
+// GsmMetrics members
+
+std::string GsmMetrics::verb(const std::string &atCommand)
+{
+  if (atCommand.length() == 0)
+    return "AT";
+  std::string result(1, toupper(atCommand[0]));
+  if (isalpha(atCommand[0]))
+    return result;              // basic command, eg. "Z" or "E0"
+  // extended command, eg. "+CMGS=..." or "&F"
+  for (std::string::size_type i = 1;
+       i < atCommand.length() && isalnum(atCommand[i]); ++i)
+    result += toupper(atCommand[i]);
+  return result;
+}
+
+double GsmMetrics::bucketBound(int i)
+{
+  if (i < LATENCY_BUCKETS - 1)
+    return bucketBounds[i];
+  return std::numeric_limits<double>::infinity();
+}
+
+void GsmMetrics::countCommand(const std::string &verb, double seconds)
+{
+  if (! _enabled)
+    return;
+  Command &command = _commands[verb];
+  ++command._count;
+  command._latencySum += seconds;
+  int i = 0;
+  while (i < LATENCY_BUCKETS - 1 && seconds > bucketBounds[i])
+    ++i;
+  ++command._latencyBuckets[i];
+}
+
+void GsmMetrics::countError(const std::string &verb, std::string type,
+                            int code)
+{
+  if (! _enabled)
+    return;
+  ++_commands[verb]._errors;
+  ++_errors[Error(verb, type, code)];
+}
+
+void GsmMetrics::countURC(const std::string &type)
+{
+  if (_enabled)
+    ++_urcs[type];
+}
+
+void GsmMetrics::reset()
+{
+  _commands.clear();
+  _errors.clear();
+  _urcs.clear();
+  _bytesIn = _bytesOut = 0;
+}
+
+void GsmMetrics::add(const GsmMetrics &metrics)
+{
+  for (CommandMap::const_iterator i = metrics._commands.begin();
+       i != metrics._commands.end(); ++i)
+  {
+    Command &command = _commands[i->first];
+    command._count += i->second._count;
+    command._errors += i->second._errors;
+    command._latencySum += i->second._latencySum;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b)
+      command._latencyBuckets[b] += i->second._latencyBuckets[b];
+  }
+  for (ErrorMap::const_iterator i = metrics._errors.begin();
+       i != metrics._errors.end(); ++i)
+    _errors[i->first] += i->second;
+  for (URCMap::const_iterator i = metrics._urcs.begin();
+       i != metrics._urcs.end(); ++i)
+    _urcs[i->first] += i->second;
+  _bytesIn += metrics._bytesIn;
+  _bytesOut += metrics._bytesOut;
+}
+
+void GsmMetrics::writePrometheus(std::ostream &os) const
+{
+  os << "# HELP gsmlib_at_command_duration_seconds "
+     << "Time from sending an AT command to its final result code"
+     << std::endl
+     << "# TYPE gsmlib_at_command_duration_seconds histogram" << std::endl;
+  for (CommandMap::const_iterator i = _commands.begin();
+       i != _commands.end(); ++i)
+  {
+    std::string verb = "verb=\"" + label(i->first) + "\"";
+    unsigned long cumulative = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b)
+    {
+      cumulative += i->second._latencyBuckets[b];
+      os << "gsmlib_at_command_duration_seconds_bucket{" << verb << ",le=\"";
+      if (b < LATENCY_BUCKETS - 1)
+        os << bucketBounds[b];
+      else
+        os << "+Inf";
+      os << "\"} " << cumulative << std::endl;
+    }
+    os << "gsmlib_at_command_duration_seconds_sum{" << verb << "} "
+       << i->second._latencySum << std::endl
+       << "gsmlib_at_command_duration_seconds_count{" << verb << "} "
+       << i->second._count << std::endl;
+  }
+
+  os << "# HELP gsmlib_at_command_errors_total "
+     << "AT commands answered with an error" << std::endl
+     << "# TYPE gsmlib_at_command_errors_total counter" << std::endl;
+  for (ErrorMap::const_iterator i = _errors.begin(); i != _errors.end(); ++i)
+    os << "gsmlib_at_command_errors_total{verb=\"" << label(i->first._verb)
+       << "\",type=\"" << i->first._type << "\",code=\""
+       << (i->first._code >= 0 ? intToStr(i->first._code) : std::string(""))
+       << "\"} " << i->second << std::endl;
+
+  os << "# HELP gsmlib_unsolicited_result_codes_total "
+     << "Unsolicited result codes received" << std::endl
+     << "# TYPE gsmlib_unsolicited_result_codes_total counter" << std::endl;
+  for (URCMap::const_iterator i = _urcs.begin(); i != _urcs.end(); ++i)
+    os << "gsmlib_unsolicited_result_codes_total{type=\""
+       << label(i->first) << "\"} " << i->second << std::endl;
+
+  os << "# HELP gsmlib_received_bytes_total Bytes read from the ME/TA"
+     << std::endl
+     << "# TYPE gsmlib_received_bytes_total counter" << std::endl
+     << "gsmlib_received_bytes_total " << _bytesIn << std::endl
+     << "# HELP gsmlib_sent_bytes_total Bytes written to the ME/TA"
+     << std::endl
+     << "# TYPE gsmlib_sent_bytes_total counter" << std::endl
+     << "gsmlib_sent_bytes_total " << _bytesOut << std::endl;
+}
+
+void GsmMetrics::writePrometheus(std::string filename) const
+{
+  AtomicFile file(filename);
+  writePrometheus(file.stream());
+  file.commit();
+}
+
+void gsmlib::exportMetrics(const GsmMetrics &metrics)
+{
+  char *metricsFile = getenv("GSMLIB_METRICS");
+  if (metricsFile == NULL || *metricsFile == 0)
+    return;
+  try
+  {
+    metrics.writePrometheus(std::string(metricsFile));
+  }
+  catch (GsmException &e)
+  {
+    ignoreOutputError("metrics", e);
+  }
+}
@@ -0,0 +1,117 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_metrics.h
+// *
+// * Purpose: Latency histograms and counters of the AT commands sent to
+// *          an ME/TA
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_METRICS_H
+#define GSM_METRICS_H
+
+#include <string>
+#include <map>
+#include <iostream>
+
+namespace gsmlib
+{
+  // number of latency histogram buckets (the last one is +Inf)
+  const int LATENCY_BUCKETS = 14;
+
+  // GsmAt records every command it sends keyed by the command verb
+  // ("+CMGS", "+CPBR", "Z", ...), the errors returned by the ME/TA by
+  // verb and code, the unsolicited result codes by type, and the bytes
+  // read and written
+  class GsmMetrics
+  {
+  public:
+    // statistics for one verb
+    struct Command
+    {
+      unsigned long _count;     // commands completed or failed
+      unsigned long _errors;    // commands answered with an error
+      double _latencySum;       // seconds
+      unsigned long _latencyBuckets[LATENCY_BUCKETS]; // commands per bucket
+      Command();
+    };
+
+    // type is "CME", "CMS", or "ERROR", code is -1 if not known
+    struct Error
+    {
+      std::string _verb;
+      std::string _type;
+      int _code;
+      Error(std::string verb, std::string type, int code) :
+        _verb(verb), _type(type), _code(code) {}
+      bool operator<(const Error &e) const;
+    };
+
+    typedef std::map<std::string, Command> CommandMap;
+    typedef std::map<Error, unsigned long> ErrorMap;
+    typedef std::map<std::string, unsigned long> URCMap;
+
+  private:
+    bool _enabled;
+    CommandMap _commands;
+    ErrorMap _errors;
+    URCMap _urcs;
+    unsigned long _bytesIn;
+    unsigned long _bytesOut;
+
+  public:
+    GsmMetrics() : _enabled(true), _bytesIn(0), _bytesOut(0) {}
+
+    // return verb of atCommand (without the "AT"), eg. "+CMGR" for
+    // "+CMGR=3", "&F" for "&F", "E" for "E0", and "AT" for ""
+    static std::string verb(const std::string &atCommand);
+
+    // upper bound of latency bucket i in seconds (infinite for the last)
+    static double bucketBound(int i);
+
+    // switch recording off (nothing is counted) or on
+    void setEnabled(bool enabled) {_enabled = enabled;}
+    bool enabled() const {return _enabled;}
+
+    // record events
+    void countCommand(const std::string &verb, double seconds);
+    void countError(const std::string &verb, std::string type, int code);
+    void countURC(const std::string &type);
+    void countBytesIn(unsigned long bytes)
+      {if (_enabled) _bytesIn += bytes;}
+    void countBytesOut(unsigned long bytes)
+      {if (_enabled) _bytesOut += bytes;}
+
+    // return a copy of the current values
+    GsmMetrics snapshot() const {return *this;}
+
+    // set all values to zero
+    void reset();
+
+    // add the values of metrics (eg. of another ME/TA)
+    void add(const GsmMetrics &metrics);
+
+    const CommandMap &commands() const {return _commands;}
+    const ErrorMap &errors() const {return _errors;}
+    const URCMap &urcs() const {return _urcs;}
+    unsigned long bytesIn() const {return _bytesIn;}
+    unsigned long bytesOut() const {return _bytesOut;}
+
+    // write values in the Prometheus text exposition format
+    void writePrometheus(std::ostream &os) const;
+
+    // write values in the Prometheus text exposition format to filename,
+    // the file is replaced atomically (for the node exporter's textfile
+    // collector)
+    void writePrometheus(std::string filename) const;
+  };
+
+  // write metrics to the file named by the environment variable
+  // GSMLIB_METRICS (if set), errors are ignored
+  // programs call this before they exit, daemons regularly
+  extern void exportMetrics(const GsmMetrics &metrics);
+};
+
+#endif // GSM_METRICS_H
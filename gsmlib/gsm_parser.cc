@@ -17,7 +17,8 @@
 #include <gsmlib/gsm_nls.h>
 #include <ctype.h>
 #include <assert.h>
-#include <sstream>
+#include <limits.h>
+#include <utility>
 
 using namespace gsmlib;
 
@@ -55,61 +56,72 @@ bool Parser::checkEmptyParameter(bool allowNoParameter)
   return false;
 }
 
-std::string Parser::parseString2(bool stringWithQuotationMarks)
+StringView Parser::parseString2(bool stringWithQuotationMarks)
 {
-  int c;
-  std::string result;
+  size_t start, end;
   if (parseChar('"', true))  // OK, string starts and ends with quotation mark
+  {
+    start = _i;
     if (stringWithQuotationMarks)
     {
       // read till end of line
-      while ((c = nextChar(false)) != -1)
-        result += c;
+      end = _s.length();
+      _i = end;
+      _eos = true;
 
       // check for """ at end of line
-      if (result.length() == 0 || result[result.length() - 1]  != '"')
+      if (end == start || _s[end - 1] != '"')
         throwParseException(_("expected '\"'"));
 
       // remove """ at the end
-      result.resize(result.length() - 1);
+      --end;
     }
     else
     {
       // read till next """
-      while ((c = nextChar(false)) != '"')
-        if (c == -1)
-          throwParseException();
-        else
-          result += c;
+      end = _s.find('"', start);
+      if (end == StringView::npos)
+      {
+        _i = _s.length();
+        _eos = true;
+        throwParseException();
+      }
+      _i = end + 1;
     }
+  }
   else // string ends with "," or ")" or EOL
   {
-    c = nextChar(false);
-    while ((c != ',') && (c != ')') && (c != -1))
-    {
-      result += c;
-      c = nextChar(false);
-    }
-    if ((c == ',') || (c == ')')) putBackChar();
+    start = end = _i;
+    while (end < _s.length() && _s[end] != ',' && _s[end] != ')')
+      ++end;
+    _i = end;
+    if (end == _s.length())
+      _eos = true;
   }
 
-  return result;
+  return _s.substr(start, end - start);
 }
 
 int Parser::parseInt2()
 {
-  std::string s;
   int c;
-  int result;
+  int result = 0;
+  bool digits = false;
 
-  while (isdigit(c = nextChar())) s += c;
+  while (isdigit(c = nextChar()))
+  {
+    // too large numbers end up as INT_MAX
+    if (result > (INT_MAX - (c - '0')) / 10)
+      result = INT_MAX;
+    else
+      result = result * 10 + c - '0';
+    digits = true;
+  }
 
   putBackChar();
-  if (s.length() == 0)
+  if (! digits)
     throwParseException(_("expected number"));
 
-  std::istringstream is(s);
-  is >> result;
   return result;
 }
 
@@ -117,14 +129,51 @@ void Parser::throwParseException(std::string message)
 {
   if (message.length() == 0)
     throw GsmException(stringPrintf(_("unexpected end of string '%s'"),
-                                    _s.c_str()), ParserError);
+                                    _s.str().c_str()), ParserError);
   else
     throw GsmException(message +
                        stringPrintf(_(" (at position %d of string '%s')"), _i,
-                                    _s.c_str()), ParserError);
+                                    _s.str().c_str()), ParserError);
 }
 
-Parser::Parser(std::string s) : _i(0), _s(s), _eos(false)
+bool Parser::beginList(bool allowNoList, bool allowNoParentheses,
+                       bool &expectClosingParenthesis)
+{
+  // handle case of empty parameter
+  if (checkEmptyParameter(allowNoList)) return false;
+
+  expectClosingParenthesis = parseChar('(', allowNoParentheses);
+  if (nextChar() == ')') return false;
+  putBackChar();
+  return true;
+}
+
+bool Parser::nextListElement(bool expectClosingParenthesis)
+{
+  int c = nextChar();
+  if (c == ')')
+    return false;
+  if (c == -1)
+  {
+    if (expectClosingParenthesis)
+      throwParseException();
+    return false;
+  }
+  if (c != ',')
+    throwParseException(_("expected ')' or ','"));
+  return true;
+}
+
+Parser::Parser(std::string s) :
+  _i(0), _owned(std::move(s)), _s(_owned), _eos(false)
+{
+}
+
+Parser::Parser(const char *s) : _i(0), _owned(s), _s(_owned), _eos(false)
+{
+}
+
+Parser::Parser(StringView s) : _i(0), _s(s), _eos(false)
 {
 }
 
@@ -146,46 +195,36 @@ bool Parser::parseChar(char c, bool allowNoChar)
 std::vector<std::string> Parser::parseStringList(bool allowNoList,
                                                  bool allowNoParentheses)
 {
-  // handle case of empty parameter
   std::vector<std::string> result;
-  if (checkEmptyParameter(allowNoList)) return result;
-
-  bool expectClosingParenthesis = parseChar('(', allowNoParentheses);
-  if (nextChar() != ')')
-  {
-    putBackChar();
-    while (1)
-    {
+  bool expectClosingParenthesis;
+  if (beginList(allowNoList, allowNoParentheses, expectClosingParenthesis))
+    do
       result.push_back(parseString());
-      int c = nextChar();
-      if (c == ')') {
-        break;
-      } else if (c == -1) {
-        if (expectClosingParenthesis)
-          throwParseException();
-        else
-          break;
-      } else if (c != ',') {
-        throwParseException(_("expected ')' or ','"));
-      }
-    }
-  }
+    while (nextListElement(expectClosingParenthesis));
+  return result;
+}
 
+std::vector<StringView> Parser::parseStringViewList(bool allowNoList,
+                                                    bool allowNoParentheses)
+{
+  std::vector<StringView> result;
+  bool expectClosingParenthesis;
+  if (beginList(allowNoList, allowNoParentheses, expectClosingParenthesis))
+    do
+      result.push_back(parseStringView());
+    while (nextListElement(expectClosingParenthesis));
   return result;
 }
 
 std::vector<bool> Parser::parseIntList(bool allowNoList, bool allowNoParentheses)
 {
-  bool isRange = false;
-  std::vector<bool> result;
-  int resultCapacity = 0;
-  unsigned int saveI = _i;
+  return parseIntRanges(allowNoList, allowNoParentheses).toBitVector();
+}
 
-  enum                 // parse in two passes
-  {
-    FIND_CAPACITY=0,   // find capacity needed for result
-    FILL_VECTOR        // resize result and fill it in
-  };
+IntList Parser::parseIntRanges(bool allowNoList, bool allowNoParentheses)
+{
+  bool isRange = false;
+  IntList result;
 
   // handle case of empty parameter
   if (checkEmptyParameter(allowNoList)) return result;
@@ -195,88 +234,49 @@ std::vector<bool> Parser::parseIntList(bool allowNoList, bool allowNoParentheses
   if (isdigit(nextChar()))
   {
     putBackChar();
-    int num = parseInt();
-    result.resize(num + 1, false);
-    result[num] = true;
+    result.add(parseInt());
     return result;
   }
   putBackChar();
 
-  // run in two passes
-  // pass 0: find capacity needed for result
-  // pass 1: resize result and fill it in
-  for (int pass = FIND_CAPACITY; pass <= FILL_VECTOR; ++pass)
+  bool expectClosingParen = parseChar('(', allowNoParentheses);
+
+  int nc = nextChar();
+  if ((expectClosingParen && nc != ')') ||
+      (! expectClosingParen && nc != -1))
   {
-    if (pass == FILL_VECTOR)
+    putBackChar();
+    int lastInt = -1;
+    while (1)
     {
-      _i = saveI;
-      result.resize(resultCapacity + 1, false);
-    }
-
-    bool expectClosingParen = parseChar('(', allowNoParentheses);
+      int thisInt = parseInt();
 
-    int nc = nextChar();
-    if ((expectClosingParen && nc != ')') ||
-        (! expectClosingParen && nc != -1))
-    {
-      putBackChar();
-      int lastInt = -1;
-      while (1)
+      if (isRange)
       {
-        int thisInt = parseInt();
-
-        if (isRange)
-        {
-          assert(lastInt != -1);
-          if (lastInt <= thisInt)
-            for (int i = lastInt; i < thisInt; ++i)
-            {
-              if (i > resultCapacity)
-                resultCapacity = i;
-              if (pass == 1)
-                result[i] = true;
-            }
-          else
-            for (int i = thisInt; i < lastInt; ++i)
-            {
-              if (i > resultCapacity)
-                resultCapacity = i;
-              if (pass == 1)
-                result[i] = true;
-            }
-          isRange = false;
-        }
-
-        if (thisInt > resultCapacity)
-          resultCapacity = thisInt;
-        if (pass == 1)
-          result[thisInt] = true;
-        lastInt = thisInt;
-
-        int c = nextChar();
-
-        if ((expectClosingParen && c == ')') ||
-            (! expectClosingParen && c == -1))
-          break;
-
-        if (c == -1)
-          throwParseException();
-
-        if (c != ',' && c != '-')
-          throwParseException(_("expected ')', ',' or '-'"));
-
-        if (c == ',')
-          isRange = false;
-        else                      // is '-'
-          if (isRange)
-            throwParseException(_("range of the form a-b-c not allowed"));
-          else
-            isRange = true;
+        assert(lastInt != -1);
+        result.add(lastInt, thisInt);
+        isRange = false;
       }
+      else
+        result.add(thisInt);
+      lastInt = thisInt;
+
+      int c = nextChar();
+
+      if ((expectClosingParen && c == ')') ||
+          (! expectClosingParen && c == -1))
+        break;
+
+      if (c == -1)
+        throwParseException();
+
+      if (c != ',' && c != '-')
+        throwParseException(_("expected ')', ',' or '-'"));
+
+      if (c == '-')
+        isRange = true;
     }
   }
-  if (isRange)
-    throwParseException(_("range of the form a- no allowed"));
   return result;
 }
 
@@ -350,13 +350,16 @@ int Parser::parseInt(bool allowNoInt)
 std::string Parser::parseString(bool allowNoString,
 				bool stringWithQuotationMarks)
 {
-  // handle case of empty parameter
-  std::string result;
-  if (checkEmptyParameter(allowNoString)) return result;
+  return parseStringView(allowNoString, stringWithQuotationMarks).str();
+}
 
-  result = parseString2(stringWithQuotationMarks);
+StringView Parser::parseStringView(bool allowNoString,
+                                   bool stringWithQuotationMarks)
+{
+  // handle case of empty parameter
+  if (checkEmptyParameter(allowNoString)) return StringView();
 
-  return result;
+  return parseString2(stringWithQuotationMarks);
 }
 
 bool Parser::parseComma(bool allowNoComma)
@@ -379,6 +382,7 @@ std::string Parser::parseEol()
   std::string result;
   int c;
 
+  result.reserve(_s.length() - _i);
   while ((c = nextChar()) != -1) result += c;
   return result;
 }
@@ -399,6 +403,7 @@ std::string Parser::getEol()
   unsigned int saveI = _i;
   bool saveEos = _eos;
 
+  result.reserve(_s.length() - _i);
   while ((c = nextChar()) != -1) result += c;
   _i = saveI;
   _eos = saveEos;
@@ -15,6 +15,7 @@
 
 #include <gsmlib/gsm_util.h>
 #include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_string_view.h>
 #include <string>
 #include <vector>
 
@@ -22,11 +23,15 @@ namespace gsmlib
 {
   using std::string;
 
-  class Parser : public RefBase
+  // A Parser either owns a copy of the string to parse or borrows it
+  // (see the constructors), the views returned by the parseXXXView()
+  // functions point into that string.
+  class Parser : public RefBase, public NoCopy
   {
   private:
     unsigned int _i;            // index into _s, next character
-    std::string _s;                  // std::string to parse
+    std::string _owned;         // string to parse if not borrowed
+    StringView _s;              // string to parse
     bool _eos;                  // true if end-of-string reached in nextChar()
 
     // return next character or -1 if end of string
@@ -43,7 +48,15 @@ namespace gsmlib
 
     // parse a std::string (like "string")
     // throw an exception if not well-formed
-    std::string parseString2(bool stringWithQuotationMarks);
+    StringView parseString2(bool stringWithQuotationMarks);
+
+    // parse "(" of a list, return false if the list is empty
+    bool beginList(bool allowNoList, bool allowNoParentheses,
+                   bool &expectClosingParenthesis);
+
+    // parse "," or ")" after a list element, return true if another
+    // element follows
+    bool nextListElement(bool expectClosingParenthesis);
 
     // parse a int (like 1234)
     // throw an exception if not well-formed
@@ -53,7 +66,13 @@ namespace gsmlib
     void throwParseException(std::string message = "");
 
   public:
+    // s is copied, or moved if the caller passes a temporary
     Parser(std::string s);
+    Parser(const char *s);
+
+    // s is borrowed, it must stay unchanged as long as the Parser and
+    // the views returned by it are used, eg. Parser p((StringView)line);
+    Parser(StringView s);
 
     // the following functions skip white space
     // parse a character, if absent throw a GsmException
@@ -66,13 +85,23 @@ namespace gsmlib
     std::vector<std::string> parseStringList(bool allowNoList = false,
                                              bool allowNoParentheses = false);
 
+    // same as above, the strings are not copied
+    std::vector<StringView> parseStringViewList(
+      bool allowNoList = false, bool allowNoParentheses = false);
+
     // parse a list of the form "(12, 14)" or "(1-4, 10)"
     // the result is returned as a bit vector where for each integer
     // in the list and/or range(s) a bit is set
     // the list can be empty (ie. == "") if allowNoList == true
+    // (the vector has as many bits as the largest integer, new code
+    // should use parseIntRanges())
     std::vector<bool> parseIntList(bool allowNoList = false,
                               bool allowNoParentheses = false);
 
+    // same as above, the result is returned as list of ranges
+    IntList parseIntRanges(bool allowNoList = false,
+                           bool allowNoParentheses = false);
+
     // parse a list of parameter ranges (see below)
     // the list can be empty (ie. == "" ) if allowNoList == true
     std::vector<ParameterRange> parseParameterRangeList(bool allowNoList = false);
@@ -103,6 +132,10 @@ namespace gsmlib
     std::string parseString(bool allowNoString = false,
                        bool stringWithQuotationMarks = false);
 
+    // same as above, the string is not copied
+    StringView parseStringView(bool allowNoString = false,
+                               bool stringWithQuotationMarks = false);
+
     // parse a single ","
     // the comma may be absent if allowNoComma == true
     // returns true if there was a comma
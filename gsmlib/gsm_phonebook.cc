@@ -22,6 +22,7 @@
 #include <iostream>
 #include <assert.h>
 #include <ctype.h>
+#include <algorithm>
 
 using namespace gsmlib;
 
@@ -63,34 +64,43 @@ void PhonebookEntry::set(std::string telephone, std::string text, int index,
 
   _useIndex = useIndex;
   _cached = true;
-  _telephone = telephone;
-  _text = text;
+  _readAhead = false;
+  _telephone = std::move(telephone);
+  _text = std::move(text);
   _changed = true;
+  if (_myPhonebook != NULL)
+    _myPhonebook->slotChanged(this - _myPhonebook->_phonebook);
 }
 
-std::string PhonebookEntry::text() const
+void PhonebookEntry::load() const
 {
+  if (_myPhonebook == NULL)
+    return;
+
+  // these operations are at least "logically const"
+  PhonebookEntry *thisEntry = const_cast<PhonebookEntry*>(this);
   if (! cached())
+    _myPhonebook->readEntries(this - _myPhonebook->_phonebook);
+  else
   {
-    assert(_myPhonebook != NULL);
-    // these operations are at least "logically const"
-    PhonebookEntry *thisEntry = const_cast<PhonebookEntry*>(this);
-    _myPhonebook->readEntry(_index, thisEntry->_telephone, thisEntry->_text);
-    thisEntry->_cached = true;
+    ++_myPhonebook->_cacheHits;
+    if (_readAhead)
+    {
+      ++_myPhonebook->_roundTripsSaved;
+      thisEntry->_readAhead = false;
+    }
   }
+}
+
+const std::string &PhonebookEntry::text() const
+{
+  load();
   return _text;
 }
 
-std::string PhonebookEntry::telephone() const
+const std::string &PhonebookEntry::telephone() const
 {
-  if (! cached())
-  {
-    assert(_myPhonebook != NULL);
-    // these operations are at least "logically const"
-    PhonebookEntry *thisEntry = const_cast<PhonebookEntry*>(this);
-    _myPhonebook->readEntry(_index, thisEntry->_telephone, thisEntry->_text);
-    thisEntry->_cached = true;
-  }
+  load();
   return _telephone;
 }
 
@@ -115,6 +125,9 @@ PhonebookEntry &PhonebookEntry::operator=(const PhonebookEntry &e)
 
 // Phonebook members
 
+// maximum number of entries requested with one +CPBR when preloading
+static const int PHONEBOOK_PRELOAD_CHUNK = 50;
+
 int Phonebook::parsePhonebookEntry(std::string response,
                                    std::string &telephone, std::string &text)
 {
@@ -122,7 +135,7 @@ int Phonebook::parsePhonebookEntry(std::string response,
   // some texts are truncated and don't have a trailing "
   if (response.length() > 0 && response[response.length() - 1] != '"')
     response += '"';
-  Parser p(response);
+  Parser p((StringView)response);
 
   int index = p.parseInt();
   p.parseComma();
@@ -160,6 +173,7 @@ int Phonebook::parsePhonebookEntry(std::string response,
 void Phonebook::readEntry(int index, std::string &telephone, std::string &text)
 {
   // select phonebook
+  GsmAt::Lock lock(_at());
   _myMeTa.setPhonebook(_phonebookName);
 
   // read entry
@@ -183,9 +197,148 @@ void Phonebook::readEntry(int index, std::string &telephone, std::string &text)
 #endif
 }
 
-void Phonebook::findEntry(std::string text, int &index, std::string &telephone)
+void Phonebook::cacheEntry(int position, const std::string &telephone,
+                           const std::string &text)
+{
+  PhonebookEntry &entry = _phonebook[position];
+  if (! entry._cached)
+  {
+    entry._cached = true;
+    entry._readAhead = true;
+    entry._telephone = telephone;
+    entry._text = text;
+    slotChanged(position);
+  }
+}
+
+int Phonebook::readRange(int first, int last)
 {
   // select phonebook
+  GsmAt::Lock lock(_at());
+  _myMeTa.setPhonebook(_phonebookName);
+
+  ++_roundTrips;
+  // an empty range is answered with OK or "not found", other errors
+  // must not make entries look empty
+  std::vector<std::string> responses;
+  try
+  {
+    responses =
+      _at->chatv("+CPBR=" + intToStr(_phonebook[first]._index) + "," +
+                 intToStr(_phonebook[last]._index), "+CPBR:");
+  }
+  catch (GsmException &ge)
+  {
+    if (ge.getErrorCode() != ME_NOT_FOUND)
+      throw;
+  }
+
+  int next = first;
+  if (responses.size() == 0)
+  {
+    for (; next <= last; ++next)
+      cacheEntry(next, "", "");
+    return next;
+  }
+
+  for (std::vector<std::string>::iterator i = responses.begin();
+       i != responses.end(); ++i)
+  {
+    std::string telephone, text;
+    int pos = position(parsePhonebookEntry(*i, telephone, text));
+    if (pos < next || pos > last)
+      continue;
+
+    // entries skipped by the ME are empty
+    for (; next < pos; ++next)
+      cacheEntry(next, "", "");
+    cacheEntry(pos, telephone, text);
+    next = pos + 1;
+#ifndef NDEBUG
+    if (debugLevel() >= 1)
+      std::cerr << "*** Reading PB entry " << _phonebook[pos]._index
+                << " number " << telephone
+                << " text " << text << std::endl;
+#endif
+  }
+  return next;
+}
+
+void Phonebook::readEntries(int position)
+{
+  ++_cacheMisses;
+  PhonebookEntry &entry = _phonebook[position];
+
+  if (_maxReadAhead > 1 && _useCache)
+  {
+    // grow window on sequential access, start small otherwise
+    if (position == _nextSequential)
+      _readAhead = std::min(_readAhead * 2, _maxReadAhead);
+    else
+      _readAhead = std::min(4, _maxReadAhead);
+
+    int last = std::min(position + _readAhead, _maxSize) - 1;
+    _nextSequential = readRange(position, last);
+    entry._readAhead = false;
+  }
+
+  // read single entry if read-ahead is off or did not return it
+  if (! entry._cached || ! _useCache)
+  {
+    ++_roundTrips;
+    readEntry(entry._index, entry._telephone, entry._text);
+    entry._cached = true;
+    slotChanged(position);
+  }
+}
+
+int Phonebook::position(int meIndex) const
+{
+  int result = _positions.position(meIndex);
+  return result < _maxSize ? result : -1;
+}
+
+void Phonebook::slotChanged(int position)
+{
+  bool isFree = _phonebook[position]._telephone == "" &&
+    _phonebook[position]._text == "";
+  _freeSlots[position] = isFree;
+  if (isFree && position < _firstFree)
+    _firstFree = position;
+}
+
+int Phonebook::firstFree()
+{
+  if (_useCache)
+  {
+    // _firstFree only moves back when a slot is freed
+    for (; _firstFree < _maxSize; ++_firstFree)
+      if (_freeSlots[_firstFree])
+        return _firstFree;
+
+    // all slots are used
+    if (_size != -1 && _size >= _maxSize)
+      return -1;
+  }
+
+  // read entries not cached yet (all entries if caching is off),
+  // entries read ahead on the way are checked without ME access
+  for (int i = 0; i < _maxSize; i++)
+    if (_useCache && _phonebook[i].cached())
+    {
+      if (_freeSlots[i])
+        return i;
+    }
+    else if (_phonebook[i].empty())
+      return i;
+  return -1;
+}
+
+void Phonebook::findEntry(const std::string &text, int &index,
+                          std::string &telephone)
+{
+  // select phonebook
+  GsmAt::Lock lock(_at());
   _myMeTa.setPhonebook(_phonebookName);
 
   // read entry
@@ -201,7 +354,10 @@ void Phonebook::findEntry(std::string text, int &index, std::string &telephone)
     index = 0;
   }
   else
-    index=parsePhonebookEntry(response, telephone, text);
+  {
+    std::string foundText;
+    index=parsePhonebookEntry(response, telephone, foundText);
+  }
 
 #ifndef NDEBUG
   if (debugLevel() >= 1)
@@ -210,7 +366,8 @@ void Phonebook::findEntry(std::string text, int &index, std::string &telephone)
 #endif
 }
 
-void Phonebook::writeEntry(int index, std::string telephone, std::string text)
+void Phonebook::writeEntry(int index, const std::string &telephone,
+                           const std::string &text)
 {
 #ifndef NDEBUG
   if (debugLevel() >= 1)
@@ -218,6 +375,7 @@ void Phonebook::writeEntry(int index, std::string telephone, std::string text)
 	      << "' text '" << text << "'" << std::endl;
 #endif
   // select phonebook
+  GsmAt::Lock lock(_at());
   _myMeTa.setPhonebook(_phonebookName);
 
   // write entry
@@ -249,41 +407,37 @@ void Phonebook::writeEntry(int index, std::string telephone, std::string text)
   _at->chat(s);
 }
 
-Phonebook::iterator Phonebook::insertFirstEmpty(std::string telephone, std::string text)
+Phonebook::iterator Phonebook::insertFirstEmpty(const std::string &telephone,
+                                                const std::string &text)
 {
-  for (int i = 0; i < _maxSize; i++)
-    if (_phonebook[i].empty())
-    {
-      _phonebook[i].set(telephone, text);
-      adjustSize(1);
-      return begin() + i;
-    }
-  throw GsmException(_("phonebook full"), OtherError);
+  int i = firstFree();
+  if (i == -1)
+    throw GsmException(_("phonebook full"), OtherError);
+  _phonebook[i].set(telephone, text);
+  adjustSize(1);
+  return begin() + i;
 }
 
-Phonebook::iterator Phonebook::insert(const std::string telephone,
-                                      const std::string text,
+Phonebook::iterator Phonebook::insert(const std::string &telephone,
+                                      const std::string &text,
                                       const int index)
 {
-  for (int i = 0; i < _maxSize; i++)
-    if (_phonebook[i].index() == index)
-      {
-	if (_phonebook[i].empty())
-	  {
-	    _phonebook[i].set(telephone, text);
-	    adjustSize(1);
-	    return begin() + i;
-	  }
-	else
-	  throw GsmException(_("attempt to overwrite phonebook entry"),
-			     OtherError);
-      }
-  return end();
+  int i = position(index);
+  if (i == -1)
+    return end();
+  if (! _phonebook[i].empty())
+    throw GsmException(_("attempt to overwrite phonebook entry"),
+                       OtherError);
+  _phonebook[i].set(telephone, text);
+  adjustSize(1);
+  return begin() + i;
 }
 
 Phonebook::Phonebook(std::string phonebookName, Ref<GsmAt> at, MeTa &myMeTa,
                      bool preload) :
-  _phonebookName(phonebookName), _at(at), _myMeTa(myMeTa), _useCache(true)
+  _phonebookName(phonebookName), _at(at), _firstFree(0), _myMeTa(myMeTa),
+  _useCache(true), _maxReadAhead(32), _readAhead(0), _nextSequential(-1),
+  _cacheHits(0), _cacheMisses(0), _roundTrips(0), _roundTripsSaved(0)
 {
   // select phonebook
   _myMeTa.setPhonebook(_phonebookName);
@@ -304,8 +458,8 @@ Phonebook::Phonebook(std::string phonebookName, Ref<GsmAt> at, MeTa &myMeTa,
   Parser p(_at->chat("+CPBR=?", "+CPBR:"));
 
   // get index of actually available entries in the phonebook
-  vector<bool> availablePositions =
-    p.parseIntList(false, myMeTa.getCapabilities()._noCPBxParentheses);
+  _positions =
+    p.parseIntRanges(false, myMeTa.getCapabilities()._noCPBxParentheses);
   p.parseComma();
   _maxNumberLength = p.parseInt();
   p.parseComma();
@@ -319,97 +473,84 @@ Phonebook::Phonebook(std::string phonebookName, Ref<GsmAt> at, MeTa &myMeTa,
   // In memory we store only phonebook entries that may actually be
   // used, ie. the phonebook in memory is not sparse.
   // Each entry has a member _index that corresponds to the index in the ME.
-  if (_maxSize == -1)
-  {
-    _maxSize = 0;
-    for (std::vector<bool>::iterator i = availablePositions.begin();
-         i != availablePositions.end(); ++i)
-      if (*i) ++_maxSize;
-  }
-
-  // for use with preload below
-  int *meToPhonebookIndexMap =
-    (int*)alloca(sizeof(int) * (availablePositions.size() + 1));
+  if (_maxSize == -1 || _maxSize > _positions.count())
+    _maxSize = _positions.count();
 
   // initialize phone book entries
   if (_maxSize == 0)
     _phonebook = NULL;
   else
     _phonebook = new PhonebookEntry[_maxSize];
-  int nextAvailableIndex = 0;
-  int i;
-  for (i = 0; i < _maxSize; i++)
-  {
-    while (! availablePositions[nextAvailableIndex])
-      nextAvailableIndex++;
-    _phonebook[i]._index = nextAvailableIndex;
-    _phonebook[i]._cached = false;
-    _phonebook[i]._myPhonebook = this;
-    meToPhonebookIndexMap[nextAvailableIndex++] = i;
-  }
-
-  // find out first index number of phonebook
-  int firstIndex = -1;
-  for (i = 0; i < _maxSize; i++)
-    if (availablePositions[i])
+  _freeSlots.assign(_maxSize, false);
+  int i = 0;
+  for (std::vector<IntRange>::const_iterator r = _positions.ranges().begin();
+       i < _maxSize; ++r)
+    for (int index = r->_low; index <= r->_high && i < _maxSize; ++index)
     {
-      firstIndex = i;
-      break;
+      _phonebook[i]._index = index;
+      _phonebook[i]._cached = false;
+      _phonebook[i]._readAhead = false;
+      _phonebook[i]._myPhonebook = this;
+      ++i;
     }
 
   // preload phonebook
-  // Note: this contains a workaround for the bug that
-  // some MEs can not return the entire phonebook with one AT command
-  // To detect this condition, _size must be known
-  // also, this code only handles non-sparse phonebooks
-  if (preload && _size != -1 && 
-      (int)availablePositions.size() == _maxSize + firstIndex)
+  // the available index ranges are read in chunks of
+  // PHONEBOOK_PRELOAD_CHUNK entries, readRange() stops after the last
+  // entry returned so that reading resumes there if the ME truncated
+  // the response
+  // if _size is known the rest is empty once _size entries are found
+  if (preload)
   {
+    int position = 0;
     int entriesRead = 0;
-    int startIndex = firstIndex;
-
-    while (entriesRead < _size)
+    while (position < _maxSize && (_size == -1 || entriesRead < _size))
     {
-      reportProgress(0, _maxSize); // chatv also calls reportProgress()
-      std::vector<std::string> responses =
-        _at->chatv("+CPBR=" + intToStr(startIndex) +
-                   "," + intToStr(_maxSize + firstIndex - 1),
-                   "+CPBR:", true);
-
-      // this means that we have read nothing even though not all
-      // entries have been retrieved (entriesRead < _size)
-      // this could be due to a malfunction of the ME...
-      // anyway, missing entries can be read later by readEntry()
-      if (responses.size() == 0)
+      reportProgress(position, _maxSize);
+
+      // chunks must not span gaps in sparse phonebooks
+      int last = position;
+      while (last + 1 < _maxSize &&
+             last + 1 - position < PHONEBOOK_PRELOAD_CHUNK &&
+             _phonebook[last + 1]._index == _phonebook[last]._index + 1)
+        ++last;
+
+      // on errors (eg. SIM busy) the remaining entries are left uncached
+      // and read later, they must not be taken for empty ones
+      int next;
+      try
+      {
+        next = readRange(position, last);
+      }
+      catch (GsmException &ge)
       {
 #ifndef NDEBUG
         if (debugLevel() >= 1)
 	  std::cerr << "*** error when preloading phonebook: "
-		    << "not all entries returned" << std::endl;
+		    << ge.what() << std::endl;
 #endif
         break;
       }
-
-      for (std::vector<std::string>::iterator i = responses.begin();
-           i != responses.end(); ++i)
+      if (next <= position)
       {
-	std::string telephone, text;
-        int meIndex = parsePhonebookEntry(*i, telephone, text);
-        _phonebook[meToPhonebookIndexMap[meIndex]]._cached = true;
-        _phonebook[meToPhonebookIndexMap[meIndex]]._telephone = telephone;
-        _phonebook[meToPhonebookIndexMap[meIndex]]._text = text;
-        assert(_phonebook[meToPhonebookIndexMap[meIndex]]._index == meIndex);
-
-        ++entriesRead;
-        startIndex = meIndex + 1;
+        // nothing usable returned, remaining entries are read later
 #ifndef NDEBUG
         if (debugLevel() >= 1)
-	  std::cerr << "*** Preloading PB entry " << meIndex
-		    << " number " << telephone 
-		    << " text " << text << std::endl;
+	  std::cerr << "*** error when preloading phonebook: "
+		    << "not all entries returned" << std::endl;
 #endif
+        break;
       }
+      for (; position < next; ++position)
+        if (_phonebook[position]._telephone != "" ||
+            _phonebook[position]._text != "")
+          ++entriesRead;
     }
+
+    if (_size != -1 && entriesRead >= _size)
+      for (; position < _maxSize; ++position)
+        cacheEntry(position, "", "");
+    reportProgress(_maxSize, _maxSize);
   }
 }
 
@@ -524,13 +665,21 @@ Phonebook::iterator Phonebook::erase(iterator first, iterator last)
   return i;
 }
 
+void Phonebook::overwrite(iterator position, const std::string &telephone,
+                          const std::string &text)
+{
+  bool wasEmpty = position->empty();
+  position->set(telephone, text);
+  adjustSize((position->empty() ? 0 : 1) - (wasEmpty ? 0 : 1));
+}
+
 void Phonebook::clear()
 {
   for (iterator i = begin(); i != end(); ++i)
     erase(i);
 }
 
-Phonebook::iterator Phonebook::find(std::string text)
+Phonebook::iterator Phonebook::find(const std::string &text)
 {
   int index;
   std::string telephone;
@@ -567,5 +716,12 @@ Phonebook::iterator Phonebook::find(std::string text)
 
 Phonebook::~Phonebook()
 {
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "*** phonebook " << _phonebookName << ": "
+              << _cacheHits << " hits, " << _cacheMisses << " misses, "
+              << _roundTrips << " round trips, " << _roundTripsSaved
+              << " saved by read-ahead" << std::endl;
+#endif
   delete []_phonebook;
 }
@@ -36,20 +36,25 @@ namespace gsmlib
     PhonebookEntry() {}
     bool _cached;               // true, if this entry corresponds to info
                                 // in the ME
+    bool _readAhead;            // true, if read with another entry and
+                                // not accessed yet
     Phonebook *_myPhonebook;
 
+    // read entry from ME if not cached
+    void load() const;
+
   public:
     PhonebookEntry(std::string telephone, std::string text) :
-      PhonebookEntryBase(telephone, text),
-      _cached(true), _myPhonebook(NULL) {}
+      PhonebookEntryBase(std::move(telephone), std::move(text)),
+      _cached(true), _readAhead(false), _myPhonebook(NULL) {}
     PhonebookEntry(const PhonebookEntryBase &e);
 
     // accessor functions, inherited from PhonebookEntryBase
     // set() does not use the index argument
     void set(std::string telephone, std::string text, int index = -1,
              bool useIndex = false);
-    std::string text() const;
-    std::string telephone() const;
+    const std::string &text() const;
+    const std::string &telephone() const;
 
     // return true if entry is cached (and caching is enabled)
     bool cached() const;
@@ -84,9 +89,19 @@ namespace gsmlib
     unsigned int _maxNumberLength; // maximum length of telephone number
     unsigned int _maxTextLength; // maximum length of descriptive text
     Ref<GsmAt> _at;             // my GsmAt class
-    std::vector<int> _positionMap;   // maps in-memory index to ME index
+    IntList _positions;         // available ME indices, the first
+                                // _maxSize of them are kept in memory
+    std::vector<bool> _freeSlots; // true for cached entries that are empty
+    int _firstFree;             // no free slot is known below this position
     MeTa &_myMeTa;              // the MeTa object that created this Phonebook
     bool _useCache;             // true if entries should be cached
+    int _maxReadAhead;          // maximum number of entries read on a miss
+    int _readAhead;             // current read-ahead window
+    int _nextSequential;        // position after the last window read
+    unsigned long _cacheHits;   // accesses to cached entries
+    unsigned long _cacheMisses; // accesses to entries not cached
+    unsigned long _roundTrips;  // +CPBR commands sent for misses
+    unsigned long _roundTripsSaved; // hits on entries read ahead
 
     // helper function, parse phonebook response returned by ME/TA
     // returns index of entry
@@ -95,8 +110,36 @@ namespace gsmlib
     // internal access functions
     // read/write/find entry from/to ME
     void readEntry(int index, std::string &telephone, std::string &text);
-    void writeEntry(int index, std::string telephone, std::string text);
-    void findEntry(std::string text, int &index, std::string &telephone);
+
+    // set entry at position from ME data unless it is already cached
+    void cacheEntry(int position, const std::string &telephone,
+                    const std::string &text);
+
+    // read entries at positions first..last with one +CPBR=a,b and
+    // cache them (missing entries are empty)
+    // entries after the last one returned are left alone because some
+    // MEs truncate long responses
+    // return position after the last entry known to be read
+    int readRange(int first, int last);
+
+    // handle cache miss for entry at position
+    // reads a window of entries that grows on sequential access
+    void readEntries(int position);
+
+    // return position of the entry with ME index meIndex, -1 if none
+    int position(int meIndex) const;
+
+    // update _freeSlots after the entry at position was cached or written
+    void slotChanged(int position);
+
+    // return position of an empty entry, -1 if the phonebook is full
+    // known empty entries are preferred, entries not cached yet are only
+    // read from the ME if there are none
+    int firstFree();
+    void writeEntry(int index, const std::string &telephone,
+                    const std::string &text);
+    void findEntry(const std::string &text, int &index,
+                   std::string &telephone);
 
     // adjust size only if it was set once
     void adjustSize(int sizeAdjust)
@@ -105,10 +148,11 @@ namespace gsmlib
       }
 
     // insert into first empty position and return position where inserted
-    iterator insertFirstEmpty(const std::string telephone, const std::string text);
+    iterator insertFirstEmpty(const std::string &telephone,
+                              const std::string &text);
 
     // insert into specified index position
-    iterator insert(const std::string telephone, const std::string text,
+    iterator insert(const std::string &telephone, const std::string &text,
                     const int index);
 
     // used my class MeTa
@@ -121,6 +165,16 @@ namespace gsmlib
     // set cache mode on or off
     void setCaching(bool useCache) {_useCache = useCache;}
 
+    // set maximum number of entries read with one +CPBR on a cache miss
+    // (1 disables read-ahead, default 32)
+    void setReadAhead(int maxEntries) {_maxReadAhead = maxEntries;}
+
+    // cache statistics
+    unsigned long cacheHits() const {return _cacheHits;}
+    unsigned long cacheMisses() const {return _cacheMisses;}
+    unsigned long roundTrips() const {return _roundTrips;}
+    unsigned long roundTripsSaved() const {return _roundTripsSaved;}
+
     // return name of this phonebook (2-character std::string)
     std::string name() const {return _phonebookName;}
 
@@ -169,8 +223,13 @@ namespace gsmlib
     iterator erase(iterator first, iterator last);
     void clear();
 
+    // write telephone and text into the slot at position, clear it if
+    // both are empty (one +CPBW, unlike erase() followed by insert())
+    void overwrite(iterator position, const std::string &telephone,
+                   const std::string &text);
+
     // finds an entry given the text
-    iterator find(std::string text);
+    iterator find(const std::string &text);
     
     // destructor
     virtual ~Phonebook();
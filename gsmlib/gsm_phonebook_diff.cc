@@ -0,0 +1,200 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_phonebook_diff.cc
+// *
+// * Purpose: Compute the minimal set of slot writes that turn the contents
+// *          of an ME phonebook into a given set of entries
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_phonebook_diff.h>
+#include <gsmlib/gsm_tracing.h>
+#include <map>
+#include <set>
+
+using namespace gsmlib;
+
+// entries are compared by text and telephone number
+typedef std::pair<std::string, std::string> EntryKey;
+
+static EntryKey key(const PhonebookSlot &slot, bool ignoreCase)
+{
+  return EntryKey(ignoreCase ? lowercase(slot._text) : slot._text,
+                  slot._telephone);
+}
+
+PhonebookDiff::PhonebookDiff(const std::vector<PhonebookSlot> &destination,
+                             const std::vector<PhonebookSlot> &source,
+                             bool indexed, bool ignoreCase) :
+  _unchanged(0), _updates(0), _inserts(0), _clears(0)
+{
+  // wanted contents of each destination slot
+  std::vector<PhonebookSlot> target(destination.size());
+  for (unsigned int i = 0; i < destination.size(); ++i)
+    target[i]._index = destination[i]._index;
+
+  if (indexed)
+  {
+    std::map<int, int> positionOfIndex;
+    for (unsigned int i = 0; i < destination.size(); ++i)
+      positionOfIndex[destination[i]._index] = i;
+
+    for (std::vector<PhonebookSlot>::const_iterator i = source.begin();
+         i != source.end(); ++i)
+    {
+      std::map<int, int>::iterator j = positionOfIndex.find(i->_index);
+      if (j == positionOfIndex.end())
+        throw GsmException(
+          stringPrintf(_("index %d not available in destination phonebook"),
+                       i->_index), ParameterError);
+      target[j->second] = *i;
+    }
+  }
+  else
+  {
+    // used destination slots by contents
+    std::multimap<EntryKey, int> present;
+    for (unsigned int i = 0; i < destination.size(); ++i)
+      if (! destination[i].empty())
+        present.insert(std::make_pair(key(destination[i], ignoreCase), i));
+
+    // 1. keep entries that are already there
+    std::vector<PhonebookSlot> pending;
+    for (std::vector<PhonebookSlot>::const_iterator i = source.begin();
+         i != source.end(); ++i)
+    {
+      std::multimap<EntryKey, int>::iterator j =
+        present.find(key(*i, ignoreCase));
+      if (j == present.end())
+        pending.push_back(*i);
+      else
+      {
+        target[j->second] = destination[j->second];
+        present.erase(j);
+      }
+    }
+
+    // the remaining used slots can be reused
+    std::set<int> reusable;
+    std::multimap<std::string, int> reusableByText;
+    for (std::multimap<EntryKey, int>::iterator i = present.begin();
+         i != present.end(); ++i)
+    {
+      reusable.insert(i->second);
+      reusableByText.insert(
+        std::make_pair(lowercase(destination[i->second]._text), i->second));
+    }
+
+    // 2. write changed entries into the slot with the same text
+    // (regardless of case, so that renaming "bob" to "Bob" is one write)
+    std::vector<PhonebookSlot> rest;
+    for (std::vector<PhonebookSlot>::iterator i = pending.begin();
+         i != pending.end(); ++i)
+    {
+      std::multimap<std::string, int>::iterator j =
+        reusableByText.find(lowercase(i->_text));
+      if (j == reusableByText.end())
+        rest.push_back(*i);
+      else
+      {
+        target[j->second]._telephone = i->_telephone;
+        target[j->second]._text = i->_text;
+        reusable.erase(j->second);
+        reusableByText.erase(j);
+      }
+    }
+
+    // 3. put new entries into reused slots first, then into empty ones
+    unsigned int nextEmpty = 0;
+    for (std::vector<PhonebookSlot>::iterator i = rest.begin();
+         i != rest.end(); ++i)
+    {
+      int position;
+      if (! reusable.empty())
+      {
+        position = *reusable.begin();
+        reusable.erase(reusable.begin());
+      }
+      else
+      {
+        while (nextEmpty < destination.size() &&
+               ! destination[nextEmpty].empty())
+          ++nextEmpty;
+        if (nextEmpty == destination.size())
+          throw GsmException(_("phonebook full"), OtherError);
+        position = nextEmpty++;
+      }
+      target[position]._telephone = i->_telephone;
+      target[position]._text = i->_text;
+    }
+  }
+
+  // collect writes for all slots whose contents change
+  std::map<int, PhonebookSlot> writes;
+  for (unsigned int i = 0; i < destination.size(); ++i)
+  {
+    const PhonebookSlot &d = destination[i];
+    const PhonebookSlot &t = target[i];
+    if (key(d, ignoreCase) == key(t, ignoreCase))
+    {
+      if (! d.empty())
+        ++_unchanged;
+      continue;
+    }
+    if (t.empty())
+      ++_clears;
+    else if (d.empty())
+      ++_inserts;
+    else
+      ++_updates;
+    writes[d._index] = PhonebookSlot(d._index, t._telephone, t._text);
+  }
+  for (std::map<int, PhonebookSlot>::iterator i = writes.begin();
+       i != writes.end(); ++i)
+    _writes.push_back(i->second);
+}
+
+std::vector<PhonebookSlot> PhonebookDiff::slots(PhonebookRef phonebook)
+{
+  std::vector<PhonebookSlot> result;
+  for (Phonebook::iterator i = phonebook->begin(); i != phonebook->end(); ++i)
+    result.push_back(PhonebookSlot(i->index(), i->telephone(), i->text()));
+  return result;
+}
+
+std::vector<PhonebookSlot> PhonebookDiff::slots(SortedPhonebookBase &phonebook)
+{
+  std::vector<PhonebookSlot> result;
+  for (SortedPhonebookBase::iterator i = phonebook.begin();
+       i != phonebook.end(); ++i)
+    if (! i->empty())
+      result.push_back(PhonebookSlot(i->index(), i->telephone(), i->text()));
+  return result;
+}
+
+void PhonebookDiff::apply(PhonebookRef phonebook) const
+{
+  TraceSpan span("store", "apply phonebook diff", phonebook->name());
+  std::map<int, Phonebook::iterator> positionOfIndex;
+  for (Phonebook::iterator i = phonebook->begin(); i != phonebook->end(); ++i)
+    positionOfIndex[i->index()] = i;
+
+  for (std::vector<PhonebookSlot>::const_iterator i = _writes.begin();
+       i != _writes.end(); ++i)
+  {
+    std::map<int, Phonebook::iterator>::iterator j =
+      positionOfIndex.find(i->_index);
+    if (j == positionOfIndex.end())
+      throw GsmException(
+        stringPrintf(_("index %d not available in destination phonebook"),
+                     i->_index), ParameterError);
+    phonebook->overwrite(j->second, i->_telephone, i->_text);
+  }
+}
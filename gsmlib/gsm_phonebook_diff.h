@@ -0,0 +1,89 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_phonebook_diff.h
+// *
+// * Purpose: Compute the minimal set of slot writes that turn the contents
+// *          of an ME phonebook into a given set of entries
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_PHONEBOOK_DIFF_H
+#define GSM_PHONEBOOK_DIFF_H
+
+#include <gsmlib/gsm_phonebook.h>
+#include <gsmlib/gsm_sorted_phonebook_base.h>
+#include <string>
+#include <vector>
+
+namespace gsmlib
+{
+  // contents of one phonebook slot
+  struct PhonebookSlot
+  {
+    int _index;                 // ME index (or source index if indexed)
+    std::string _telephone;
+    std::string _text;
+
+    PhonebookSlot() : _index(-1) {}
+    PhonebookSlot(int index, std::string telephone, std::string text) :
+      _index(index), _telephone(telephone), _text(text) {}
+
+    // return true if both telephone and text are empty
+    bool empty() const {return _telephone == "" && _text == "";}
+  };
+
+  // The PhonebookDiff compares the slots of a destination phonebook with
+  // the entries of a source and computes the writes needed to make the
+  // destination contain exactly the source entries. Every write is one
+  // +CPBW, so the number of writes is the number of round trips needed.
+  // If indexed is true, source entries must end up at their index.
+  // Otherwise entries that are present on both sides (same text and
+  // telephone number) stay where they are, changed numbers are written
+  // into the slot that has the same text, and new entries reuse the slots
+  // of deleted ones before taking empty slots.
+  // If ignoreCase is true, texts differing only in case are considered
+  // equal.
+
+  class PhonebookDiff
+  {
+  private:
+    std::vector<PhonebookSlot> _writes; // writes ordered by ME index
+    int _unchanged;             // number of entries left alone
+    int _updates;               // writes to used slots
+    int _inserts;               // writes to empty slots
+    int _clears;                // used slots to be emptied
+
+  public:
+    // compute the diff
+    // destination must contain all slots including empty ones
+    // throw an exception if the source does not fit
+    PhonebookDiff(const std::vector<PhonebookSlot> &destination,
+                  const std::vector<PhonebookSlot> &source, bool indexed,
+                  bool ignoreCase = false);
+
+    // return all slots of an ME phonebook
+    static std::vector<PhonebookSlot> slots(PhonebookRef phonebook);
+
+    // return all non-empty entries of a sorted phonebook
+    static std::vector<PhonebookSlot> slots(SortedPhonebookBase &phonebook);
+
+    // writes to perform, empty slots mean that the slot is cleared
+    const std::vector<PhonebookSlot> &writes() const {return _writes;}
+
+    // statistics
+    int unchanged() const {return _unchanged;}
+    int updates() const {return _updates;}
+    int inserts() const {return _inserts;}
+    int clears() const {return _clears;}
+
+    // number of +CPBW commands apply() sends
+    int roundTrips() const {return _writes.size();}
+
+    // perform the writes on phonebook (which must be the destination)
+    void apply(PhonebookRef phonebook) const;
+  };
+};
+
+#endif // GSM_PHONEBOOK_DIFF_H
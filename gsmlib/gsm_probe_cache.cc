@@ -0,0 +1,179 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_probe_cache.cc
+// *
+// * Purpose: On-disk cache of the capabilities and static information
+// *          probed from an ME/TA
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_util.h>
+#include <gsmlib/gsm_probe_cache.h>
+#include <fstream>
+#include <stdlib.h>
+#include <cctype>
+
+using namespace gsmlib;
+
+// format version of the cache files
+static const char PROBE_CACHE_VERSION[] = "1";
+
+// escape '\\', ',', CR, and LF in values
+static std::string escapeValue(const std::string &s)
+{
+  std::string result;
+  for (std::string::const_iterator i = s.begin(); i != s.end(); ++i)
+    if (*i == CR)
+      result += "\\r";
+    else if (*i == LF)
+      result += "\\n";
+    else if (*i == '\\' || *i == ',')
+    {
+      result += '\\';
+      result += *i;
+    }
+    else
+      result += *i;
+  return result;
+}
+
+// split value at unescaped ',' and unescape the parts
+static std::vector<std::string> splitValue(const std::string &value)
+{
+  std::vector<std::string> result(1);
+  for (std::string::const_iterator i = value.begin(); i != value.end(); ++i)
+    if (*i == ',')
+      result.push_back("");
+    else if (*i == '\\' && i + 1 != value.end())
+    {
+      ++i;
+      result.back() += (*i == 'r' ? CR : *i == 'n' ? LF : *i);
+    }
+    else
+      result.back() += *i;
+  return result;
+}
+
+static std::string joinValue(const std::vector<std::string> &v)
+{
+  std::string result;
+  for (std::vector<std::string>::const_iterator i = v.begin();
+       i != v.end(); ++i)
+  {
+    if (i != v.begin())
+      result += ',';
+    result += escapeValue(*i);
+  }
+  return result;
+}
+
+std::string ProbeCache::filename(std::string serialNumber) const
+{
+  std::string name;
+  for (std::string::const_iterator i = serialNumber.begin();
+       i != serialNumber.end(); ++i)
+    if (isalnum(*i))
+      name += *i;
+  if (name == "" || _directory == "")
+    return "";
+  return _directory + "/" + name;
+}
+
+bool ProbeCache::load(std::string serialNumber, std::string revision,
+                      ProbeCacheEntry &entry) const
+{
+  std::string fn = filename(serialNumber);
+  if (fn == "")
+    return false;
+  std::ifstream ifs(fn.c_str());
+  if (! ifs)
+    return false;
+
+  ProbeCacheEntry result;
+  bool versionOk = false;
+  std::string line;
+  while (getline(ifs, line))
+  {
+    if (line == "" || line[0] == '#')
+      continue;
+    std::string::size_type eq = line.find('=');
+    if (eq == std::string::npos)
+      return false;
+    std::string key = line.substr(0, eq);
+    std::string value = line.substr(eq + 1);
+    std::string s = splitValue(value)[0];
+    if (key == "version")
+      versionOk = value == PROBE_CACHE_VERSION;
+    else if (key == "manufacturer")
+      result._meInfo._manufacturer = s;
+    else if (key == "model")
+      result._meInfo._model = s;
+    else if (key == "revision")
+      result._meInfo._revision = s;
+    else if (key == "serialNumber")
+      result._meInfo._serialNumber = s;
+    else if (key == "hasSMSPDUmode")
+      result._hasSMSPDUmode = value == "1";
+    else if (key == "MotorolaModeCmd")
+      result._MotorolaModeCmd = value == "1";
+    else if (key == "noCPBxParentheses")
+      result._noCPBxParentheses = value == "1";
+    else if (key == "hasCMMS")
+      result._hasCMMS = value == "1";
+    else if (key == "cpmsParamCount")
+      result._cpmsParamCount = atoi(value.c_str());
+    else if (key == "charSets" && value != "")
+      result._charSets = splitValue(value);
+    else if (key == "phonebookStrings" && value != "")
+      result._phonebookStrings = splitValue(value);
+    else if (key == "smsStoreNames" && value != "")
+      result._smsStoreNames = splitValue(value);
+    else if (key == "cnmiModes")
+      result._cnmiModes = s;
+  }
+
+  // the entry is only valid for the same ME with the same firmware
+  if (! versionOk || result._meInfo._serialNumber != serialNumber ||
+      result._meInfo._revision != revision)
+    return false;
+  entry = result;
+  return true;
+}
+
+void ProbeCache::save(const ProbeCacheEntry &entry) const
+{
+  std::string fn = filename(entry._meInfo._serialNumber);
+  if (fn == "")
+    return;
+
+  // several clients may probe the same ME, readers never see partial
+  // entries
+  AtomicFile file(fn);
+  std::ostream &os = file.stream();
+  os << "# gsmlib probe cache" << std::endl
+     << "version=" << PROBE_CACHE_VERSION << std::endl
+     << "manufacturer=" << escapeValue(entry._meInfo._manufacturer)
+     << std::endl
+     << "model=" << escapeValue(entry._meInfo._model) << std::endl
+     << "revision=" << escapeValue(entry._meInfo._revision) << std::endl
+     << "serialNumber=" << escapeValue(entry._meInfo._serialNumber)
+     << std::endl
+     << "hasSMSPDUmode=" << entry._hasSMSPDUmode << std::endl
+     << "MotorolaModeCmd=" << entry._MotorolaModeCmd << std::endl
+     << "noCPBxParentheses=" << entry._noCPBxParentheses << std::endl
+     << "hasCMMS=" << entry._hasCMMS << std::endl
+     << "cpmsParamCount=" << entry._cpmsParamCount << std::endl
+     << "charSets=" << joinValue(entry._charSets) << std::endl
+     << "phonebookStrings=" << joinValue(entry._phonebookStrings)
+     << std::endl
+     << "smsStoreNames=" << joinValue(entry._smsStoreNames) << std::endl
+     << "cnmiModes=" << escapeValue(entry._cnmiModes) << std::endl;
+  file.commit();
+}
@@ -0,0 +1,70 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_probe_cache.h
+// *
+// * Purpose: On-disk cache of the capabilities and static information
+// *          probed from an ME/TA
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_PROBE_CACHE_H
+#define GSM_PROBE_CACHE_H
+
+#include <gsmlib/gsm_me_ta.h>
+#include <string>
+#include <vector>
+
+namespace gsmlib
+{
+  // everything MeTa finds out about an ME/TA that does not change
+  // as long as the same ME with the same firmware is connected
+  struct ProbeCacheEntry
+  {
+    MEInfo _meInfo;             // +CGMI, +CGMM, +CGMR, +CGSN
+    bool _hasSMSPDUmode;        // +CMGF=0 works
+    bool _MotorolaModeCmd;      // Motorola 60t detected with +GMM
+    bool _noCPBxParentheses;    // missing() around CPBS/CPBR responses
+    bool _hasCMMS;              // +CMMS=? lists modes 1 and 2
+    int _cpmsParamCount;        // number of +CPMS parameters, -1 if unknown
+    std::vector<std::string> _charSets; // +CSCS=?, empty if unknown
+    std::vector<std::string> _phonebookStrings; // +CPBS=?, empty if unknown
+    std::vector<std::string> _smsStoreNames; // +CPMS=?, empty if unknown
+    std::string _cnmiModes;     // +CNMI=? response, empty if unknown
+
+    ProbeCacheEntry() : _hasSMSPDUmode(true), _MotorolaModeCmd(false),
+      _noCPBxParentheses(false), _hasCMMS(false), _cpmsParamCount(-1) {}
+  };
+
+  // The ProbeCache keeps one file per ME in the given directory, named
+  // after the IMEI (serial number). An entry is only valid if the firmware
+  // revision still matches, so MeTa::init() needs just +CGSN and +CGMR
+  // to validate it.
+  // MeTa uses the cache if the environment variable GSMLIB_PROBE_CACHE
+  // is set to the directory.
+
+  class ProbeCache
+  {
+  private:
+    std::string _directory;     // cache directory
+
+    // return file name for the given serial number, "" if not usable
+    std::string filename(std::string serialNumber) const;
+
+  public:
+    ProbeCache(std::string directory) : _directory(directory) {}
+
+    // read the entry for serialNumber
+    // return false if there is no entry, if the revision differs or
+    // the entry is unreadable
+    bool load(std::string serialNumber, std::string revision,
+              ProbeCacheEntry &entry) const;
+
+    // write entry (keyed by entry._meInfo._serialNumber)
+    // does nothing if the ME has no serial number
+    void save(const ProbeCacheEntry &entry) const;
+  };
+};
+
+#endif // GSM_PROBE_CACHE_H
@@ -0,0 +1,354 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_recording_port.cc
+// *
+// * Purpose: Ports that record the dialogue with the ME/TA in a trace file
+// *          and play such a trace back
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <gsmlib/gsm_recording_port.h>
+#include <iostream>
+#include <cstring>
+#include <cassert>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+
+using namespace gsmlib;
+
+static const char TRACE_MAGIC[] = "GSMT";
+static const unsigned long MAX_RECORD_LENGTH = 1 << 20;
+
+// return current time in seconds
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// sleep for the given number of seconds, stop if interrupted
+static void sleepFor(double seconds)
+{
+  double end = now() + seconds;
+  while (seconds > 0)
+  {
+    if (interrupted())
+      throw GsmException(_("interrupted when reading from TA"), OSError);
+    if (seconds > 1)
+      seconds = 1;
+    struct timeval tv;
+    tv.tv_sec = (long)seconds;
+    tv.tv_usec = (long)((seconds - tv.tv_sec) * 1000000);
+    select(0, NULL, NULL, NULL, &tv);
+    seconds = end - now();
+  }
+}
+
+static void putLong(std::string &s, unsigned long l)
+{
+  uint32_t n = htonl(l);
+  s.append((const char*)&n, sizeof(n));
+}
+
+// return written line without CR for messages
+static std::string lineOf(const std::string &data)
+{
+  if (data.length() > 0 && data[data.length() - 1] == CR)
+    return data.substr(0, data.length() - 1);
+  return data;
+}
+
+// RecordingPort members
+
+void RecordingPort::record(char direction, const std::string &data)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  long sec = tv.tv_sec - _start.tv_sec;
+  long usec = tv.tv_usec - _start.tv_usec;
+  if (usec < 0)
+  {
+    usec += 1000000;
+    --sec;
+  }
+
+  std::string header(1, direction);
+  putLong(header, sec);
+  putLong(header, usec);
+  putLong(header, data.length());
+  _trace.write(header.data(), header.length());
+  _trace.write(data.data(), data.length());
+  _trace.flush();
+  if (! _trace)
+    throw GsmException(stringPrintf(_("error writing to file '%s'"),
+                                    _filename.c_str()), OSError);
+}
+
+void RecordingPort::flushRead()
+{
+  if (_readBuffer.length() > 0)
+  {
+    record('R', _readBuffer);
+    _readBuffer = "";
+  }
+}
+
+RecordingPort::RecordingPort(Ref<Port> port, std::string filename) :
+  _port(port), _filename(filename), _skipNext(false)
+{
+  _trace.open(filename.c_str(), std::ios::out | std::ios::binary);
+  if (! _trace)
+    throw GsmException(stringPrintf(_("cannot open file '%s'"),
+                                    filename.c_str()), OSError);
+
+  std::string header(TRACE_MAGIC);
+  uint16_t version = htons(TRACE_FORMAT_VERSION);
+  header.append((const char*)&version, sizeof(version));
+  _trace.write(header.data(), header.length());
+  gettimeofday(&_start, NULL);
+}
+
+void RecordingPort::putBack(unsigned char c)
+{
+  // the byte is read again, record it only once
+  if (_readBuffer.length() > 0)
+    _readBuffer.erase(_readBuffer.length() - 1);
+  else
+    _skipNext = true;
+  _port->putBack(c);
+}
+
+int RecordingPort::readByte()
+{
+  int c = _port->readByte();
+  if (c >= 0)
+  {
+    if (_skipNext)
+      _skipNext = false;
+    else
+    {
+      _readBuffer += (char)c;
+      if (c == LF)
+        flushRead();
+    }
+  }
+  return c;
+}
+
+std::string RecordingPort::getLine()
+{
+  std::string result = _port->getLine();
+  _readBuffer += result + CR + LF;
+  _skipNext = false;
+  flushRead();
+  return result;
+}
+
+void RecordingPort::putLine(std::string line, bool carriageReturn)
+{
+  flushRead();
+  record('W', carriageReturn ? line + CR : line);
+  _port->putLine(line, carriageReturn);
+}
+
+bool RecordingPort::wait(GsmTime timeout)
+{
+  return _port->wait(timeout);
+}
+
+void RecordingPort::setTimeOut(unsigned int timeout)
+{
+  _port->setTimeOut(timeout);
+}
+
+RecordingPort::~RecordingPort()
+{
+  if (_readBuffer.length() > 0)
+    try
+    {
+      flushRead();
+    }
+    catch (GsmException &)
+    {
+    }
+}
+
+// ReplayPort members
+
+void ReplayPort::nextRecord()
+{
+  char header[13];
+  _haveRecord = false;
+  if (! _trace.read(header, 1))
+    return;                     // end of trace
+  _trace.read(header + 1, sizeof(header) - 1);
+  uint32_t values[3];
+  memcpy(values, header + 1, sizeof(values));
+  unsigned long length = ntohl(values[2]);
+  _direction = header[0];
+  _recordTime = ntohl(values[0]) + ntohl(values[1]) / 1000000.0;
+  if (! _trace || length > MAX_RECORD_LENGTH)
+    throw GsmException(stringPrintf(_("corrupt trace file '%s'"),
+                                    _filename.c_str()), ParserError);
+
+  char *data = new char[length];
+  _trace.read(data, length);
+  _data.assign(data, length);
+  delete[] data;
+  if (! _trace || (_direction != 'R' && _direction != 'W'))
+    throw GsmException(stringPrintf(_("corrupt trace file '%s'"),
+                                    _filename.c_str()), ParserError);
+  _haveRecord = true;
+}
+
+double ReplayPort::delay()
+{
+  if (_speed <= 0)
+    return 0;
+  return _lastTime + (_recordTime - _lastRecordTime) / _speed - now();
+}
+
+void ReplayPort::consume()
+{
+  _lastTime = now();
+  _lastRecordTime = _recordTime;
+  nextRecord();
+}
+
+ReplayPort::ReplayPort(std::string filename, double speed) :
+  _filename(filename), _speed(speed), _oldChar(-1), _bufferPos(0),
+  _haveRecord(false), _lastRecordTime(0)
+{
+  _trace.open(filename.c_str(), std::ios::in | std::ios::binary);
+  if (! _trace)
+    throw GsmException(stringPrintf(_("cannot open file '%s'"),
+                                    filename.c_str()), OSError);
+
+  char header[6];
+  uint16_t version;
+  _trace.read(header, sizeof(header));
+  memcpy(&version, header + 4, sizeof(version));
+  if (! _trace || std::string(header, 4) != TRACE_MAGIC)
+    throw GsmException(stringPrintf(_("corrupt trace file '%s'"),
+                                    filename.c_str()), ParserError);
+  if (ntohs(version) != TRACE_FORMAT_VERSION)
+    throw GsmException(stringPrintf(_("file '%s' has wrong version"),
+                                    filename.c_str()), ParameterError);
+  nextRecord();
+  _lastTime = now();
+}
+
+void ReplayPort::putBack(unsigned char c)
+{
+  assert(_oldChar == -1);
+  _oldChar = c;
+}
+
+int ReplayPort::readByte()
+{
+  if (_oldChar != -1)
+  {
+    int result = _oldChar;
+    _oldChar = -1;
+    return result;
+  }
+
+  while (_bufferPos == _buffer.length())
+  {
+    if (! _haveRecord)
+      throw GsmException(stringPrintf(_("end of trace file '%s'"),
+                                      _filename.c_str()), OSError);
+    if (_direction != 'R')
+      throw GsmException(
+        stringPrintf(_("trace file '%s' expects '%s' to be sent"),
+                     _filename.c_str(), lineOf(_data).c_str()), OtherError);
+    sleepFor(delay());
+    _buffer = _data;
+    _bufferPos = 0;
+    consume();
+  }
+  return (unsigned char)_buffer[_bufferPos++];
+}
+
+std::string ReplayPort::getLine()
+{
+  std::string result;
+  int c;
+  while ((c = readByte()) >= 0)
+  {
+    while (c == CR)
+      c = readByte();
+    if (c == LF)
+      break;
+    result += c;
+  }
+
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "<-- " << result << std::endl;
+#endif
+
+  return result;
+}
+
+void ReplayPort::putLine(std::string line, bool carriageReturn)
+{
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "--> " << line << std::endl;
+#endif
+
+  // data recorded before the line was written has arrived by now
+  while (_haveRecord && _direction == 'R')
+  {
+    _buffer = _buffer.substr(_bufferPos) + _data;
+    _bufferPos = 0;
+    consume();
+  }
+
+  std::string data = carriageReturn ? line + CR : line;
+  if (! _haveRecord)
+    throw GsmException(stringPrintf(_("end of trace file '%s'"),
+                                    _filename.c_str()), OSError);
+  if (_data != data)
+    throw GsmException(
+      stringPrintf(_("trace file '%s' expects '%s' to be sent instead of '%s'"),
+                   _filename.c_str(), lineOf(_data).c_str(), line.c_str()),
+      OtherError);
+  consume();
+}
+
+bool ReplayPort::wait(GsmTime timeout)
+{
+  if (_oldChar != -1 || _bufferPos < _buffer.length())
+    return true;
+
+  double timeoutSecs = -1;
+  if (timeout != NULL)
+    timeoutSecs = timeout->tv_sec + timeout->tv_usec / 1000000.0;
+  if (_haveRecord && _direction == 'R')
+  {
+    // readByte() waits for the rest of the delay
+    double d = delay();
+    if (timeoutSecs < 0 || d <= timeoutSecs)
+      return true;
+  }
+  else if (timeoutSecs < 0)
+    return false;               // nothing would ever arrive
+  sleepFor(timeoutSecs);
+  return false;
+}
+
+void ReplayPort::setTimeOut(unsigned int timeout)
+{
+  // the trace determines the timing
+}
@@ -0,0 +1,125 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_recording_port.h
+// *
+// * Purpose: Ports that record the dialogue with the ME/TA in a trace file
+// *          and play such a trace back
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_RECORDING_PORT_H
+#define GSM_RECORDING_PORT_H
+
+#include <string>
+#include <fstream>
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_port.h>
+#include <gsmlib/gsm_util.h>
+
+namespace gsmlib
+{
+  // Trace file format:
+  // The file starts with the magic "GSMT" and the format version (2 bytes,
+  // network byte order). Each record consists of
+  // 1. the direction (1 byte): 'W' for a line written to the ME/TA, 'R'
+  //    for data read from the ME/TA
+  // 2. the time since the start of the recording: seconds and
+  //    microseconds (4 bytes each, network byte order)
+  // 3. the length of the data (4 bytes, network byte order)
+  // 4. the data
+  // Written lines include the CR if one was sent. Data read byte by byte
+  // is recorded up to and including each LF, lines returned by getLine()
+  // are recorded with CR LF appended.
+
+  const unsigned short TRACE_FORMAT_VERSION = 1;
+
+  // The RecordingPort passes everything through to the port it decorates
+  // and writes every line in both directions to the trace file.
+
+  class RecordingPort : public Port
+  {
+  private:
+    Ref<Port> _port;            // decorated port
+    std::string _filename;      // trace file
+    std::ofstream _trace;
+    struct timeval _start;      // start of recording
+    std::string _readBuffer;    // data read but not recorded yet
+    bool _skipNext;             // next byte read is recorded already
+
+    // write one record
+    void record(char direction, const std::string &data);
+
+    // record _readBuffer if not empty
+    void flushRead();
+
+  public:
+    // start recording to filename, an existing file is overwritten
+    RecordingPort(Ref<Port> port, std::string filename);
+
+    // return decorated port
+    Ref<Port> port() const {return _port;}
+
+    // inherited from Port
+    void putBack(unsigned char c);
+    int readByte();
+    std::string getLine();
+    void putLine(std::string line,
+                 bool carriageReturn = true);
+    bool wait(GsmTime timeout);
+    void setTimeOut(unsigned int timeout);
+
+    virtual ~RecordingPort();
+  };
+
+  // The ReplayPort plays a trace written by the RecordingPort back.
+  // Lines written must match the recorded ones, otherwise a GsmException
+  // is thrown. Read data becomes available after the same delay relative
+  // to the preceding record as in the recording, divided by speed.
+
+  class ReplayPort : public Port
+  {
+  private:
+    std::string _filename;      // trace file
+    std::ifstream _trace;
+    double _speed;              // 1.0 recorded speed, 0 no delays
+    int _oldChar;               // character set by putBack() (-1 == none)
+    std::string _buffer;        // data replayed but not read yet
+    unsigned int _bufferPos;    // next byte in _buffer
+
+    // next record in the trace
+    bool _haveRecord;           // false at end of trace
+    char _direction;
+    double _recordTime;
+    std::string _data;
+
+    double _lastRecordTime;     // trace time of the previous record
+    double _lastTime;           // time when previous record was replayed
+
+    // read next record from the trace
+    void nextRecord();
+
+    // return seconds until the next record is due
+    double delay();
+
+    // mark the next record as replayed and read the one after it
+    void consume();
+
+  public:
+    // open trace filename, speed 10.0 replays ten times faster than
+    // recorded, 0 replays without delays
+    ReplayPort(std::string filename, double speed = 1.0);
+
+    // inherited from Port
+    void putBack(unsigned char c);
+    int readByte();
+    std::string getLine();
+    void putLine(std::string line,
+                 bool carriageReturn = true);
+    bool wait(GsmTime timeout);
+    void setTimeOut(unsigned int timeout);
+  };
+};
+
+#endif // GSM_RECORDING_PORT_H
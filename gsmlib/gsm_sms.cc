@@ -20,8 +20,10 @@
 #include <gsmlib/gsm_util.h>
 #include <gsmlib/gsm_parser.h>
 #include <gsmlib/gsm_me_ta.h>
+#include <gsmlib/gsm_tracing.h>
 #include <sstream>
 #include <string>
+#include <cstdint>
 
 using namespace gsmlib;
 
@@ -30,12 +32,16 @@ using namespace gsmlib;
 static const std::string dashes =
 "---------------------------------------------------------------------------";
 
+// returned by address() of messages that have none
+static const Address noAddress;
+
 // SMSMessage members
 
-Ref<SMSMessage> SMSMessage::decode(std::string pdu,
+Ref<SMSMessage> SMSMessage::decode(const std::string &pdu,
                                    bool SCtoMEdirection,
                                    GsmAt *at)
 {
+  TraceSpan span("pdu", "decode");
   Ref<SMSMessage> result;
   SMSDecoder d(pdu);
   d.getAddress(true);
@@ -198,7 +204,7 @@ SMSDeliverMessage::SMSDeliverMessage()
   init();
 }
 
-SMSDeliverMessage::SMSDeliverMessage(std::string pdu)
+SMSDeliverMessage::SMSDeliverMessage(const std::string &pdu)
 {
   SMSDecoder d(pdu);
   _serviceCentreAddress = d.getAddress(true);
@@ -244,6 +250,7 @@ SMSDeliverMessage::SMSDeliverMessage(std::string pdu)
 
 std::string SMSDeliverMessage::encode()
 {
+  TraceSpan span("pdu", "encode");
   SMSEncoder e;
   e.setAddress(_serviceCentreAddress, true);
   e.set2Bits(_messageTypeIndicator); // bits 0..1
@@ -298,7 +305,7 @@ std::string SMSDeliverMessage::toString() const
      return os.str();
 }
 
-Address SMSDeliverMessage::address() const
+const Address &SMSDeliverMessage::address() const
 {
   return _originatingAddress;
 }
@@ -330,7 +337,7 @@ SMSSubmitMessage::SMSSubmitMessage()
   init();
 }
 
-SMSSubmitMessage::SMSSubmitMessage(std::string pdu)
+SMSSubmitMessage::SMSSubmitMessage(const std::string &pdu)
 { 
   SMSDecoder d(pdu);
   _serviceCentreAddress = d.getAddress(true);
@@ -375,7 +382,8 @@ SMSSubmitMessage::SMSSubmitMessage(std::string pdu)
   }
 }
 
-SMSSubmitMessage::SMSSubmitMessage(std::string text, std::string number)
+SMSSubmitMessage::SMSSubmitMessage(const std::string &text,
+                                   const std::string &number)
 {
   init();
   _destinationAddress = Address(number);
@@ -384,6 +392,7 @@ SMSSubmitMessage::SMSSubmitMessage(std::string text, std::string number)
 
 std::string SMSSubmitMessage::encode()
 {
+  TraceSpan span("pdu", "encode");
   SMSEncoder e;
   e.setAddress(_serviceCentreAddress, true);
   e.set2Bits(_messageTypeIndicator); // bits 0..1
@@ -456,7 +465,7 @@ std::string SMSSubmitMessage::toString() const
      return os.str();
 }
 
-Address SMSSubmitMessage::address() const
+const Address &SMSSubmitMessage::address() const
 {
   return _destinationAddress;
 }
@@ -478,7 +487,7 @@ void SMSStatusReportMessage::init()
   _status = SMS_STATUS_RECEIVED;
 }
 
-SMSStatusReportMessage::SMSStatusReportMessage(std::string pdu)
+SMSStatusReportMessage::SMSStatusReportMessage(const std::string &pdu)
 {
   SMSDecoder d(pdu);
   _serviceCentreAddress = d.getAddress(true);
@@ -497,6 +506,7 @@ SMSStatusReportMessage::SMSStatusReportMessage(std::string pdu)
 
 std::string SMSStatusReportMessage::encode()
 {
+  TraceSpan span("pdu", "encode");
   SMSEncoder e;
   e.setAddress(_serviceCentreAddress, true);
   e.set2Bits(_messageTypeIndicator); // bits 0..1
@@ -530,7 +540,7 @@ std::string SMSStatusReportMessage::toString() const
   return os.str();
 }
 
-Address SMSStatusReportMessage::address() const
+const Address &SMSStatusReportMessage::address() const
 {
   return _recipientAddress;
 }
@@ -554,7 +564,7 @@ void SMSCommandMessage::init()
   _commandDataLength = 0;
 }
 
-SMSCommandMessage::SMSCommandMessage(std::string pdu)
+SMSCommandMessage::SMSCommandMessage(const std::string &pdu)
 {
   SMSDecoder d(pdu);
   _serviceCentreAddress = d.getAddress(true);
@@ -577,6 +587,7 @@ SMSCommandMessage::SMSCommandMessage(std::string pdu)
 
 std::string SMSCommandMessage::encode()
 {
+  TraceSpan span("pdu", "encode");
   SMSEncoder e;
   e.setAddress(_serviceCentreAddress, true);
   e.set2Bits(_messageTypeIndicator); // bits 0..1
@@ -616,7 +627,7 @@ std::string SMSCommandMessage::toString() const
   return os.str();
 }
 
-Address SMSCommandMessage::address() const
+const Address &SMSCommandMessage::address() const
 {
   return _destinationAddress;
 }
@@ -637,7 +648,7 @@ void SMSDeliverReportMessage::init()
   _userDataLengthPresent = false;
 }
 
-SMSDeliverReportMessage::SMSDeliverReportMessage(std::string pdu)
+SMSDeliverReportMessage::SMSDeliverReportMessage(const std::string &pdu)
 {
   SMSDecoder d(pdu);
   _serviceCentreAddress = d.getAddress(true);
@@ -672,6 +683,7 @@ SMSDeliverReportMessage::SMSDeliverReportMessage(std::string pdu)
 
 std::string SMSDeliverReportMessage::encode()
 {
+  TraceSpan span("pdu", "encode");
   SMSEncoder e;
   e.setAddress(_serviceCentreAddress, true);
   e.set2Bits(_messageTypeIndicator); // bits 0..1
@@ -723,10 +735,10 @@ std::string SMSDeliverReportMessage::toString() const
   return os.str();
 }
 
-Address SMSDeliverReportMessage::address() const
+const Address &SMSDeliverReportMessage::address() const
 {
   assert(0);                    // not address, should not be in SMS store
-  return Address();
+  return noAddress;
 }
 
 Ref<SMSMessage> SMSDeliverReportMessage::clone()
@@ -745,7 +757,7 @@ void SMSSubmitReportMessage::init()
   _userDataLengthPresent = false;
 }
 
-SMSSubmitReportMessage::SMSSubmitReportMessage(std::string pdu)
+SMSSubmitReportMessage::SMSSubmitReportMessage(const std::string &pdu)
 {
   SMSDecoder d(pdu);
   _serviceCentreAddress = d.getAddress(true);
@@ -780,6 +792,7 @@ SMSSubmitReportMessage::SMSSubmitReportMessage(std::string pdu)
 
 std::string SMSSubmitReportMessage::encode()
 {
+  TraceSpan span("pdu", "encode");
   SMSEncoder e;
   e.setAddress(_serviceCentreAddress, true);
   e.set2Bits(_messageTypeIndicator); // bits 0..1
@@ -831,10 +844,10 @@ std::string SMSSubmitReportMessage::toString() const
   return os.str();
 }
 
-Address SMSSubmitReportMessage::address() const
+const Address &SMSSubmitReportMessage::address() const
 {
   assert(0);                    // not address, should not be in SMS store
-  return Address();
+  return noAddress;
 }
 
 Ref<SMSMessage> SMSSubmitReportMessage::clone()
@@ -843,3 +856,106 @@ Ref<SMSMessage> SMSSubmitReportMessage::clone()
   return result;
 }
 
+
+// splitSMSText and SMSSubmitTemplate members
+
+std::vector<Ref<SMSSubmitMessage> >
+gsmlib::splitSMSText(Ref<SMSSubmitMessage> smsTemplate, std::string text,
+                     bool oneSMS, int concatenatedMessageId)
+{
+  assert(! smsTemplate.isnull());
+  std::vector<Ref<SMSSubmitMessage> > result;
+
+  // compute maximum text length for normal SMSs and concatenated SMSs
+  unsigned int maxTextLength, concMaxTextLength;
+  switch (smsTemplate->dataCodingScheme().getAlphabet())
+  {
+  case DCS_DEFAULT_ALPHABET:
+    maxTextLength = 160;
+    concMaxTextLength = 152;
+    break;
+  case DCS_EIGHT_BIT_ALPHABET:
+    maxTextLength = 140;
+    concMaxTextLength = 134;
+    break;
+  case DCS_SIXTEEN_BIT_ALPHABET:
+    maxTextLength = 70;
+    concMaxTextLength = 67;
+    break;
+  default:
+    throw GsmException(_("unsupported alphabet for SMS"),
+                       ParameterError);
+    break;
+  }
+
+  // simple case, only one SMS
+  if (oneSMS || text.length() <= maxTextLength)
+  {
+    if (text.length() > maxTextLength)
+      throw GsmException(_("SMS text is larger than allowed"),
+                         ParameterError);
+    Ref<SMSSubmitMessage> sms = new SMSSubmitMessage(*smsTemplate.getptr());
+    sms->setUserData(text);
+    result.push_back(sms);
+  }
+  else                          // multiple SMSs
+  {
+    if (concatenatedMessageId != -1)
+      maxTextLength = concMaxTextLength;
+
+    int numMessages = (text.length() + maxTextLength - 1) / maxTextLength;
+    if (numMessages > 255)
+      throw GsmException(_("not more than 255 concatenated SMSs allowed"),
+                         ParameterError);
+    unsigned char numMessage = 0;
+    for (unsigned int pos = 0; pos < text.length(); pos += maxTextLength)
+    {
+      Ref<SMSSubmitMessage> sms = new SMSSubmitMessage(*smsTemplate.getptr());
+      if (concatenatedMessageId != -1)
+      {
+        unsigned char udhs[] = {0x00, 0x03, (uint8_t)concatenatedMessageId,
+                                (uint8_t)numMessages, ++numMessage};
+        UserDataHeader udh(std::string((char*)udhs, 5));
+        sms->setUserDataHeader(udh);
+      }
+      sms->setUserData(text.substr(pos, maxTextLength));
+      result.push_back(sms);
+    }
+  }
+  return result;
+}
+
+SMSSubmitTemplate::SMSSubmitTemplate(Ref<SMSSubmitMessage> smsTemplate,
+                                     std::string text, bool oneSMS,
+                                     int concatenatedMessageId)
+{
+  std::vector<Ref<SMSSubmitMessage> > sms =
+    splitSMSText(smsTemplate, text, oneSMS, concatenatedMessageId);
+  _scAddressLen = smsTemplate->getSCAddressLen();
+
+  for (std::vector<Ref<SMSSubmitMessage> >::iterator i = sms.begin();
+       i != sms.end(); ++i)
+  {
+    // PDU layout: SC address, first octet, TP-MR, TP-DA, rest
+    std::string pdu = (*i)->encode();
+    SMSEncoder e;
+    Address destination = (*i)->destinationAddress();
+    e.setAddress(destination);
+    unsigned int tailStart = (_scAddressLen + 2 + e.getLength()) * 2;
+
+    Part part;
+    part._head = pdu.substr(0, (_scAddressLen + 1) * 2);
+    part._tail = pdu.substr(tailStart);
+    _parts.push_back(part);
+  }
+}
+
+std::string SMSSubmitTemplate::pdu(unsigned int part, Address destination,
+                                   unsigned char messageReference) const
+{
+  assert(part < _parts.size());
+  SMSEncoder e;
+  e.setOctet(messageReference);
+  e.setAddress(destination);
+  return _parts[part]._head + e.getHexString() + _parts[part]._tail;
+}
@@ -20,6 +20,7 @@
 #include <gsmlib/gsm_at.h>
 #include <string>
 #include <vector>
+#include <utility>
 
 namespace gsmlib
 {
@@ -57,7 +58,7 @@ namespace gsmlib
     // return SMSMessage of the appropriate type
     // differentiate between SMS transfer directions SC to ME, ME to SC
     // also give GsmAt object for send()
-    static Ref<SMSMessage> decode(std::string pdu,
+    static Ref<SMSMessage> decode(const std::string &pdu,
                                   bool SCtoMEdirection = true,
                                   GsmAt *at = NULL);
 
@@ -85,30 +86,32 @@ namespace gsmlib
 
     // accessor functions
     MessageType messageType() const {return _messageTypeIndicator;}
-    Address serviceCentreAddress() const {return _serviceCentreAddress;}
+    const Address &serviceCentreAddress() const {return _serviceCentreAddress;}
 
     // provided for sorting messages by timestamp
     virtual Timestamp serviceCentreTimestamp() const {return Timestamp();}
     
     // return recipient, destination etc. address (for sorting by address)
-    virtual Address address() const = 0;
+    virtual const Address &address() const = 0;
 
-    virtual void setUserData(std::string x) {_userData = x;}
-    virtual std::string userData() const {return _userData;}
+    virtual void setUserData(std::string x) {_userData = std::move(x);}
+    virtual const std::string &userData() const {return _userData;}
     
     // return the size of user data (including user data header)
     unsigned char userDataLength() const;
 
     // accessor functions
-    virtual void setUserDataHeader(UserDataHeader x) {_userDataHeader = x;}
-    virtual UserDataHeader userDataHeader() const {return _userDataHeader;}
+    virtual void setUserDataHeader(UserDataHeader x)
+      {_userDataHeader = std::move(x);}
+    virtual const UserDataHeader &userDataHeader() const
+      {return _userDataHeader;}
     
     virtual DataCodingScheme dataCodingScheme() const
       {return _dataCodingScheme;}
     virtual void setDataCodingScheme(DataCodingScheme x)
       {_dataCodingScheme = x;}
 
-    void setServiceCentreAddress(Address &x) {_serviceCentreAddress = x;}
+    void setServiceCentreAddress(const Address &x) {_serviceCentreAddress = x;}
     void setAt(Ref<GsmAt> at) {_at = at;}
 
     virtual ~SMSMessage();
@@ -143,7 +146,7 @@ namespace gsmlib
     SMSDeliverMessage();
 
     // constructor with given pdu
-    SMSDeliverMessage(std::string pdu);
+    SMSDeliverMessage(const std::string &pdu);
 
     // encode pdu, return hexadecimal pdu string
     virtual std::string encode();
@@ -152,21 +155,21 @@ namespace gsmlib
     virtual std::string toString() const;
 
     // inherited from SMSMessage
-    Address address() const;
+    const Address &address() const;
     Ref<SMSMessage> clone();
 
     // accessor functions
     bool moreMessagesToSend() const {return _moreMessagesToSend;}
     bool replyPath() const {return _replyPath;}
     bool statusReportIndication() const {return _statusReportIndication;}
-    Address originatingAddress() const {return _originatingAddress;}
+    const Address &originatingAddress() const {return _originatingAddress;}
     unsigned char protocolIdentifier() const {return _protocolIdentifier;}
     Timestamp serviceCentreTimestamp() const {return _serviceCentreTimestamp;}
 
     void setMoreMessagesToSend(bool x) {_moreMessagesToSend = x;}
     void setReplyPath(bool x) {_replyPath = x;}
     void setStatusReportIndication(bool x) {_statusReportIndication = x;}
-    void setOriginatingAddress(Address &x) {_originatingAddress = x;}
+    void setOriginatingAddress(const Address &x) {_originatingAddress = x;}
     void setProtocolIdentifier(unsigned char x) {_protocolIdentifier = x;}
     void setServiceCentreTimestamp(Timestamp &x) {_serviceCentreTimestamp = x;}
 
@@ -195,11 +198,11 @@ namespace gsmlib
     SMSSubmitMessage();
 
     // constructor with given pdu
-    SMSSubmitMessage(std::string pdu);
+    SMSSubmitMessage(const std::string &pdu);
 
     // convenience constructor
     // given the text and recipient telephone number
-    SMSSubmitMessage(std::string text, std::string number);
+    SMSSubmitMessage(const std::string &text, const std::string &number);
 
     // encode pdu, return hexadecimal pdu string
     virtual std::string encode();
@@ -208,7 +211,7 @@ namespace gsmlib
     virtual std::string toString() const;
 
     // inherited from SMSMessage
-    Address address() const;
+    const Address &address() const;
     Ref<SMSMessage> clone();
 
     // accessor functions
@@ -218,7 +221,7 @@ namespace gsmlib
     bool replyPath() const {return _replyPath;}
     bool statusReportRequest() const {return _statusReportRequest;}
     unsigned char messageReference() const {return _messageReference;}
-    Address destinationAddress() const {return _destinationAddress;}
+    const Address &destinationAddress() const {return _destinationAddress;}
     unsigned char protocolIdentifier() const {return _protocolIdentifier;}
     TimePeriod validityPeriod() const {return _validityPeriod;}
 
@@ -228,7 +231,7 @@ namespace gsmlib
     void setReplyPath(bool x) {_replyPath = x;}
     void setStatusReportRequest(bool x) {_statusReportRequest = x;}
     void setMessageReference(unsigned char x) {_messageReference = x;}
-    void setDestinationAddress(Address &x) {_destinationAddress = x;}
+    void setDestinationAddress(const Address &x) {_destinationAddress = x;}
     void setProtocolIdentifier(unsigned char x) {_protocolIdentifier = x;}
     void setValidityPeriod(TimePeriod &x) {_validityPeriod = x;}
     
@@ -256,7 +259,7 @@ namespace gsmlib
     SMSStatusReportMessage() {init();}
 
     // constructor with given pdu
-    SMSStatusReportMessage(std::string pdu);
+    SMSStatusReportMessage(const std::string &pdu);
 
     // encode pdu, return hexadecimal pdu string
     virtual std::string encode();
@@ -265,14 +268,14 @@ namespace gsmlib
     virtual std::string toString() const;
 
     // inherited from SMSMessage
-    Address address() const;
+    const Address &address() const;
     Ref<SMSMessage> clone();
 
     // accessor functions
     bool moreMessagesToSend() const {return _moreMessagesToSend;}
     bool statusReportQualifier() const {return _statusReportQualifier;}
     unsigned char messageReference() const {return _messageReference;}
-    Address recipientAddress() const {return _recipientAddress;}
+    const Address &recipientAddress() const {return _recipientAddress;}
     Timestamp serviceCentreTimestamp() const {return _serviceCentreTimestamp;}
     Timestamp dischargeTime() const {return _dischargeTime;}
     unsigned char status() const {return _status;}
@@ -280,7 +283,7 @@ namespace gsmlib
     void setMoreMessagesToSend(bool x) {_moreMessagesToSend = x;}
     void setStatusReportQualifier(bool x) {_statusReportQualifier = x;}
     void setMessageReference(unsigned char x) {_messageReference = x;}
-    void setRecipientAddress(Address x) {_recipientAddress = x;}
+    void setRecipientAddress(Address x) {_recipientAddress = std::move(x);}
     void setServiceCentreTimestamp(Timestamp x) {_serviceCentreTimestamp = x;}
     void setDischargeTime(Timestamp x) {_serviceCentreTimestamp = x;}
     void setStatus(unsigned char x) {_status = x;}
@@ -315,7 +318,7 @@ namespace gsmlib
     SMSCommandMessage() {init();}
 
     // constructor with given pdu
-    SMSCommandMessage(std::string pdu);
+    SMSCommandMessage(const std::string &pdu);
 
     // encode pdu, return hexadecimal pdu string
     virtual std::string encode();
@@ -324,7 +327,7 @@ namespace gsmlib
     virtual std::string toString() const;
 
     // inherited from SMSMessage
-    Address address() const;
+    const Address &address() const;
     Ref<SMSMessage> clone();
 
     // accessor functions
@@ -333,18 +336,18 @@ namespace gsmlib
     unsigned char protocolIdentifier() const {return _protocolIdentifier;}
     unsigned char commandType() const {return _commandType;}
     unsigned char messageNumber() const {return _messageNumber;}
-    Address destinationAddress() const {return _destinationAddress;}
+    const Address &destinationAddress() const {return _destinationAddress;}
     unsigned char commandDataLength() const {return _commandDataLength;}
-    std::string commandData() const {return _commandData;}
+    const std::string &commandData() const {return _commandData;}
 
     void setMessageReference(unsigned char x) {_messageReference = x;}
     void setStatusReportRequest(bool x) {_statusReportRequest = x;}
     void setProtocolIdentifier(unsigned char x) {_protocolIdentifier = x;}
     void setCommandType(unsigned char x) {_commandType = x;}
     void setMessageNumber(unsigned char x) {_messageNumber = x;}
-    void setDestinationAddress(Address &x) {_destinationAddress = x;}
+    void setDestinationAddress(const Address &x) {_destinationAddress = x;}
     void setCommandDataLength(unsigned char x) {_commandDataLength = x;}
-    void setCommandData(std::string x) {_commandData = x;}
+    void setCommandData(std::string x) {_commandData = std::move(x);}
 
     virtual ~SMSCommandMessage() {}
   };
@@ -367,7 +370,7 @@ namespace gsmlib
     SMSDeliverReportMessage() {init();}
 
     // constructor with given pdu
-    SMSDeliverReportMessage(std::string pdu);
+    SMSDeliverReportMessage(const std::string &pdu);
 
     // encode pdu, return hexadecimal pdu string
     virtual std::string encode();
@@ -376,7 +379,7 @@ namespace gsmlib
     virtual std::string toString() const;
 
     // inherited from SMSMessage
-    Address address() const;
+    const Address &address() const;
     Ref<SMSMessage> clone();
 
     // accessor functions
@@ -387,9 +390,9 @@ namespace gsmlib
       {assert(_protocolIdentifierPresent); return _protocolIdentifier;}
     DataCodingScheme dataCodingScheme() const
       {assert(_dataCodingSchemePresent); return _dataCodingScheme;}
-    UserDataHeader userDataHeader() const
+    const UserDataHeader &userDataHeader() const
       {assert(_userDataLengthPresent); return _userDataHeader;}
-    std::string userData() const
+    const std::string &userData() const
       {assert(_userDataLengthPresent); return _userData;}
     
     void setProtocolIdentifier(unsigned char x)
@@ -399,12 +402,12 @@ namespace gsmlib
     void setUserDataHeader(UserDataHeader x)
     {
       _userDataLengthPresent = true;
-      _userDataHeader = x;
+      _userDataHeader = std::move(x);
     }
     void setUserData(std::string x)
     {
       _userDataLengthPresent = true;
-      _userData = x;
+      _userData = std::move(x);
     }
     
     virtual ~SMSDeliverReportMessage() {}
@@ -430,7 +433,7 @@ namespace gsmlib
     SMSSubmitReportMessage() {init();}
 
     // constructor with given pdu
-    SMSSubmitReportMessage(std::string pdu);
+    SMSSubmitReportMessage(const std::string &pdu);
 
     // encode pdu, return hexadecimal pdu string
     virtual std::string encode();
@@ -439,7 +442,7 @@ namespace gsmlib
     virtual std::string toString() const;
 
     // inherited from SMSMessage
-    Address address() const;
+    const Address &address() const;
     Ref<SMSMessage> clone();
 
     // accessor functions
@@ -451,9 +454,9 @@ namespace gsmlib
       {assert(_protocolIdentifierPresent); return _protocolIdentifier;}
     DataCodingScheme dataCodingScheme() const
       {assert(_dataCodingSchemePresent); return _dataCodingScheme;}
-    UserDataHeader userDataHeader() const
+    const UserDataHeader &userDataHeader() const
       {assert(_userDataLengthPresent); return _userDataHeader;}
-    std::string userData() const
+    const std::string &userData() const
       {assert(_userDataLengthPresent); return _userData;}
 
     void setServiceCentreTimestamp(Timestamp &x) {_serviceCentreTimestamp = x;}
@@ -464,18 +467,60 @@ namespace gsmlib
     void setUserDataHeader(UserDataHeader x)
     {
       _userDataLengthPresent = true;
-      _userDataHeader = x;
+      _userDataHeader = std::move(x);
     }
     void setUserData(std::string x)
     {
       _userDataLengthPresent = true;
-      _userData = x;
+      _userData = std::move(x);
     }
     virtual ~SMSSubmitReportMessage() {}
   };
 
+  // split text into one or several (concatenated) SMS-SUBMIT TPDUs
+  // all other options are copied from smsTemplate
+  // see MeTa::sendSMSs() for the meaning of the parameters
+  std::vector<Ref<SMSSubmitMessage> >
+    splitSMSText(Ref<SMSSubmitMessage> smsTemplate, std::string text,
+                 bool oneSMS = false, int concatenatedMessageId = -1);
+
+  // SMS-SUBMIT TPDUs for sending the same text to many recipients
+  // The text is split and encoded once, for every recipient only the
+  // destination address is encoded and patched into the cached PDUs
+  // (together with the message reference and the TPDU length)
+  class SMSSubmitTemplate : public RefBase
+  {
+  private:
+    // cached PDU of one part, split around TP-MR and TP-DA
+    struct Part
+    {
+      std::string _head;        // SC address and first octet (hex)
+      std::string _tail;        // everything after TP-DA (hex)
+    };
+    std::vector<Part> _parts;
+    unsigned int _scAddressLen; // length of encoded SC address (octets)
+
+  public:
+    // parameters as for splitSMSText()
+    // the destination address of smsTemplate is ignored
+    SMSSubmitTemplate(Ref<SMSSubmitMessage> smsTemplate, std::string text,
+                      bool oneSMS = false, int concatenatedMessageId = -1);
+
+    // number of SMSs needed for the text
+    unsigned int parts() const {return _parts.size();}
+
+    // return hexadecimal PDU of the given part for destination
+    std::string pdu(unsigned int part, Address destination,
+                    unsigned char messageReference = 0) const;
+
+    // return length of the TPDU (without SC address) as needed by +CMGS
+    unsigned int tpduLength(const std::string &pdu) const
+      {return pdu.length() / 2 - _scAddressLen;}
+  };
+
   // some useful typdefs
   typedef Ref<SMSMessage> SMSMessageRef;
+  typedef Ref<SMSSubmitTemplate> SMSSubmitTemplateRef;
 };
 
 #endif // GSM_SMS_H
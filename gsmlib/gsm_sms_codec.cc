@@ -28,19 +28,16 @@ using namespace gsmlib;
 
 // Address members
 
-Address::Address(std::string number) : _plan(ISDN_Telephone)
+Address::Address(const std::string &number) : _plan(ISDN_Telephone),
+  _number(removeWhiteSpace(number))
 {
-  number = removeWhiteSpace(number);
-  if (number.length() > 0 && number[0] == '+')
+  if (_number.length() > 0 && _number[0] == '+')
   {
     _type = International;
-    _number = number.substr(1, number.length() - 1);
+    _number.erase(0, 1);
   }
   else
-  {
     _type = Unknown;
-    _number = number;
-  }
 }
 
 std::string Address::toString() const
@@ -236,7 +233,7 @@ std::string DataCodingScheme::toString() const
 
 // SMSDecoder members
 
-SMSDecoder::SMSDecoder(std::string pdu) : _bi(0), _septetStart(NULL)
+SMSDecoder::SMSDecoder(const std::string &pdu) : _bi(0), _septetStart(NULL)
 {
   _p = new unsigned char[pdu.length() / 2];
   _op = _p;
@@ -466,7 +463,7 @@ TimePeriod SMSDecoder::getTimePeriod(TimePeriod::Format format)
 
 SMSDecoder::~SMSDecoder()
 {
-  delete _p;
+  delete[] _p;
 }
 
 // SMSEncoder members
@@ -14,6 +14,7 @@
 #define GSM_SMS_CODEC_H
 
 #include <string>
+#include <utility>
 #include <assert.h>
 
 namespace gsmlib
@@ -41,7 +42,7 @@ namespace gsmlib
     // _type == International if number starts with "+"
     // _type == unknown otherwise
     // number must be of the form "+123456" or "123456"
-    Address(std::string number);
+    Address(const std::string &number);
 
     // return std::string representation
     std::string toString() const;
@@ -162,7 +163,7 @@ namespace gsmlib
 
   public:
     // initialize with a hexadecimal octet std::string containing SMS TPDU
-    SMSDecoder(std::string pdu);
+    SMSDecoder(const std::string &pdu);
 
     // align to octet border
     void alignOctet();
@@ -315,7 +316,7 @@ namespace gsmlib
     UserDataHeader() {}
 
     // initialize with user data header
-    UserDataHeader (std::string udh) : _udh(udh) {}
+    UserDataHeader (std::string udh) : _udh(std::move(udh)) {}
 
     // encode header
     void encode(SMSEncoder &e);
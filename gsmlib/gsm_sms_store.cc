@@ -29,7 +29,7 @@ SMSStoreEntry::SMSStoreEntry() :
 }
 
 
-SMSMessageRef SMSStoreEntry::message() const
+const SMSMessageRef &SMSStoreEntry::message() const
 {
   if (! cached())
   {
@@ -168,6 +168,7 @@ void SMSStore::readEntry(int index, SMSMessageRef &message,
                          SMSStoreEntry::SMSMemoryStatus &status)
 {
   // select SMS store
+  GsmAt::Lock lock(_at());
   _meTa.setSMSStore(_storeName, 1);
 
 #ifndef NDEBUG
@@ -219,6 +220,7 @@ void SMSStore::readEntry(int index, SMSMessageRef &message,
 void SMSStore::readEntry(int index, CBMessageRef &message)
 {
   // select SMS store
+  GsmAt::Lock lock(_at());
   _meTa.setSMSStore(_storeName, 1);
 
 #ifndef NDEBUG
@@ -256,6 +258,7 @@ void SMSStore::readEntry(int index, CBMessageRef &message)
 void SMSStore::writeEntry(int &index, SMSMessageRef message)
 {
   // select SMS store
+  GsmAt::Lock lock(_at());
   _meTa.setSMSStore(_storeName, 2);
 
 #ifndef NDEBUG
@@ -287,6 +290,7 @@ void SMSStore::writeEntry(int &index, SMSMessageRef message)
 void SMSStore::eraseEntry(int index)
 {
   // Select SMS store
+  GsmAt::Lock lock(_at());
   _meTa.setSMSStore(_storeName, 1);
 
 #ifndef NDEBUG
@@ -320,24 +324,89 @@ unsigned char SMSStore::send(int index, Ref<SMSMessage> &ackPdu)
 
 int SMSStore::doInsert(SMSMessageRef message)
 {
+  applyIndications();
   int index;
   writeEntry(index, message);
   // it is safer to force reading back the SMS from the ME
   resizeStore(index + 1);
   _store[index]->_cached = false;
+  changeSize(1);
   return index;
 }
 
 SMSStore::SMSStore(std::string storeName, Ref<GsmAt> at, MeTa &meTa) :
-  _storeName(storeName), _at(at), _meTa(meTa), _useCache(true)
+  _storeName(storeName), _at(at), _meTa(meTa), _useCache(true), _used(-1),
+  _lastSync(0), _syncInterval(30), _fullWarningLevel(1), _fullWarned(false)
+{
+  syncSize();
+}
+
+void SMSStore::syncSize()
 {
   // select SMS store
-  Parser p(_meTa.setSMSStore(_storeName, true, true));
+  GsmAt::Lock lock(_at());
+  Parser p(_meTa.setSMSStore(_storeName, 1, true));
   
-  p.parseInt();                 // skip number of used mems
+  int used = p.parseInt();
   p.parseComma();
 
   resizeStore(p.parseInt());    // ignore rest of line
+  _used = used;
+  _lastSync = time(NULL);
+  changeSize(0);
+}
+
+void SMSStore::changeSize(int delta)
+{
+  if (_used == -1)
+    return;
+  _used += delta;
+  if (_used < 0 || _used > max_size())
+  {
+    // out of step with the ME, read it again next time
+    _used = -1;
+    return;
+  }
+
+  // warn once when the store fills up, re-arm when entries are freed
+  int freeEntries = max_size() - _used;
+  if (freeEntries > _fullWarningLevel)
+    _fullWarned = false;
+  else if (! _fullWarned)
+  {
+    _fullWarned = true;
+    GsmEvent *eventHandler = _at->getEventHandler();
+    if (eventHandler != NULL)
+      eventHandler->SMSStoreFull(_storeName, freeEntries);
+  }
+}
+
+void SMSStore::indication(int index)
+{
+  // the thread reading the +CMTI may not be the one using the store
+  if (_at->threadSafe())
+    _indications.push_back(index);
+  else
+    applyIndication(index);
+}
+
+void SMSStore::applyIndication(int index)
+{
+  resizeStore(index + 1);
+  _store[index]->_cached = false;
+  changeSize(1);
+}
+
+void SMSStore::applyIndications()
+{
+  if (! _at->threadSafe())
+    return;
+  GsmAt::Lock lock(_at());
+  std::vector<int> indications;
+  indications.swap(_indications);
+  for (std::vector<int>::iterator i = indications.begin();
+       i != indications.end(); ++i)
+    applyIndication(*i);
 }
 
 void SMSStore::resizeStore(int newSize)
@@ -361,62 +430,74 @@ void SMSStore::resizeStore(int newSize)
 
 SMSStore::iterator SMSStore::begin()
 {
+  applyIndications();
   return SMSStoreIterator(0, this);
 }
 
 SMSStore::const_iterator SMSStore::begin() const
 {
+  const_cast<SMSStore*>(this)->applyIndications();
   return SMSStoreConstIterator(0, this);
 }
 
 SMSStore::iterator SMSStore::end()
 {
+  applyIndications();
   return SMSStoreIterator(_store.size(), this);
 }
 
 SMSStore::const_iterator SMSStore::end() const
 {
+  const_cast<SMSStore*>(this)->applyIndications();
   return SMSStoreConstIterator(_store.size(), this);
 }
 
 SMSStore::reference SMSStore::operator[](int n)
 {
+  applyIndications();
   resizeStore(n + 1);
   return *_store[n];
 }
 
 SMSStore::const_reference SMSStore::operator[](int n) const
 {
+  const_cast<SMSStore*>(this)->applyIndications();
   const_cast<SMSStore*>(this)->resizeStore(n + 1);
   return *_store[n];
 }
 
 SMSStore::reference SMSStore::front()
 {
+  applyIndications();
   return *_store[0];
 }
 
 SMSStore::const_reference SMSStore::front() const
 {
+  const_cast<SMSStore*>(this)->applyIndications();
   return *_store[0];
 }
 
 SMSStore::reference SMSStore::back()
 {
+  applyIndications();
   return *_store.back();
 }
 
 SMSStore::const_reference SMSStore::back() const
 {
+  const_cast<SMSStore*>(this)->applyIndications();
   return *_store.back();
 }
 
 int SMSStore::size() const
 {
-  // select SMS store
-  Parser p(_meTa.setSMSStore(_storeName, 1, true));
-  
-  return p.parseInt();  
+  const_cast<SMSStore*>(this)->applyIndications();
+  // only ask the ME if the tracked value is unknown or too old
+  if (_used == -1 || _syncInterval == 0 ||
+      time(NULL) - _lastSync >= _syncInterval)
+    const_cast<SMSStore*>(this)->syncSize();
+  return _used;
 }
 
 SMSStore::iterator SMSStore::insert(iterator position,
@@ -446,8 +527,15 @@ void SMSStore::insert (iterator pos, long n, const SMSStoreEntry& x)
 
 SMSStore::iterator SMSStore::erase(iterator position)
 {
+  // only known to free an entry if the old contents were read
+  bool wasCached = position->_cached;
+  bool wasEmpty = position->_message.isnull();
   eraseEntry(position->_index);
   position->_cached = false;
+  if (! wasCached)
+    invalidateSize();
+  else if (! wasEmpty)
+    changeSize(-1);
   return position + 1;
 }
 
@@ -16,6 +16,8 @@
 
 #include <string>
 #include <iterator>
+#include <utility>
+#include <time.h>
 #include <gsmlib/gsm_at.h>
 #include <gsmlib/gsm_util.h>
 #include <gsmlib/gsm_sms.h>
@@ -54,20 +56,20 @@ namespace gsmlib
 
     // create new entry given a SMS message
     SMSStoreEntry(SMSMessageRef message) :
-      _message(message), _status(Unknown), _cached(true), _mySMSStore(NULL),
-      _index(0) {}
+      _message(std::move(message)), _status(Unknown), _cached(true),
+      _mySMSStore(NULL), _index(0) {}
 
     // create new entry given a SMS message and an index
     // only to be used for file-based stores (see gsm_sorted_sms_store)
     SMSStoreEntry(SMSMessageRef message, int index) :
-      _message(message), _status(Unknown), _cached(true), _mySMSStore(NULL),
-      _index(index) {}
+      _message(std::move(message)), _status(Unknown), _cached(true),
+      _mySMSStore(NULL), _index(index) {}
    
     // clear cached flag
     void clearCached() { _cached = false; }
 
     // return SMS message stored in the entry
-    SMSMessageRef message() const;
+    const SMSMessageRef &message() const;
 
     // return CB message stored in the entry
     CBMessageRef cbMessage() const;
@@ -219,6 +221,13 @@ namespace gsmlib
     Ref<GsmAt> _at;             // my GsmAt class
     MeTa &_meTa;                // my MeTa class
     bool _useCache;             // true if entries should be cached
+    int _used;                  // number of used entries, -1 if unknown
+    time_t _lastSync;           // time _used was last read from the ME
+    int _syncInterval;          // seconds until size() asks the ME again
+    int _fullWarningLevel;      // free entries that trigger SMSStoreFull
+    bool _fullWarned;           // SMSStoreFull has been sent
+    std::vector<int> _indications; // indications not applied yet
+                                // (thread-safe mode, protected by GsmAt)
 
     // internal access functions
     // read/write entry from/to ME
@@ -243,6 +252,24 @@ namespace gsmlib
     // resize store entry vector if necessary
     void resizeStore(int newSize);
 
+    // read number of used and total entries from the ME (+CPMS)
+    void syncSize();
+
+    // add delta to the number of used entries (if known)
+    // and send GsmEvent::SMSStoreFull if the store is getting full
+    void changeSize(int delta);
+
+    // called by MeTa if the ME indicates a new message at index
+    // in thread-safe mode this may happen in any thread, the indication
+    // is then only recorded and applied by the next access of the store
+    void indication(int index);
+
+    // mark entry at index as changed and count it
+    void applyIndication(int index);
+
+    // apply the indications recorded in thread-safe mode
+    void applyIndications();
+
   public:
     // iterator defs
     typedef SMSStoreIterator iterator;
@@ -253,6 +280,18 @@ namespace gsmlib
     // set cache mode on or off
     void setCaching(bool useCache) {_useCache = useCache;}
 
+    // the number of used entries is tracked locally and only read from
+    // the ME again after syncInterval seconds (0 means on every size() call)
+    void setSyncInterval(int syncInterval) {_syncInterval = syncInterval;}
+
+    // read the number of used entries from the ME on the next size() call
+    void invalidateSize() {_used = -1;}
+
+    // send GsmEvent::SMSStoreFull when only freeEntries entries are left
+    // (default 1)
+    void setFullWarningLevel(int freeEntries)
+      {_fullWarningLevel = freeEntries; _fullWarned = false;}
+
     // return name of this store (2-character string)
     std::string name() const {return _storeName;}
 
@@ -0,0 +1,651 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_socket_port.cc
+// *
+// * Purpose: Port that talks to a gsmbrokerd over a UNIX domain socket or
+// *          to a serial-over-IP server over TCP
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <gsmlib/gsm_socket_port.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <sstream>
+#include <cassert>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <cstring>
+
+using namespace gsmlib;
+
+// telnet (RFC 854) and COM port control (RFC 2217) codes
+static const unsigned char TELNET_IAC = 255;
+static const unsigned char TELNET_DONT = 254;
+static const unsigned char TELNET_DO = 253;
+static const unsigned char TELNET_WONT = 252;
+static const unsigned char TELNET_WILL = 251;
+static const unsigned char TELNET_SB = 250;
+static const unsigned char TELNET_SE = 240;
+static const unsigned char TELNET_BINARY = 0;
+static const unsigned char TELNET_SGA = 3;
+static const unsigned char TELNET_COM_PORT = 44;
+static const unsigned char COM_PORT_SET_BAUDRATE = 1;
+static const unsigned char COM_PORT_SET_DATASIZE = 2;
+static const unsigned char COM_PORT_SET_PARITY = 3;
+static const unsigned char COM_PORT_SET_STOPSIZE = 4;
+static const unsigned char COM_PORT_SET_CONTROL = 5;
+
+// states of the telnet command parser
+enum TelnetState {TelnetData, TelnetCommand, TelnetOption,
+                  TelnetSubnegotiation, TelnetSubnegotiationCommand};
+
+// time to wait for a TCP connection (in seconds)
+static const int TCP_CONNECT_TIMEOUT = 10;
+
+// time to wait for the answer to the probe of a fast open (in seconds)
+static const long int FAST_OPEN_TIMEOUT = 1;
+
+// double IAC characters in data sent with the telnet protocol
+static std::string telnetEscape(const std::string &data)
+{
+  std::string result;
+  for (std::string::const_iterator i = data.begin(); i != data.end(); ++i)
+  {
+    result += *i;
+    if ((unsigned char)*i == TELNET_IAC)
+      result += *i;
+  }
+  return result;
+}
+
+// RFC 2217 subnegotiation
+static std::string comPortCommand(unsigned char command, std::string value)
+{
+  std::string result;
+  result += (char)TELNET_IAC;
+  result += (char)TELNET_SB;
+  result += (char)TELNET_COM_PORT;
+  result += (char)command;
+  result += telnetEscape(value);
+  result += (char)TELNET_IAC;
+  result += (char)TELNET_SE;
+  return result;
+}
+
+// telnet option negotiation
+static std::string telnetOption(unsigned char verb, unsigned char option)
+{
+  std::string result;
+  result += (char)TELNET_IAC;
+  result += (char)verb;
+  result += (char)option;
+  return result;
+}
+
+// wait for non-blocking connect() to finish, return true if connected
+static bool waitConnected(int fd)
+{
+  fd_set fdSet;
+  struct timeval timeout;
+  timeout.tv_sec = TCP_CONNECT_TIMEOUT;
+  timeout.tv_usec = 0;
+  FD_ZERO(&fdSet);
+  FD_SET(fd, &fdSet);
+  int res = select(fd + 1, NULL, &fdSet, NULL, &timeout);
+  if (res == 0)
+    errno = ETIMEDOUT;
+  if (res <= 0)
+    return false;
+
+  int error;
+  socklen_t length = sizeof(error);
+  if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0)
+    return false;
+  errno = error;
+  return error == 0;
+}
+
+// SocketPort members
+
+void SocketPort::throwSocketException(std::string message)
+{
+  std::ostringstream os;
+  os << message << " (errno: " << errno << "/" << strerror(errno) << ")";
+  throw GsmException(os.str(), OSError, errno);
+}
+
+void SocketPort::connectTcp()
+{
+  if (_fd != -1)
+  {
+#ifndef NDEBUG
+    if (debugLevel() >= 1)
+      std::cerr << "*** reconnecting to " << _host << ":" << _service
+                << std::endl;
+#endif
+    close(_fd);
+    _fd = -1;
+  }
+
+  struct addrinfo hints, *addresses;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int res = getaddrinfo(_host.c_str(), _service.c_str(), &hints, &addresses);
+  if (res != 0)
+    throw GsmException(stringPrintf(_("cannot resolve '%s:%s' (%s)"),
+                                    _host.c_str(), _service.c_str(),
+                                    gai_strerror(res)), OSError);
+
+  // use the first address that accepts the connection
+  int savedErrno = 0;
+  for (struct addrinfo *a = addresses; a != NULL && _fd == -1; a = a->ai_next)
+  {
+    int fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd == -1)
+      continue;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    if (connect(fd, a->ai_addr, a->ai_addrlen) == 0 ||
+        (errno == EINPROGRESS && waitConnected(fd)))
+      _fd = fd;
+    else
+    {
+      savedErrno = errno;
+      close(fd);
+    }
+  }
+  freeaddrinfo(addresses);
+  if (_fd == -1)
+  {
+    errno = savedErrno;
+    throwSocketException(stringPrintf(_("connecting to '%s:%s'"),
+                                      _host.c_str(), _service.c_str()));
+  }
+
+  // send command lines at once, detect dead connections
+  int on = 1;
+  setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  setsockopt(_fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+#ifdef TCP_KEEPIDLE
+  int idle = 30, interval = 10, count = 3;
+  setsockopt(_fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+  setsockopt(_fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+  setsockopt(_fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+#endif
+
+  ++_connections;
+  _buffer = "";
+  _bufferPos = 0;
+  _telnetState = TelnetData;
+  if (_rfc2217)
+    sendLineSettings();
+}
+
+bool SocketPort::connectionLost()
+{
+  char c;
+  ssize_t res = recv(_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return res == 0 || (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                      errno != EINTR);
+}
+
+bool SocketPort::sendRaw(const std::string &data)
+{
+  size_t bytesWritten = 0;
+  int timeElapsed = 0;
+  while (bytesWritten < data.length())
+  {
+    if (interrupted())
+      throwSocketException(_("interrupted when writing to socket"));
+    ssize_t bw = send(_fd, data.data() + bytesWritten,
+                      data.length() - bytesWritten, MSG_NOSIGNAL);
+    if (bw >= 0)
+    {
+      bytesWritten += bw;
+      continue;
+    }
+    if (errno == EINTR)
+      continue;
+    if (errno == EPIPE || errno == ECONNRESET || errno == ENOTCONN)
+      return false;
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+      throwSocketException(_("writing to socket"));
+
+    // socket buffer full
+    if (timeElapsed++ >= _timeoutVal)
+      throwSocketException(_("timeout when writing to socket"));
+    fd_set fdSet;
+    struct timeval oneSecond;
+    oneSecond.tv_sec = 1;
+    oneSecond.tv_usec = 0;
+    FD_ZERO(&fdSet);
+    FD_SET(_fd, &fdSet);
+    select(_fd + 1, NULL, &fdSet, NULL, &oneSecond);
+  }
+  return true;
+}
+
+void SocketPort::sendLineSettings()
+{
+  std::string baudRate;
+  baudRate += (char)((_baudRate >> 24) & 0xff);
+  baudRate += (char)((_baudRate >> 16) & 0xff);
+  baudRate += (char)((_baudRate >> 8) & 0xff);
+  baudRate += (char)(_baudRate & 0xff);
+
+  // 8N1, flow control as for UnixSerialPort (hardware unless XON/XOFF)
+  std::string s = telnetOption(TELNET_WILL, TELNET_COM_PORT) +
+    telnetOption(TELNET_WILL, TELNET_BINARY) +
+    telnetOption(TELNET_DO, TELNET_BINARY) +
+    telnetOption(TELNET_WILL, TELNET_SGA) +
+    telnetOption(TELNET_DO, TELNET_SGA) +
+    comPortCommand(COM_PORT_SET_BAUDRATE, baudRate) +
+    comPortCommand(COM_PORT_SET_DATASIZE, std::string(1, 8)) +
+    comPortCommand(COM_PORT_SET_PARITY, std::string(1, 1)) +
+    comPortCommand(COM_PORT_SET_STOPSIZE, std::string(1, 1)) +
+    comPortCommand(COM_PORT_SET_CONTROL,
+                   std::string(1, _swHandshake ? 2 : 3));
+  if (! sendRaw(s))
+    throwSocketException(stringPrintf(_("writing to '%s:%s'"),
+                                      _host.c_str(), _service.c_str()));
+}
+
+void SocketPort::received(const char *data, size_t length)
+{
+  if (_bufferPos == _buffer.length())
+  {
+    _buffer = "";
+    _bufferPos = 0;
+  }
+  if (! _rfc2217)
+  {
+    _buffer.append(data, length);
+    return;
+  }
+
+  for (size_t i = 0; i < length; ++i)
+  {
+    unsigned char c = data[i];
+    switch (_telnetState)
+    {
+    case TelnetData:
+      if (c == TELNET_IAC)
+        _telnetState = TelnetCommand;
+      else
+        _buffer += c;
+      break;
+    case TelnetCommand:
+      _telnetState = TelnetData;
+      if (c == TELNET_IAC)
+        _buffer += c;
+      else if (c == TELNET_SB)
+        _telnetState = TelnetSubnegotiation;
+      else if (c >= TELNET_WILL && c <= TELNET_DONT)
+      {
+        _telnetVerb = c;
+        _telnetState = TelnetOption;
+      }
+      break;
+    case TelnetOption:
+    {
+      // refuse everything we did not ask for
+      _telnetState = TelnetData;
+      bool accepted = c == TELNET_BINARY || c == TELNET_SGA ||
+        (c == TELNET_COM_PORT && _telnetVerb == TELNET_DO);
+      if (! accepted && _telnetVerb == TELNET_DO)
+        sendRaw(telnetOption(TELNET_WONT, c));
+      else if (! accepted && _telnetVerb == TELNET_WILL)
+        sendRaw(telnetOption(TELNET_DONT, c));
+      break;
+    }
+    case TelnetSubnegotiation:
+      // answers to the line settings are ignored
+      if (c == TELNET_IAC)
+        _telnetState = TelnetSubnegotiationCommand;
+      break;
+    case TelnetSubnegotiationCommand:
+      _telnetState = c == TELNET_SE ? TelnetData : TelnetSubnegotiation;
+      break;
+    }
+  }
+}
+
+void SocketPort::receiveNow()
+{
+  char data[256];
+  ssize_t res = recv(_fd, data, sizeof(data), MSG_DONTWAIT);
+  if (res > 0)
+    received(data, res);
+  else if (res < 0 &&
+           (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    return;
+  else if (brokered())
+    throwSocketException(_("end of file when reading from broker"));
+  else
+    connectTcp();               // the answer is lost
+}
+
+bool SocketPort::probe(std::string command, long int timeout)
+{
+  long int saveTimeoutVal = _timeoutVal;
+  _timeoutVal = timeout;
+  bool result = false;
+  try
+  {
+    putLine(command);
+    for (int readTries = 5; readTries > 0; --readTries)
+    {
+      std::string s = getLine();
+      if (s.find("OK") != std::string::npos ||
+          s.find("CABLE: GSM") != std::string::npos)
+      {
+        result = true;
+        break;
+      }
+      if (s.find("ERROR") != std::string::npos)
+        break;
+    }
+  }
+  catch (GsmException &)
+  {
+  }
+  _timeoutVal = saveTimeoutVal;
+  return result;
+}
+
+SocketPort::SocketPort(std::string socketPath) :
+  _oldChar(-1), _timeoutVal(TIMEOUT_SECS), _bufferPos(0), _rfc2217(false),
+  _baudRate(DEFAULT_BAUD_RATE), _swHandshake(false), _telnetState(TelnetData),
+  _telnetVerb(0), _connections(1)
+{
+  struct sockaddr_un addr;
+  if (socketPath.length() >= sizeof(addr.sun_path))
+    throw GsmException(stringPrintf(_("socket name '%s' too long"),
+                                    socketPath.c_str()), ParameterError);
+
+  _fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (_fd == -1)
+    throwSocketException(_("creating socket"));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socketPath.c_str());
+  if (connect(_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+  {
+    int savedErrno = errno;
+    close(_fd);
+    errno = savedErrno;
+    throwSocketException(stringPrintf(_("connecting to broker '%s'"),
+                                      socketPath.c_str()));
+  }
+}
+
+SocketPort::SocketPort(std::string host, std::string service, bool rfc2217,
+                       int baudRate, std::string initString,
+                       bool swHandshake, bool fastOpen) :
+  _fd(-1), _oldChar(-1), _timeoutVal(TIMEOUT_SECS), _bufferPos(0),
+  _host(host), _service(service), _rfc2217(rfc2217), _baudRate(baudRate),
+  _swHandshake(swHandshake), _telnetState(TelnetData), _telnetVerb(0),
+  _connections(0)
+{
+  connectTcp();
+
+  // a modem that was left in a sane state answers the init string at once
+  if (fastOpen && probe("AT" + initString, FAST_OPEN_TIMEOUT))
+    return;
+  if (! probe("ATZ", 3) || ! probe("AT" + initString, 3))
+  {
+    close(_fd);
+    throw GsmException(stringPrintf(_("reset modem failed '%s'"),
+                                    (host + ":" + service).c_str()),
+                       OtherError);
+  }
+}
+
+void SocketPort::putBack(unsigned char c)
+{
+  assert(_oldChar == -1);
+  _oldChar = c;
+}
+
+int SocketPort::readByte()
+{
+  if (_oldChar != -1)
+  {
+    int result = _oldChar;
+    _oldChar = -1;
+    return result;
+  }
+
+  int timeElapsed = 0;
+  bool reconnected = false;
+  while (_bufferPos == _buffer.length() && timeElapsed < _timeoutVal)
+  {
+    if (interrupted())
+      throwSocketException(_("interrupted when reading from socket"));
+
+    fd_set fdSet;
+    struct timeval oneSecond;
+    oneSecond.tv_sec = 1;
+    oneSecond.tv_usec = 0;
+    FD_ZERO(&fdSet);
+    FD_SET(_fd, &fdSet);
+
+    switch (select(_fd + 1, &fdSet, NULL, NULL, &oneSecond))
+    {
+    case 1:
+    {
+      char data[256];
+      ssize_t res = recv(_fd, data, sizeof(data), 0);
+      if (res > 0)
+        received(data, res);
+      else if (res < 0 &&
+               (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        break;
+      else if (brokered())
+        throwSocketException(_("end of file when reading from broker"));
+      else if (reconnected)
+        throwSocketException(stringPrintf(_("connection to '%s:%s' lost"),
+                                          _host.c_str(), _service.c_str()));
+      else
+      {
+        // the answer is lost but the next command gets through
+        connectTcp();
+        reconnected = true;
+      }
+      break;
+    }
+    case 0:
+      ++timeElapsed;
+      break;
+    default:
+      if (errno != EINTR)
+        throwSocketException(_("reading from socket"));
+      break;
+    }
+  }
+  if (_bufferPos == _buffer.length())
+    throwSocketException(_("timeout when reading from socket"));
+
+  unsigned char c = _buffer[_bufferPos++];
+#ifndef NDEBUG
+  if (debugLevel() >= 2)
+  {
+    if (c == LF)
+      std::cerr << "<LF>";
+    else if (c == CR)
+      std::cerr << "<CR>";
+    else
+      std::cerr << "<'" << (char) c << "'>";
+    std::cerr.flush();
+  }
+#endif
+  return c;
+}
+
+std::string SocketPort::getLine()
+{
+  std::string result;
+  int c;
+  while ((c = readByte()) >= 0)
+  {
+    while (c == CR)
+      c = readByte();
+    if (c == LF)
+      break;
+    result += c;
+  }
+
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "<-- " << result << std::endl;
+#endif
+
+  return result;
+}
+
+void SocketPort::putLine(std::string line, bool carriageReturn)
+{
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "--> " << line << std::endl;
+#endif
+
+  if (carriageReturn) line += CR;
+  if (_rfc2217)
+    line = telnetEscape(line);
+
+  // reconnect before sending if the server closed an idle connection
+  if (! brokered() && connectionLost())
+    connectTcp();
+  if (sendRaw(line))
+    return;
+  if (brokered())
+    throwSocketException(_("writing to broker"));
+
+  // connection dropped by the server, try once more
+  connectTcp();
+  if (! sendRaw(line))
+    throwSocketException(stringPrintf(_("writing to '%s:%s'"),
+                                      _host.c_str(), _service.c_str()));
+}
+
+bool SocketPort::wait(GsmTime timeout)
+{
+  // only return true if readByte() does not block, a readable socket may
+  // just carry telnet commands or the end of a dropped connection
+  struct timeval deadline;
+  if (timeout != NULL)
+  {
+    gettimeofday(&deadline, NULL);
+    long int usecs = deadline.tv_usec + timeout->tv_usec;
+    deadline.tv_sec += timeout->tv_sec + usecs / 1000000L;
+    deadline.tv_usec = usecs % 1000000L;
+  }
+  while (_oldChar == -1 && _bufferPos == _buffer.length())
+  {
+    // wait for the rest of the timeout
+    struct timeval remaining = {0, 0};
+    if (timeout != NULL)
+    {
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      if (now.tv_sec < deadline.tv_sec ||
+          (now.tv_sec == deadline.tv_sec && now.tv_usec < deadline.tv_usec))
+      {
+        remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+        remaining.tv_usec = deadline.tv_usec - now.tv_usec;
+        if (remaining.tv_usec < 0)
+        {
+          --remaining.tv_sec;
+          remaining.tv_usec += 1000000L;
+        }
+      }
+    }
+
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(_fd, &fds);
+    if (select(_fd + 1, &fds, NULL, NULL,
+               timeout == NULL ? NULL : &remaining) <= 0)
+      return false;
+    receiveNow();
+  }
+  return true;
+}
+
+void SocketPort::setTimeOut(unsigned int timeout)
+{
+  _timeoutVal = timeout;
+}
+
+SocketPort::~SocketPort()
+{
+  if (_fd != -1)
+    close(_fd);
+}
+
+bool gsmlib::isSocket(std::string filename)
+{
+  struct stat statBuf;
+  return stat(filename.c_str(), &statBuf) == 0 && S_ISSOCK(statBuf.st_mode);
+}
+
+bool gsmlib::parseNetworkDevice(std::string device, std::string &host,
+                                std::string &service, bool &rfc2217)
+{
+  std::string address;
+  if (device.substr(0, 6) == "tcp://")
+  {
+    rfc2217 = false;
+    address = device.substr(6);
+  }
+  else if (device.substr(0, 10) == "rfc2217://")
+  {
+    rfc2217 = true;
+    address = device.substr(10);
+  }
+  else
+    return false;
+
+  std::string::size_type colon;
+  if (address.length() > 0 && address[0] == '[')
+  {
+    // [IPv6 address]:port
+    std::string::size_type bracket = address.find(']');
+    colon = bracket == std::string::npos ? bracket : bracket + 1;
+    if (colon != std::string::npos && colon < address.length() &&
+        address[colon] == ':')
+      host = address.substr(1, bracket - 1);
+    else
+      colon = std::string::npos;
+  }
+  else
+  {
+    colon = address.rfind(':');
+    if (colon != std::string::npos)
+      host = address.substr(0, colon);
+  }
+  if (colon == std::string::npos || host == "" ||
+      colon + 1 == address.length())
+    throw GsmException(stringPrintf(_("invalid network device '%s' "
+                                      "(expected host:port)"),
+                                    device.c_str()), ParameterError);
+  service = address.substr(colon + 1);
+  return true;
+}
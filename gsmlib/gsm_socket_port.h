@@ -0,0 +1,121 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_socket_port.h
+// *
+// * Purpose: Port that talks to a gsmbrokerd over a UNIX domain socket or
+// *          to a serial-over-IP server over TCP
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_SOCKET_PORT_H
+#define GSM_SOCKET_PORT_H
+
+#include <string>
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_port.h>
+#include <gsmlib/gsm_util.h>
+
+namespace gsmlib
+{
+  // The SocketPort connects to a UNIX domain socket served by gsmbrokerd.
+  // The broker owns the serial port and has already reset and initialized
+  // the ME/TA, so opening the port is just a connect().
+  // The byte stream is the same as on the serial line, the broker forwards
+  // each command and its response as a whole.
+  // Alternatively the SocketPort connects to the TCP port of a
+  // serial-over-IP server (modem bank). The raw byte stream of the serial
+  // line is used, or the telnet protocol with the COM port control option
+  // (RFC 2217) if the server needs the line settings. If the server drops
+  // the connection, the SocketPort reconnects at once.
+
+  class SocketPort : public Port
+  {
+  private:
+    int _fd;                    // socket
+    int _oldChar;               // character set by putBack() (-1 == none)
+    long int _timeoutVal;       // timeout for getLine/readByte
+    std::string _buffer;        // data received but not read yet
+    unsigned int _bufferPos;    // next byte in _buffer
+
+    // TCP connections only
+    std::string _host;          // host, "" for UNIX domain sockets
+    std::string _service;       // TCP port
+    bool _rfc2217;              // use telnet with COM port control
+    int _baudRate;              // line settings sent with RFC 2217
+    bool _swHandshake;
+    int _telnetState;           // state of telnet command parser
+    unsigned char _telnetVerb;  // WILL, WONT, DO, or DONT being parsed
+    unsigned int _connections;  // number of connections made so far
+
+    // throw GsmException include UNIX errno
+    void throwSocketException(std::string message);
+
+    // connect to _host/_service, close old connection if any
+    void connectTcp();
+
+    // return true if the server has closed the connection
+    bool connectionLost();
+
+    // send data as is, return false if the connection was lost
+    bool sendRaw(const std::string &data);
+
+    // send RFC 2217 option negotiation and line settings
+    void sendLineSettings();
+
+    // append received data to _buffer, handle telnet commands
+    void received(const char *data, size_t length);
+
+    // pass data the socket has already received to received() without
+    // blocking, reconnect if the server has closed the connection
+    void receiveNow();
+
+    // send command, return true if the TA answers OK within timeout secs
+    bool probe(std::string command, long int timeout);
+
+  public:
+    // connect to the broker listening on the given socket path
+    SocketPort(std::string socketPath);
+
+    // connect to host:service and initialize the ME/TA like
+    // UnixSerialPort does (ATZ, init string)
+    SocketPort(std::string host, std::string service, bool rfc2217,
+               int baudRate = DEFAULT_BAUD_RATE,
+               std::string initString = DEFAULT_INIT_STRING,
+               bool swHandshake = false, bool fastOpen = false);
+
+    // return true if connected to gsmbrokerd
+    bool brokered() const {return _host == "";}
+
+    // return socket file descriptor (eg. for select())
+    // changes if the TCP connection is reestablished
+    int fd() const {return _fd;}
+
+    // return number of TCP connections made so far, a new one means that
+    // data received before may be lost
+    unsigned int connections() const {return _connections;}
+
+    // inherited from Port
+    void putBack(unsigned char c);
+    int readByte();
+    std::string getLine();
+    void putLine(std::string line,
+                 bool carriageReturn = true);
+    bool wait(GsmTime timeout);
+    void setTimeOut(unsigned int timeout);
+
+    virtual ~SocketPort();
+  };
+
+  // return true if filename is a UNIX domain socket
+  extern bool isSocket(std::string filename);
+
+  // split device names of the form "tcp://host:port" and
+  // "rfc2217://host:port" (IPv6 addresses in brackets)
+  // return false if device is not of this form
+  extern bool parseNetworkDevice(std::string device, std::string &host,
+                                 std::string &service, bool &rfc2217);
+};
+
+#endif // GSM_SOCKET_PORT_H
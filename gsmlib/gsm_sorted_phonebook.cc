@@ -16,6 +16,7 @@
 #endif
 #include <gsmlib/gsm_util.h>
 #include <gsmlib/gsm_sorted_phonebook.h>
+#include <gsmlib/gsm_tracing.h>
 #include <gsmlib/gsm_nls.h>
 #include <iostream>
 #include <fstream>
@@ -132,6 +133,7 @@ void SortedPhonebook::readPhonebookFile(std::istream &pbs, std::string filename)
 
 void SortedPhonebook::sync(bool fromDestructor)
 {
+  TraceSpan span("store", "sync phonebook");
   // if not in file it already is stored in ME/TA
   if (! _fromFile) return;
 
@@ -245,6 +247,7 @@ SortedPhonebook::SortedPhonebook(PhonebookRef mePhonebook) :
   _changed(false), _fromFile(false), _madeBackupFile(false),
   _sortOrder(ByIndex), _readonly(false), _mePhonebook(mePhonebook)
 {
+  TraceSpan span("store", "load phonebook", _mePhonebook->name());
   int entriesRead = 0;
   reportProgress(0, _mePhonebook->end() - _mePhonebook->begin());
 
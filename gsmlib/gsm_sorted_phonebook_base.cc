@@ -33,8 +33,8 @@ void PhonebookEntryBase::set(std::string telephone, std::string text, int index,
   checkTextAndTelephone(text, telephone);
 
   _changed = true;
-  _telephone = telephone;
-  _text = text;
+  _telephone = std::move(telephone);
+  _text = std::move(text);
   _useIndex = useIndex;
   if (index != -1)
     _index = index;
@@ -48,12 +48,12 @@ bool PhonebookEntryBase::operator==(const PhonebookEntryBase &e) const
     (! (_useIndex || e._useIndex) || _index == e._index);
 }
 
-std::string PhonebookEntryBase::text() const
+const std::string &PhonebookEntryBase::text() const
 {
   return _text;
 }
 
-std::string PhonebookEntryBase::telephone() const
+const std::string &PhonebookEntryBase::telephone() const
 {
   return _telephone;
 }
@@ -19,6 +19,7 @@
 #include <gsmlib/gsm_util.h>
 #include <gsmlib/gsm_map_key.h>
 #include <string>
+#include <utility>
 #include <map>
 #include <fstream>
 
@@ -50,14 +51,16 @@ namespace gsmlib
       
     // convenience constructor
     PhonebookEntryBase(std::string telephone, std::string text, int index = -1) :
-      _changed(false), _telephone(telephone), _text(text),
-      _index(index), _useIndex(false) {}
+      _changed(false), _telephone(std::move(telephone)),
+      _text(std::move(text)), _index(index), _useIndex(false) {}
       
     // accessor functions
+    // the references returned by text() and telephone() are valid until
+    // the entry is changed
     virtual void set(std::string telephone, std::string text, int index = -1,
 		     bool useIndex = false);
-    virtual std::string text() const;
-    virtual std::string telephone() const;
+    virtual const std::string &text() const;
+    virtual const std::string &telephone() const;
 
     // return true if both telephone and text are empty
     bool empty() const;
@@ -16,6 +16,7 @@
 #include <gsmlib/gsm_nls.h>
 #include <gsmlib/gsm_sysdep.h>
 #include <gsmlib/gsm_sorted_sms_store.h>
+#include <gsmlib/gsm_tracing.h>
 #include <iostream>
 #include <fstream>
 #include <cstring>
@@ -82,7 +83,7 @@ void SortedSMSStore::readSMSFile(std::istream &pbs, std::string filename)
       // ignore error, file might be empty initially
     }
   unsigned_int_2 version;
-  memcpy(&version, numberBuf, sizeof(*numberBuf));
+  memcpy(&version, numberBuf, sizeof(version));
   version = ntohs(version);
   if (!pbs.eof() && version != SMS_STORE_FILE_FORMAT_VERSION)
     throw GsmException(stringPrintf(_("file '%s' has wrong version"),
@@ -96,7 +97,7 @@ void SortedSMSStore::readSMSFile(std::istream &pbs, std::string filename)
 	break;
 
       unsigned_int_2 pduLen;
-      memcpy(&pduLen, numberBuf, sizeof(*numberBuf));
+      memcpy(&pduLen, numberBuf, sizeof(pduLen));
       pduLen = ntohs(pduLen);
 
       if (pduLen > 500)
@@ -115,13 +116,12 @@ void SortedSMSStore::readSMSFile(std::istream &pbs, std::string filename)
 	throw GsmException(stringPrintf(_("corrupt SMS store file '%s'"),
 					filename.c_str()), ParameterError);
 
-      char *pduBuf = (char*)alloca(sizeof(char) * pduLen);
-
-      // read pdu
-      readnbytes(filename, pbs, pduLen, pduBuf);
+      // read pdu (not into an alloca() buffer, that would only be freed
+      // after the last entry)
+      std::string pdu(pduLen, ' ');
+      readnbytes(filename, pbs, pduLen, &pdu[0]);
       SMSMessageRef message =
-	SMSMessage::decode(std::string(pduBuf, pduLen),
-			   (messageType != SMSMessage::SMS_SUBMIT));
+	SMSMessage::decode(pdu, (messageType != SMSMessage::SMS_SUBMIT));
     
       SMSStoreEntry *newEntry = new SMSStoreEntry(message, _nextIndex++);
       _sortedSMSStore.insert(
@@ -134,6 +134,7 @@ void SortedSMSStore::readSMSFile(std::istream &pbs, std::string filename)
 
 void SortedSMSStore::sync(bool fromDestructor)
 {
+  TraceSpan span("store", "sync SMS store");
   if (_fromFile && _changed)
   {
     checkReadonly();
@@ -236,6 +237,8 @@ SortedSMSStore::SortedSMSStore(SMSStoreRef meSMSStore) :
   _changed(false), _fromFile(false), _madeBackupFile(false),
   _sortOrder(ByDate), _readonly(false), _meSMSStore(meSMSStore)
 {
+  TraceSpan span("store", "load SMS store", _meSMSStore->name());
+
   // It is necessary to count the entries read because
   // the maximum index into the SMS store may be larger than smsStore.size()
   int entriesRead = 0;
@@ -0,0 +1,272 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_status_report_index.cc
+// *
+// * Purpose: Persistent index that correlates SMS status reports with
+// *          the submitted messages (spool files) they refer to
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_status_report_index.h>
+#include <fstream>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <cstring>
+
+using namespace gsmlib;
+
+// number of trailing digits of the recipient address used in the key
+// (the SC may report the address in national instead of international
+// format, so leading digits and the type of number are ignored)
+static const unsigned int RECIPIENT_KEY_DIGITS = 9;
+
+// escape '|', '\\', CR, and LF in journal fields
+static std::string escapeField(const std::string &s)
+{
+  std::string result;
+  for (std::string::const_iterator i = s.begin(); i != s.end(); ++i)
+    if (*i == CR)
+      result += "\\r";
+    else if (*i == LF)
+      result += "\\n";
+    else if (*i == '\\' || *i == '|')
+    {
+      result += '\\';
+      result += *i;
+    }
+    else
+      result += *i;
+  return result;
+}
+
+// split journal line into unescaped fields
+static std::vector<std::string> splitFields(const std::string &line)
+{
+  std::vector<std::string> result(1);
+  for (std::string::const_iterator i = line.begin(); i != line.end(); ++i)
+    if (*i == '|')
+      result.push_back("");
+    else if (*i == '\\' && i + 1 != line.end())
+    {
+      ++i;
+      result.back() += (*i == 'r' ? CR : *i == 'n' ? LF : *i);
+    }
+    else
+      result.back() += *i;
+  return result;
+}
+
+std::string StatusReportIndex::key(const std::string &modem,
+                                   unsigned char messageReference,
+                                   const std::string &recipient)
+{
+  std::string digits;
+  for (std::string::const_iterator i = recipient.begin();
+       i != recipient.end(); ++i)
+    if (isdigit(*i))
+      digits += *i;
+  if (digits.length() > RECIPIENT_KEY_DIGITS)
+    digits.erase(0, digits.length() - RECIPIENT_KEY_DIGITS);
+  return modem + '\0' + (char)messageReference + digits;
+}
+
+void StatusReportIndex::doAdd(const StatusReportIndexEntry &entry)
+{
+  std::string k = key(entry._modem, entry._messageReference,
+                      entry._recipient);
+
+  // a wrapped-around TP-MR for the same recipient replaces the old entry
+  doErase(k);
+
+  // drop oldest entry if the ring buffer is full
+  if (_used[_next])
+    doErase(key(_entries[_next]._modem, _entries[_next]._messageReference,
+                _entries[_next]._recipient));
+
+  _entries[_next] = entry;
+  _used[_next] = true;
+  _index[k] = _next;
+  ++_size;
+  _next = (_next + 1) % _entries.size();
+}
+
+bool StatusReportIndex::doErase(const std::string &key)
+{
+  std::unordered_map<std::string, unsigned int>::iterator i = _index.find(key);
+  if (i == _index.end())
+    return false;
+  _used[i->second] = false;
+  _entries[i->second] = StatusReportIndexEntry();
+  _index.erase(i);
+  --_size;
+  return true;
+}
+
+void StatusReportIndex::readJournal()
+{
+  std::ifstream ifs(_filename.c_str());
+  if (! ifs)
+    return;                     // no journal yet
+
+  // the last line may be incomplete if gsmsmsd was killed or the power
+  // failed while it was written, it is dropped (even if it looks valid,
+  // digits may be missing) and the journal is rewritten so that the next
+  // line is not appended to it
+  std::string line;
+  bool incomplete = false;
+  while (getline(ifs, line))
+  {
+    if (ifs.eof())
+    {
+      incomplete = true;        // no newline at the end
+      break;
+    }
+    std::vector<std::string> f = splitFields(line);
+    if (f[0] == "+" && f.size() == 6)
+    {
+      StatusReportIndexEntry e;
+      e._modem = f[1];
+      e._messageReference = (unsigned char)atoi(f[2].c_str());
+      e._recipient = f[3];
+      e._spoolId = f[4];
+      e._submitTime = (time_t)atol(f[5].c_str());
+      doAdd(e);
+    }
+    else if (f[0] == "-" && f.size() == 4)
+      doErase(key(f[1], (unsigned char)atoi(f[2].c_str()), f[3]));
+    else if (ifs.peek() == EOF)
+    {
+      incomplete = true;        // eg. a block of zeroes after a crash
+      break;
+    }
+    else
+      throw GsmException(
+        stringPrintf(_("corrupt line '%s' in status report index '%s'"),
+                     line.c_str(), _filename.c_str()), ParameterError);
+    ++_journalLines;
+  }
+  ifs.close();
+  if (incomplete)
+    compactJournal();
+}
+
+void StatusReportIndex::writeJournal(const std::string &line)
+{
+  if (_filename == "")
+    return;
+
+  if (_journalLines > 2 * _entries.size())
+  {
+    compactJournal();
+    return;
+  }
+
+  std::ofstream ofs(_filename.c_str(), std::ios::out | std::ios::app);
+  ofs << line << std::endl;
+  if (! ofs)
+    throw GsmException(
+      stringPrintf(_("error writing to file '%s'"), _filename.c_str()),
+      OSError);
+  ++_journalLines;
+}
+
+void StatusReportIndex::compactJournal()
+{
+  std::string tmpFilename = _filename + ".tmp";
+  {
+    std::ofstream ofs(tmpFilename.c_str());
+    // write from the oldest to the newest entry
+    for (unsigned int j = 0; j < _entries.size(); ++j)
+    {
+      unsigned int i = (_next + j) % _entries.size();
+      if (! _used[i])
+        continue;
+      ofs << "+|" << escapeField(_entries[i]._modem) << "|"
+          << (int)_entries[i]._messageReference << "|"
+          << escapeField(_entries[i]._recipient) << "|"
+          << escapeField(_entries[i]._spoolId) << "|"
+          << (long)_entries[i]._submitTime << std::endl;
+    }
+    if (! ofs)
+      throw GsmException(
+        stringPrintf(_("error writing to file '%s'"), tmpFilename.c_str()),
+        OSError);
+  }
+  if (rename(tmpFilename.c_str(), _filename.c_str()) != 0)
+    throw GsmException(
+      stringPrintf(_("error renaming '%s' to '%s' (errno: %d/%s)"),
+                   tmpFilename.c_str(), _filename.c_str(),
+                   errno, strerror(errno)), OSError);
+  _journalLines = _size;
+}
+
+StatusReportIndex::StatusReportIndex(std::string filename,
+                                     unsigned int capacity) :
+  _filename(filename), _entries(capacity == 0 ? 1 : capacity),
+  _used(_entries.size(), false), _next(0), _size(0), _journalLines(0)
+{
+  if (_filename != "")
+    readJournal();
+}
+
+void StatusReportIndex::add(const std::string &modem,
+                            unsigned char messageReference,
+                            const std::string &recipient,
+                            const std::string &spoolId, time_t submitTime)
+{
+  StatusReportIndexEntry e;
+  e._modem = modem;
+  e._messageReference = messageReference;
+  e._recipient = recipient;
+  e._spoolId = spoolId;
+  e._submitTime = submitTime;
+  doAdd(e);
+  writeJournal("+|" + escapeField(modem) + "|" + intToStr(messageReference) +
+               "|" + escapeField(recipient) + "|" + escapeField(spoolId) +
+               "|" + stringPrintf("%ld", (long)submitTime));
+}
+
+bool StatusReportIndex::find(const std::string &modem,
+                             unsigned char messageReference,
+                             const std::string &recipient,
+                             StatusReportIndexEntry &entry)
+{
+  std::unordered_map<std::string, unsigned int>::iterator i =
+    _index.find(key(modem, messageReference, recipient));
+  if (i == _index.end())
+    return false;
+  entry = _entries[i->second];
+  return true;
+}
+
+bool StatusReportIndex::erase(const std::string &modem,
+                              unsigned char messageReference,
+                              const std::string &recipient)
+{
+  if (! doErase(key(modem, messageReference, recipient)))
+    return false;
+  writeJournal("-|" + escapeField(modem) + "|" + intToStr(messageReference) +
+               "|" + escapeField(recipient));
+  return true;
+}
+
+bool StatusReportIndex::resolve(const std::string &modem,
+                                const SMSStatusReportMessage &report,
+                                StatusReportIndexEntry &entry)
+{
+  std::string recipient = report.recipientAddress().toString();
+  if (! find(modem, report.messageReference(), recipient, entry))
+    return false;
+  if ((report.status() & SMS_STATUS_TEMPORARY_BIT) == 0 ||
+      (report.status() & SMS_STATUS_PERMANENT_BIT) != 0)
+    erase(modem, report.messageReference(), recipient);
+  return true;
+}
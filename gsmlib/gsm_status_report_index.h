@@ -0,0 +1,112 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_status_report_index.h
+// *
+// * Purpose: Persistent index that correlates SMS status reports with
+// *          the submitted messages (spool files) they refer to
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_STATUS_REPORT_INDEX_H
+#define GSM_STATUS_REPORT_INDEX_H
+
+#include <gsmlib/gsm_sms.h>
+#include <gsmlib/gsm_util.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <time.h>
+
+namespace gsmlib
+{
+  // one submitted message waiting for its status report
+  struct StatusReportIndexEntry
+  {
+    std::string _modem;              // device or other name of the modem
+    unsigned char _messageReference; // TP-MR returned by +CMGS
+    std::string _recipient;          // destination address of the SMS
+    std::string _spoolId;            // caller's id, eg. spool file name
+    time_t _submitTime;              // time the SMS was submitted
+
+    StatusReportIndexEntry() : _messageReference(0), _submitTime(0) {}
+  };
+
+  // The StatusReportIndex maps (modem, TP-MR, recipient) to the
+  // submitted message. Lookups are O(1), the number of entries is bounded
+  // by the capacity given to the constructor (oldest entries are dropped
+  // first). If a filename is given, all changes are appended to that file
+  // as a journal which is replayed on startup and compacted from time
+  // to time, so that the index survives restarts.
+
+  class StatusReportIndex : public RefBase, public NoCopy
+  {
+  private:
+    std::string _filename;      // journal file, "" if not persistent
+    std::vector<StatusReportIndexEntry> _entries; // ring buffer of entries
+    std::vector<bool> _used;    // true if slot in _entries is in use
+    unsigned int _next;         // next slot in _entries to (re)use
+    unsigned int _size;         // number of slots in use
+    unsigned int _journalLines; // lines written to journal since compaction
+    std::unordered_map<std::string, unsigned int> _index; // key -> slot
+
+    // return lookup key for the given triple
+    static std::string key(const std::string &modem,
+                           unsigned char messageReference,
+                           const std::string &recipient);
+
+    // insert entry without writing the journal
+    void doAdd(const StatusReportIndexEntry &entry);
+
+    // erase entry without writing the journal, return false if not found
+    bool doErase(const std::string &key);
+
+    // read and replay journal
+    void readJournal();
+
+    // append line to journal, compact it if it got too long
+    void writeJournal(const std::string &line);
+
+    // rewrite journal with the current entries only
+    void compactJournal();
+
+  public:
+    // create index with the given maximum number of entries
+    // if filename is != "" the index is kept persistently in that file
+    StatusReportIndex(std::string filename = "",
+                      unsigned int capacity = 4096);
+
+    // record a submitted message
+    void add(const std::string &modem, unsigned char messageReference,
+             const std::string &recipient, const std::string &spoolId,
+             time_t submitTime = time(NULL));
+
+    // find the submitted message for the given triple
+    // return false if not found
+    bool find(const std::string &modem, unsigned char messageReference,
+              const std::string &recipient, StatusReportIndexEntry &entry);
+
+    // remove entry for the given triple, return false if not found
+    bool erase(const std::string &modem, unsigned char messageReference,
+               const std::string &recipient);
+
+    // find the submitted message the status report refers to
+    // the entry is removed from the index unless the status is temporary
+    // (ie. the SC will send further status reports for this SMS)
+    // return false if not found
+    bool resolve(const std::string &modem,
+                 const SMSStatusReportMessage &report,
+                 StatusReportIndexEntry &entry);
+
+    // number of entries in the index
+    unsigned int size() const {return _size;}
+
+    // maximum number of entries in the index
+    unsigned int capacity() const {return _entries.size();}
+  };
+
+  typedef Ref<StatusReportIndex> StatusReportIndexRef;
+};
+
+#endif // GSM_STATUS_REPORT_INDEX_H
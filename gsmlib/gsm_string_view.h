@@ -0,0 +1,116 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_string_view.h
+// *
+// * Purpose: Non-owning view of a character sequence
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_STRING_VIEW_H
+#define GSM_STRING_VIEW_H
+
+#include <string>
+#include <string.h>
+#include <ctype.h>
+
+namespace gsmlib
+{
+  // A StringView refers to characters owned by someone else (usually a
+  // std::string), it is only valid as long as they are not changed or
+  // freed. Taking parts of a view and comparing views never allocates.
+  // (std::string_view would need C++17)
+  class StringView
+  {
+  private:
+    const char *_data;
+    size_t _length;
+
+  public:
+    static const size_t npos = (size_t)-1;
+
+    StringView() : _data(""), _length(0) {}
+    StringView(const char *s) : _data(s), _length(strlen(s)) {}
+    StringView(const char *s, size_t length) : _data(s), _length(length) {}
+    StringView(const std::string &s) : _data(s.data()), _length(s.length()) {}
+
+    const char *data() const {return _data;}
+    size_t length() const {return _length;}
+    size_t size() const {return _length;}
+    bool empty() const {return _length == 0;}
+    char operator[](size_t i) const {return _data[i];}
+    const char *begin() const {return _data;}
+    const char *end() const {return _data + _length;}
+
+    // return copy of the characters
+    std::string str() const {return std::string(_data, _length);}
+
+    // return view of at most n characters starting at pos
+    StringView substr(size_t pos, size_t n = npos) const
+      {
+        if (pos > _length)
+          pos = _length;
+        if (n > _length - pos)
+          n = _length - pos;
+        return StringView(_data + pos, n);
+      }
+
+    // return position of c or npos
+    size_t find(char c, size_t pos = 0) const
+      {
+        for (; pos < _length; ++pos)
+          if (_data[pos] == c)
+            return pos;
+        return npos;
+      }
+
+    // return true if the view starts with prefix
+    bool startsWith(StringView prefix) const
+      {
+        return prefix._length <= _length &&
+          memcmp(_data, prefix._data, prefix._length) == 0;
+      }
+
+    // same as above, ignoring case
+    bool startsWithNoCase(StringView prefix) const
+      {
+        if (prefix._length > _length)
+          return false;
+        for (size_t i = 0; i < prefix._length; ++i)
+          if (tolower((unsigned char)_data[i]) !=
+              tolower((unsigned char)prefix._data[i]))
+            return false;
+        return true;
+      }
+
+    // return view without white space at beginning and end
+    StringView trim() const
+      {
+        size_t start = 0, end = _length;
+        while (start < end && isspace((unsigned char)_data[start]))
+          ++start;
+        while (start < end && isspace((unsigned char)_data[end - 1]))
+          --end;
+        return StringView(_data + start, end - start);
+      }
+
+    bool operator==(StringView s) const
+      {
+        return _length == s._length && memcmp(_data, s._data, _length) == 0;
+      }
+    bool operator!=(StringView s) const {return ! (*this == s);}
+  };
+
+  // comparisons with strings and literals, eg. s == "OK"
+  inline bool operator==(const std::string &s, StringView v)
+    {return StringView(s) == v;}
+  inline bool operator==(const char *s, StringView v)
+    {return StringView(s) == v;}
+  inline bool operator!=(const std::string &s, StringView v)
+    {return StringView(s) != v;}
+  inline bool operator!=(const char *s, StringView v)
+    {return StringView(s) != v;}
+};
+
+#endif // GSM_STRING_VIEW_H
@@ -0,0 +1,238 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_tracing.cc
+// *
+// * Purpose: Record the timeline of library operations as spans and write
+// *          it in the Chrome trace event format
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_nls.h>
+#include <gsmlib/gsm_tracing.h>
+#include <gsmlib/gsm_error.h>
+#include <gsmlib/gsm_util.h>
+#include <fstream>
+#include <cstring>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace gsmlib;
+
+std::atomic<TraceBuffer*> gsmlib::traceBuffer(NULL);
+
+static std::string traceFilename;       // set by traceToFile()
+static std::atomic<bool> writeRequested(false); // SIGUSR2 arrived
+static std::atomic<unsigned int> threadCount(0);
+static thread_local unsigned int threadId = 0;
+
+// return monotonic time in microseconds
+static unsigned long long now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// escape string for JSON
+static std::string json(const char *s)
+{
+  std::string result;
+  for (; *s != 0; ++s)
+    if (*s == '"' || *s == '\\')
+      result += std::string("\\") + *s;
+    else if ((unsigned char)*s < 0x20)
+      result += stringPrintf("\\u%04x", (unsigned char)*s);
+    else
+      result += *s;
+  return result;
+}
+
+static void requestWrite(int)
+{
+  writeRequested = true;
+}
+
+static void writeAtExit()
+{
+  try
+  {
+    writeTrace(traceFilename);
+  }
+  catch (GsmException &e)
+  {
+    ignoreOutputError("trace", e);
+  }
+}
+
+// TraceBuffer members
+
+TraceBuffer::TraceBuffer(unsigned int capacity) :
+  _slots(new Slot[capacity]), _capacity(capacity), _next(0)
+{
+  for (unsigned int i = 0; i < capacity; ++i)
+  {
+    _slots[i]._writing.store(false);
+    _slots[i]._sequence.store(0);
+  }
+}
+
+void TraceBuffer::push(const TraceEvent &event)
+{
+  unsigned long long words[EventWords] = {0};
+  memcpy(words, &event, sizeof(event));
+
+  unsigned long long ticket = _next.fetch_add(1, std::memory_order_relaxed);
+  Slot &slot = _slots[ticket % _capacity];
+  while (slot._writing.exchange(true, std::memory_order_acquire))
+    ;                           // slot is short, just spin
+
+  // a writer that came later may have been faster
+  if (slot._sequence.load(std::memory_order_relaxed) <= ticket)
+  {
+    slot._sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (unsigned int i = 0; i < EventWords; ++i)
+      slot._event[i].store(words[i], std::memory_order_relaxed);
+    slot._sequence.store(ticket + 1, std::memory_order_release);
+  }
+  slot._writing.store(false, std::memory_order_release);
+}
+
+std::vector<TraceEvent> TraceBuffer::events() const
+{
+  std::vector<TraceEvent> result;
+  unsigned long long next = _next.load(std::memory_order_acquire);
+  unsigned long long first = next > _capacity ? next - _capacity : 0;
+  for (unsigned long long ticket = first; ticket < next; ++ticket)
+  {
+    const Slot &slot = _slots[ticket % _capacity];
+    unsigned long long sequence =
+      slot._sequence.load(std::memory_order_acquire);
+    if (sequence != ticket + 1)
+      continue;                 // being written or already overwritten
+    unsigned long long words[EventWords];
+    for (unsigned int i = 0; i < EventWords; ++i)
+      words[i] = slot._event[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot._sequence.load(std::memory_order_relaxed) == sequence)
+    {
+      TraceEvent event;
+      memcpy(&event, words, sizeof(event));
+      result.push_back(event);
+    }
+  }
+  return result;
+}
+
+TraceBuffer::~TraceBuffer()
+{
+  delete[] _slots;
+}
+
+// TraceSpan members
+
+void TraceSpan::begin(const char *category, const char *name,
+                      const char *detail, unsigned int detailLength)
+{
+  _event._category = category;
+  _event._name = name;
+  if (detailLength >= sizeof(_event._detail))
+    detailLength = sizeof(_event._detail) - 1;
+  memcpy(_event._detail, detail, detailLength);
+  _event._detail[detailLength] = 0;
+  if (threadId == 0)
+    threadId = ++threadCount;
+  _event._thread = threadId;
+  _event._start = now();
+}
+
+void TraceSpan::end()
+{
+  _event._duration = now() - _event._start;
+  _buffer->push(_event);
+  if (writeRequested.load(std::memory_order_relaxed))
+    writeTraceIfRequested();
+}
+
+// tracing functions
+
+void gsmlib::enableTracing(unsigned int capacity)
+{
+  TraceBuffer *expected = NULL;
+  TraceBuffer *buffer = new TraceBuffer(capacity);
+  // the buffer is never freed because spans may still refer to it
+  if (! traceBuffer.compare_exchange_strong(expected, buffer))
+    delete buffer;
+}
+
+void gsmlib::writeTrace(std::ostream &os)
+{
+  std::vector<TraceEvent> events;
+  TraceBuffer *buffer = traceBuffer.load();
+  if (buffer != NULL)
+    events = buffer->events();
+
+  int pid = getpid();
+  os << "{\"traceEvents\":[";
+  for (std::vector<TraceEvent>::iterator i = events.begin();
+       i != events.end(); ++i)
+  {
+    std::string name = i->_name;
+    if (i->_detail[0] != 0)
+      name += std::string(" ") + i->_detail;
+    os << (i == events.begin() ? "\n" : ",\n")
+       << "{\"name\":\"" << json(name.c_str())
+       << "\",\"cat\":\"" << json(i->_category)
+       << "\",\"ph\":\"X\",\"ts\":" << i->_start
+       << ",\"dur\":" << i->_duration
+       << ",\"pid\":" << pid << ",\"tid\":" << i->_thread << "}";
+  }
+  os << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+void gsmlib::writeTrace(std::string filename)
+{
+  AtomicFile file(filename);
+  writeTrace(file.stream());
+  file.commit();
+}
+
+void gsmlib::traceToFile(std::string filename)
+{
+  if (traceFilename != "")
+    return;                     // already set up
+  enableTracing();
+  traceFilename = filename;
+  atexit(writeAtExit);
+
+  struct sigaction action;
+  if (sigaction(SIGUSR2, NULL, &action) == 0 && action.sa_handler == SIG_DFL)
+  {
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestWrite;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &action, NULL);
+  }
+}
+
+void gsmlib::writeTraceIfRequested()
+{
+  if (! writeRequested.exchange(false) || traceFilename == "")
+    return;
+  try
+  {
+    writeTrace(traceFilename);
+  }
+  catch (GsmException &e)
+  {
+    ignoreOutputError("trace", e);
+  }
+}
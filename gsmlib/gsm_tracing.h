@@ -0,0 +1,122 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsm_tracing.h
+// *
+// * Purpose: Record the timeline of library operations as spans and write
+// *          it in the Chrome trace event format
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifndef GSM_TRACING_H
+#define GSM_TRACING_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <atomic>
+
+namespace gsmlib
+{
+  // default number of spans kept
+  const unsigned int DEFAULT_TRACE_CAPACITY = 16384;
+
+  // one completed span
+  struct TraceEvent
+  {
+    const char *_category;      // static string, eg. "at"
+    const char *_name;          // static string, eg. "chat"
+    char _detail[40];           // eg. the AT command verb
+    unsigned long long _start;  // microseconds (monotonic clock)
+    unsigned long long _duration; // microseconds
+    unsigned int _thread;       // small number identifying the thread
+  };
+
+  // Ring buffer keeping the last capacity spans. Any thread can push()
+  // without a global lock, each slot has a sequence number so that
+  // events() can skip slots that are being overwritten. The event is
+  // copied word by word through atomics, so readers never race with
+  // writers. Writers that wrapped around to the same slot take turns.
+  class TraceBuffer
+  {
+  private:
+    static const unsigned int EventWords =
+      (sizeof(TraceEvent) + sizeof(unsigned long long) - 1) /
+      sizeof(unsigned long long);
+
+    struct Slot
+    {
+      std::atomic<bool> _writing; // held by the writer of the slot
+      std::atomic<unsigned long long> _sequence; // 0 while written
+      std::atomic<unsigned long long> _event[EventWords];
+    };
+
+    Slot *_slots;
+    unsigned int _capacity;
+    std::atomic<unsigned long long> _next; // number of spans pushed
+
+  public:
+    TraceBuffer(unsigned int capacity);
+
+    // record span
+    void push(const TraceEvent &event);
+
+    // return the spans recorded, oldest first
+    std::vector<TraceEvent> events() const;
+
+    ~TraceBuffer();
+  };
+
+  // buffer the spans are recorded in, NULL if tracing is disabled
+  extern std::atomic<TraceBuffer*> traceBuffer;
+
+  // return true if spans are recorded
+  inline bool tracingEnabled()
+    {return traceBuffer.load(std::memory_order_relaxed) != NULL;}
+
+  // start recording spans (no-op if already started)
+  extern void enableTracing(unsigned int capacity = DEFAULT_TRACE_CAPACITY);
+
+  // write the spans recorded so far as Chrome trace JSON (can be loaded
+  // into chrome://tracing or Perfetto)
+  extern void writeTrace(std::ostream &os);
+  extern void writeTrace(std::string filename);
+
+  // enable tracing and write the trace to filename when the program
+  // exits and when SIGUSR2 arrives (unless the program handles SIGUSR2)
+  // MeTa calls this if the environment variable GSMLIB_TRACE is set
+  extern void traceToFile(std::string filename);
+
+  // write the trace file if SIGUSR2 has arrived since the last call
+  // (called when spans end and by MeTa::waitEvent())
+  extern void writeTraceIfRequested();
+
+  // Records the time from its construction to its destruction as a span.
+  // Nothing is done if tracing is disabled.
+  class TraceSpan
+  {
+  private:
+    TraceBuffer *_buffer;       // NULL if disabled
+    TraceEvent _event;
+
+    void begin(const char *category, const char *name, const char *detail,
+               unsigned int detailLength);
+    void end();
+
+  public:
+    TraceSpan(const char *category, const char *name) :
+      _buffer(traceBuffer.load(std::memory_order_relaxed))
+      {if (_buffer != NULL) begin(category, name, "", 0);}
+
+    TraceSpan(const char *category, const char *name,
+              const std::string &detail) :
+      _buffer(traceBuffer.load(std::memory_order_relaxed))
+      {if (_buffer != NULL)
+          begin(category, name, detail.data(), detail.length());}
+
+    ~TraceSpan() {if (_buffer != NULL) end();}
+  };
+};
+
+#endif // GSM_TRACING_H
@@ -15,6 +15,8 @@
 #endif
 #include <gsmlib/gsm_nls.h>
 #include <gsmlib/gsm_unix_serial.h>
+#include <gsmlib/gsm_socket_port.h>
+#include <gsmlib/gsm_recording_port.h>
 #include <gsmlib/gsm_util.h>
 #include <termios.h>
 #include <fcntl.h>
@@ -23,8 +25,10 @@
 #include <cassert>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/time.h>
 #include <signal.h>
 #include <pthread.h>
 #include <cstring>
@@ -35,7 +39,21 @@ using namespace gsmlib;
 static const int holdoff[] = {2000000, 1000000, 400000};
 static const int holdoffArraySize = sizeof(holdoff) / sizeof(int);
 
+// time to wait for the answer to the probe of a fast open (in ms)
+static const long int FAST_OPEN_TIMEOUT = 500;
+
+// return milliseconds elapsed since startTime
+static long int millisecondsSince(const struct timeval &startTime)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - startTime.tv_sec) * 1000 +
+    (now.tv_usec - startTime.tv_usec) / 1000;
+}
+
+#ifndef TIOCOUTQ
 // alarm handling for socket read/write
+// (only if the output queue cannot be polled, see putLine())
 // the timerMtx is necessary since several threads cannot use the
 // timer indepently of each other
 
@@ -92,6 +110,7 @@ static void stopTimer()
   sigaction(SIGALRM, NULL, NULL);
   pthread_mutex_unlock(&timerMtx);
 }
+#endif // TIOCOUTQ
 
 // UnixSerialPort members
 
@@ -173,12 +192,106 @@ int UnixSerialPort::readByte()
   return c;
 }
 
+void UnixSerialPort::setLineModes(std::string device, speed_t lineSpeed,
+                                  bool swHandshake)
+{
+  struct termios t;
+
+  // get line modes
+  if (tcgetattr(_fd, &t) < 0) {
+    close(_fd);
+    throwModemException(stringPrintf(_("tcgetattr device '%s'"),
+                                     device.c_str()));
+  }
+
+  // set line speed
+  cfsetispeed(&t, lineSpeed);
+  cfsetospeed(&t, lineSpeed);
+
+  // set the device to a sane state
+  t.c_iflag |= IGNPAR | (swHandshake ? IXON | IXOFF : 0);
+  t.c_iflag &= ~(INPCK | ISTRIP | IMAXBEL |
+                 (swHandshake ? 0 : IXON |  IXOFF)
+                 | IXANY | IGNCR | ICRNL | IMAXBEL | INLCR | IGNBRK);
+  t.c_oflag &= ~(OPOST);
+  // be careful, only touch "known" flags
+  t.c_cflag &= ~(CSIZE | CSTOPB | PARENB | PARODD |
+                (swHandshake ? CRTSCTS : 0 ));
+  t.c_cflag |= CS8 | CREAD | HUPCL | (swHandshake ? 0 : CRTSCTS) | CLOCAL;
+  t.c_lflag &= ~(ECHO | ECHOE | ECHOPRT | ECHOK | ECHOKE | ECHONL |
+                 ECHOCTL | ISIG | IEXTEN | TOSTOP | FLUSHO | ICANON);
+  t.c_lflag |= NOFLSH;
+  t.c_cc[VMIN] = 1;
+  t.c_cc[VTIME] = 0;
+
+  t.c_cc[VSUSP] = 0;
+
+  // write back
+  if(tcsetattr (_fd, TCSANOW, &t) < 0) {
+    close(_fd);
+    throwModemException(stringPrintf(_("tcsetattr device '%s'"),
+                                     device.c_str()));
+  }
+}
+
+bool UnixSerialPort::probe(std::string command, long int timeout)
+{
+  struct timeval startTime;
+  gettimeofday(&startTime, NULL);
+  try
+  {
+    putLine(command);
+  }
+  catch (GsmException &e)
+  {
+    return false;
+  }
+
+  std::string line;
+  long int remaining;
+  while ((remaining = timeout - millisecondsSince(startTime)) > 0)
+  {
+    fd_set fdSet;
+    struct timeval tv;
+    tv.tv_sec = remaining / 1000;
+    tv.tv_usec = (remaining % 1000) * 1000;
+    FD_ZERO(&fdSet);
+    FD_SET(_fd, &fdSet);
+
+    int res = select(_fd + 1, &fdSet, NULL, NULL, &tv);
+    if (res < 0 && errno != EINTR)
+      return false;
+    unsigned char c;
+    if (res <= 0 || read(_fd, &c, 1) != 1)
+      continue;
+    if (c != LF)
+    {
+      if (c != CR)
+        line += c;
+      continue;
+    }
+#ifndef NDEBUG
+    if (debugLevel() >= 1)
+      std::cerr << "<-- " << line << std::endl;
+#endif
+    if (line.find("OK") != std::string::npos ||
+        line.find("CABLE: GSM") != std::string::npos)
+      return true;
+    if (line.find("ERROR") != std::string::npos)
+      return false;
+    line = "";
+  }
+  return false;
+}
+
 UnixSerialPort::UnixSerialPort(std::string device, speed_t lineSpeed,
-                               string initString, bool swHandshake) :
-  _noop(0), _oldChar(-1), _timeoutVal(TIMEOUT_SECS)
+                               string initString, bool swHandshake,
+                               bool fastOpen) :
+  _noop(0), _oldChar(-1), _timeoutVal(TIMEOUT_SECS), _openLatency(0)
 {
   (void) _noop; // suppress unused private member warning
-  struct termios t;
+  struct timeval startTime;
+  gettimeofday(&startTime, NULL);
 
   // open device
   _fd = open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
@@ -198,6 +311,23 @@ UnixSerialPort::UnixSerialPort(std::string device, speed_t lineSpeed,
     throwModemException(_("switching of non-blocking mode failed"));
   }
 
+  // a modem that was left in a sane state answers the init string at once
+  if (fastOpen)
+  {
+    setLineModes(device, lineSpeed, swHandshake);
+    tcflush(_fd, TCIFLUSH);
+    if (probe("AT" + initString, FAST_OPEN_TIMEOUT))
+    {
+      _openLatency = millisecondsSince(startTime);
+#ifndef NDEBUG
+      if (debugLevel() >= 1)
+        std::cerr << "*** fast open of '" << device << "' took "
+                  << _openLatency << " ms" << std::endl;
+#endif
+      return;
+    }
+  }
+
   long int saveTimeoutVal = _timeoutVal;
   _timeoutVal = 3;
   int initTries = holdoffArraySize;
@@ -218,41 +348,8 @@ UnixSerialPort::UnixSerialPort(std::string device, speed_t lineSpeed,
       close(_fd);
       throwModemException(_("setting DTR failed"));
     }
-    // get line modes
-    if (tcgetattr(_fd, &t) < 0) {
-      close(_fd);
-      throwModemException(stringPrintf(_("tcgetattr device '%s'"),
-                                       device.c_str()));
-    }
+    setLineModes(device, lineSpeed, swHandshake);
 
-    // set line speed
-    cfsetispeed(&t, lineSpeed);
-    cfsetospeed(&t, lineSpeed);
-
-    // set the device to a sane state
-    t.c_iflag |= IGNPAR | (swHandshake ? IXON | IXOFF : 0);
-    t.c_iflag &= ~(INPCK | ISTRIP | IMAXBEL |
-                   (swHandshake ? 0 : IXON |  IXOFF)
-                   | IXANY | IGNCR | ICRNL | IMAXBEL | INLCR | IGNBRK);
-    t.c_oflag &= ~(OPOST);
-    // be careful, only touch "known" flags
-    t.c_cflag &= ~(CSIZE | CSTOPB | PARENB | PARODD |
-                  (swHandshake ? CRTSCTS : 0 ));
-    t.c_cflag |= CS8 | CREAD | HUPCL | (swHandshake ? 0 : CRTSCTS) | CLOCAL;
-    t.c_lflag &= ~(ECHO | ECHOE | ECHOPRT | ECHOK | ECHOKE | ECHONL |
-                   ECHOCTL | ISIG | IEXTEN | TOSTOP | FLUSHO | ICANON);
-    t.c_lflag |= NOFLSH;
-    t.c_cc[VMIN] = 1;
-    t.c_cc[VTIME] = 0;
-
-    t.c_cc[VSUSP] = 0;
-
-    // write back
-    if(tcsetattr (_fd, TCSANOW, &t) < 0) {
-      close(_fd);
-      throwModemException(stringPrintf(_("tcsetattr device '%s'"),
-                                       device.c_str()));
-    }
     // the waiting time for writing to the ME/TA is increased with each loop
     usleep(holdoff[initTries]);
 
@@ -293,7 +390,15 @@ UnixSerialPort::UnixSerialPort(std::string device, speed_t lineSpeed,
           std::string s = getLine();
           if (s.find("OK") != std::string::npos ||
               s.find("CABLE: GSM") != std::string::npos)
+          {
+            _openLatency = millisecondsSince(startTime);
+#ifndef NDEBUG
+            if (debugLevel() >= 1)
+              std::cerr << "*** reset of '" << device << "' took "
+                        << _openLatency << " ms" << std::endl;
+#endif
             return;                 // found OK, return
+          }
         }
       }
     }
@@ -379,6 +484,26 @@ void UnixSerialPort::putLine(std::string line, bool carriageReturn)
     }
   }
 
+#ifdef TIOCOUTQ
+  if (timeElapsed >= _timeoutVal)
+    throwModemException(_("timeout when writing to TA"));
+
+  // wait for output to be read by TA
+  // the output queue is polled because interrupting tcdrain() with
+  // SIGALRM does not work if several threads use ports, if the driver
+  // cannot tell the size of the queue there is nothing to wait for
+  struct timeval drainStart;
+  gettimeofday(&drainStart, NULL);
+  int pending;
+  while (ioctl(_fd, TIOCOUTQ, &pending) == 0 && pending > 0)
+  {
+    if (interrupted())
+      throwModemException(_("interrupted when writing to TA"));
+    if (millisecondsSince(drainStart) >= (_timeoutVal - timeElapsed) * 1000L)
+      throwModemException(_("timeout when writing to TA"));
+    usleep(1000);
+  }
+#else
   while (timeElapsed < _timeoutVal)
   {
     if (interrupted())
@@ -396,6 +521,7 @@ void UnixSerialPort::putLine(std::string line, bool carriageReturn)
   }
   if (timeElapsed >= _timeoutVal)
     throwModemException(_("timeout when writing to TA"));
+#endif
 
   // echo CR LF must be removed by higher layer functions in gsm_at because
   // in order to properly handle unsolicited result codes from the ME/TA
@@ -459,3 +585,49 @@ speed_t gsmlib::baudRateStrToSpeed(std::string baudrate)
     throw GsmException(stringPrintf(_("unknown baudrate '%s'"),
                                     baudrate.c_str()), ParameterError);
 }
+
+// line speed in bits/s for the line settings of network ports
+static int speedToBaudRate(speed_t lineSpeed)
+{
+  static const char *baudRates[] = {"300", "600", "1200", "2400", "4800",
+                                    "9600", "19200", "38400", "57600",
+                                    "115200", "230400", "460800", NULL};
+  for (int i = 0; baudRates[i] != NULL; ++i)
+    try
+    {
+      if (baudRateStrToSpeed(baudRates[i]) == lineSpeed)
+        return atoi(baudRates[i]);
+    }
+    catch (GsmException &)
+    {
+    }
+  return DEFAULT_BAUD_RATE;
+}
+
+Ref<Port> gsmlib::openPort(std::string device, speed_t lineSpeed,
+                           std::string initString, bool swHandshake,
+                           bool fastOpen)
+{
+  std::string host, service;
+  bool rfc2217;
+  Ref<Port> port;
+  if (device.substr(0, 7) == "replay:")
+  {
+    char *speed = getenv("GSMLIB_REPLAY_SPEED");
+    return new ReplayPort(device.substr(7), speed == NULL ? 1.0 : atof(speed));
+  }
+  if (isSocket(device))
+    port = new SocketPort(device);
+  else if (parseNetworkDevice(device, host, service, rfc2217))
+    port = new SocketPort(host, service, rfc2217, speedToBaudRate(lineSpeed),
+                          initString, swHandshake, fastOpen);
+  else
+    port = new UnixSerialPort(device, lineSpeed, initString, swHandshake,
+                              fastOpen);
+
+  // record the dialogue with the ME/TA if requested
+  char *traceFile = getenv("GSMLIB_RECORD");
+  if (traceFile != NULL && *traceFile != 0)
+    port = new RecordingPort(port, traceFile);
+  return port;
+}
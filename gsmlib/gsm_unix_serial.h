@@ -31,15 +31,31 @@ namespace gsmlib
     int _noop;                  // Unused; kept for ABI-compat (like anybody cares about it)
     int _oldChar;               // character set by putBack() (-1 == none)
     long int _timeoutVal;       // timeout for getLine/readByte
+    long int _openLatency;      // time the constructor took (in ms)
 
     // throw GsmException include UNIX errno
     void throwModemException(std::string message);
+
+    // set line speed, handshake, and raw mode
+    void setLineModes(std::string device, speed_t lineSpeed,
+                      bool swHandshake);
+
+    // send command, return true if the TA answers OK within timeout ms
+    bool probe(std::string command, long int timeout);
     
   public:
     // create Port given the UNIX device name
+    // if fastOpen is true, the init string is sent right away and the
+    // DTR toggling and ATZ reset is only done if the TA does not answer
     UnixSerialPort(std::string device, speed_t lineSpeed = DEFAULT_BAUD_RATE,
                    std::string initString = DEFAULT_INIT_STRING,
-                   bool swHandshake = false);
+                   bool swHandshake = false, bool fastOpen = false);
+
+    // return time it took to open and initialize the device (in ms)
+    long int openLatency() const {return _openLatency;}
+
+    // return file descriptor of the device (eg. for select())
+    int fd() const {return _fd;}
 
     // inherited from Port
     void putBack(unsigned char c);
@@ -55,6 +71,17 @@ namespace gsmlib
 
   // convert baudrate string ("300" .. "460800") to speed_t
   extern speed_t baudRateStrToSpeed(std::string baudrate);
+
+  // open device: if it is the socket of a gsmbrokerd connect to the broker,
+  // if it is "tcp://host:port" or "rfc2217://host:port" connect to a
+  // serial-over-IP server, if it is "replay:file" play back a trace
+  // (speed taken from GSMLIB_REPLAY_SPEED), otherwise open the serial device;
+  // record the dialogue if GSMLIB_RECORD names a trace file
+  extern Ref<Port> openPort(std::string device,
+                            speed_t lineSpeed = DEFAULT_BAUD_RATE,
+                            std::string initString = DEFAULT_INIT_STRING,
+                            bool swHandshake = false,
+                            bool fastOpen = false);
 };
 
 #endif // GSM_UNIX_SERIAL_H
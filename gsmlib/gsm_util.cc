@@ -21,6 +21,7 @@
 #include <string.h>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <ctype.h>
 #include <errno.h>
 #if !defined(HAVE_CONFIG_H) || defined(HAVE_UNISTD_H)
@@ -196,6 +197,12 @@ bool gsmlib::isFile(std::string filename)
   // stat does not work reliably under Win32 to indicate devices
   if (isCom(filename))
     return false;
+#else
+  // serial-over-IP server, see parseNetworkDevice(), or trace replay
+  if (filename.substr(0, 6) == "tcp://" ||
+      filename.substr(0, 10) == "rfc2217://" ||
+      filename.substr(0, 7) == "replay:")
+    return false;
 #endif
 
   struct stat statBuf;
@@ -228,7 +235,7 @@ bool gsmlib::isFile(std::string filename)
       }
       ++retries;
     }
-    else if (S_ISCHR(statBuf.st_mode))
+    else if (S_ISCHR(statBuf.st_mode) || S_ISSOCK(statBuf.st_mode))
       return false;
     else 
 #endif
@@ -255,6 +262,43 @@ void gsmlib::renameToBackupFile(std::string filename)
       OSError, errno);
 }
 
+// AtomicFile members
+
+AtomicFile::AtomicFile(std::string filename) :
+  _filename(filename), _tmpFilename(filename + ".tmp" + intToStr(getpid())),
+  _ofs(_tmpFilename.c_str()), _committed(false)
+{
+}
+
+void AtomicFile::commit()
+{
+  _ofs.close();
+  _committed = true;
+  if (! _ofs || rename(_tmpFilename.c_str(), _filename.c_str()) != 0)
+  {
+    unlink(_tmpFilename.c_str());
+    throw GsmException(stringPrintf(_("error writing to file '%s'"),
+                                    _filename.c_str()), OSError);
+  }
+}
+
+AtomicFile::~AtomicFile()
+{
+  if (! _committed)
+  {
+    _ofs.close();
+    unlink(_tmpFilename.c_str());
+  }
+}
+
+void gsmlib::ignoreOutputError(std::string what, const std::exception &e)
+{
+#ifndef NDEBUG
+  if (debugLevel() >= 1)
+    std::cerr << "*** " << what << " not written: " << e.what() << std::endl;
+#endif
+}
+
 // NoCopy members
 
 #ifndef NDEBUG
@@ -385,3 +429,105 @@ bool gsmlib::isSet(std::vector<bool> &b, unsigned int bit)
 {
   return b.size() > bit && b[bit];
 }
+
+// IntList members
+
+// comparison for std::upper_bound() in IntList::position()
+static bool startsAfter(int i, const IntRange &r)
+{
+  return i < r._low;
+}
+
+void IntList::add(int low, int high)
+{
+  if (low > high)
+  {
+    int temp = low;
+    low = high;
+    high = temp;
+  }
+
+  IntRange range;
+  range._low = low;
+  range._high = high;
+
+  // parsers add in ascending order, so handle the last range directly
+  if (_ranges.empty() || _ranges.back()._high < low - 1)
+  {
+    _before.push_back(count());
+    _ranges.push_back(range);
+    return;
+  }
+  if (low >= _ranges.back()._low)
+  {
+    if (high > _ranges.back()._high)
+      _ranges.back()._high = high;
+    return;
+  }
+
+  // skip ranges that end before low, then merge all ranges that start
+  // no later than high into the new range
+  std::vector<IntRange>::iterator i = _ranges.begin();
+  while (i != _ranges.end() && i->_high < low - 1)
+    ++i;
+  std::vector<IntRange>::iterator j = i;
+  while (j != _ranges.end() && j->_low - 1 <= high)
+  {
+    if (j->_low < low) low = j->_low;
+    if (j->_high > high) high = j->_high;
+    ++j;
+  }
+
+  range._low = low;
+  range._high = high;
+  std::vector<IntRange>::size_type first = i - _ranges.begin();
+  if (i == j)
+    _ranges.insert(i, range);
+  else
+  {
+    *i = range;
+    _ranges.erase(i + 1, j);
+  }
+
+  // recount the ranges from the changed one on
+  _before.resize(_ranges.size());
+  for (std::vector<IntRange>::size_type k = first; k < _ranges.size(); ++k)
+    _before[k] = k == 0 ? 0 :
+      _before[k - 1] + _ranges[k - 1]._high - _ranges[k - 1]._low + 1;
+}
+
+bool IntList::contains(int i) const
+{
+  return position(i) != -1;
+}
+
+int IntList::position(int i) const
+{
+  // find the last range that starts no later than i
+  std::vector<IntRange>::const_iterator r =
+    std::upper_bound(_ranges.begin(), _ranges.end(), i, startsAfter);
+  if (r == _ranges.begin() || i > (--r)->_high)
+    return -1;
+  return _before[r - _ranges.begin()] + i - r->_low;
+}
+
+int IntList::count() const
+{
+  if (_ranges.empty())
+    return 0;
+  return _before.back() + _ranges.back()._high - _ranges.back()._low + 1;
+}
+
+std::vector<bool> IntList::toBitVector() const
+{
+  std::vector<bool> result;
+  if (! _ranges.empty())
+  {
+    result.resize(last() + 1, false);
+    for (std::vector<IntRange>::const_iterator r = _ranges.begin();
+         r != _ranges.end(); ++r)
+      for (int i = r->_low; i <= r->_high; ++i)
+        result[i] = true;
+  }
+  return result;
+}
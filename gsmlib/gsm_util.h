@@ -15,6 +15,8 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <fstream>
 #include <gsmlib/gsm_error.h>
 #ifndef WIN32
 #include <sys/time.h>
@@ -63,6 +65,43 @@ namespace gsmlib
     IntRange() : _high(NOT_SET), _low(NOT_SET) {}
   };
 
+  // A list of integers such as "(1-5,7,11-12)", stored as sorted ranges
+  // that neither overlap nor touch, eg. 1-5, 7-7, 11-12
+  class IntList
+  {
+  private:
+    std::vector<IntRange> _ranges;
+    std::vector<int> _before;   // number of integers before each range
+
+  public:
+    // add the integers from low to high (or high to low)
+    // adding in ascending order is O(1)
+    void add(int low, int high);
+    void add(int i) {add(i, i);}
+
+    // return true if i is in the list
+    bool contains(int i) const;
+
+    // return the number of integers in the list that are smaller than i
+    // or -1 if i is not in the list (O(log n) in the number of ranges)
+    int position(int i) const;
+
+    // return the number of integers in the list
+    int count() const;
+
+    // return the smallest and largest integer or NOT_SET if empty
+    int first() const
+      {return _ranges.empty() ? NOT_SET : _ranges.front()._low;}
+    int last() const
+      {return _ranges.empty() ? NOT_SET : _ranges.back()._high;}
+
+    bool empty() const {return _ranges.empty();}
+    const std::vector<IntRange> &ranges() const {return _ranges;}
+
+    // return bit vector with a bit set for each integer in the list
+    std::vector<bool> toBitVector() const;
+  };
+
   // A valid integer range for a given parameter
   struct ParameterRange
   {
@@ -71,16 +110,24 @@ namespace gsmlib
   };
 
   // *** general-purpose pointer wrapper with reference counting
+  // the count is atomic so that Refs to the same object can be copied
+  // and destroyed in different threads (the object itself is not
+  // protected by this)
   class RefBase
   {
   private:
-    int _refCount;
+    std::atomic<int> _refCount;
     
   public:
     RefBase() : _refCount(0) {}
-    int ref() {return _refCount++;}
-    int unref() {return --_refCount;}
-    int refCount() const {return _refCount;}
+    // a copy is a new object that is not yet referenced
+    RefBase(const RefBase &) : _refCount(0) {}
+    RefBase &operator=(const RefBase &) {return *this;}
+    int ref() {return _refCount.fetch_add(1, std::memory_order_relaxed);}
+    // the last unref() sees all changes made through other references
+    int unref()
+      {return _refCount.fetch_sub(1, std::memory_order_acq_rel) - 1;}
+    int refCount() const {return _refCount.load(std::memory_order_relaxed);}
   };
   
   template <class T>
@@ -97,6 +144,10 @@ namespace gsmlib
       Ref(T *pp) : _rep(pp) {if (pp != (T*)NULL) pp->ref();}
       Ref(const Ref &r);
       Ref &operator=(const Ref &r);
+      // take over the reference of r without touching the count,
+      // r becomes null
+      Ref(Ref &&r) : _rep(r._rep) {r._rep = (T*)NULL;}
+      Ref &operator=(Ref &&r);
       ~Ref();
       bool operator==(const Ref &r) const
         {
@@ -119,6 +170,19 @@ namespace gsmlib
       return *this;
     }
 
+  template <class T>
+    Ref<T> &Ref<T>::operator=(Ref<T> &&r)
+    {
+      if (this != &r)
+      {
+        T *old = _rep;
+        _rep = r._rep;
+        r._rep = (T*)NULL;
+        if (old != (T*)NULL && old->unref() == 0) delete old;
+      }
+      return *this;
+    }
+
   template <class T>
     Ref<T>::~Ref()
     {
@@ -136,11 +200,41 @@ namespace gsmlib
 
   // return true if filename refers to a file
   // throws exception if filename is neither file nor device
+  // (tcp:// and rfc2217:// network devices count as devices)
   bool isFile(std::string filename);
 
   // make backup file adequate for this operating system
   void renameToBackupFile(std::string filename);
 
+  // file that is written to a temporary file (named after the process)
+  // and only replaces filename on commit(), so that readers never see
+  // partial contents
+  // the temporary file is removed if commit() is not reached
+  class AtomicFile
+  {
+  private:
+    std::string _filename;
+    std::string _tmpFilename;
+    std::ofstream _ofs;
+    bool _committed;
+
+  public:
+    AtomicFile(std::string filename);
+
+    // stream to write the contents to
+    std::ostream &stream() {return _ofs;}
+
+    // replace filename by the temporary file
+    // throws OSError exception if writing or renaming fails
+    void commit();
+
+    ~AtomicFile();
+  };
+
+  // report that the optional output what (metrics, trace, ...) could not
+  // be written because of e, gsmlib carries on without it
+  void ignoreOutputError(std::string what, const std::exception &e);
+
   // Base class for class for which copying is not allow
   // only used for debugging
 
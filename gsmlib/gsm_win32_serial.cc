@@ -155,7 +155,8 @@ int Win32SerialPort::readByte()
 }
 
 Win32SerialPort::Win32SerialPort(std::string device, int lineSpeed,
-                               std::string initString, bool swHandshake)
+                               std::string initString, bool swHandshake,
+                               bool fastOpen)
   _oldChar(-1)
 {
  try
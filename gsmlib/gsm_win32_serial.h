@@ -36,9 +36,11 @@ namespace gsmlib
     
   public:
     // create Port given the UNIX device name
+    // fastOpen is accepted for compatibility with UnixSerialPort, the
+    // device is always reset
     Win32SerialPort(string device, int lineSpeed = DEFAULT_BAUD_RATE,
                    string initString = DEFAULT_INIT_STRING,
-                   bool swHandshake = false)
+                   bool swHandshake = false, bool fastOpen = false)
 
     // inherited from Port
     void putBack(unsigned char c);
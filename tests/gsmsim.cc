@@ -0,0 +1,987 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    gsmsim.cc
+// *
+// * Purpose: ME/TA simulator on a PTY for testing and benchmarking without
+// *          a mobile phone
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_sms.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/select.h>
+
+using namespace std;
+using namespace gsmlib;
+
+// The simulator implements the subset of AT commands used by gsmlib with
+// one SMS store and one phonebook ("SM"). SMS are handled in PDU mode
+// only. Responses can be delayed per command and commands can be made to
+// fail at random (reproducibly, the random numbers are seeded).
+// Incoming SMS are delivered as +CMTI or +CMT according to +CNMI after
+// gsmlib has enabled the indications, or when SIGUSR1 is received.
+// Sending an SMS can include setting up the relay link to the SC, which
+// is kept open for a while after an SMS if +CMMS is 1 or 2.
+
+// *** options
+
+static struct option longOpts[] =
+{
+  {"link", required_argument, (int*)NULL, 'L'},
+  {"latency", required_argument, (int*)NULL, 'l'},
+  {"command-latency", required_argument, (int*)NULL, 'c'},
+  {"error", required_argument, (int*)NULL, 'e'},
+  {"seed", required_argument, (int*)NULL, 'r'},
+  {"sms-size", required_argument, (int*)NULL, 's'},
+  {"sms-used", required_argument, (int*)NULL, 'S'},
+  {"pb-size", required_argument, (int*)NULL, 'p'},
+  {"pb-used", required_argument, (int*)NULL, 'P'},
+  {"incoming", required_argument, (int*)NULL, 'i'},
+  {"interval", required_argument, (int*)NULL, 'I'},
+  {"link-setup", required_argument, (int*)NULL, 'k'},
+  {"no-cmms", no_argument, (int*)NULL, 'N'},
+  {"trace", no_argument, (int*)NULL, 't'},
+  {"help", no_argument, (int*)NULL, 'h'},
+  {(char*)NULL, 0, (int*)NULL, 0}
+};
+
+static long defaultLatency = 0;         // ms before each response
+static map<string, long> commandLatency; // ms by command verb
+static map<string, double> errorRate;   // probability by verb ("*" == all)
+static bool trace = false;              // log dialogue to stderr
+
+// *** ME/TA state
+
+struct SMSSlot
+{
+  int _status;                  // 0 unread, 1 read, 2 unsent, 3 sent
+  string _pdu;                  // hex PDU including SCA, "" == free
+};
+
+struct PhonebookSlot
+{
+  string _number, _text;
+  int _type;
+  bool empty() const {return _number == "" && _text == "";}
+};
+
+static vector<SMSSlot> smsStore;
+static vector<PhonebookSlot> phonebook;
+static bool echo = true;
+static int cmee = 0;
+static int copsFormat = 0;
+static int cnmi[5] = {0, 0, 0, 0, 0};
+static int csms = 0;
+static int messageReference = 0;
+
+// relay link to the SC for +CMGS
+// (GSM 07.05 allows 1-5 seconds for keeping the link open)
+static const double LINK_HOLD_MS = 3000;
+static long linkSetup = 0;              // ms to set up the link
+static bool hasCMMS = true;             // false: +CMMS is not supported
+static int cmms = 0;                    // +CMMS mode
+static double linkOpenUntil = 0;        // time the link closes (0 == closed)
+
+// PDU expected after "> " prompt for +CMGS or +CMGW
+static bool pduMode = false;
+static string pduVerb;
+static int pduStatus;
+
+// incoming SMS
+static int incomingLeft = 0;            // still to be delivered
+static long incomingInterval = 1000;    // ms between incoming SMS
+static double nextIncoming = 0;         // time of next one (0 == none)
+static int incomingCount = 0;           // delivered so far
+
+static int master = -1;
+static string linkName;
+static volatile sig_atomic_t terminateSent = 0;
+static volatile sig_atomic_t injectSent = 0;
+
+static void terminateHandler(int signum)
+{
+  terminateSent = 1;
+}
+
+static void injectHandler(int signum)
+{
+  injectSent = 1;
+}
+
+// *** helpers
+
+// current time in ms
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static void sleepMs(long ms)
+{
+  if (ms > 0)
+    usleep(ms * 1000);
+}
+
+// deterministic random numbers in [0, 1)
+static unsigned long randomState = 1;
+static double random01()
+{
+  randomState = randomState * 1103515245 + 12345;
+  return ((randomState >> 16) & 0x7fff) / 32768.0;
+}
+
+// time for trace output (seconds modulo 1000000 with microseconds)
+static string timestamp()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return stringPrintf("%06ld.%06ld", (long)tv.tv_sec % 1000000,
+                      (long)tv.tv_usec);
+}
+
+static string visible(const string &s)
+{
+  string result;
+  for (string::const_iterator i = s.begin(); i != s.end(); ++i)
+    if (*i == '\r')
+      result += "\\r";
+    else if (*i == '\n')
+      result += "\\n";
+    else
+      result += *i;
+  return result;
+}
+
+static void send(const string &s)
+{
+  if (trace)
+    cerr << timestamp() << " --> " << visible(s) << endl;
+  size_t bytesWritten = 0;
+  while (bytesWritten < s.length())
+  {
+    ssize_t bw = write(master, s.data() + bytesWritten,
+                       s.length() - bytesWritten);
+    if (bw < 0 && errno != EINTR && errno != EAGAIN)
+      return;                   // nobody listening
+    if (bw > 0)
+      bytesWritten += bw;
+  }
+}
+
+// "+CMGS" in "+CMGS=12", "+CPBS" in "+CPBS?", "Z" in "Z"
+static string verbOf(const string &command)
+{
+  if (command.length() == 0 || (command[0] != '+' && command[0] != '&'))
+    return command.substr(0, 1);
+  string::size_type end = command.find_first_of("=?", 1);
+  return command.substr(0, end);
+}
+
+// normalize verb given on the command line
+static string normalizeVerb(string verb)
+{
+  for (string::iterator i = verb.begin(); i != verb.end(); ++i)
+    *i = toupper(*i);
+  if (verb == "ALL")
+    return "*";
+  if (verb.length() > 1 && isalpha(verb[0]))
+    verb = "+" + verb;
+  return verb;
+}
+
+// split VERB=value
+static void parseSetting(string setting, string &verb, string &value)
+{
+  string::size_type equal = setting.rfind('=');
+  if (equal == string::npos || equal == 0)
+    throw GsmException("expected VERB=value instead of '" + setting + "'",
+                       ParameterError);
+  verb = normalizeVerb(setting.substr(0, equal));
+  value = setting.substr(equal + 1);
+}
+
+static long latencyOf(const string &verb)
+{
+  map<string, long>::iterator i = commandLatency.find(verb);
+  return i == commandLatency.end() ? defaultLatency : i->second;
+}
+
+static bool injectError(const string &verb)
+{
+  map<string, double>::iterator i = errorRate.find(verb);
+  if (i == errorRate.end())
+    i = errorRate.find("*");
+  return i != errorRate.end() && random01() < i->second;
+}
+
+// split parameters at commas outside of quotes, remove quotes
+static vector<string> parameters(const string &s)
+{
+  vector<string> result(1);
+  bool quoted = false;
+  for (string::const_iterator i = s.begin(); i != s.end(); ++i)
+    if (*i == '"')
+      quoted = ! quoted;
+    else if (*i == ',' && ! quoted)
+      result.push_back("");
+    else
+      result.back() += *i;
+  return result;
+}
+
+static int intParameter(const vector<string> &p, unsigned int n,
+                        int defaultValue = -1)
+{
+  if (n >= p.size() || p[n] == "")
+    return defaultValue;
+  return atoi(p[n].c_str());
+}
+
+static string cmeError(int code)
+{
+  return cmee == 0 ? "ERROR" : "+CME ERROR: " + intToStr(code);
+}
+
+static string cmsError(int code)
+{
+  return cmee == 0 ? "ERROR" : "+CMS ERROR: " + intToStr(code);
+}
+
+static bool isSMSVerb(const string &verb)
+{
+  return verb.substr(0, 4) == "+CMG" || verb == "+CMSS" ||
+    verb == "+CPMS" || verb == "+CNMI" || verb == "+CSMS" ||
+    verb == "+CNMA" || verb == "+CSCA" || verb == "+CMMS";
+}
+
+// *** SMS store
+
+static int smsUsed()
+{
+  int result = 0;
+  for (vector<SMSSlot>::iterator i = smsStore.begin(); i != smsStore.end();
+       ++i)
+    if (i->_pdu != "")
+      ++result;
+  return result;
+}
+
+static string cpmsCounts()
+{
+  string s = intToStr(smsUsed()) + "," + intToStr(smsStore.size());
+  return s + "," + s + "," + s;
+}
+
+// store PDU in first free slot, return 1-based index or -1 if full
+static int storeSMS(const string &pdu, int status)
+{
+  for (unsigned int i = 0; i < smsStore.size(); ++i)
+    if (smsStore[i]._pdu == "")
+    {
+      smsStore[i]._pdu = pdu;
+      smsStore[i]._status = status;
+      return i + 1;
+    }
+  return -1;
+}
+
+// length of the TPDU (without SCA)
+static int tpduLength(const string &pdu)
+{
+  int scaLength = strtol(pdu.substr(0, 2).c_str(), NULL, 16);
+  return pdu.length() / 2 - 1 - scaLength;
+}
+
+static string smsPdu(int n, string text)
+{
+  SMSDeliverMessage message;
+  Address originator("+49170000" + intToStr(1000 + n));
+  Address serviceCentre("+491710760000");
+  Timestamp timestamp;
+  timestamp._year = 26;
+  timestamp._month = 10;
+  timestamp._day = 19;
+  timestamp._hour = 12;
+  timestamp._minute = n / 60 % 60;
+  timestamp._seconds = n % 60;
+  timestamp._timeZoneMinutes = 120;
+  message.setOriginatingAddress(originator);
+  message.setServiceCentreAddress(serviceCentre);
+  message.setServiceCentreTimestamp(timestamp);
+  message.setUserData(text + " " + intToStr(n));
+  return message.encode();
+}
+
+static void deliverSMS()
+{
+  ++incomingCount;
+  string pdu = smsPdu(incomingCount, "incoming message");
+  if (cnmi[1] == 2 || cnmi[1] == 3)
+    send("\r\n+CMT: ," + intToStr(tpduLength(pdu)) + "\r\n" + pdu + "\r\n");
+  else
+  {
+    int index = storeSMS(pdu, 0);
+    if (index == -1)
+    {
+      if (trace)
+        cerr << "*** SMS store full, incoming SMS lost" << endl;
+    }
+    else if (cnmi[1] == 1)
+      send("\r\n+CMTI: \"SM\"," + intToStr(index) + "\r\n");
+  }
+}
+
+// *** commands, return "" if successful or the final result code
+
+static string smsCommand(const string &verb, const string &arguments,
+                         string &response)
+{
+  vector<string> p = parameters(arguments.substr(1));
+  if (verb == "+CPMS")
+  {
+    if (arguments == "=?")
+      response += "+CPMS: (\"SM\"),(\"SM\"),(\"SM\")\r\n";
+    else if (arguments == "?")
+      response += "+CPMS: \"SM\"," + intToStr(smsUsed()) + "," +
+        intToStr(smsStore.size()) + ",\"SM\"," + intToStr(smsUsed()) + "," +
+        intToStr(smsStore.size()) + ",\"SM\"," + intToStr(smsUsed()) + "," +
+        intToStr(smsStore.size()) + "\r\n";
+    else
+    {
+      for (vector<string>::iterator i = p.begin(); i != p.end(); ++i)
+        if (*i != "SM")
+          return cmsError(302);
+      response += "+CPMS: " + cpmsCounts() + "\r\n";
+    }
+  }
+  else if (verb == "+CMGF")
+  {
+    if (arguments == "=?")
+      response += "+CMGF: (0)\r\n";
+    else if (arguments == "?")
+      response += "+CMGF: 0\r\n";
+    else if (intParameter(p, 0) != 0)
+      return cmsError(303);
+  }
+  else if (verb == "+CSMS")
+  {
+    if (arguments == "=?")
+      response += "+CSMS: (0,1)\r\n";
+    else if (arguments == "?")
+      response += "+CSMS: " + intToStr(csms) + ",1,1,1\r\n";
+    else
+    {
+      csms = intParameter(p, 0, 0);
+      response += "+CSMS: 1,1,1\r\n";
+    }
+  }
+  else if (verb == "+CNMI")
+  {
+    if (arguments == "=?")
+      response += "+CNMI: (0-2),(0-3),(0,2),(0-2),(0,1)\r\n";
+    else if (arguments == "?")
+      response += "+CNMI: " + intToStr(cnmi[0]) + "," + intToStr(cnmi[1]) +
+        "," + intToStr(cnmi[2]) + "," + intToStr(cnmi[3]) + "," +
+        intToStr(cnmi[4]) + "\r\n";
+    else
+    {
+      for (int i = 0; i < 5; ++i)
+        cnmi[i] = intParameter(p, i, 0);
+      // start delivering incoming SMS once indications are enabled
+      if (cnmi[1] != 0 && incomingLeft > 0 && nextIncoming == 0)
+        nextIncoming = now() + incomingInterval;
+    }
+  }
+  else if (verb == "+CNMA")
+  {
+    if (arguments == "=?")
+      response += verb + ": (0-2)\r\n";
+  }
+  else if (verb == "+CMMS")
+  {
+    if (! hasCMMS)
+      return "ERROR";
+    if (arguments == "=?")
+      response += verb + ": (0-2)\r\n";
+    else if (arguments == "?")
+      response += verb + ": " + intToStr(cmms) + "\r\n";
+    else if (intParameter(p, 0) < 0 || intParameter(p, 0) > 2)
+      return cmsError(302);
+    else if ((cmms = intParameter(p, 0)) == 0)
+      linkOpenUntil = 0;
+  }
+  else if (verb == "+CSCA")
+  {
+    if (arguments == "?")
+      response += "+CSCA: \"+491710760000\",145\r\n";
+  }
+  else if (verb == "+CMGR")
+  {
+    int index = intParameter(p, 0);
+    if (index < 1 || index > (int)smsStore.size() ||
+        smsStore[index - 1]._pdu == "")
+      return cmsError(321);
+    SMSSlot &slot = smsStore[index - 1];
+    response += "+CMGR: " + intToStr(slot._status) + ",," +
+      intToStr(tpduLength(slot._pdu)) + "\r\n" + slot._pdu + "\r\n";
+    if (slot._status == 0)
+      slot._status = 1;
+  }
+  else if (verb == "+CMGL")
+  {
+    if (arguments == "=?")
+    {
+      response += "+CMGL: (0-4)\r\n";
+      return "";
+    }
+    int status = intParameter(p, 0, 0);
+    for (unsigned int i = 0; i < smsStore.size(); ++i)
+      if (smsStore[i]._pdu != "" &&
+          (status == 4 || smsStore[i]._status == status))
+      {
+        response += "+CMGL: " + intToStr(i + 1) + "," +
+          intToStr(smsStore[i]._status) + ",," +
+          intToStr(tpduLength(smsStore[i]._pdu)) + "\r\n" +
+          smsStore[i]._pdu + "\r\n";
+        if (smsStore[i]._status == 0)
+          smsStore[i]._status = 1;
+      }
+  }
+  else if (verb == "+CMGD")
+  {
+    int index = intParameter(p, 0);
+    if (index < 1 || index > (int)smsStore.size())
+      return cmsError(321);
+    smsStore[index - 1]._pdu = "";
+  }
+  else if (verb == "+CMSS")
+  {
+    int index = intParameter(p, 0);
+    if (index < 1 || index > (int)smsStore.size() ||
+        smsStore[index - 1]._pdu == "")
+      return cmsError(321);
+    response += "+CMSS: " + intToStr(++messageReference % 256) + "\r\n";
+  }
+  else if (verb == "+CMGS" || verb == "+CMGW")
+  {
+    if (arguments == "=?")
+      return "";
+    pduMode = true;
+    pduVerb = verb;
+    pduStatus = intParameter(p, 1, 2);
+  }
+  else
+    return "ERROR";
+  return "";
+}
+
+static string phonebookCommand(const string &verb, const string &arguments,
+                               string &response)
+{
+  vector<string> p = parameters(arguments.substr(1));
+  int used = 0;
+  for (vector<PhonebookSlot>::iterator i = phonebook.begin();
+       i != phonebook.end(); ++i)
+    if (! i->empty())
+      ++used;
+
+  if (verb == "+CPBS")
+  {
+    if (arguments == "=?")
+      response += "+CPBS: (\"SM\")\r\n";
+    else if (arguments == "?")
+      response += "+CPBS: \"SM\"," + intToStr(used) + "," +
+        intToStr(phonebook.size()) + "\r\n";
+    else if (p[0] != "SM")
+      return cmeError(3);
+  }
+  else if (verb == "+CPBR")
+  {
+    if (arguments == "=?")
+    {
+      response += "+CPBR: (1-" + intToStr(phonebook.size()) + "),20,18\r\n";
+      return "";
+    }
+    int first = intParameter(p, 0);
+    int last = intParameter(p, 1, first);
+    if (first < 1 || last > (int)phonebook.size() || last < first)
+      return cmeError(21);
+    for (int i = first; i <= last; ++i)
+      if (! phonebook[i - 1].empty())
+        response += "+CPBR: " + intToStr(i) + ",\"" +
+          phonebook[i - 1]._number + "\"," +
+          intToStr(phonebook[i - 1]._type) + ",\"" +
+          phonebook[i - 1]._text + "\"\r\n";
+  }
+  else if (verb == "+CPBF")
+  {
+    if (arguments == "=?")
+    {
+      response += "+CPBF: 20,18\r\n";
+      return "";
+    }
+    string text = lowercase(p[0]);
+    for (unsigned int i = 0; i < phonebook.size(); ++i)
+      if (! phonebook[i].empty() &&
+          lowercase(phonebook[i]._text).substr(0, text.length()) == text)
+        response += "+CPBF: " + intToStr(i + 1) + ",\"" +
+          phonebook[i]._number + "\"," + intToStr(phonebook[i]._type) +
+          ",\"" + phonebook[i]._text + "\"\r\n";
+  }
+  else if (verb == "+CPBW")
+  {
+    if (arguments == "=?")
+    {
+      response += "+CPBW: (1-" + intToStr(phonebook.size()) +
+        "),20,(129,145),18\r\n";
+      return "";
+    }
+    int index = intParameter(p, 0);
+    if (index == -1)
+    {
+      // first free slot
+      for (unsigned int i = 0; i < phonebook.size() && index == -1; ++i)
+        if (phonebook[i].empty())
+          index = i + 1;
+      if (index == -1)
+        return cmeError(20);
+    }
+    if (index < 1 || index > (int)phonebook.size())
+      return cmeError(21);
+    PhonebookSlot &slot = phonebook[index - 1];
+    slot._number = p.size() > 1 ? p[1] : "";
+    slot._type = intParameter(p, 2, 129);
+    slot._text = p.size() > 3 ? p[3] : "";
+  }
+  else
+    return "ERROR";
+  return "";
+}
+
+static string command(const string &command, string &response)
+{
+  string verb = verbOf(command);
+  string arguments = command.substr(verb.length());
+  if (injectError(verb))
+    return isSMSVerb(verb) ? cmsError(500) : cmeError(100);
+
+  if (verb == "Z")
+  {
+    echo = true;
+    cmee = 0;
+    cmms = 0;
+  }
+  else if (verb == "E")
+    echo = arguments != "0";
+  else if (verb == "I")
+    response += "gsmlib modem simulator\r\n";
+  else if (verb == "+CMEE")
+    cmee = atoi(arguments.substr(1).c_str());
+  else if (verb == "+CGMI" || verb == "+GMI")
+    response += "gsmlib\r\n";
+  else if (verb == "+CGMM" || verb == "+GMM")
+    response += "Modem simulator\r\n";
+  else if (verb == "+CGMR" || verb == "+GMR")
+    response += string(VERSION) + "\r\n";
+  else if (verb == "+CGSN" || verb == "+GSN")
+    response += "000000000000001\r\n";
+  else if (verb == "+CSCS")
+  {
+    if (arguments == "=?")
+      response += "+CSCS: (\"GSM\")\r\n";
+    else if (arguments == "?")
+      response += "+CSCS: \"GSM\"\r\n";
+    else if (arguments != "=\"GSM\"")
+      return cmeError(4);
+  }
+  else if (verb == "+CPIN")
+  {
+    if (arguments == "?")
+      response += "+CPIN: READY\r\n";
+  }
+  else if (verb == "+CFUN")
+  {
+    if (arguments == "?")
+      response += "+CFUN: 1\r\n";
+  }
+  else if (verb == "+CBC")
+    response += "+CBC: 0,100\r\n";
+  else if (verb == "+CSQ")
+    response += "+CSQ: 20,99\r\n";
+  else if (verb == "+COPS")
+  {
+    static const char *names[] = {"\"Simulated Network\"", "\"SimNet\"",
+                                  "\"00101\""};
+    vector<string> p = parameters(arguments.substr(1));
+    if (arguments == "=?")
+      response += "+COPS: (2,\"Simulated Network\",\"SimNet\",\"00101\"),"
+        "(1,\"Other Network\",\"Other\",\"00102\"),,(0-4),(0-2)\r\n";
+    else if (arguments == "?")
+      response += "+COPS: 0," + intToStr(copsFormat) + "," +
+        names[copsFormat] + "\r\n";
+    else if (intParameter(p, 0) == 3)
+      copsFormat = intParameter(p, 1, 0) % 3;
+  }
+  else if (verb.substr(0, 4) == "+CPB")
+    return phonebookCommand(verb, arguments, response);
+  else if (isSMSVerb(verb))
+    return smsCommand(verb, arguments, response);
+  else if (verb[0] == '+')
+    return cmeError(100);
+  // other basic commands (D, H, &F, ...) are accepted and ignored
+  return "";
+}
+
+// split command line (without "AT") into basic and extended commands
+static vector<string> commands(const string &line)
+{
+  vector<string> result;
+  string::size_type i = 0;
+  while (i < line.length())
+  {
+    if (line[i] == '+')
+    {
+      // extended command up to ';' outside of quotes
+      string::size_type end = i;
+      bool quoted = false;
+      while (end < line.length() && (quoted || line[end] != ';'))
+        if (line[end++] == '"')
+          quoted = ! quoted;
+      result.push_back(line.substr(i, end - i));
+      i = end + 1;
+    }
+    else
+    {
+      // basic command: letter (or & letter) and digits
+      string::size_type end = i + (line[i] == '&' ? 2 : 1);
+      while (end < line.length() && isdigit(line[end]))
+        ++end;
+      result.push_back(line.substr(i, end - i));
+      i = end;
+    }
+  }
+  return result;
+}
+
+static void commandLine(string line)
+{
+  if (trace)
+    cerr << timestamp() << " <-- " << line << endl;
+  if (echo)
+    send(line + "\r");
+  if (line.length() < 2 || toupper(line[0]) != 'A' || toupper(line[1]) != 'T')
+  {
+    send("\r\nERROR\r\n");
+    return;
+  }
+
+  // extended command names are not case sensitive
+  string upper = line.substr(2);
+  bool quoted = false;
+  for (string::iterator i = upper.begin(); i != upper.end(); ++i)
+    if (*i == '"')
+      quoted = ! quoted;
+    else if (! quoted)
+      *i = toupper(*i);
+
+  vector<string> c = commands(upper);
+  string response, result;
+  long latency = 0;
+  for (vector<string>::iterator i = c.begin();
+       i != c.end() && result == "" && ! pduMode; ++i)
+  {
+    latency += latencyOf(verbOf(*i));
+    result = command(*i, response);
+  }
+
+  if (pduMode)
+  {
+    // the latency of +CMGS and +CMGW applies when the PDU is complete
+    send("\r\n> ");
+    return;
+  }
+  sleepMs(latency);
+  if (result == "")
+    result = "OK";
+  string s;
+  string::size_type start = 0, end;
+  while ((end = response.find("\r\n", start)) != string::npos)
+  {
+    s += "\r\n" + response.substr(start, end - start + 2);
+    start = end + 2;
+  }
+  send(s + "\r\n" + result + "\r\n");
+}
+
+// return ms to set up the relay link for an SMS sent now, with +CMMS=1
+// the mode falls back to 0 once the link has been released
+static long relayLinkSetup()
+{
+  if (linkOpenUntil != 0 && now() < linkOpenUntil)
+    return 0;
+  if (cmms == 1 && linkOpenUntil != 0)
+    cmms = 0;
+  return linkSetup;
+}
+
+static void pdu(string pdu, bool cancelled)
+{
+  pduMode = false;
+  if (trace)
+    cerr << timestamp() << " <-- " << pdu
+         << (cancelled ? "<ESC>" : "<^Z>") << endl;
+  if (cancelled)
+  {
+    send("\r\nOK\r\n");
+    return;
+  }
+
+  if (pduVerb == "+CMGS")
+  {
+    sleepMs(latencyOf(pduVerb) + relayLinkSetup());
+    linkOpenUntil = cmms != 0 ? now() + LINK_HOLD_MS : 0;
+    send("\r\n+CMGS: " + intToStr(++messageReference % 256) +
+         "\r\n\r\nOK\r\n");
+  }
+  else
+  {
+    sleepMs(latencyOf(pduVerb));
+    int index = storeSMS(pdu, pduStatus);
+    if (index == -1)
+      send("\r\n" + cmsError(322) + "\r\n");
+    else
+      send("\r\n+CMGW: " + intToStr(index) + "\r\n\r\nOK\r\n");
+  }
+}
+
+// *** main program
+
+static void usage(const char *name)
+{
+  cerr << name << ": [-c verb=ms][-e verb=probability][-h]"
+    "[-i count][-I ms][-k ms][-l ms]\n"
+    "  [-N][-p size][-P used][-r seed][-s size][-S used][-t] -L link"
+       << endl << endl
+       << "  -c, --command-latency latency of one command in ms (repeatable)"
+       << endl
+       << "  -e, --error       probability of an error for a command"
+    " (repeatable,\n"
+    "                    verb ALL for all commands)" << endl
+       << "  -h, --help        prints this message" << endl
+       << "  -i, --incoming    number of SMS to deliver after +CNMI"
+    " (default: 0)" << endl
+       << "  -I, --interval    ms between incoming SMS (default: 1000)"
+       << endl
+       << "  -k, --link-setup  ms to set up the relay link for an SMS"
+    " unless +CMMS\n"
+    "                    keeps it open (default: 0)" << endl
+       << "  -l, --latency     latency of all commands in ms (default: 0)"
+       << endl
+       << "  -L, --link        symbolic link to create for the PTY" << endl
+       << "  -N, --no-cmms     answer +CMMS with ERROR like older MEs" << endl
+       << "  -p, --pb-size     phonebook size (default: 100)" << endl
+       << "  -P, --pb-used     phonebook entries at start (default: 0)"
+       << endl
+       << "  -r, --seed        seed for error injection (default: 1)"
+       << endl
+       << "  -s, --sms-size    SMS store size (default: 30)" << endl
+       << "  -S, --sms-used    SMS at start (default: 0)" << endl
+       << "  -t, --trace       log dialogue to stderr" << endl
+       << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  int result = 0;
+  try
+  {
+    int smsSize = 30, smsPreloaded = 0, pbSize = 100, pbPreloaded = 0;
+    int opt;
+    int dummy;
+    string verb, value;
+    while ((opt = getopt_long(argc, argv, "L:l:c:e:r:s:S:p:P:i:I:k:Nth",
+                              longOpts, &dummy)) != -1)
+      switch (opt)
+      {
+      case 'L':
+        linkName = optarg;
+        break;
+      case 'l':
+        defaultLatency = checkNumber(optarg);
+        break;
+      case 'c':
+        parseSetting(optarg, verb, value);
+        commandLatency[verb] = checkNumber(value);
+        break;
+      case 'e':
+        parseSetting(optarg, verb, value);
+        errorRate[verb] = atof(value.c_str());
+        break;
+      case 'r':
+        randomState = checkNumber(optarg);
+        break;
+      case 's':
+        smsSize = checkNumber(optarg);
+        break;
+      case 'S':
+        smsPreloaded = checkNumber(optarg);
+        break;
+      case 'p':
+        pbSize = checkNumber(optarg);
+        break;
+      case 'P':
+        pbPreloaded = checkNumber(optarg);
+        break;
+      case 'i':
+        incomingLeft = checkNumber(optarg);
+        break;
+      case 'I':
+        incomingInterval = checkNumber(optarg);
+        break;
+      case 'k':
+        linkSetup = checkNumber(optarg);
+        break;
+      case 'N':
+        hasCMMS = false;
+        break;
+      case 't':
+        trace = true;
+        break;
+      case 'h':
+        usage(argv[0]);
+        return 0;
+      case '?':
+        usage(argv[0]);
+        return 1;
+      }
+    if (linkName == "")
+      throw GsmException("link name must be given", ParameterError);
+    if (smsPreloaded > smsSize || pbPreloaded > pbSize)
+      throw GsmException("more entries than store size", ParameterError);
+
+    smsStore.resize(smsSize);
+    for (int i = 0; i < smsPreloaded; ++i)
+      storeSMS(smsPdu(i + 1, "stored message"), 1);
+    phonebook.resize(pbSize);
+    for (int i = 0; i < pbPreloaded; ++i)
+    {
+      phonebook[i]._number = "0123" + intToStr(1000 + i + 1);
+      phonebook[i]._type = 129;
+      phonebook[i]._text = "Name " + intToStr(i + 1);
+    }
+
+    // create PTY, keep the slave open so that the master stays usable
+    // when clients close it
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master == -1 || grantpt(master) != 0 || unlockpt(master) != 0)
+      throw GsmException("cannot create PTY", OSError, errno);
+    string slaveName = ptsname(master);
+    int slave = open(slaveName.c_str(), O_RDWR | O_NOCTTY);
+    struct termios t;
+    if (slave == -1 || tcgetattr(slave, &t) != 0)
+      throw GsmException("cannot open PTY " + slaveName, OSError, errno);
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+
+    unlink(linkName.c_str());
+    if (symlink(slaveName.c_str(), linkName.c_str()) != 0)
+      throw GsmException("cannot create link " + linkName, OSError, errno);
+
+    signal(SIGINT, terminateHandler);
+    signal(SIGTERM, terminateHandler);
+    signal(SIGUSR1, injectHandler);
+
+    string input;
+    while (! terminateSent)
+    {
+      if (! pduMode && injectSent)
+      {
+        injectSent = 0;
+        deliverSMS();
+      }
+      if (! pduMode && nextIncoming != 0 && now() >= nextIncoming)
+      {
+        deliverSMS();
+        nextIncoming = --incomingLeft > 0 ? now() + incomingInterval : 0;
+      }
+
+      // wait for input or the next incoming SMS
+      struct timeval timeout = {1, 0};
+      if (nextIncoming != 0)
+      {
+        double wait = nextIncoming - now();
+        if (wait < 0)
+          wait = 0;
+        timeout.tv_sec = (long)wait / 1000;
+        timeout.tv_usec = ((long)wait % 1000) * 1000;
+      }
+      fd_set fds;
+      FD_ZERO(&fds);
+      FD_SET(master, &fds);
+      if (select(master + 1, &fds, NULL, NULL, &timeout) <= 0)
+        continue;
+      char buffer[1024];
+      ssize_t res = read(master, buffer, sizeof(buffer));
+      if (res <= 0)
+        continue;
+      input.append(buffer, res);
+
+      // handle complete command lines and PDUs
+      for (;;)
+      {
+        string::size_type end;
+        if (pduMode)
+        {
+          end = input.find_first_of("\032\033");
+          if (end == string::npos)
+            break;
+          bool cancelled = input[end] == '\033';
+          string data = input.substr(0, end);
+          input.erase(0, end + 1);
+          pdu(data, cancelled);
+        }
+        else
+        {
+          end = input.find('\r');
+          if (end == string::npos)
+            break;
+          string line = input.substr(0, end);
+          input.erase(0, end + 1);
+          string::size_type start = line.find_first_not_of(" \n");
+          if (start != string::npos)
+            commandLine(line.substr(start));
+        }
+      }
+    }
+    close(slave);
+  }
+  catch (GsmException &ge)
+  {
+    cerr << argv[0] << ": " << ge.what() << endl;
+    result = 1;
+  }
+  if (linkName != "")
+    unlink(linkName.c_str());
+  return result;
+}
@@ -0,0 +1,7 @@
+#!/bin/sh
+
+# run the test
+./testcmux > testcmux.log
+
+# check if output differs from what it should be
+diff testcmux.log testcmux-output.txt
@@ -0,0 +1,7 @@
+#!/bin/sh
+
+# run the test
+./testevent > testevent.log
+
+# check if output differs from what it should be
+diff testevent.log testevent-output.txt
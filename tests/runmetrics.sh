@@ -0,0 +1,7 @@
+#!/bin/sh
+
+# run the test
+./testmetrics > testmetrics.log
+
+# check if output differs from what it should be
+diff testmetrics.log testmetrics-output.txt
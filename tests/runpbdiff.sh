@@ -0,0 +1,7 @@
+#!/bin/sh
+
+# run the test
+./testpbdiff > testpbdiff.log
+
+# check if output differs from what it should be
+diff testpbdiff.log testpbdiff-output.txt
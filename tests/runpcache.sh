@@ -0,0 +1,19 @@
+#!/bin/sh
+
+errorexit() {
+    echo $1
+    exit 1
+}
+
+rm -rf pcache.d || errorexit "could not delete pcache.d"
+mkdir pcache.d || errorexit "could not create pcache.d"
+
+# run the test
+./testpcache > testpcache.log
+
+# add contents of the cache directory to the test log
+ls pcache.d >> testpcache.log
+cat pcache.d/* >> testpcache.log
+
+# check if output differs from what it should be
+diff testpcache.log testpcache-output.txt
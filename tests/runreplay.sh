@@ -0,0 +1,8 @@
+#!/bin/sh
+
+# run the test
+./testreplay > testreplay.log
+rm -f replay.trace
+
+# check if output differs from what it should be
+diff testreplay.log testreplay-output.txt
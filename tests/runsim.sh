@@ -0,0 +1,126 @@
+#!/bin/sh
+
+# run the apps against the ME/TA simulator (gsmsim)
+# with --time print how long each step takes instead of checking the
+# output, options for gsmsim can be given in SIM_OPTIONS
+# (eg. SIM_OPTIONS="--latency 50 --command-latency CMGS=2000")
+
+apps=../apps
+timing=no
+if [ "$1" = "--time" ]; then
+  timing=yes
+fi
+
+startsim()
+{
+  rm -f sim.tty
+  ./gsmsim --link sim.tty $SIM_OPTIONS "$@" &
+  simpid=$!
+  tries=0
+  while [ ! -h sim.tty -a $tries -lt 50 ]; do
+    sleep 0.1
+    tries=`expr $tries + 1`
+  done
+}
+
+stopsim()
+{
+  kill $simpid
+  wait $simpid
+}
+
+# run a step, print its output (without program name) or the time it took
+run()
+{
+  name=$1
+  shift
+  start=`date +%s%N`
+  "$@" > sim.out 2>&1
+  status=$?
+  end=`date +%s%N`
+  if [ $timing = yes ]; then
+    echo "$name: `expr \( $end - $start \) / 1000000` ms"
+  else
+    echo "*** $name (exit status $status)"
+    sed "s/[^ ]*\\[ERROR\\]/[ERROR]/" sim.out
+  fi
+}
+
+# wait until gsmsmsd has handled count SMS
+receive()
+{
+  count=$1
+  shift
+  rm -f sim.received
+  "$@" &
+  smsdpid=$!
+  tries=0
+  while [ `cat sim.received 2>/dev/null | grep -c "User data:"` -lt $count \
+          -a $tries -lt 100 ]; do
+    sleep 0.1
+    tries=`expr $tries + 1`
+  done
+  # gsmsmsd exits only after its event timeout on SIGTERM
+  kill -KILL $smsdpid
+  wait $smsdpid 2>/dev/null
+  grep "User data:" sim.received
+}
+
+steps()
+{
+  # ME information, phonebook, and SMS store
+  startsim --sms-used 3 --pb-used 5
+  run "gsmctl" $apps/gsmctl -d sim.tty me op currop sig
+  run "gsmsmsstore list" \
+    env GSMLIB_TRACE=sim.json $apps/gsmsmsstore -s sim.tty -t SM -l
+  [ $timing = yes ] ||
+    grep -o '"name":"[^"]*","cat":"\(pdu\|store\)"' sim.json | sort | uniq -c
+  run "gsmsendsms" $apps/gsmsendsms -d sim.tty +4917012345 "hello world"
+  : > sim.pb
+  run "gsmpb copy to file" $apps/gsmpb -s sim.tty -p SM -d sim.pb
+  [ $timing = yes ] || cat sim.pb
+  sed -e 's/Name 2/Renamed/' -e '/Name 5/d' sim.pb > sim2.pb
+  echo "|New entry|0987654" >> sim2.pb
+  run "gsmpb synchronize" $apps/gsmpb -y -s sim2.pb -d sim.tty -p SM
+  run "gsmpb read" $apps/gsmpb -s sim.tty -p SM -d -
+  : > sim.sms
+  run "gsmsmsstore backup" \
+    $apps/gsmsmsstore -s sim.tty -t SM -k -d sim.sms
+  run "gsmsmsstore list backup" \
+    sh -c "$apps/gsmsmsstore -s sim.sms -l | grep 'User data:'"
+  stopsim
+
+  # incoming SMS
+  startsim --incoming 5 --interval 0
+  run "gsmsmsd" receive 5 $apps/gsmsmsd -d sim.tty -a "cat >> sim.received"
+  stopsim
+
+  # error injection
+  startsim --error CSQ=1
+  run "gsmctl with error" \
+    env GSMLIB_METRICS=sim.prom $apps/gsmctl -d sim.tty sig
+  stopsim
+  [ $timing = yes ] ||
+    grep -e "errors_total{" -e "_count{verb=\"+CSQ\"}" sim.prom
+
+  # record a session and replay it without the simulator
+  startsim
+  run "gsmctl recorded" \
+    env GSMLIB_RECORD=sim.trace $apps/gsmctl -d sim.tty me op sig
+  stopsim
+  run "gsmctl replayed" \
+    env GSMLIB_REPLAY_SPEED=0 $apps/gsmctl -d replay:sim.trace me op sig
+}
+
+if [ $timing = yes ]; then
+  steps
+else
+  steps > testsim.log 2>&1
+fi
+rm -f sim.tty sim.out sim.pb sim2.pb sim.sms sim.received sim.trace \
+  sim.prom sim.json
+
+# check if output differs from what it should be
+if [ $timing = no ]; then
+  diff testsim.log testsim-output.txt
+fi
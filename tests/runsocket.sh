@@ -0,0 +1,7 @@
+#!/bin/sh
+
+# run the test
+./testsocket > testsocket.log
+
+# check if output differs from what it should be
+diff testsocket.log testsocket-output.txt
@@ -0,0 +1,18 @@
+#!/bin/sh
+
+errorexit() {
+    echo $1
+    exit 1
+}
+
+rm -f sri.idx sri2.idx || errorexit "could not delete sri.idx"
+
+# run the test
+./testsri > testsri.log
+
+# add contents of the compacted index file to the test log
+cat sri.idx >> testsri.log
+rm -f sri2.idx
+
+# check if output differs from what it should be
+diff testsri.log testsri-output.txt
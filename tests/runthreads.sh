@@ -0,0 +1,38 @@
+#!/bin/sh
+
+# share one MeTa between threads that receive SMS, send replies, and
+# query the ME/TA simulator (gsmsim) at the same time, then between a
+# thread receiving +CMTI indications and one reading the SMS store
+rm -f threads.tty
+./gsmsim --link threads.tty --incoming 5 --interval 50 &
+simpid=$!
+tries=0
+while [ ! -h threads.tty -a $tries -lt 50 ]; do
+  sleep 0.1
+  tries=`expr $tries + 1`
+done
+
+# run the test
+./testthreads threads.tty > testthreads.log 2>&1
+
+kill $simpid
+wait $simpid
+rm -f threads.tty
+
+# the same with SMS stored in the ME and indicated by +CMTI
+./gsmsim --link threads.tty --incoming 5 --interval 50 &
+simpid=$!
+tries=0
+while [ ! -h threads.tty -a $tries -lt 50 ]; do
+  sleep 0.1
+  tries=`expr $tries + 1`
+done
+
+./testthreads threads.tty indications >> testthreads.log 2>&1
+
+kill $simpid
+wait $simpid
+rm -f threads.tty
+
+# check if output differs from what it should be
+diff testthreads.log testthreads-output.txt
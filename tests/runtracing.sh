@@ -0,0 +1,8 @@
+#!/bin/sh
+
+# run the test
+./testtracing > testtracing.log
+rm -f tracing.json
+
+# check if output differs from what it should be
+diff testtracing.log testtracing-output.txt
@@ -0,0 +1,353 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testcmux.cc
+// *
+// * Purpose: Test GSM 07.10 multiplexer against an emulated ME on a PTY
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_cmux_port.h>
+#include <gsmlib/gsm_event.h>
+#include <gsmlib/gsm_me_ta.h>
+#include <gsmlib/gsm_sms.h>
+#include <gsmlib/gsm_unix_serial.h>
+#include <iostream>
+#include <map>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace gsmlib;
+
+// *** emulated ME (runs in the child process on the PTY master)
+
+// number of SMS sent on DLC 3, the last one is indicated on DLC 4
+static const int Messages = 5;
+
+static int master;
+static map<int, bool> pduMode;  // DLC waits for PDU after "> "
+static int messageReference = 0;
+
+static unsigned char crc(const string &data)
+{
+  unsigned char result = 0xff;
+  for (string::const_iterator i = data.begin(); i != data.end(); ++i)
+  {
+    result ^= (unsigned char)*i;
+    for (int bit = 0; bit < 8; ++bit)
+      result = (result & 1) ? (result >> 1) ^ 0xe0 : result >> 1;
+  }
+  return result;
+}
+
+static void sendRaw(const string &s)
+{
+  if (write(master, s.data(), s.length()) != (ssize_t)s.length())
+    _exit(1);
+}
+
+// frame from the ME, corrupt the FCS if bad is true
+static void sendFrame(int dlci, unsigned char control, const string &info,
+                      bool bad = false)
+{
+  string header;
+  header += (char)((dlci << 2) | 0x01);
+  header += (char)control;
+  header += (char)((info.length() << 1) | 0x01);
+  string frame = "\xf9" + header + info;
+  frame += (char)(0xff - crc(header) + (bad ? 1 : 0));
+  frame += '\xf9';
+  sendRaw(frame);
+}
+
+// respond to a complete AT command line received on dlci
+static void command(int dlci, const string &line)
+{
+  if (line == "AT+COPS=?")
+  {
+    // an unsolicited result code on DLC 2 (after a corrupt frame) arrives
+    // while DLC 1 waits for the answer, the answer is split in two frames
+    sendFrame(2, 0xef, "\r\nBAD\r\n", true);
+    sendFrame(2, 0xef, "\r\n+CMTI: \"SM\",3\r\n");
+    sendFrame(1, 0xef, "\r\n+COPS: (2,\"Fake\",");
+    sendFrame(1, 0xef, ",\"26201\")\r\n\r\nOK\r\n");
+  }
+  else if (line.substr(0, 5) == "AT+LN")
+    sendFrame(dlci, 0xef, "\r\n+LN: " + intToStr(line.length()) +
+              "\r\n\r\nOK\r\n");
+  // the commands that a MeTa needs
+  else if (line == "AT")
+    sendFrame(dlci, 0xef, "\r\nOK\r\n");
+  else if (line == "AT+CSMS?")
+    sendFrame(dlci, 0xef, "\r\n+CSMS: 0,1,1,1\r\n\r\nOK\r\n");
+  else if (line.substr(0, 8) == "AT+CMGS=")
+  {
+    sendFrame(dlci, 0xef, "\r\n> ");
+    pduMode[dlci] = true;
+  }
+  else if (dlci >= 3 && (line.substr(0, 4) == "AT+G" ||
+                         line.substr(0, 5) == "AT+CG"))
+    sendFrame(dlci, 0xef, "\r\nFake\r\n\r\nOK\r\n");
+  else if (dlci >= 3 && line.find('?') != string::npos)
+    sendFrame(dlci, 0xef, "\r\nERROR\r\n");
+  else if (dlci >= 3)
+    sendFrame(dlci, 0xef, "\r\nOK\r\n");
+  else
+    sendFrame(dlci, 0xef, "\r\n[" + intToStr(dlci) + "] " + line +
+              "\r\n\r\nOK\r\n");
+}
+
+static void emulator()
+{
+  string buffer;
+  bool mux = false;
+  map<int, string> lines;
+  char c;
+  while (read(master, &c, 1) == 1)
+  {
+    buffer += c;
+    if (! mux)
+    {
+      // AT command mode
+      string::size_type cr = buffer.find('\r');
+      if (cr == string::npos)
+        continue;
+      string line = buffer.substr(0, cr);
+      buffer.erase(0, cr + 1);
+      sendRaw("\r\nOK\r\n");
+      mux = line == "AT+CMUX=0";
+      continue;
+    }
+
+    // multiplexer mode, frames sent by CmuxPort have a one byte length
+    while (buffer.length() > 0 && (unsigned char)buffer[0] != 0xf9)
+      buffer.erase(0, 1);
+    while (buffer.length() > 1 && (unsigned char)buffer[1] == 0xf9)
+      buffer.erase(0, 1);
+    if (buffer.length() < 4)
+      continue;
+    unsigned int length = (unsigned char)buffer[3] >> 1;
+    if (buffer.length() < length + 6)
+      continue;
+    int dlci = (unsigned char)buffer[1] >> 2;
+    unsigned char control = buffer[2] & ~0x10;
+    string info = buffer.substr(4, length);
+    if (crc(buffer.substr(1, 3) + buffer[4 + length]) != 0xcf)
+      _exit(2);
+    buffer.erase(0, length + 5);
+
+    if (control == 0x2f)        // SABM
+      sendFrame(dlci, dlci == 9 ? 0x1f : 0x73, "");
+    else if (control == 0x43)   // DISC
+      sendFrame(dlci, 0x73, "");
+    else if (control == 0xef && dlci == 0)
+    {
+      // answer control channel commands
+      if (info[0] & 0x02)
+      {
+        string response = info;
+        response[0] &= ~0x02;
+        sendFrame(0, 0xef, response);
+      }
+      if ((info[0] & ~0x02) == (char)0xc1)
+        _exit(0);               // CLD
+    }
+    else if (control == 0xef)
+    {
+      lines[dlci] += info;
+      string::size_type end;
+      while (true)
+        if (pduMode[dlci])
+        {
+          // PDU up to ^Z
+          if ((end = lines[dlci].find('\032')) == string::npos)
+            break;
+          lines[dlci].erase(0, end + 1);
+          pduMode[dlci] = false;
+          sendFrame(dlci, 0xef, "\r\n+CMGS: " + intToStr(++messageReference) +
+                    "\r\n\r\nOK\r\n");
+          if (messageReference == Messages)
+            sendFrame(4, 0xef, "\r\n+CMTI: \"SM\",1\r\n");
+        }
+        else
+        {
+          if ((end = lines[dlci].find('\r')) == string::npos)
+            break;
+          command(dlci, lines[dlci].substr(0, end));
+          lines[dlci].erase(0, end + 1);
+        }
+    }
+  }
+  _exit(0);
+}
+
+// *** test program
+
+// read the response to a command up to OK
+static void printResponse(Ref<Port> port, string name)
+{
+  string line;
+  while ((line = port->getLine()) != "OK")
+    if (line != "")
+      cout << name << ": " << line << endl;
+}
+
+// time of day in milliseconds
+static long milliseconds()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+}
+
+// the waiter thread waits for events on DLC 4 while the main thread sends
+// SMS on DLC 3
+
+static string indication;       // set by the waiter thread
+
+class IndicationEvent : public GsmEvent
+{
+public:
+  bool _received;
+
+  IndicationEvent() : _received(false) {}
+
+  void SMSReceptionIndication(string storeName, unsigned int index,
+                              SMSMessageType messageType)
+    {
+      indication = storeName + " " + intToStr(index);
+      _received = true;
+    }
+};
+
+static void *waitForIndication(void *arg)
+{
+  MeTa &meTa = *(MeTa*)arg;
+  IndicationEvent events;
+  meTa.setEventHandler(&events);
+  try
+  {
+    // give up after 20 seconds
+    for (int i = 0; i < 20 && ! events._received; ++i)
+    {
+      struct timeval timeout = {1, 0};
+      meTa.waitEvent(&timeout);
+    }
+  }
+  catch (GsmException &ge)
+  {
+    indication = string("GsmException '") + ge.what() + "'";
+  }
+  meTa.setEventHandler(NULL);
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master == -1 || grantpt(master) != 0 || unlockpt(master) != 0)
+  {
+    cerr << "cannot create PTY" << endl;
+    return 1;
+  }
+  string slave = ptsname(master);
+
+  pid_t pid = fork();
+  if (pid == 0)
+    emulator();
+
+  int result = 0;
+  try
+  {
+    Ref<CmuxPort> mux =
+      new CmuxPort(new UnixSerialPort(slave, B38400, DEFAULT_INIT_STRING,
+                                      false, true));
+    cout << "multiplexer open" << endl;
+
+    Ref<Port> commands = mux->openChannel(1);
+    Ref<Port> events = mux->openChannel(2);
+    cout << "DLC 1 and 2 open" << endl;
+
+    try
+    {
+      mux->openChannel(9);
+    }
+    catch (GsmException &ge)
+    {
+      cout << "DLC 9: " << ge.what() << endl;
+    }
+
+    // DLC 2 receives the URC while DLC 1 reads its response
+    commands->putLine("AT+COPS=?");
+    printResponse(commands, "DLC 1");
+    struct timeval noWait = {0, 0};
+    cout << "DLC 2 has data: " << events->wait(&noWait) << endl;
+    events->getLine();
+    cout << "DLC 2: " << events->getLine() << endl;
+    cout << "DLC 2 has data: " << events->wait(&noWait) << endl;
+
+    // commands longer than one frame
+    commands->putLine("AT+LN=" + string(70, 'x'));
+    printResponse(commands, "DLC 1");
+
+    // both channels in turn
+    events->putLine("AT+CSQ");
+    commands->putLine("AT+CPAS");
+    printResponse(commands, "DLC 1");
+    printResponse(events, "DLC 2");
+
+    // a MeTa sends SMS on DLC 3 while another one waits for events on
+    // DLC 4 in a second thread
+    {
+      MeTa sender(mux->openChannel(3));
+      MeTa waiter(mux->openChannel(4));
+      pthread_t waiterThread;
+      pthread_create(&waiterThread, NULL, waitForIndication, &waiter);
+      long slowest = 0;
+      for (int i = 0; i < Messages; ++i)
+      {
+        long start = milliseconds();
+        Ref<SMSSubmitMessage> message =
+          new SMSSubmitMessage("message " + intToStr(i), "+491700000000");
+        sender.sendSMS(message);
+        slowest = max(slowest, milliseconds() - start);
+      }
+      pthread_join(waiterThread, NULL);
+      cout << "DLC 3: sent " << Messages << " SMS, "
+           << (slowest < 100 ? "none" : "some")
+           << " waited for a receive slice" << endl;
+      cout << "DLC 4: indication " << indication << endl;
+    }
+
+    commands = Ref<Port>();
+    cout << "DLC 1 closed" << endl;
+    events->putLine("ATI");
+    printResponse(events, "DLC 2");
+    events = Ref<Port>();
+    mux->close();
+    cout << "multiplexer closed" << endl;
+  }
+  catch (GsmException &ge)
+  {
+    cout << "GsmException '" << ge.what() << "'" << endl;
+    kill(pid, SIGKILL);
+    result = 1;
+  }
+
+  int status;
+  if (waitpid(pid, &status, 0) == pid && WIFEXITED(status))
+    cout << "emulator exit status " << WEXITSTATUS(status) << endl;
+  else
+    cout << "emulator did not exit" << endl;
+  return result;
+}
@@ -0,0 +1,181 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testevent.cc
+// *
+// * Purpose: Test dispatching unsolicited result codes
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_at.h>
+#include <gsmlib/gsm_event.h>
+#include <gsmlib/gsm_me_ta.h>
+#include <gsmlib/gsm_port.h>
+#include <iostream>
+#include <map>
+
+using namespace std;
+using namespace gsmlib;
+
+// *** scripted TA
+
+// ScriptPort answers each line written with the lines given to
+// respond(), or with "OK" for unknown commands
+class ScriptPort : public Port
+{
+  map<string, vector<string> > _responses;
+  vector<string> _pending;      // answer to the last line written
+
+public:
+  // answer line with lines separated by '\n'
+  void respond(string line, string lines);
+
+  string getLine();
+  void putLine(string line, bool carriageReturn = true);
+  bool wait(GsmTime timeout) {return true;}
+  void putBack(unsigned char c) {}
+  int readByte() {return -1;}
+  void setTimeOut(unsigned int timeout) {}
+};
+
+void ScriptPort::respond(string line, string lines)
+{
+  vector<string> &response = _responses[line];
+  response.clear();
+  string::size_type start = 0, end;
+  while ((end = lines.find('\n', start)) != string::npos)
+  {
+    response.push_back(lines.substr(start, end - start));
+    start = end + 1;
+  }
+  response.push_back(lines.substr(start));
+}
+
+string ScriptPort::getLine()
+{
+  if (_pending.size() == 0)
+    throw GsmException("timeout when reading from TA", OSError);
+  string result = _pending.front();
+  _pending.erase(_pending.begin());
+  return result;
+}
+
+void ScriptPort::putLine(string line, bool carriageReturn)
+{
+  // the empty line is removed by GsmAt::putLine()
+  _pending.clear();
+  _pending.push_back("");
+  map<string, vector<string> >::iterator i = _responses.find(line);
+  if (i == _responses.end())
+    _pending.push_back("OK");
+  else
+    _pending.insert(_pending.end(), i->second.begin(), i->second.end());
+}
+
+// *** event handlers
+
+class EventPrinter : public GsmEvent
+{
+public:
+  void callerLineID(string number, string subAddr, string alpha)
+    {cout << "caller " << number << " '" << alpha << "'" << endl;}
+  void noAnswer()
+    {cout << "no answer" << endl;}
+  void SMSReceptionIndication(string storeName, unsigned int index,
+                              SMSMessageType messageType)
+    {
+      cout << "SMS " << messageType << " stored in " << storeName
+           << " at index " << index << endl;
+    }
+  void ringIndication()
+    {cout << "ring" << endl;}
+};
+
+class URCPrinter : public URCHandler
+{
+public:
+  bool handleURC(StringView tag, StringView arguments, GsmAt &at)
+    {
+      cout << "URC " << tag.str() << " '" << arguments.str() << "'" << endl;
+      return true;
+    }
+};
+
+// +CREG: <stat> is unsolicited, +CREG: <n>,<stat> the response to +CREG?
+class RegistrationHandler : public URCHandler
+{
+public:
+  bool handleURC(StringView tag, StringView arguments, GsmAt &at)
+    {
+      if (arguments.find(',') != StringView::npos)
+        return false;
+      cout << "registration status " << arguments.str() << endl;
+      return true;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    // answers for MeTa::init(), everything else gets "OK"
+    ScriptPort *port = new ScriptPort();
+    port->respond("AT+CGMI", "gsmlib\n\nOK");
+    port->respond("AT+CGMM", "Modem simulator\n\nOK");
+    port->respond("AT+CGMR", "1.11\n\nOK");
+    port->respond("AT+CGSN", "000000000000001\n\nOK");
+    port->respond("AT+CSMS?", "+CSMS: 0,1,1,1\n\nOK");
+    port->respond("AT+CMMS=?", "+CMMS: (0-2)\n\nOK");
+    port->respond("AT+CSCS?", "+CSCS: \"GSM\"\n\nOK");
+
+    // answers with URCs in between
+    port->respond("AT+CSQ", "RING\n+CMTI: \"SM\",3\n+CDSI: \"SR\",1\n"
+                  "+CREG: 5\n^SIS: 0,0,2200\n+CIEV: 1,0\n\nNO CARRIER\n"
+                  "+CSQ: 20,99\n\nOK");
+    port->respond("AT+CREG?", "+CREG: 0,1\n\nOK");
+    port->respond("AT+CLIP?", "+CLIP: \"4917012345\",145,,,\"Peter\"\n"
+                  "+CLIP: 0,1\n\nOK");
+    port->respond("AT+CIND?", "+CIEV: 1,0\n\nOK");
+
+    MeTa meTa((Ref<Port>)port);
+    GsmAt &at = *meTa.getAt().getptr();
+    EventPrinter events;
+    URCPrinter printer;
+    RegistrationHandler registration;
+    events.setURCHandler("+CREG", &registration);
+    events.setURCHandler("^SIS", &printer);
+    events.setURCHandler("+CIEV:", &printer);
+    at.setEventHandler(&events);
+
+    string result = at.chat("+CSQ", "+CSQ:");
+    cout << "+CSQ: " << result << endl << endl;
+    result = at.chat("+CREG?", "+CREG:");
+    cout << "+CREG?: " << result << endl << endl;
+    result = at.chat("+CLIP?", "+CLIP:");
+    cout << "+CLIP?: " << result << endl << endl;
+
+    // replace the handling of RING, remove +CIEV
+    events.setURCHandler("RING", &printer);
+    events.setURCHandler("+CIEV", NULL);
+    port->respond("AT+CSQ", "RING\n+CMTI: \"SM\",4\n+CSQ: 21,99\n\nOK");
+    result = at.chat("+CSQ", "+CSQ:");
+    cout << "+CSQ: " << result << endl;
+    result = at.chat("+CIND?", "+CIEV:");
+    cout << "+CIND?: " << result << endl << endl;
+
+    const GsmMetrics::URCMap &urcs = meTa.getMetrics().urcs();
+    for (GsmMetrics::URCMap::const_iterator i = urcs.begin();
+         i != urcs.end(); ++i)
+      cout << i->first << ": " << i->second << endl;
+  }
+  catch (GsmException &ge)
+  {
+    cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,55 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testmetrics.cc
+// *
+// * Purpose: Test AT command metrics and their Prometheus format
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_metrics.h>
+#include <iostream>
+
+using namespace std;
+using namespace gsmlib;
+
+int main(int argc, char *argv[])
+{
+  const char *commands[] = {"+CMGS=23", "+cpbr=1,10", "+CPMS?", "&F", "Z",
+                            "E0", "", "+WS46=?", NULL};
+  for (int i = 0; commands[i] != NULL; ++i)
+    cout << "'" << commands[i] << "' -> " << GsmMetrics::verb(commands[i])
+         << endl;
+
+  GsmMetrics metrics;
+  metrics.countCommand("+CMGS", 0.75);
+  metrics.countCommand("+CMGS", 3);
+  metrics.countCommand("+CMGS", 120);
+  metrics.countCommand("+CPBR", 0.005);
+  metrics.countError("+CMGS", "CMS", 500);
+  metrics.countError("+CMGS", "CMS", 500);
+  metrics.countError("+CPBR", "CME", 21);
+  metrics.countError("+CPBR", "ERROR", -1);
+  metrics.countURC("+CMTI");
+  metrics.countURC("RING");
+  metrics.countURC("+CMTI");
+  metrics.countBytesIn(1234);
+  metrics.countBytesOut(56);
+
+  GsmMetrics snapshot = metrics.snapshot();
+  metrics.reset();
+  metrics.setEnabled(false);
+  metrics.countCommand("+CSQ", 0.1);
+  cout << "after reset: " << metrics.commands().size() << " verbs, "
+       << metrics.bytesIn() << " bytes" << endl;
+  cout << "+CMGS: " << snapshot.commands().find("+CMGS")->second._count
+       << " commands, " << snapshot.commands().find("+CMGS")->second._errors
+       << " errors" << endl << endl;
+
+  snapshot.writePrometheus(cout);
+  return 0;
+}
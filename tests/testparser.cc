@@ -37,6 +37,18 @@ void printIntList(vector<bool> &vb)
   cout << ")";
 }
 
+void printIntRanges(const IntList &il)
+{
+  cout << "(";
+  for (vector<IntRange>::const_iterator i = il.ranges().begin();
+       i != il.ranges().end(); ++i)
+  {
+    if (i != il.ranges().begin()) cout << ",";
+    cout << i->_low << "-" << i->_high;
+  }
+  cout << ")";
+}
+
 void printIntRange(IntRange ir)
 {
   cout << "(" << ir._low << "-" << ir._high << ")";
@@ -160,6 +172,40 @@ int main(int argc, char *argv[])
            << shortName << "\","
            << numericName << ")" << endl << endl;
     }
+    {
+      cout << "Test 7" << endl;
+      string response = "(\"ME\",\"SM\"),(7,1-5,12-11,6,25),"
+        "(1-65535),SM,\"+ab\"cd\"";
+      Parser p((StringView)response);
+
+      vector<StringView> vs = p.parseStringViewList();
+      p.parseComma();
+      IntList il = p.parseIntRanges();
+      p.parseComma();
+      IntList il2 = p.parseIntRanges();
+      p.parseComma();
+      StringView s = p.parseStringView();
+      p.parseComma();
+      StringView s2 = p.parseStringView(false, true);
+      p.checkEol();
+
+      // the views point into response
+      assert(vs[0].data() == response.data() + 2);
+      for (vector<StringView>::iterator i = vs.begin(); i != vs.end(); ++i)
+        cout << (i == vs.begin() ? "(" : ",") << "\"" << i->str() << "\"";
+      cout << "),";
+      printIntRanges(il);
+      cout << ",";
+      printIntRanges(il2);
+      cout << "," << s.str() << ",\"" << s2.str() << "\"" << endl;
+      cout << "count " << il.count() << " " << il2.count()
+           << ", contains 6 " << il.contains(6)
+           << ", contains 8 " << il.contains(8)
+           << ", position of 11 " << il.position(11)
+           << ", position of 25 " << il.position(25)
+           << ", position of 0 " << il.position(0)
+           << ", position of 65535 " << il2.position(65535) << endl << endl;
+    }
   }
   catch (GsmException &p)
   {
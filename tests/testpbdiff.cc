@@ -0,0 +1,106 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testpbdiff.cc
+// *
+// * Purpose: Test phonebook diff
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#include <gsmlib/gsm_phonebook_diff.h>
+#include <gsmlib/gsm_error.h>
+#include <iostream>
+
+using namespace std;
+using namespace gsmlib;
+
+// destination with 8 slots (ME indices 1..8), slots 1, 3, 4, 6 used
+vector<PhonebookSlot> destination()
+{
+  vector<PhonebookSlot> result;
+  for (int i = 1; i <= 8; ++i)
+    result.push_back(PhonebookSlot(i, "", ""));
+  result[0] = PhonebookSlot(1, "0815", "Anna");
+  result[2] = PhonebookSlot(3, "4711", "bob");
+  result[3] = PhonebookSlot(4, "1234", "Carl");
+  result[5] = PhonebookSlot(6, "5555", "Dora");
+  return result;
+}
+
+void printDiff(string title, const vector<PhonebookSlot> &source,
+               bool indexed, bool ignoreCase = false)
+{
+  cout << title << ":" << endl;
+  try
+  {
+    PhonebookDiff diff(destination(), source, indexed, ignoreCase);
+    for (vector<PhonebookSlot>::const_iterator i = diff.writes().begin();
+         i != diff.writes().end(); ++i)
+      if (i->empty())
+        cout << "  clear " << i->_index << endl;
+      else
+        cout << "  write " << i->_index << " '" << i->_text << "' "
+             << i->_telephone << endl;
+    cout << "  unchanged: " << diff.unchanged()
+         << " updates: " << diff.updates()
+         << " inserts: " << diff.inserts()
+         << " clears: " << diff.clears()
+         << " round trips: " << diff.roundTrips() << endl;
+  }
+  catch (GsmException &ge)
+  {
+    cout << "  GsmException '" << ge.what() << "'" << endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  vector<PhonebookSlot> source;
+
+  // identical contents in a different order
+  source.push_back(PhonebookSlot(-1, "5555", "Dora"));
+  source.push_back(PhonebookSlot(-1, "0815", "Anna"));
+  source.push_back(PhonebookSlot(-1, "1234", "Carl"));
+  source.push_back(PhonebookSlot(-1, "4711", "bob"));
+  printDiff("same entries", source, false);
+
+  // case of a name changed
+  source[3]._text = "Bob";
+  printDiff("renamed, copy", source, false);
+  printDiff("renamed, synchronize", source, false, true);
+
+  // number changed, one deleted, two new
+  source[0]._telephone = "6666";
+  source.erase(source.begin() + 2);
+  source.push_back(PhonebookSlot(-1, "1", "Emil"));
+  source.push_back(PhonebookSlot(-1, "2", "Fritz"));
+  printDiff("changed", source, false);
+
+  // duplicate entries
+  source.clear();
+  source.push_back(PhonebookSlot(-1, "0815", "Anna"));
+  source.push_back(PhonebookSlot(-1, "0815", "Anna"));
+  printDiff("duplicates", source, false);
+
+  // empty source clears everything
+  source.clear();
+  printDiff("empty source", source, false);
+
+  // too many entries
+  for (int i = 0; i < 9; ++i)
+    source.push_back(PhonebookSlot(-1, "9", "Gustav"));
+  printDiff("full", source, false);
+
+  // indexed: entries move to their index
+  source.clear();
+  source.push_back(PhonebookSlot(1, "0815", "Anna"));
+  source.push_back(PhonebookSlot(2, "4711", "bob"));
+  source.push_back(PhonebookSlot(6, "5555", "DORA"));
+  printDiff("indexed", source, true);
+  printDiff("indexed, synchronize", source, true, true);
+
+  source.push_back(PhonebookSlot(9, "9", "Gustav"));
+  printDiff("indexed, bad index", source, true);
+  return 0;
+}
@@ -0,0 +1,87 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testpcache.cc
+// *
+// * Purpose: Test probe cache
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#include <gsmlib/gsm_probe_cache.h>
+#include <gsmlib/gsm_error.h>
+#include <iostream>
+
+using namespace std;
+using namespace gsmlib;
+
+void printList(string name, const vector<string> &v)
+{
+  cout << name << ":";
+  for (vector<string>::const_iterator i = v.begin(); i != v.end(); ++i)
+    cout << " <" << *i << ">";
+  cout << endl;
+}
+
+void printLoad(ProbeCache &pc, string serialNumber, string revision)
+{
+  ProbeCacheEntry e;
+  cout << "'" << serialNumber << "': ";
+  if (! pc.load(serialNumber, revision, e))
+  {
+    cout << "not found" << endl;
+    return;
+  }
+  cout << e._meInfo._manufacturer << "|" << e._meInfo._model << endl
+       << "hasSMSPDUmode: " << e._hasSMSPDUmode
+       << " MotorolaModeCmd: " << e._MotorolaModeCmd
+       << " noCPBxParentheses: " << e._noCPBxParentheses
+       << " hasCMMS: " << e._hasCMMS
+       << " cpmsParamCount: " << e._cpmsParamCount << endl;
+  printList("charSets", e._charSets);
+  printList("phonebookStrings", e._phonebookStrings);
+  printList("smsStoreNames", e._smsStoreNames);
+  cout << "cnmiModes: " << e._cnmiModes << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    ProbeCache pc("pcache.d");
+
+    cout << "Test 1: save and load" << endl;
+    ProbeCacheEntry e;
+    e._meInfo._manufacturer = "ACME, Inc.";
+    e._meInfo._model = "Phone\\1";
+    e._meInfo._revision = "R1\nbuild 7";
+    e._meInfo._serialNumber = "350123451234560";
+    e._hasCMMS = true;
+    e._cpmsParamCount = 3;
+    e._charSets.push_back("GSM");
+    e._charSets.push_back("UCS2");
+    e._phonebookStrings.push_back("SM");
+    e._phonebookStrings.push_back("ME");
+    e._phonebookStrings.push_back("");
+    e._cnmiModes = "(0-2),(0-3),(0,2),(0,1),(0,1)";
+    pc.save(e);
+    printLoad(pc, "350123451234560", "R1\nbuild 7");
+
+    cout << "Test 2: different firmware revision" << endl;
+    printLoad(pc, "350123451234560", "R2");
+
+    cout << "Test 3: unknown ME" << endl;
+    printLoad(pc, "350123451234561", "R1\nbuild 7");
+
+    cout << "Test 4: no serial number" << endl;
+    e._meInfo._serialNumber = "";
+    pc.save(e);
+    printLoad(pc, "", "R1\nbuild 7");
+  }
+  catch (GsmException &ge)
+  {
+    cerr << "GsmException '" << ge.what() << "'" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,272 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testreplay.cc
+// *
+// * Purpose: Test recording the dialogue with a TA and replaying it
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_recording_port.h>
+#include <iostream>
+#include <fstream>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+using namespace std;
+using namespace gsmlib;
+
+// *** scripted TA
+
+class ScriptPort : public Port
+{
+  string _pending;              // response not read yet
+  int _oldChar;
+  struct timeval _ready;        // response available from then on
+
+public:
+  ScriptPort() : _oldChar(-1) {gettimeofday(&_ready, NULL);}
+
+  void putBack(unsigned char c) {_oldChar = c;}
+  int readByte();
+  string getLine();
+  void putLine(string line, bool carriageReturn = true);
+  bool wait(GsmTime timeout) {return true;}
+  void setTimeOut(unsigned int timeout) {}
+};
+
+int ScriptPort::readByte()
+{
+  if (_oldChar != -1)
+  {
+    int result = _oldChar;
+    _oldChar = -1;
+    return result;
+  }
+  if (_pending.length() == 0)
+    throw GsmException("timeout when reading from TA", OSError);
+
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  long delay = (_ready.tv_sec - now.tv_sec) * 1000000 +
+    _ready.tv_usec - now.tv_usec;
+  if (delay > 0)
+    usleep(delay);
+  int result = (unsigned char)_pending[0];
+  _pending.erase(0, 1);
+  return result;
+}
+
+string ScriptPort::getLine()
+{
+  string result;
+  int c;
+  while ((c = readByte()) != LF)
+    if (c != CR)
+      result += c;
+  return result;
+}
+
+void ScriptPort::putLine(string line, bool carriageReturn)
+{
+  gettimeofday(&_ready, NULL);
+  if (line == "ATI")
+    _pending += "\r\nScriptPort\r\n\r\nOK\r\n";
+  else if (line == "AT+CMGS=23")
+    _pending += "\r\n> ";
+  else if (! carriageReturn)
+    _pending += "\r\n+CMGS: " + intToStr(line.length()) + "\r\n\r\nOK\r\n";
+  else if (line == "AT+SLOW")
+  {
+    // answer after 300 ms followed by an unsolicited result code
+    _ready.tv_usec += 300000;
+    if (_ready.tv_usec >= 1000000)
+    {
+      _ready.tv_usec -= 1000000;
+      ++_ready.tv_sec;
+    }
+    _pending += "\r\nOK\r\n\r\n+CMTI: \"SM\",1\r\n";
+  }
+  else
+    _pending += "\r\nERROR\r\n";
+}
+
+// *** test program
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static string escape(const string &s)
+{
+  string result;
+  for (string::const_iterator i = s.begin(); i != s.end(); ++i)
+    if (*i == CR)
+      result += "<CR>";
+    else if (*i == LF)
+      result += "<LF>";
+    else if (*i == '\032')
+      result += "<SUB>";
+    else
+      result += *i;
+  return result;
+}
+
+// read the response to a command up to OK or ERROR
+static void printResponse(Ref<Port> port)
+{
+  string line;
+  do
+  {
+    line = port->getLine();
+    if (line != "")
+      cout << "  " << line << endl;
+  }
+  while (line != "OK" && line != "ERROR");
+}
+
+// talk to the TA, return time the response to AT+SLOW took
+static double session(Ref<Port> port)
+{
+  port->putLine("ATI");
+  printResponse(port);
+
+  // SMS prompt is read byte by byte as GsmAt does
+  port->putLine("AT+CMGS=23");
+  int c;
+  string prompt;
+  while ((c = port->readByte()) != '>')
+    prompt += c;
+  c = port->readByte();
+  port->putBack(c);
+  prompt += '>';
+  prompt += port->readByte();
+  cout << "  prompt '" << escape(prompt) << "'" << endl;
+  port->putLine("0011000B919471101032F50000AA0AE8329BFD4697D9EC37\032",
+                false);
+  printResponse(port);
+
+  double start = now();
+  port->putLine("AT+SLOW");
+  printResponse(port);
+  double result = now() - start;
+  port->getLine();
+  cout << "  " << port->getLine() << endl;
+
+  port->putLine("AT+UNKNOWN");
+  printResponse(port);
+  return result;
+}
+
+// print the records of the trace file
+static void dump(string filename)
+{
+  ifstream trace(filename.c_str(), ios::in | ios::binary);
+  char header[13];
+  trace.read(header, 6);
+  cout << "magic " << string(header, 4) << " version "
+       << ntohs(*(uint16_t*)(header + 4)) << endl;
+  double lastTime = 0;
+  while (trace.read(header, sizeof(header)))
+  {
+    uint32_t values[3];
+    memcpy(values, header + 1, sizeof(values));
+    double time = ntohl(values[0]) + ntohl(values[1]) / 1000000.0;
+    string data(ntohl(values[2]), ' ');
+    trace.read(&data[0], data.length());
+    cout << header[0] << (time - lastTime >= 0.3 ? " (after 300 ms) " : " ")
+         << escape(data) << endl;
+    lastTime = time;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    cout << "*** recording" << endl;
+    double recorded =
+      session(new RecordingPort(new ScriptPort(), "replay.trace"));
+    cout << "AT+SLOW took at least 300 ms: " << (recorded >= 0.3) << endl;
+
+    cout << "*** trace" << endl;
+    dump("replay.trace");
+
+    cout << "*** replay at recorded speed" << endl;
+    double replayed = session(new ReplayPort("replay.trace"));
+    cout << "AT+SLOW took at least 300 ms: " << (replayed >= 0.3) << endl;
+
+    cout << "*** replay ten times faster" << endl;
+    replayed = session(new ReplayPort("replay.trace", 10));
+    cout << "AT+SLOW took 30 to 200 ms: "
+         << (replayed >= 0.03 && replayed < 0.2) << endl;
+
+    cout << "*** replay without delays" << endl;
+    replayed = session(new ReplayPort("replay.trace", 0));
+    cout << "AT+SLOW took less than 30 ms: " << (replayed < 0.03) << endl;
+
+    cout << "*** waiting for data" << endl;
+    Ref<Port> port = new ReplayPort("replay.trace");
+    port->putLine("ATI");
+    struct timeval shortWait = {0, 100000};
+    cout << "data available: " << port->wait(&shortWait) << endl;
+    printResponse(port);
+    cout << "data available: " << port->wait(&shortWait) << endl;
+
+    cout << "*** deviating from the trace" << endl;
+    try
+    {
+      port->putLine("AT+CMGS=42");
+    }
+    catch (GsmException &ge)
+    {
+      cout << "GsmException '" << ge.what() << "'" << endl;
+    }
+    try
+    {
+      port->getLine();
+    }
+    catch (GsmException &ge)
+    {
+      cout << "GsmException '" << ge.what() << "'" << endl;
+    }
+
+    cout << "*** end of trace" << endl;
+    port = new ReplayPort("replay.trace", 0);
+    session(port);
+    try
+    {
+      port->getLine();
+    }
+    catch (GsmException &ge)
+    {
+      cout << "GsmException '" << ge.what() << "'" << endl;
+    }
+
+    cout << "*** not a trace" << endl;
+    ofstream("replay.trace") << "no trace" << endl;
+    try
+    {
+      port = new ReplayPort("replay.trace");
+    }
+    catch (GsmException &ge)
+    {
+      cout << "GsmException '" << ge.what() << "'" << endl;
+    }
+  }
+  catch (GsmException &ge)
+  {
+    cout << "GsmException '" << ge.what() << "'" << endl;
+    return 1;
+  }
+  return 0;
+}
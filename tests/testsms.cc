@@ -67,5 +67,38 @@ int main(int argc, char *argv[])
   pdu = sms->encode();
   sms = gsmlib::SMSMessage::decode(pdu);
   std::cout << sms->toString() << std::endl;
+
+  // test SMS template: patched PDUs must equal fully encoded ones
+  const char *recipients[] = {"+4917712345678", "0815", "12345", NULL};
+  for (int alphabet = 0; alphabet < 3; ++alphabet)
+  {
+    gsmlib::Ref<gsmlib::SMSSubmitMessage> submitSMS =
+      new gsmlib::SMSSubmitMessage();
+    gsmlib::Address sca("+491710760000");
+    submitSMS->setServiceCentreAddress(sca);
+    submitSMS->setStatusReportRequest(true);
+    gsmlib::DataCodingScheme dcs(alphabet == 0 ? gsmlib::DCS_DEFAULT_ALPHABET :
+                                 alphabet == 1 ? gsmlib::DCS_EIGHT_BIT_ALPHABET :
+                                 gsmlib::DCS_SIXTEEN_BIT_ALPHABET);
+    submitSMS->setDataCodingScheme(dcs);
+    std::string text(200, 'x');
+    gsmlib::SMSSubmitTemplate smsTemplate(submitSMS, text, false, 42);
+    std::vector<gsmlib::Ref<gsmlib::SMSSubmitMessage> > parts =
+      gsmlib::splitSMSText(submitSMS, text, false, 42);
+    std::cout << "Template with alphabet " << alphabet << ": "
+              << smsTemplate.parts() << " parts" << std::endl;
+    for (int r = 0; recipients[r] != NULL; ++r)
+      for (unsigned int i = 0; i < smsTemplate.parts(); ++i)
+      {
+        gsmlib::Address destination(recipients[r]);
+        parts[i]->setDestinationAddress(destination);
+        parts[i]->setMessageReference(r);
+        std::string patched = smsTemplate.pdu(i, destination, r);
+        std::cout << recipients[r] << " part " << i << " length "
+                  << smsTemplate.tpduLength(patched) << ": "
+                  << (patched == parts[i]->encode() ? "ok" : "MISMATCH")
+                  << std::endl;
+      }
+  }
   return 0;
 }
@@ -0,0 +1,317 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testsocket.cc
+// *
+// * Purpose: Test TCP and RFC 2217 ports against a loopback server
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_socket_port.h>
+#include <gsmlib/gsm_unix_serial.h>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+using namespace gsmlib;
+
+// *** serial-over-IP server (runs in the child process)
+
+static const unsigned char IAC = 255;
+
+static int connections = 0;
+
+static void sendRaw(int fd, const string &s)
+{
+  if (write(fd, s.data(), s.length()) != (ssize_t)s.length())
+    _exit(1);
+}
+
+static string telnetCommand(unsigned char verb, unsigned char option)
+{
+  string result;
+  result += (char)IAC;
+  result += (char)verb;
+  result += (char)option;
+  return result;
+}
+
+static string hex(const string &s)
+{
+  string result;
+  char buf[3];
+  for (string::const_iterator i = s.begin(); i != s.end(); ++i)
+  {
+    sprintf(buf, "%02x", (unsigned char)*i);
+    result += buf;
+  }
+  return result;
+}
+
+// answer one connection, the telnet protocol is used if the client
+// starts with a telnet command
+static void serve(int fd)
+{
+  ++connections;
+  bool first = true, telnet = false;
+  int state = 0;                // 0 data, 1 IAC, 2 option, 3 SB, 4 SB IAC
+  unsigned char verb = 0;
+  string line, subnegotiation, settings, refused;
+  unsigned char c;
+  while (read(fd, &c, 1) == 1)
+  {
+    if (first && c == IAC)
+    {
+      // ask for options the client must refuse
+      telnet = true;
+      sendRaw(fd, telnetCommand(253, 1) + telnetCommand(251, 5));
+    }
+    first = false;
+
+    switch (state)
+    {
+    case 0:
+      if (telnet && c == IAC)
+        state = 1;
+      else if (c != '\r')
+        line += c;
+      else if (line == "AT+DROP")
+      {
+        sendRaw(fd, "\r\nOK\r\n");
+        close(fd);
+        return;
+      }
+      else if (line == "AT+HANGUP")
+      {
+        close(fd);
+        return;
+      }
+      else
+      {
+        string response;
+        if (line == "ATI")
+          response = "connection " + intToStr(connections) + "\r\n\r\n";
+        else if (line == "AT+NEG?")
+          // a telnet command in the middle of the data
+          response = "+NEG: " + settings + telnetCommand(253, 1) +
+            " refused" + refused + "\r\n\r\n";
+        else if (line.substr(0, 6) == "AT+FF=")
+          response = "+FF: " + hex(line.substr(6)) + " " +
+            (telnet ? string("\xff\xff") : string("\xff")) + "\r\n\r\n";
+        sendRaw(fd, "\r\n" + response + "OK\r\n");
+        line = "";
+      }
+      break;
+    case 1:
+      state = 0;
+      if (c == IAC)
+        line += c;
+      else if (c == 250)
+      {
+        subnegotiation = "";
+        state = 3;
+      }
+      else if (c >= 251)
+      {
+        verb = c;
+        state = 2;
+      }
+      break;
+    case 2:
+      state = 0;
+      if (verb == 252)
+        refused += " WONT " + intToStr(c);
+      else if (verb == 254)
+        refused += " DONT " + intToStr(c);
+      break;
+    case 3:
+      if (c == IAC)
+        state = 4;
+      else
+        subnegotiation += c;
+      break;
+    case 4:
+      if (c == IAC)
+      {
+        subnegotiation += c;
+        state = 3;
+        break;
+      }
+      state = 0;
+      if (subnegotiation.length() < 3 || subnegotiation[0] != 44)
+        break;
+      if (subnegotiation[1] == 1 && subnegotiation.length() == 6)
+      {
+        int baudRate = 0;
+        for (int i = 2; i < 6; ++i)
+          baudRate = (baudRate << 8) | (unsigned char)subnegotiation[i];
+        settings += "baud " + intToStr(baudRate);
+      }
+      else
+        settings += " " + intToStr(subnegotiation[1]) + "=" +
+          intToStr(subnegotiation[2]);
+      // confirm the setting like a real server
+      sendRaw(fd, string("\xff\xfa\x2c") + (char)(subnegotiation[1] + 100) +
+              subnegotiation.substr(2) + "\xff\xf0");
+      break;
+    }
+  }
+  close(fd);
+}
+
+static void server(int listenFd)
+{
+  int fd;
+  while ((fd = accept(listenFd, NULL, NULL)) != -1)
+    serve(fd);
+  _exit(0);
+}
+
+// *** test program
+
+// read the response to a command up to OK
+static void printResponse(Ref<Port> port)
+{
+  string line;
+  while ((line = port->getLine()) != "OK")
+    if (line != "")
+    {
+      string::size_type ff;
+      while ((ff = line.find('\xff')) != string::npos)
+        line.replace(ff, 1, "<ff>");
+      cout << line << endl;
+    }
+}
+
+static void parse(string device)
+{
+  string host, service;
+  bool rfc2217 = false;
+  cout << device << ": ";
+  try
+  {
+    if (parseNetworkDevice(device, host, service, rfc2217))
+      cout << (rfc2217 ? "rfc2217 " : "tcp ") << host << " " << service
+           << endl;
+    else
+      cout << "not a network device" << endl;
+  }
+  catch (GsmException &ge)
+  {
+    cout << "GsmException '" << ge.what() << "'" << endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  parse("tcp://modembank:4001");
+  parse("rfc2217://[::1]:2217");
+  parse("tcp://modembank");
+  parse("rfc2217://:2217");
+  parse("/dev/ttyS0");
+
+  int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  socklen_t length = sizeof(addr);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (listenFd == -1 ||
+      bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+      listen(listenFd, 5) != 0 ||
+      getsockname(listenFd, (struct sockaddr*)&addr, &length) != 0)
+  {
+    cerr << "cannot listen on loopback interface" << endl;
+    return 1;
+  }
+  string address = "127.0.0.1:" + intToStr(ntohs(addr.sin_port));
+
+  pid_t pid = fork();
+  if (pid == 0)
+    server(listenFd);
+  close(listenFd);
+
+  int result = 0;
+  try
+  {
+    // raw TCP
+    Ref<Port> port = openPort("tcp://" + address);
+    cout << "tcp port open" << endl;
+    port->putLine("ATI");
+    printResponse(port);
+
+    // server closes the idle connection, next command reconnects
+    port->putLine("AT+DROP");
+    printResponse(port);
+    usleep(100000);
+    port->putLine("ATI");
+    printResponse(port);
+
+    // server drops the connection while the command is pending
+    port->setTimeOut(2);
+    port->putLine("AT+HANGUP");
+    try
+    {
+      port->getLine();
+      cout << "AT+HANGUP answered" << endl;
+    }
+    catch (GsmException &)
+    {
+      cout << "AT+HANGUP not answered" << endl;
+    }
+    port->putLine("ATI");
+    printResponse(port);
+    port->putLine("AT+FF=\xff");
+    printResponse(port);
+
+    // telnet with COM port control
+    port = Ref<Port>();
+    port = openPort("rfc2217://" + address, baudRateStrToSpeed("19200"),
+                    DEFAULT_INIT_STRING, true);
+    cout << "rfc2217 port open" << endl;
+    port->putLine("ATI");
+    printResponse(port);
+    port->putLine("AT+NEG?");
+    printResponse(port);
+    port->putLine("AT+FF=\xff");
+    printResponse(port);
+    port = Ref<Port>();
+
+    // nobody listening
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    pid = -1;
+    try
+    {
+      openPort("tcp://" + address);
+    }
+    catch (GsmException &ge)
+    {
+      cout << "connect after shutdown: "
+           << (ge.getErrorClass() == OSError ? "OSError" : "other") << endl;
+    }
+  }
+  catch (GsmException &ge)
+  {
+    cout << "GsmException '" << ge.what() << "'" << endl;
+    result = 1;
+  }
+
+  if (pid != -1)
+  {
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+  }
+  return result;
+}
@@ -0,0 +1,152 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testsri.cc
+// *
+// * Purpose: Test status report index
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#include <gsmlib/gsm_status_report_index.h>
+#include <gsmlib/gsm_error.h>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+using namespace gsmlib;
+
+void printLookup(StatusReportIndex &sri, string modem, unsigned char mr,
+                 string recipient)
+{
+  StatusReportIndexEntry e;
+  cout << modem << "/" << (int)mr << "/" << recipient << ": ";
+  if (sri.find(modem, mr, recipient, e))
+    cout << e._spoolId << " (submitted " << (long)e._submitTime << ")";
+  else
+    cout << "not found";
+  cout << endl;
+}
+
+void printResolve(StatusReportIndex &sri, string modem, unsigned char mr,
+                  string recipient, unsigned char status)
+{
+  SMSStatusReportMessage report;
+  report.setMessageReference(mr);
+  report.setRecipientAddress(Address(recipient));
+  report.setStatus(status);
+
+  StatusReportIndexEntry e;
+  cout << "report " << modem << "/" << (int)mr << "/" << recipient
+       << " status " << (int)status << ": ";
+  if (sri.resolve(modem, report, e))
+    cout << e._spoolId;
+  else
+    cout << "not found";
+  cout << ", " << sri.size() << " entries left" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    {
+      cout << "Test 1: add and find" << endl;
+      StatusReportIndex sri("sri.idx", 3);
+      sri.add("/dev/ttyS0", 17, "+49177123456", "spool-a", 1000);
+      sri.add("/dev/ttyS0", 18, "+49177123456", "spool-b|part", 1001);
+      sri.add("/dev/ttyS1", 17, "+49177123456", "spool-c", 1002);
+      printLookup(sri, "/dev/ttyS0", 17, "+49177123456");
+      printLookup(sri, "/dev/ttyS0", 18, "0177123456");
+      printLookup(sri, "/dev/ttyS1", 17, "+49177123456");
+      printLookup(sri, "/dev/ttyS1", 18, "+49177123456");
+      printLookup(sri, "/dev/ttyS0", 17, "+49177654321");
+      cout << endl;
+    }
+    {
+      cout << "Test 2: journal replay and capacity" << endl;
+      StatusReportIndex sri("sri.idx", 3);
+      printLookup(sri, "/dev/ttyS0", 18, "+49177123456");
+      sri.add("/dev/ttyS0", 19, "+49177123456", "spool-d", 1003);
+      cout << sri.size() << " entries" << endl;
+      printLookup(sri, "/dev/ttyS0", 17, "+49177123456");
+      printLookup(sri, "/dev/ttyS0", 19, "+49177123456");
+      cout << endl;
+    }
+    {
+      cout << "Test 3: resolve status reports" << endl;
+      StatusReportIndex sri("sri.idx", 3);
+      // temporary error, SC still trying: entry is kept
+      printResolve(sri, "/dev/ttyS0", 18, "+49177123456",
+                   SMS_STATUS_TEMPORARY_BIT | SMS_STATUS_SME_BUSY);
+      // delivered
+      printResolve(sri, "/dev/ttyS0", 18, "+49177123456",
+                   SMS_STATUS_RECEIVED);
+      printResolve(sri, "/dev/ttyS0", 18, "+49177123456",
+                   SMS_STATUS_RECEIVED);
+      // permanent error
+      printResolve(sri, "/dev/ttyS1", 17, "+49177123456",
+                   SMS_STATUS_PERMANENT_BIT | SMS_STATUS_NOT_OBTAINABLE);
+      cout << endl;
+    }
+    {
+      cout << "Test 4: compaction" << endl;
+      StatusReportIndex sri("sri.idx", 3);
+      for (int i = 0; i < 20; ++i)
+        sri.add("/dev/ttyS0", i, "+49177123456", "spool-" + intToStr(i),
+                2000 + i);
+    }
+    {
+      StatusReportIndex sri("sri.idx", 3);
+      cout << sri.size() << " entries" << endl;
+      printLookup(sri, "/dev/ttyS0", 16, "+49177123456");
+      printLookup(sri, "/dev/ttyS0", 17, "+49177123456");
+      printLookup(sri, "/dev/ttyS0", 19, "+49177123456");
+      cout << endl;
+    }
+    {
+      cout << "Test 5: incomplete last line" << endl;
+      {
+        ofstream ofs("sri2.idx");
+        ofs << "+|/dev/ttyS0|1|+49177123456|spool-1|3001\n"
+            << "+|/dev/ttyS0|2|+49177123456|spool-2|30";
+      }
+      {
+        StatusReportIndex sri("sri2.idx", 3);
+        cout << sri.size() << " entries" << endl;
+        printLookup(sri, "/dev/ttyS0", 2, "+49177123456");
+        sri.add("/dev/ttyS0", 3, "+49177123456", "spool-3", 3003);
+      }
+      StatusReportIndex sri("sri2.idx", 3);
+      cout << sri.size() << " entries" << endl;
+      printLookup(sri, "/dev/ttyS0", 1, "+49177123456");
+      printLookup(sri, "/dev/ttyS0", 3, "+49177123456");
+      cout << endl;
+    }
+    {
+      cout << "Test 6: corrupt line in the middle" << endl;
+      {
+        ofstream ofs("sri2.idx");
+        ofs << "+|/dev/ttyS0|1|+49177123456|spool-1|3001\n"
+            << "+|/dev/ttyS0|2|+4917\n"
+            << "+|/dev/ttyS0|3|+49177123456|spool-3|3003\n";
+      }
+      try
+      {
+        StatusReportIndex sri("sri2.idx", 3);
+        cout << "no exception" << endl;
+      }
+      catch (GsmException &ge)
+      {
+        cout << "GsmException '" << ge.what() << "'" << endl;
+      }
+      cout << endl;
+    }
+  }
+  catch (GsmException &ge)
+  {
+    cerr << "GsmException '" << ge.what() << "'" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,265 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testthreads.cc
+// *
+// * Purpose: Test sharing a MeTa between threads against the ME/TA
+// *          simulator (gsmsim)
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_event.h>
+#include <gsmlib/gsm_me_ta.h>
+#include <gsmlib/gsm_sms.h>
+#include <gsmlib/gsm_sms_store.h>
+#include <gsmlib/gsm_unix_serial.h>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+using namespace std;
+using namespace gsmlib;
+
+// the receiver thread waits for the SMS sent by the simulator, the
+// replier thread answers each of them, and the main thread queries the
+// signal strength meanwhile
+// with the argument "indications" the SMS are stored in the ME and only
+// indicated (+CMTI), the main thread lists the SMS store meanwhile
+
+static const int Messages = 5;
+
+// *** state shared between the threads, protected by stateMutex
+
+static pthread_mutex_t stateMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stateChanged = PTHREAD_COND_INITIALIZER;
+static deque<SMSMessageRef> toAnswer; // received, not yet answered
+static vector<SMSMessageRef> received; // all received SMS
+static int indicated = 0;       // number of +CMTI indications
+static bool receiving = true;   // receiver thread still running
+static bool replying = true;    // replier thread still running
+static string errors;           // exceptions caught in the threads
+
+class StateLock
+{
+public:
+  StateLock() {pthread_mutex_lock(&stateMutex);}
+  ~StateLock() {pthread_mutex_unlock(&stateMutex);}
+};
+
+static void threadError(string thread, GsmException &ge)
+{
+  StateLock lock;
+  errors += thread + ": GsmException '" + ge.what() + "'\n";
+}
+
+// *** receiver thread
+
+// the SMS are handed to the replier thread, which drops its reference
+// while the receiver thread may still be creating new ones
+class ReceiveEvent : public GsmEvent
+{
+public:
+  void SMSReception(SMSMessageRef newMessage, SMSMessageType messageType)
+    {
+      StateLock lock;
+      toAnswer.push_back(newMessage);
+      received.push_back(newMessage);
+      pthread_cond_broadcast(&stateChanged);
+    }
+
+  void SMSReceptionIndication(string storeName, unsigned int index,
+                              SMSMessageType messageType)
+    {
+      StateLock lock;
+      ++indicated;
+    }
+};
+
+static int receivedCount()
+{
+  StateLock lock;
+  return received.size() + indicated;
+}
+
+static bool stillReceiving()
+{
+  StateLock lock;
+  return receiving;
+}
+
+static void *receive(void *arg)
+{
+  MeTa &meTa = *(MeTa*)arg;
+  try
+  {
+    // give up after 20 seconds
+    for (int i = 0; i < 200 && receivedCount() < Messages; ++i)
+    {
+      struct timeval timeout = {0, 100000};
+      meTa.waitEvent(&timeout);
+    }
+  }
+  catch (GsmException &ge)
+  {
+    threadError("receiver", ge);
+  }
+  StateLock lock;
+  receiving = false;
+  pthread_cond_broadcast(&stateChanged);
+  return NULL;
+}
+
+// *** replier thread
+
+static vector<string> replies;  // only used by the replier thread
+
+static void *reply(void *arg)
+{
+  MeTa &meTa = *(MeTa*)arg;
+  while (true)
+  {
+    SMSMessageRef message;
+    {
+      StateLock lock;
+      while (toAnswer.empty() && receiving)
+        pthread_cond_wait(&stateChanged, &stateMutex);
+      if (toAnswer.empty())
+        break;
+      message = toAnswer.front();
+      toAnswer.pop_front();
+    }
+    try
+    {
+      Ref<SMSSubmitMessage> answer =
+        new SMSSubmitMessage("re: " + message->userData(),
+                             message->address().toString());
+      meTa.sendSMS(answer);
+      replies.push_back(answer->userData() + " to " +
+                        answer->address().toString());
+    }
+    catch (GsmException &ge)
+    {
+      threadError("replier", ge);
+    }
+  }
+  StateLock lock;
+  replying = false;
+  return NULL;
+}
+
+static bool stillReplying()
+{
+  StateLock lock;
+  return replying;
+}
+
+// list the non-empty entries of store, return their number
+static int listStore(SMSStoreRef store, bool print)
+{
+  int entries = 0;
+  for (SMSStore::iterator i = store->begin(); i != store->end(); ++i)
+    if (! i->empty())
+    {
+      ++entries;
+      if (print)
+        cout << "  " << i->index() << ": " << i->message()->userData()
+             << endl;
+    }
+  return entries;
+}
+
+// the receiver thread gets the +CMTI indications while the main thread
+// reads the store that they change
+static void indications(MeTa &meTa)
+{
+  SMSStoreRef store = meTa.getSMSStore("SM");
+  meTa.setSMSRoutingToTA(true, false, false, true);
+
+  pthread_t receiver;
+  pthread_create(&receiver, NULL, receive, &meTa);
+  int listings = 0;
+  while (stillReceiving())
+  {
+    listStore(store, false);
+    ++listings;
+    usleep(10000);
+  }
+  pthread_join(receiver, NULL);
+
+  cout << errors;
+  cout << "indicated " << indicated << " SMS, "
+       << (listings > 0 ? "listed" : "not listed") << " meanwhile" << endl;
+  cout << "store has " << store->size() << " SMS:" << endl;
+  listStore(store, true);
+}
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    MeTa meTa(new UnixSerialPort(argc > 1 ? argv[1] : "threads.tty",
+                                 B38400, DEFAULT_INIT_STRING, false, true));
+    meTa.setThreadSafe(true);
+    ReceiveEvent events;
+    meTa.setEventHandler(&events);
+    if (argc > 2 && string(argv[2]) == "indications")
+    {
+      indications(meTa);
+      return 0;
+    }
+    meTa.setSMSRoutingToTA(true, false, false, false);
+
+    pthread_t receiver, replier;
+    pthread_create(&receiver, NULL, receive, &meTa);
+    pthread_create(&replier, NULL, reply, &meTa);
+
+    // all queries must get the simulator's answer, not one meant for
+    // another thread
+    int queries = 0, wrongAnswers = 0;
+    while (stillReplying())
+    {
+      try
+      {
+        if (meTa.getSignalStrength() != 20)
+          ++wrongAnswers;
+      }
+      catch (GsmException &ge)
+      {
+        cout << "main: GsmException '" << ge.what() << "'" << endl;
+        ++wrongAnswers;
+      }
+      ++queries;
+      usleep(10000);
+    }
+
+    pthread_join(receiver, NULL);
+    pthread_join(replier, NULL);
+
+    cout << errors;
+    cout << "received " << received.size() << " SMS:" << endl;
+    for (vector<SMSMessageRef>::iterator i = received.begin();
+         i != received.end(); ++i)
+      cout << "  " << (*i)->userData() << " from "
+           << (*i)->address().toString() << endl;
+    cout << "sent " << replies.size() << " replies:" << endl;
+    for (vector<string>::iterator i = replies.begin(); i != replies.end(); ++i)
+      cout << "  " << *i << endl;
+    cout << "signal strength queries: "
+         << (queries > 0 ? "answered" : "none") << ", "
+         << wrongAnswers << " wrong" << endl;
+  }
+  catch (GsmException &ge)
+  {
+    cerr << argv[0] << ": GsmException '" << ge.what() << "'" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+// *************************************************************************
+// * GSM TA/ME library
+// *
+// * File:    testtracing.cc
+// *
+// * Purpose: Test recording spans and writing them as Chrome trace
+// *
+// * Created: 19.10.2026
+// *************************************************************************
+
+#ifdef HAVE_CONFIG_H
+#include <gsm_config.h>
+#endif
+#include <gsmlib/gsm_tracing.h>
+#include <gsmlib/gsm_util.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+
+using namespace std;
+using namespace gsmlib;
+
+static const int THREADS = 4;
+static const int SPANS_PER_THREAD = 20000;
+
+static TraceBuffer sharedBuffer(1000);
+
+// push spans whose detail is the thread number
+static void *pushSpans(void *arg)
+{
+  TraceEvent event;
+  memset(&event, 0, sizeof(event));
+  event._category = "test";
+  event._name = "thread";
+  snprintf(event._detail, sizeof(event._detail), "%ld", (long)arg);
+  for (int i = 0; i < SPANS_PER_THREAD; ++i)
+  {
+    event._start = i;
+    event._duration = (long)arg;
+    sharedBuffer.push(event);
+  }
+  return NULL;
+}
+
+static void printSpans()
+{
+  vector<TraceEvent> events = traceBuffer.load()->events();
+  for (vector<TraceEvent>::iterator i = events.begin(); i != events.end(); ++i)
+    cout << "  " << i->_category << " " << i->_name << " '" << i->_detail
+         << "'" << endl;
+}
+
+// count occurrences of s in file
+static int count(string filename, string s)
+{
+  ifstream ifs(filename.c_str());
+  stringstream content;
+  content << ifs.rdbuf();
+  string text = content.str();
+  int result = 0;
+  for (string::size_type pos = 0;
+       (pos = text.find(s, pos)) != string::npos; pos += s.length())
+    ++result;
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  // disabled
+  cout << "tracing enabled: " << tracingEnabled() << endl;
+  {
+    TraceSpan span("test", "ignored");
+  }
+  ostringstream empty;
+  writeTrace(empty);
+  cout << empty.str();
+
+  // ring buffer keeps the last spans
+  enableTracing(4);
+  cout << "tracing enabled: " << tracingEnabled() << endl;
+  for (int i = 1; i <= 6; ++i)
+    TraceSpan span("test", "span", intToStr(i));
+  cout << "last 4 of 6 spans:" << endl;
+  printSpans();
+
+  // nested spans, long details are cut
+  {
+    TraceSpan outer("test", "outer");
+    TraceSpan inner("test", "inner", string(100, 'x'));
+    usleep(1000);
+  }
+  vector<TraceEvent> events = traceBuffer.load()->events();
+  TraceEvent inner = events[2], outer = events[3];
+  cout << "inner detail length " << strlen(inner._detail) << endl;
+  cout << "inner within outer: "
+       << (outer._start <= inner._start && inner._duration >= 1000 &&
+           inner._start + inner._duration <= outer._start + outer._duration)
+       << endl;
+
+  // concurrent writers
+  pthread_t threads[THREADS];
+  for (long t = 0; t < THREADS; ++t)
+    pthread_create(&threads[t], NULL, pushSpans, (void*)t);
+  for (int t = 0; t < THREADS; ++t)
+    pthread_join(threads[t], NULL);
+  events = sharedBuffer.events();
+  bool consistent = true;
+  for (vector<TraceEvent>::iterator i = events.begin(); i != events.end();
+       ++i)
+    consistent = consistent && intToStr(i->_duration) == i->_detail;
+  // a slot is skipped if a writer of an older span was overtaken
+  cout << THREADS * SPANS_PER_THREAD << " spans from " << THREADS
+       << " threads, kept about 1000: "
+       << (events.size() > 900 && events.size() <= 1000)
+       << ", consistent " << consistent << endl;
+
+  // written on SIGUSR2 when the next span ends
+  unlink("tracing.json");
+  traceToFile("tracing.json");
+  raise(SIGUSR2);
+  cout << "written before next span: " << (access("tracing.json", 0) == 0)
+       << endl;
+  {
+    TraceSpan span("test", "after signal");
+  }
+  cout << "written after next span: " << (access("tracing.json", 0) == 0)
+       << endl;
+  cout << "complete events in file: "
+       << count("tracing.json", "\"ph\":\"X\"") << endl;
+  cout << "span in file: "
+       << count("tracing.json", "\"name\":\"after signal\",\"cat\":\"test\"")
+       << endl;
+  unlink("tracing.json");
+  return 0;
+}